@@ -0,0 +1,97 @@
+#include "AdaptivePlacement.h"
+
+namespace Core
+{
+	// ProcessTimeSource clocks tick in 100ns units
+	const unsigned long long ticksPerMs = 10000;
+
+	AdaptivePlacer::AdaptivePlacer(std::unique_ptr<ProcessTimeSource> source)
+		: m_Source(std::move(source))
+	{
+	}
+
+	void AdaptivePlacer::SetPolicy(const AdaptivePolicy& policy)
+	{
+		m_Policy = policy;
+	}
+
+	void AdaptivePlacer::Track(unsigned long pid, CoreClass coreClass)
+	{
+		State& state = m_States[pid];
+		state = State();
+		state.coreClass = coreClass;
+		state.lastMove = m_Source->Now();
+	}
+
+	void AdaptivePlacer::Forget(unsigned long pid)
+	{
+		m_States.erase(pid);
+	}
+
+	void AdaptivePlacer::Clear()
+	{
+		m_States.clear();
+	}
+
+	bool AdaptivePlacer::IsTracked(unsigned long pid) const
+	{
+		return m_States.find(pid) != m_States.end();
+	}
+
+	bool AdaptivePlacer::Due()
+	{
+		return !m_Stepped || m_Source->Now() - m_LastStep >= m_Policy.intervalMs * ticksPerMs;
+	}
+
+	void AdaptivePlacer::Step(std::vector<AdaptiveDecision>& decisions)
+	{
+		decisions.clear();
+		unsigned long long now = m_Source->Now();
+		m_LastStep = now;
+		m_Stepped = true;
+
+		for (auto it = m_States.begin(); it != m_States.end();) {
+			State& state = it->second;
+			unsigned long long cpuTime = 0;
+			if (!m_Source->CpuTime(it->first, cpuTime)) {
+				it = m_States.erase(it);
+				continue;
+			}
+
+			// the first sample only sets the baseline
+			if (!state.sampled || now <= state.lastSample) {
+				state.sampled = true;
+				state.lastCpuTime = cpuTime;
+				state.lastSample = now;
+				++it;
+				continue;
+			}
+
+			double load = static_cast<double>(cpuTime - state.lastCpuTime) / static_cast<double>(now - state.lastSample);
+			state.load = state.loaded ? m_Policy.smoothing * load + (1 - m_Policy.smoothing) * state.load : load;
+			state.loaded = true;
+			state.lastCpuTime = cpuTime;
+			state.lastSample = now;
+
+			// the streak counts samples past the threshold that would move the process
+			bool pastThreshold = state.coreClass == CoreClass::Efficiency
+				? state.load > m_Policy.promoteAbove
+				: state.load < m_Policy.demoteBelow;
+			state.streak = pastThreshold ? state.streak + 1 : 0;
+
+			unsigned required = state.coreClass == CoreClass::Efficiency ? m_Policy.promoteSamples : m_Policy.demoteSamples;
+			bool dwelled = now - state.lastMove >= m_Policy.minDwellMs * ticksPerMs;
+			if (state.streak >= required && dwelled) {
+				state.coreClass = state.coreClass == CoreClass::Efficiency ? CoreClass::Performance : CoreClass::Efficiency;
+				state.lastMove = now;
+				state.streak = 0;
+
+				AdaptiveDecision decision;
+				decision.pid = it->first;
+				decision.coreClass = state.coreClass;
+				decisions.push_back(decision);
+			}
+			++it;
+		}
+	}
+}
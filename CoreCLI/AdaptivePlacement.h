@@ -0,0 +1,87 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "CoreTopology.h"
+#include "ProcessTimeSource.h"
+
+namespace Core
+{
+    // Thresholds are in cores, the share of one core a process keeps busy.
+    struct AdaptivePolicy
+    {
+        double promoteAbove = 0.5;
+        double demoteBelow = 0.1;
+
+        // Consecutive samples past a threshold before the process moves.
+        unsigned promoteSamples = 3;
+        unsigned demoteSamples = 5;
+
+        // Least time a process stays in a class after moving, in milliseconds.
+        unsigned minDwellMs = 5000;
+        unsigned intervalMs = 1000;
+
+        // Weight of the newest sample in the smoothed load.
+        double smoothing = 0.5;
+
+        // Cores of each class for the two placements, -1 for every core of the class.
+        int idleECores = -1;
+        int idlePCores = 0;
+        int busyECores = 0;
+        int busyPCores = -1;
+    };
+
+    struct AdaptiveDecision
+    {
+        unsigned long pid = 0;
+        CoreClass coreClass = CoreClass::Efficiency;
+    };
+
+    // Moves tracked processes between core classes by their measured CPU load. A process is
+    // promoted once its smoothed load stays above promoteAbove for promoteSamples samples, and
+    // demoted once it stays below demoteBelow for demoteSamples. The gap between the thresholds
+    // and the dwell time keep a process with bursty load from moving back and forth.
+    class AdaptivePlacer
+    {
+    public:
+        explicit AdaptivePlacer(std::unique_ptr<ProcessTimeSource> source);
+
+        void SetPolicy(const AdaptivePolicy& policy);
+        const AdaptivePolicy& Policy() const { return m_Policy; }
+
+        void Track(unsigned long pid, CoreClass coreClass);
+        void Forget(unsigned long pid);
+        void Clear();
+        bool IsTracked(unsigned long pid) const;
+        std::size_t Size() const { return m_States.size(); }
+
+        // True once intervalMs has passed since the previous step.
+        bool Due();
+
+        // Samples every tracked process and returns those that should change class. Processes
+        // that can no longer be sampled have exited and are dropped.
+        void Step(std::vector<AdaptiveDecision>& decisions);
+
+        ProcessTimeSource& Source() { return *m_Source; }
+
+    private:
+        struct State
+        {
+            CoreClass coreClass = CoreClass::Efficiency;
+            unsigned long long lastCpuTime = 0;
+            unsigned long long lastSample = 0;
+            unsigned long long lastMove = 0;
+            double load = 0;
+            unsigned streak = 0;
+            bool sampled = false;
+            bool loaded = false;
+        };
+
+        std::unique_ptr<ProcessTimeSource> m_Source;
+        AdaptivePolicy m_Policy;
+        std::unordered_map<unsigned long, State> m_States;
+        unsigned long long m_LastStep = 0;
+        bool m_Stepped = false;
+    };
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Core
+{
+    class SimulatedOsBackend;
+}
+
+namespace Bench
+{
+    // Heap allocations since start, counted by the global operator new in Benchmarks.cpp.
+    unsigned long long Allocations();
+
+    // Calls made into the simulated system last passed to CountOsCalls, nullptr when
+    // there is none to count.
+    unsigned long long OsCalls();
+    void CountOsCalls(const Core::SimulatedOsBackend* system);
+
+    struct Measurement
+    {
+        std::string name;
+        double nsPerOp = 0;
+        double syscallsPerOp = -1;      // -1 when the case cannot count them
+        double allocationsPerOp = 0;
+    };
+
+    // Runs op in growing batches until a batch takes at least minSeconds, after one warm-up
+    // call, and reports the cost of one call in the last batch.
+    template <typename Op>
+    Measurement Measure(const std::string& name, Op op, bool countsSyscalls = true, double minSeconds = 0.2)
+    {
+        op();
+
+        Measurement measurement;
+        measurement.name = name;
+        for (unsigned long long iterations = 1; ; iterations *= 2) {
+            unsigned long long allocations = Allocations();
+            unsigned long long osCalls = OsCalls();
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned long long i = 0; i < iterations; i++) {
+                op();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (seconds >= minSeconds || iterations >= (1ULL << 40)) {
+                measurement.nsPerOp = seconds * 1e9 / iterations;
+                measurement.allocationsPerOp = static_cast<double>(Allocations() - allocations) / iterations;
+                measurement.syscallsPerOp = countsSyscalls ? static_cast<double>(OsCalls() - osCalls) / iterations : -1;
+                return measurement;
+            }
+        }
+    }
+
+    // Baselines are text files of one "name ns/op syscalls/op allocations/op" line per case.
+    bool SaveBaseline(const char* path, const std::vector<Measurement>& measurements);
+    bool LoadBaseline(const char* path, std::vector<Measurement>& measurements);
+}
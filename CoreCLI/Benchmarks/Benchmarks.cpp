@@ -0,0 +1,503 @@
+// Microbenchmarks of the controller's hot paths against synthetic process tables and
+// topologies. Run with --help for the options.
+
+#include "Benchmark.h"
+#include "SyntheticSystem.h"
+
+#include "CommandServer.h"
+#include "CommandTransport.h"
+#include "CoreFeatureTable.h"
+#include "NativeController.h"
+#include "PlacementPolicy.h"
+#include "ProcessCpuSampler.h"
+
+#ifdef _WIN32
+#include "HybridDetect.h"
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+
+static std::atomic<unsigned long long> allocationCount{ 0 };
+static const Core::SimulatedOsBackend* countedSystem = nullptr;
+
+void* operator new(std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* memory = std::malloc(size != 0 ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+namespace Bench
+{
+	unsigned long long Allocations()
+	{
+		return allocationCount.load(std::memory_order_relaxed);
+	}
+
+	unsigned long long OsCalls()
+	{
+		return countedSystem != nullptr ? countedSystem->CallCount() : 0;
+	}
+
+	void CountOsCalls(const Core::SimulatedOsBackend* system)
+	{
+		countedSystem = system;
+	}
+
+	bool SaveBaseline(const char* path, const std::vector<Measurement>& measurements)
+	{
+		std::ofstream file(path);
+		for (const Measurement& measurement : measurements) {
+			file << measurement.name << ' ' << measurement.nsPerOp << ' ' << measurement.syscallsPerOp << ' '
+				<< measurement.allocationsPerOp << '\n';
+		}
+		return static_cast<bool>(file);
+	}
+
+	bool LoadBaseline(const char* path, std::vector<Measurement>& measurements)
+	{
+		std::ifstream file(path);
+		if (!file) {
+			return false;
+		}
+
+		Measurement measurement;
+		while (file >> measurement.name >> measurement.nsPerOp >> measurement.syscallsPerOp >> measurement.allocationsPerOp) {
+			measurements.push_back(measurement);
+		}
+		return true;
+	}
+}
+
+using namespace Bench;
+
+struct Options
+{
+	std::string filter;
+	double minSeconds = 0.2;
+	const char* savePath = nullptr;
+	const char* baselinePath = nullptr;
+	double threshold = 10;
+	bool system = false;
+};
+
+static bool Selected(const Options& options, const std::string& name)
+{
+	return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+// Discards the controller's console output, which would otherwise dominate the timings.
+class NullBuffer : public std::streambuf
+{
+protected:
+	int overflow(int c) override { return c; }
+};
+
+static const std::size_t processCounts[] = { 100, 1000, 10000 };
+
+// The real controller on a fresh simulated 8P16E system, with the calls it makes counted.
+static std::unique_ptr<Core::NativeController> MakeController(const std::vector<Core::SimulatedProcess>& processes)
+{
+	std::unique_ptr<Core::SimulatedOsBackend> system = MakeSystem(8, 16, processes);
+	CountOsCalls(system.get());
+	return std::unique_ptr<Core::NativeController>(new Core::NativeController(std::move(system)));
+}
+
+static void RunProcessCases(const Options& options, std::vector<Measurement>& results)
+{
+	NullBuffer nullBuffer;
+	std::streambuf* console = std::cout.rdbuf(&nullBuffer);
+
+	for (std::size_t count : processCounts) {
+		std::vector<Core::SimulatedProcess> processes = MakeProcessTable(count);
+		std::string size = "/" + std::to_string(count);
+
+		std::string name = "ProcessesSnapShot/steady" + size;
+		if (Selected(options, name)) {
+			std::unique_ptr<Core::NativeController> controller = MakeController(processes);
+			results.push_back(Measure(name, [&] { controller->MoveAllAppsToHybridCores(16, 0); }, true, options.minSeconds));
+		}
+
+		// alternating masks make every process need a new bind on every call
+		name = "ProcessesSnapShot/rebind" + size;
+		if (Selected(options, name)) {
+			std::unique_ptr<Core::NativeController> controller = MakeController(processes);
+			bool toggle = false;
+			results.push_back(Measure(name, [&] {
+				toggle = !toggle;
+				controller->MoveAllAppsToHybridCores(16, toggle ? 0 : 8);
+			}, true, options.minSeconds));
+		}
+
+		name = "FindAndBind" + size;
+		if (Selected(options, name)) {
+			std::unique_ptr<Core::NativeController> controller = MakeController(processes);
+			results.push_back(Measure(name, [&] { controller->MoveAppToHybridCores(L"APP1.exe", 16, 0); }, true, options.minSeconds));
+		}
+
+		name = "MoveAppsToHybridCores/4" + size;
+		if (Selected(options, name)) {
+			std::unique_ptr<Core::NativeController> controller = MakeController(processes);
+			std::vector<Core::HybridTarget> targets(4);
+			targets[0].exeName = L"app1.exe";
+			targets[1].exeName = L"app2.exe";
+			targets[2].exeName = L"app3.exe";
+			targets[3].exeName = L"missing.exe";
+			for (Core::HybridTarget& target : targets) {
+				target.eCores = 16;
+			}
+			results.push_back(Measure(name, [&] { controller->MoveAppsToHybridCores(targets); }, true, options.minSeconds));
+		}
+		CountOsCalls(nullptr);
+
+		name = "PolicyMatch" + size;
+		if (Selected(options, name)) {
+			std::vector<Core::PlacementRule> rules;
+			for (int i = 0; i < 40; i++) {
+				Core::PlacementRule rule;
+				rule.pattern = L"app" + std::to_wstring(i * 7) + (i % 4 == 0 ? L"*" : L".exe");
+				rules.push_back(rule);
+			}
+			Core::PlacementRule suffix;
+			suffix.pattern = L"*helper.exe";
+			rules.push_back(suffix);
+			Core::PolicyMatcher matcher;
+			matcher.Compile(rules);
+
+			int matched = 0;
+			results.push_back(Measure(name, [&] {
+				for (const Core::SimulatedProcess& process : processes) {
+					matched += matcher.Match(process.exeName.c_str()) >= 0;
+				}
+			}, true, options.minSeconds));
+		}
+
+		name = "ProcessCpuSampler" + size;
+		if (Selected(options, name)) {
+			Core::SyntheticProcessTimeSource* source = new Core::SyntheticProcessTimeSource();
+			for (const Core::SimulatedProcess& process : processes) {
+				source->SetLoad(process.pid, (process.pid % 100) / 100.0);
+			}
+			Core::ProcessCpuSampler sampler{ std::unique_ptr<Core::ProcessTimeSource>(source) };
+			results.push_back(Measure(name, [&] {
+				source->Advance(10000000);
+				sampler.Sample();
+			}, true, options.minSeconds));
+		}
+	}
+
+	std::cout.rdbuf(console);
+}
+
+struct TopologyShape
+{
+	const char* name;
+	unsigned pCores;
+	unsigned eCores;
+};
+
+static const TopologyShape topologyShapes[] = {
+	{ "8P16E", 8, 16 },
+	{ "64P64E", 64, 64 }
+};
+
+static void RunTopologyCases(const Options& options, std::vector<Measurement>& results)
+{
+	for (const TopologyShape& shape : topologyShapes) {
+		std::vector<Core::LogicalCore> cores = MakeTopology(shape.pCores, shape.eCores);
+		std::string suffix = std::string("/") + shape.name;
+
+		std::string name = "CreateAffinityMask" + suffix;
+		if (Selected(options, name)) {
+			Core::CoreTopology topology;
+			topology.Build(cores);
+			int e = 0, p = 0;
+			unsigned long long sum = 0;
+			results.push_back(Measure(name, [&] {
+				sum += topology.Mask(e, p).Count();
+				e = e < topology.EfficiencyCoreCount() ? e + 1 : 0;
+				p = p < topology.PerformanceCoreCount() ? p + 1 : 0;
+			}, true, options.minSeconds));
+		}
+
+		// the part of DetectCoreCount after the OS has been queried
+		name = "DetectCoreCount/build" + suffix;
+		if (Selected(options, name)) {
+			Core::CoreTopology topology;
+			Core::CoreFeatureTable features;
+			results.push_back(Measure(name, [&] {
+				topology.Build(cores);
+				features.Clear();
+				features.Reserve(cores.size());
+				for (const Core::LogicalCore& core : cores) {
+					features.Add(core, Core::FeatureBit(core.coreClass), 0, 2000, 5000);
+				}
+			}, true, options.minSeconds));
+		}
+	}
+
+	// the OS query DetectCoreCount makes without the topology cache: the CPU set and CPUID
+	// walk on Windows, sysfs elsewhere. It only reads, so it runs on this machine by default.
+	if (Selected(options, "GetProcessorInfo")) {
+#ifdef _WIN32
+		results.push_back(Measure("GetProcessorInfo", [] {
+			PROCESSOR_INFO info;
+			GetProcessorInfo(info);
+		}, false, options.minSeconds));
+#else
+		std::unique_ptr<Core::OsBackend> backend = Core::CreateOsBackend();
+		std::vector<Core::ProcessorDescription> processors;
+		results.push_back(Measure("GetProcessorInfo", [&] {
+			backend->DetectTopology(false, processors);
+		}, false, options.minSeconds));
+#endif
+	}
+}
+
+#ifdef _WIN32
+static const wchar_t commandEndpoint[] = L"\\\\.\\pipe\\CoreBenchmarks";
+#else
+static const wchar_t commandEndpoint[] = L"/tmp/CoreBenchmarks.sock";
+#endif
+
+// Reads one response frame, false when the server hung up.
+static bool ReadResponse(Core::CommandChannel& channel, std::vector<unsigned char>& body)
+{
+	unsigned char header[Core::frameHeaderSize];
+	unsigned long length = 0;
+	Core::FrameReader reader(header, sizeof(header));
+	if (!channel.Read(header, sizeof(header)) || !reader.U32(length)) {
+		return false;
+	}
+	body.resize(length);
+	return length == 0 || channel.Read(body.data(), length);
+}
+
+// The command server on a simulated system: decoding and running a batch in process, and
+// whole requests through the platform transport, one at a time and pipelined.
+static void RunCommandCases(const Options& options, std::vector<Measurement>& results)
+{
+	NullBuffer nullBuffer;
+	std::streambuf* console = std::cout.rdbuf(&nullBuffer);
+
+	std::unique_ptr<Core::NativeController> controller = MakeController(MakeProcessTable(1000));
+	CountOsCalls(nullptr);
+	Core::RequestQueue requests(*controller);
+	Core::CommandServer server(*controller, requests);
+
+	std::vector<unsigned char> frame;
+	Core::BeginCommandFrame(frame, 1);
+	Core::FrameWriter writer(frame);
+	for (int i = 0; i < 16; i++) {
+		Core::EndCommand(writer, Core::BeginCommand(writer, Core::CommandCode::CoreCounts));
+	}
+	Core::EndCommandFrame(frame, 16);
+
+	std::vector<unsigned char> response;
+	if (Selected(options, "CommandBatch/16")) {
+		results.push_back(Measure("CommandBatch/16", [&] {
+			response.clear();
+			server.HandleRequest(frame.data() + Core::frameHeaderSize, frame.size() - Core::frameHeaderSize, response);
+		}, false, options.minSeconds));
+	}
+
+	bool roundTrip = Selected(options, "CommandRoundTrip/1");
+	bool pipelined = Selected(options, "CommandPipelined/64");
+	if ((roundTrip || pipelined) && server.Start(commandEndpoint)) {
+		std::unique_ptr<Core::CommandChannel> channel = Core::ConnectCommandChannel(commandEndpoint);
+		Core::BeginCommandFrame(frame, 2);
+		Core::EndCommand(writer, Core::BeginCommand(writer, Core::CommandCode::CoreCounts));
+		Core::EndCommandFrame(frame, 1);
+
+		if (channel && roundTrip) {
+			results.push_back(Measure("CommandRoundTrip/1", [&] {
+				channel->Write(frame.data(), frame.size());
+				ReadResponse(*channel, response);
+			}, false, options.minSeconds));
+		}
+		if (channel && pipelined) {
+			std::vector<unsigned char> frames;
+			for (int i = 0; i < 64; i++) {
+				frames.insert(frames.end(), frame.begin(), frame.end());
+			}
+			results.push_back(Measure("CommandPipelined/64", [&] {
+				channel->Write(frames.data(), frames.size());
+				for (int i = 0; i < 64; i++) {
+					ReadResponse(*channel, response);
+				}
+			}, false, options.minSeconds));
+		}
+		channel.reset();
+		server.Stop();
+	}
+
+	std::cout.rdbuf(console);
+}
+
+// The real paths against the running system. OS calls are not counted here.
+static void RunSystemCases(const Options& options, std::vector<Measurement>& results)
+{
+	NullBuffer nullBuffer;
+	std::streambuf* console = std::cout.rdbuf(&nullBuffer);
+
+	Core::NativeController controller;
+	if (Selected(options, "DetectCoreCount/system")) {
+		results.push_back(Measure("DetectCoreCount/system", [&] { controller.DetectCoreCount(); }, false, options.minSeconds));
+	}
+	if (Selected(options, "FindAndBind/system")) {
+		results.push_back(Measure("FindAndBind/system", [&] {
+			controller.MoveAppToHybridCores(L"benchmark-missing.exe", 0, 1);
+		}, false, options.minSeconds));
+	}
+	if (Selected(options, "ProcessesSnapShot/system")) {
+		int eCores = controller.EfficiencyCoreCount();
+		int pCores = controller.PerformanceCoreCount();
+		results.push_back(Measure("ProcessesSnapShot/system", [&] {
+			controller.MoveAllAppsToHybridCores(eCores, pCores, Core::PlacementMode::Soft);
+		}, false, options.minSeconds));
+	}
+
+	std::cout.rdbuf(console);
+}
+
+static void PrintUsage()
+{
+	std::printf(
+		"Usage: CoreBenchmarks [options]\n"
+		"  --filter <text>      run only cases whose name contains text\n"
+		"  --min-time <s>       shortest timed batch per case, default 0.2\n"
+		"  --save <file>        write the results as a baseline\n"
+		"  --baseline <file>    compare with a saved baseline, failing on regressions\n"
+		"  --threshold <pct>    slowdown that counts as a regression, default 10\n"
+		"  --system             also time the real controller against this machine\n");
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+			options.filter = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+			options.minSeconds = std::atof(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--save") == 0 && hasValue) {
+			options.savePath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue) {
+			options.baselinePath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--threshold") == 0 && hasValue) {
+			options.threshold = std::atof(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--system") == 0) {
+			options.system = true;
+		}
+		else {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Prints the results, against the baseline when there is one. Returns the number of regressions:
+// cases slower by more than the threshold, or making more OS calls or allocations than before.
+static int Report(const Options& options, const std::vector<Measurement>& results, const std::vector<Measurement>& baseline)
+{
+	int regressions = 0;
+	std::printf("%-36s %14s %12s %12s", "case", "ns/op", "syscalls/op", "allocs/op");
+	std::printf(baseline.empty() ? "\n" : " %14s %9s\n", "baseline ns", "change");
+
+	for (const Measurement& result : results) {
+		char syscalls[32] = "-";
+		if (result.syscallsPerOp >= 0) {
+			std::snprintf(syscalls, sizeof(syscalls), "%.1f", result.syscallsPerOp);
+		}
+		std::printf("%-36s %14.1f %12s %12.1f", result.name.c_str(), result.nsPerOp, syscalls, result.allocationsPerOp);
+
+		const Measurement* before = nullptr;
+		for (const Measurement& candidate : baseline) {
+			if (candidate.name == result.name) {
+				before = &candidate;
+			}
+		}
+		if (before == nullptr) {
+			std::printf(baseline.empty() ? "\n" : " %14s %9s\n", "-", "new");
+			continue;
+		}
+
+		double change = before->nsPerOp > 0 ? (result.nsPerOp / before->nsPerOp - 1) * 100 : 0;
+		bool regressed = change > options.threshold
+			|| result.syscallsPerOp > before->syscallsPerOp + 0.05
+			|| result.allocationsPerOp > before->allocationsPerOp + 0.05;
+		std::printf(" %14.1f %+8.1f%%%s\n", before->nsPerOp, change, regressed ? "  REGRESSION" : "");
+		regressions += regressed ? 1 : 0;
+	}
+	return regressions;
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return 2;
+	}
+
+	std::vector<Measurement> baseline;
+	if (options.baselinePath != nullptr && !LoadBaseline(options.baselinePath, baseline)) {
+		std::fprintf(stderr, "Cannot read baseline %s\n", options.baselinePath);
+		return 2;
+	}
+
+	std::vector<Measurement> results;
+	RunProcessCases(options, results);
+	RunTopologyCases(options, results);
+	RunCommandCases(options, results);
+	if (options.system) {
+		RunSystemCases(options, results);
+	}
+
+	int regressions = Report(options, results, baseline);
+	if (options.savePath != nullptr && !SaveBaseline(options.savePath, results)) {
+		std::fprintf(stderr, "Cannot write baseline %s\n", options.savePath);
+		return 2;
+	}
+	return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+#include "SyntheticSystem.h"
+
+#include <random>
+
+namespace Bench
+{
+	std::vector<Core::SimulatedProcess> MakeProcessTable(std::size_t count, unsigned seed)
+	{
+		std::mt19937 random(seed);
+		std::size_t nameCount = count / 4 > 0 ? count / 4 : 1;
+
+		std::vector<Core::SimulatedProcess> processes(count);
+		for (std::size_t i = 0; i < count; i++) {
+			processes[i].pid = static_cast<unsigned long>(4 * (i + 1));
+			processes[i].exeName = L"app" + std::to_wstring(random() % nameCount) + L".exe";
+			processes[i].creationTime = 132000000000000000ULL + random();
+		}
+		return processes;
+	}
+
+	std::vector<Core::LogicalCore> MakeTopology(unsigned pCores, unsigned eCores)
+	{
+		std::vector<Core::LogicalCore> cores;
+		unsigned logical = 0;
+		unsigned physical = 0;
+		auto add = [&](Core::CoreClass coreClass, unsigned char efficiencyClass) {
+			Core::LogicalCore core;
+			core.group = static_cast<unsigned short>(logical / 64);
+			core.index = static_cast<unsigned char>(logical % 64);
+			core.coreIndex = static_cast<unsigned char>(physical % 256);
+			core.efficiencyClass = efficiencyClass;
+			core.coreClass = coreClass;
+			core.cpuSetId = 256 + logical;
+			cores.push_back(core);
+			logical++;
+		};
+
+		for (unsigned p = 0; p < pCores; p++, physical++) {
+			add(Core::CoreClass::Performance, 1);
+			add(Core::CoreClass::Performance, 1);
+		}
+		for (unsigned e = 0; e < eCores; e++, physical++) {
+			add(Core::CoreClass::Efficiency, 0);
+		}
+		return cores;
+	}
+
+	std::unique_ptr<Core::SimulatedOsBackend> MakeSystem(unsigned pCores, unsigned eCores, const std::vector<Core::SimulatedProcess>& processes)
+	{
+		std::unique_ptr<Core::SimulatedOsBackend> system(new Core::SimulatedOsBackend());
+		system->SetRecording(false);
+		system->AddCores(Core::CoreClass::Performance, pCores, 2);
+		system->AddCores(Core::CoreClass::Efficiency, eCores);
+		for (const Core::SimulatedProcess& process : processes) {
+			system->AddProcess(process);
+		}
+		return system;
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "CoreTopology.h"
+#include "SimulatedOsBackend.h"
+
+namespace Bench
+{
+    // count processes spread over count / 4 executable names, with PIDs that are multiples
+    // of 4 as on Windows. The same seed gives the same table.
+    std::vector<Core::SimulatedProcess> MakeProcessTable(std::size_t count, unsigned seed = 1);
+
+    // pCores SMT P-cores followed by single-threaded E-cores, split into processor groups
+    // of at most 64 logical processors.
+    std::vector<Core::LogicalCore> MakeTopology(unsigned pCores, unsigned eCores);
+
+    // A simulated system with the topology of MakeTopology running processes. Calls are
+    // counted but not recorded, so the controller can run against it for as long as a
+    // measurement takes.
+    std::unique_ptr<Core::SimulatedOsBackend> MakeSystem(unsigned pCores, unsigned eCores, const std::vector<Core::SimulatedProcess>& processes);
+}
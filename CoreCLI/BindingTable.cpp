@@ -0,0 +1,76 @@
+#include "BindingTable.h"
+
+namespace Core
+{
+	bool BindingTable::IsBound(unsigned long pid, unsigned long long creationTime, const CpuMask& mask, PlacementMode mode) const
+	{
+		auto it = m_Entries.find(pid);
+		if (it == m_Entries.end()) {
+			return false;
+		}
+
+		// a different creation time means the PID now belongs to a new process
+		return it->second.creationTime == creationTime && it->second.mask == mask && it->second.mode == mode;
+	}
+
+	const CpuMask* BindingTable::Find(unsigned long pid) const
+	{
+		auto it = m_Entries.find(pid);
+		return it != m_Entries.end() ? &it->second.mask : nullptr;
+	}
+
+	bool BindingTable::IsSoft(unsigned long pid, unsigned long long creationTime) const
+	{
+		auto it = m_Entries.find(pid);
+		return it != m_Entries.end() && it->second.creationTime == creationTime && it->second.mode == PlacementMode::Soft;
+	}
+
+	void BindingTable::Record(unsigned long pid, unsigned long long creationTime, const CpuMask& mask, PlacementMode mode)
+	{
+		Entry& entry = m_Entries[pid];
+		entry.creationTime = creationTime;
+		entry.mask = mask;
+		entry.mode = mode;
+		entry.sweep = m_Sweep;
+	}
+
+	void BindingTable::Touch(unsigned long pid)
+	{
+		auto it = m_Entries.find(pid);
+		if (it != m_Entries.end()) {
+			it->second.sweep = m_Sweep;
+		}
+	}
+
+	void BindingTable::Forget(unsigned long pid)
+	{
+		m_Entries.erase(pid);
+	}
+
+	void BindingTable::Clear()
+	{
+		m_Entries.clear();
+	}
+
+	void BindingTable::BeginSweep()
+	{
+		m_Sweep++;
+	}
+
+	void BindingTable::EndSweep()
+	{
+		for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+			if (it->second.sweep != m_Sweep) {
+				it = m_Entries.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	std::size_t BindingTable::Size() const
+	{
+		return m_Entries.size();
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+
+#include "CpuMask.h"
+
+namespace Core
+{
+    // Hard placements restrict a process with an affinity mask. Soft placements set its
+    // default CPU sets, a preference the scheduler may leave when other cores sit idle.
+    enum class PlacementMode : unsigned char
+    {
+        Hard,
+        Soft
+    };
+
+    // Remembers which affinity mask was last applied to each process so that
+    // re-applying a mode only has to touch processes that actually changed.
+    // A process is identified by its PID together with its creation time, so a
+    // recycled PID is never mistaken for the process that previously owned it.
+    class BindingTable
+    {
+    public:
+        // Returns true when the process already holds the given mask and mode from an earlier
+        // apply. Lookups do not modify the table, so workers may call this concurrently.
+        bool IsBound(unsigned long pid, unsigned long long creationTime, const CpuMask& mask,
+            PlacementMode mode = PlacementMode::Hard) const;
+        // The mask last applied to the process, or null when it was never bound.
+        const CpuMask* Find(unsigned long pid) const;
+        // True when the process was last bound with a soft placement, whose CPU sets a hard
+        // placement has to clear.
+        bool IsSoft(unsigned long pid, unsigned long long creationTime) const;
+        void Record(unsigned long pid, unsigned long long creationTime, const CpuMask& mask,
+            PlacementMode mode = PlacementMode::Hard);
+        void Touch(unsigned long pid);
+        void Forget(unsigned long pid);
+        void Clear();
+
+        // A sweep brackets one walk over the process list. Entries that were not
+        // seen during the sweep belong to processes that have exited and are dropped.
+        void BeginSweep();
+        void EndSweep();
+
+        std::size_t Size() const;
+
+    private:
+        struct Entry
+        {
+            unsigned long long creationTime = 0;
+            CpuMask mask;
+            PlacementMode mode = PlacementMode::Hard;
+            unsigned sweep = 0;
+        };
+
+        std::unordered_map<unsigned long, Entry> m_Entries;
+        unsigned m_Sweep = 0;
+    };
+}
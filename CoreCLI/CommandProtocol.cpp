@@ -0,0 +1,220 @@
+#include "CommandProtocol.h"
+
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+
+namespace Core
+{
+	void FrameWriter::U8(unsigned value)
+	{
+		m_Buffer.push_back(static_cast<unsigned char>(value));
+	}
+
+	void FrameWriter::U16(unsigned value)
+	{
+		m_Buffer.push_back(static_cast<unsigned char>(value));
+		m_Buffer.push_back(static_cast<unsigned char>(value >> 8));
+	}
+
+	void FrameWriter::U32(unsigned long value)
+	{
+		for (int shift = 0; shift < 32; shift += 8) {
+			m_Buffer.push_back(static_cast<unsigned char>(value >> shift));
+		}
+	}
+
+	void FrameWriter::I32(int value)
+	{
+		U32(static_cast<uint32_t>(value));
+	}
+
+	void FrameWriter::F32(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		U32(bits);
+	}
+
+	void FrameWriter::F64(double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		U32(static_cast<uint32_t>(bits));
+		U32(static_cast<uint32_t>(bits >> 32));
+	}
+
+	// Names go out as UTF-16, which wchar_t already is on Windows.
+	void FrameWriter::Name(const wchar_t* name)
+	{
+		size_t offset = m_Buffer.size();
+		U16(0);
+		unsigned units = 0;
+		for (const wchar_t* c = name; *c != L'\0' && units < 0xFFFE; c++) {
+			unsigned long code = static_cast<unsigned long>(*c);
+			if (code > 0xFFFF) {
+				code -= 0x10000;
+				U16(0xD800 + (code >> 10));
+				U16(0xDC00 + (code & 0x3FF));
+				units += 2;
+			}
+			else {
+				U16(code);
+				units++;
+			}
+		}
+		PatchU16(offset, units);
+	}
+
+	void FrameWriter::Bytes(const void* data, size_t length)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		m_Buffer.insert(m_Buffer.end(), bytes, bytes + length);
+	}
+
+	void FrameWriter::PatchU16(size_t offset, unsigned value)
+	{
+		m_Buffer[offset] = static_cast<unsigned char>(value);
+		m_Buffer[offset + 1] = static_cast<unsigned char>(value >> 8);
+	}
+
+	void FrameWriter::PatchU32(size_t offset, unsigned long value)
+	{
+		for (int i = 0; i < 4; i++) {
+			m_Buffer[offset + i] = static_cast<unsigned char>(value >> (i * 8));
+		}
+	}
+
+	bool FrameReader::Take(size_t length, const unsigned char*& data)
+	{
+		if (m_Failed || length > m_Remaining) {
+			m_Failed = true;
+			return false;
+		}
+		data = m_Data;
+		m_Data += length;
+		m_Remaining -= length;
+		return true;
+	}
+
+	bool FrameReader::U8(unsigned& value)
+	{
+		const unsigned char* data;
+		if (!Take(1, data)) {
+			return false;
+		}
+		value = data[0];
+		return true;
+	}
+
+	bool FrameReader::U16(unsigned& value)
+	{
+		const unsigned char* data;
+		if (!Take(2, data)) {
+			return false;
+		}
+		value = data[0] | (static_cast<unsigned>(data[1]) << 8);
+		return true;
+	}
+
+	bool FrameReader::U32(unsigned long& value)
+	{
+		const unsigned char* data;
+		if (!Take(4, data)) {
+			return false;
+		}
+		value = data[0] | (static_cast<unsigned long>(data[1]) << 8) | (static_cast<unsigned long>(data[2]) << 16) | (static_cast<unsigned long>(data[3]) << 24);
+		return true;
+	}
+
+	bool FrameReader::I32(int& value)
+	{
+		unsigned long bits;
+		if (!U32(bits)) {
+			return false;
+		}
+		value = static_cast<int32_t>(static_cast<uint32_t>(bits));
+		return true;
+	}
+
+	bool FrameReader::F32(float& value)
+	{
+		unsigned long bits;
+		if (!U32(bits)) {
+			return false;
+		}
+		uint32_t bits32 = static_cast<uint32_t>(bits);
+		memcpy(&value, &bits32, sizeof(value));
+		return true;
+	}
+
+	bool FrameReader::F64(double& value)
+	{
+		unsigned long low, high;
+		if (!U32(low) || !U32(high)) {
+			return false;
+		}
+		uint64_t bits = static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+		memcpy(&value, &bits, sizeof(value));
+		return true;
+	}
+
+	bool FrameReader::Name(std::wstring& name)
+	{
+		unsigned units;
+		const unsigned char* data;
+		if (!U16(units) || !Take(static_cast<size_t>(units) * 2, data)) {
+			return false;
+		}
+
+		name.clear();
+		name.reserve(units);
+		for (unsigned i = 0; i < units; i++) {
+			unsigned long code = data[i * 2] | (static_cast<unsigned>(data[i * 2 + 1]) << 8);
+			// a wider wchar_t takes a surrogate pair as one character
+			if (sizeof(wchar_t) > 2 && code >= 0xD800 && code < 0xDC00 && i + 1 < units) {
+				unsigned long low = data[i * 2 + 2] | (static_cast<unsigned>(data[i * 2 + 3]) << 8);
+				if (low >= 0xDC00 && low < 0xE000) {
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+					i++;
+				}
+			}
+			name.push_back(static_cast<wchar_t>(code));
+		}
+		return true;
+	}
+
+	bool FrameReader::Bytes(size_t length, const unsigned char*& data)
+	{
+		return Take(length, data);
+	}
+
+	void BeginCommandFrame(std::vector<unsigned char>& frame, unsigned long requestId)
+	{
+		frame.clear();
+		FrameWriter writer(frame);
+		writer.U32(0);
+		writer.U32(requestId);
+		writer.U16(0);
+	}
+
+	size_t BeginCommand(FrameWriter& writer, CommandCode code)
+	{
+		writer.U8(static_cast<unsigned>(code));
+		size_t command = writer.Size();
+		writer.U16(0);
+		return command;
+	}
+
+	void EndCommand(FrameWriter& writer, size_t command)
+	{
+		writer.PatchU16(command, static_cast<unsigned>(writer.Size() - command - 2));
+	}
+
+	void EndCommandFrame(std::vector<unsigned char>& frame, unsigned commandCount)
+	{
+		FrameWriter writer(frame);
+		writer.PatchU32(0, static_cast<unsigned long>(frame.size() - frameHeaderSize));
+		writer.PatchU16(frameHeaderSize + 4, commandCount);
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Core
+{
+    // Binary protocol of the command server. Every integer is little-endian.
+    //
+    //   frame    := u32 length, then length bytes of body
+    //   request  := u32 requestId, u16 commandCount, commandCount x command
+    //   command  := u8 CommandCode, u16 argLength, argLength bytes of arguments
+    //   response := u32 requestId, u16 resultCount, resultCount x result
+    //   result   := u8 CommandStatus, u16 dataLength, dataLength bytes of data
+    //
+    // A request is a batch run in order, answered by one response with a result per command.
+    // Clients may send requests without waiting for responses, which come back in request
+    // order on each connection and carry the requestId they answer.
+    //
+    // Arguments and data per command, where name is u16 units then units UTF-16 code units:
+    //   DetectCoreCount, CoreCounts        -> i32 total, i32 efficiency, i32 performance
+    //   MoveAllAppsToEfficiencyCores,
+    //   MoveAllAppsToSomeEfficiencyCores,
+    //   ResetToDefaultCores                -> i32 bound
+    //   MoveAllAppsToHybridCores           i32 eCores, i32 pCores, u8 mode -> i32 bound
+    //   MoveAppToHybridCores, WatchApp     i32 eCores, i32 pCores, u8 mode, name -> i32 0 or 1
+    //   UnwatchApp, StopAdaptingApp        name
+    //   AdaptApp                           name -> i32 0 or 1
+    //   PlaceAppThreads                    f64 performanceShare, i32 maxPerformanceThreads, name -> i32 placed
+    //   ApplyPlacementPolicy               -> i32 matched
+    //   SampleProcessCpu                   -> i32 processes sampled
+    //   TopProcessCpu                      u16 count -> u16 n, n x (u32 pid, f32 utilization)
+    //   CancelApplies                      stops the bulk apply running on any connection
+    enum class CommandCode : unsigned char
+    {
+        DetectCoreCount = 1,
+        CoreCounts,
+        MoveAllAppsToEfficiencyCores,
+        MoveAllAppsToSomeEfficiencyCores,
+        MoveAllAppsToHybridCores,
+        MoveAppToHybridCores,
+        ResetToDefaultCores,
+        WatchApp,
+        UnwatchApp,
+        AdaptApp,
+        StopAdaptingApp,
+        PlaceAppThreads,
+        ApplyPlacementPolicy,
+        SampleProcessCpu,
+        TopProcessCpu,
+        CancelApplies
+    };
+
+    enum class CommandStatus : unsigned char
+    {
+        Ok,
+        Failed,         // the controller refused, data is empty
+        Cancelled,      // a bulk apply stopped by CancelApplies or superseded before it ran, data holds what it bound
+        UnknownCommand,
+        BadArguments
+    };
+
+    // Frames larger than this close the connection, as the stream can no longer be trusted.
+    const std::size_t maxCommandFrame = 1 << 20;
+    const std::size_t frameHeaderSize = 4;
+
+    // Appends little-endian fields to a frame body.
+    class FrameWriter
+    {
+    public:
+        explicit FrameWriter(std::vector<unsigned char>& buffer) : m_Buffer(buffer) {}
+
+        void U8(unsigned value);
+        void U16(unsigned value);
+        void U32(unsigned long value);
+        void I32(int value);
+        void F32(float value);
+        void F64(double value);
+        void Name(const wchar_t* name);
+        void Bytes(const void* data, std::size_t length);
+
+        std::size_t Size() const { return m_Buffer.size(); }
+        // Overwrites a u16 or u32 written earlier at offset, for lengths known only afterwards.
+        void PatchU16(std::size_t offset, unsigned value);
+        void PatchU32(std::size_t offset, unsigned long value);
+
+    private:
+        std::vector<unsigned char>& m_Buffer;
+    };
+
+    // Reads little-endian fields from a frame body. A read past the end fails and leaves
+    // the reader failed, so a run of reads is checked once at the end.
+    class FrameReader
+    {
+    public:
+        FrameReader(const unsigned char* data, std::size_t length) : m_Data(data), m_Remaining(length) {}
+
+        bool U8(unsigned& value);
+        bool U16(unsigned& value);
+        bool U32(unsigned long& value);
+        bool I32(int& value);
+        bool F32(float& value);
+        bool F64(double& value);
+        bool Name(std::wstring& name);
+        // Returns the next length bytes without copying them.
+        bool Bytes(std::size_t length, const unsigned char*& data);
+
+        bool Ok() const { return !m_Failed; }
+        std::size_t Remaining() const { return m_Remaining; }
+
+    private:
+        bool Take(std::size_t length, const unsigned char*& data);
+
+        const unsigned char* m_Data;
+        std::size_t m_Remaining;
+        bool m_Failed = false;
+    };
+
+    // Client side helpers, for the managed client and load tests. BeginCommandFrame writes
+    // the frame header and request header, and the commands follow, each started with
+    // BeginCommand and finished with EndCommand. EndCommandFrame fills in the lengths.
+    void BeginCommandFrame(std::vector<unsigned char>& frame, unsigned long requestId);
+    std::size_t BeginCommand(FrameWriter& writer, CommandCode code);
+    void EndCommand(FrameWriter& writer, std::size_t command);
+    void EndCommandFrame(std::vector<unsigned char>& frame, unsigned commandCount);
+}
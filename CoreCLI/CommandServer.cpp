@@ -0,0 +1,397 @@
+#include "CommandServer.h"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "CommandTransport.h"
+#include "NativeController.h"
+#include "ProcessCpuSampler.h"
+
+namespace Core
+{
+	// How long the accept thread waits for a client before checking whether it should stop.
+	const unsigned acceptWaitMs = 100;
+
+	// TopProcessCpu entries that fit the u16 data length of a result.
+	const unsigned maxTopEntries = (0xFFFF - 2) / 8;
+
+	// The lock of a server that is the only caller of its controller, still needed as every
+	// connection runs on a thread of its own.
+	class MutexControllerLock : public ControllerLock
+	{
+	public:
+		void Lock() override { m_Mutex.lock(); }
+		void Unlock() override { m_Mutex.unlock(); }
+
+	private:
+		std::mutex m_Mutex;
+	};
+
+	// Takes the controller lock on the first command of a batch that needs it and holds it
+	// until the batch is answered.
+	class BatchLock
+	{
+	public:
+		explicit BatchLock(ControllerLock& lock) : m_Lock(lock) {}
+
+		~BatchLock()
+		{
+			if (m_Held) {
+				m_Lock.Unlock();
+			}
+		}
+
+		void Take()
+		{
+			if (!m_Held) {
+				m_Lock.Lock();
+				m_Held = true;
+			}
+		}
+
+	private:
+		ControllerLock& m_Lock;
+		bool m_Held = false;
+	};
+
+	struct CommandServer::Connection
+	{
+		std::unique_ptr<CommandChannel> channel;
+		std::thread thread;
+		std::atomic<bool> done{ false };
+	};
+
+	struct CommandServer::State
+	{
+		MutexControllerLock ownLock;
+		std::unique_ptr<CommandListener> listener;
+		std::thread acceptThread;
+		std::atomic<bool> running{ false };
+
+		mutable std::mutex mutex;       // guards connections
+		std::list<std::unique_ptr<Connection>> connections;
+
+		// TopProcessCpu output, used under the controller lock
+		std::vector<unsigned long> topPids;
+		std::vector<float> topUtilization;
+	};
+
+	CommandServer::CommandServer(NativeController& controller, RequestQueue& requests, ControllerLock* lock)
+		: m_Controller(controller), m_Lock(lock), m_Requests(requests), m_State(new State())
+	{
+		if (m_Lock == nullptr) {
+			m_Lock = &m_State->ownLock;
+		}
+	}
+
+	CommandServer::~CommandServer()
+	{
+		Stop();
+	}
+
+	bool CommandServer::Start(const wchar_t* name)
+	{
+		return Start(CreateCommandListener(), name);
+	}
+
+	bool CommandServer::Start(std::unique_ptr<CommandListener> listener, const wchar_t* name)
+	{
+		Stop();
+
+		if (!listener || !listener->Listen(name)) {
+			return false;
+		}
+		m_State->listener = std::move(listener);
+		m_State->running = true;
+		m_State->acceptThread = std::thread(&CommandServer::AcceptLoop, this);
+		return true;
+	}
+
+	void CommandServer::Stop()
+	{
+		m_State->running = false;
+		if (m_State->acceptThread.joinable()) {
+			m_State->acceptThread.join();
+		}
+		if (m_State->listener) {
+			m_State->listener->Close();
+			m_State->listener.reset();
+		}
+
+		std::list<std::unique_ptr<Connection>> connections;
+		{
+			std::lock_guard<std::mutex> lock(m_State->mutex);
+			connections.swap(m_State->connections);
+		}
+		for (auto& connection : connections) {
+			connection->channel->Close();
+		}
+		for (auto& connection : connections) {
+			connection->thread.join();
+		}
+	}
+
+	size_t CommandServer::ConnectionCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		return m_State->connections.size();
+	}
+
+	void CommandServer::AcceptLoop()
+	{
+		while (m_State->running) {
+			std::unique_ptr<CommandChannel> channel = m_State->listener->Accept(acceptWaitMs);
+
+			std::lock_guard<std::mutex> lock(m_State->mutex);
+			std::list<std::unique_ptr<Connection>>& connections = m_State->connections;
+			for (auto it = connections.begin(); it != connections.end();) {
+				if ((*it)->done) {
+					(*it)->thread.join();
+					it = connections.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+
+			if (channel) {
+				connections.emplace_back(new Connection());
+				Connection& connection = *connections.back();
+				connection.channel = std::move(channel);
+				connection.thread = std::thread(&CommandServer::Serve, this, std::ref(connection));
+			}
+		}
+	}
+
+	// Reads the requests of one client and answers them in order. A client that sends a
+	// malformed frame or goes away ends the connection and nothing else.
+	void CommandServer::Serve(Connection& connection)
+	{
+		std::vector<unsigned char> body;
+		std::vector<unsigned char> response;
+		while (m_State->running) {
+			unsigned char header[frameHeaderSize];
+			if (!connection.channel->Read(header, sizeof(header))) {
+				break;
+			}
+
+			unsigned long length = 0;
+			FrameReader reader(header, sizeof(header));
+			reader.U32(length);
+			if (length > maxCommandFrame) {
+				break;
+			}
+
+			body.resize(length);
+			if (length > 0 && !connection.channel->Read(body.data(), length)) {
+				break;
+			}
+
+			response.clear();
+			if (!HandleRequest(body.data(), length, response) || !connection.channel->Write(response.data(), response.size())) {
+				break;
+			}
+		}
+		connection.done = true;
+	}
+
+	bool CommandServer::HandleRequest(const unsigned char* body, size_t length, std::vector<unsigned char>& response)
+	{
+		FrameReader request(body, length);
+		unsigned long requestId;
+		unsigned count;
+		if (!request.U32(requestId) || !request.U16(count)) {
+			return false;
+		}
+
+		size_t start = response.size();
+		FrameWriter writer(response);
+		writer.U32(0);
+		writer.U32(requestId);
+		writer.U16(count);
+
+		BatchLock lock(*m_Lock);
+		for (unsigned i = 0; i < count; i++) {
+			unsigned code;
+			unsigned argLength;
+			const unsigned char* args;
+			if (!request.U8(code) || !request.U16(argLength) || !request.Bytes(argLength, args)) {
+				response.resize(start);
+				return false;
+			}
+
+			size_t result = writer.Size();
+			writer.U8(0);
+			writer.U16(0);
+
+			CommandCode command = static_cast<CommandCode>(code);
+			if (command != CommandCode::CancelApplies) {
+				lock.Take();
+			}
+			FrameReader argReader(args, argLength);
+			CommandStatus status = Execute(command, argReader, writer);
+
+			// only results that answer the command carry data
+			if (status != CommandStatus::Ok && status != CommandStatus::Cancelled) {
+				response.resize(result + 3);
+			}
+			response[result] = static_cast<unsigned char>(status);
+			writer.PatchU16(result + 1, static_cast<unsigned>(writer.Size() - result - 3));
+		}
+
+		writer.PatchU32(start, static_cast<unsigned long>(response.size() - start - frameHeaderSize));
+		return true;
+	}
+
+	// Bulk applies go through the request queue so CancelApplies can stop them. The batch
+	// holds the controller lock, so the queue's consumer cannot take the request before the
+	// server does, though a submitter that does not take the lock may supersede it.
+	CommandStatus CommandServer::RunRequest(const ControllerRequest& request, FrameWriter& data)
+	{
+		unsigned long long token = m_Requests.Submit(request);
+
+		ControllerRequest taken;
+		if (!m_Requests.Take(token, taken)) {
+			data.I32(0);
+			return CommandStatus::Cancelled;
+		}
+		int result = ExecuteRequest(m_Controller, taken);
+		bool cancelled = m_Requests.Finish(token) == RequestStatus::Cancelled;
+		data.I32(result);
+		return cancelled ? CommandStatus::Cancelled : CommandStatus::Ok;
+	}
+
+	CommandStatus CommandServer::Execute(CommandCode code, FrameReader& args, FrameWriter& data)
+	{
+		ControllerRequest request;
+		int eCores = 0;
+		int pCores = 0;
+		unsigned mode = 0;
+		std::wstring name;
+
+		switch (code) {
+		case CommandCode::DetectCoreCount:
+		case CommandCode::CoreCounts:
+			if (code == CommandCode::DetectCoreCount) {
+				m_Controller.DetectCoreCount();
+			}
+			data.I32(m_Controller.TotalCoreCount());
+			data.I32(m_Controller.EfficiencyCoreCount());
+			data.I32(m_Controller.PerformanceCoreCount());
+			return CommandStatus::Ok;
+
+		case CommandCode::MoveAllAppsToEfficiencyCores:
+			request.type = RequestType::MoveAllAppsToEfficiencyCores;
+			return RunRequest(request, data);
+
+		case CommandCode::MoveAllAppsToSomeEfficiencyCores:
+			request.type = RequestType::MoveAllAppsToSomeEfficiencyCores;
+			return RunRequest(request, data);
+
+		case CommandCode::ResetToDefaultCores:
+			request.type = RequestType::ResetToDefaultCores;
+			return RunRequest(request, data);
+
+		case CommandCode::ApplyPlacementPolicy:
+			request.type = RequestType::ApplyPlacementPolicy;
+			return RunRequest(request, data);
+
+		case CommandCode::MoveAllAppsToHybridCores:
+			args.I32(eCores);
+			args.I32(pCores);
+			if (!args.U8(mode) || mode > static_cast<unsigned>(PlacementMode::Soft)) {
+				return CommandStatus::BadArguments;
+			}
+			request.type = RequestType::MoveAllAppsToHybridCores;
+			request.eCores = eCores;
+			request.pCores = pCores;
+			request.mode = static_cast<PlacementMode>(mode);
+			return RunRequest(request, data);
+
+		case CommandCode::MoveAppToHybridCores:
+		case CommandCode::WatchApp:
+			args.I32(eCores);
+			args.I32(pCores);
+			args.U8(mode);
+			if (!args.Name(name) || mode > static_cast<unsigned>(PlacementMode::Soft)) {
+				return CommandStatus::BadArguments;
+			}
+			if (code == CommandCode::WatchApp) {
+				data.I32(m_Controller.WatchApp(name.c_str(), eCores, pCores, static_cast<PlacementMode>(mode)) ? 1 : 0);
+			}
+			else {
+				data.I32(m_Controller.MoveAppToHybridCores(name.c_str(), eCores, pCores, static_cast<PlacementMode>(mode)) ? 1 : 0);
+			}
+			return CommandStatus::Ok;
+
+		case CommandCode::UnwatchApp:
+			if (!args.Name(name)) {
+				return CommandStatus::BadArguments;
+			}
+			m_Controller.UnwatchApp(name.c_str());
+			return CommandStatus::Ok;
+
+		case CommandCode::AdaptApp:
+			if (!args.Name(name)) {
+				return CommandStatus::BadArguments;
+			}
+			data.I32(m_Controller.AdaptApp(name.c_str()) ? 1 : 0);
+			return CommandStatus::Ok;
+
+		case CommandCode::StopAdaptingApp:
+			if (!args.Name(name)) {
+				return CommandStatus::BadArguments;
+			}
+			m_Controller.StopAdaptingApp(name.c_str());
+			return CommandStatus::Ok;
+
+		case CommandCode::PlaceAppThreads: {
+			ThreadPlacementPolicy policy;
+			args.F64(policy.performanceShare);
+			args.I32(policy.maxPerformanceThreads);
+			if (!args.Name(name)) {
+				return CommandStatus::BadArguments;
+			}
+			data.I32(m_Controller.PlaceAppThreads(name.c_str(), policy));
+			return CommandStatus::Ok;
+		}
+
+		case CommandCode::SampleProcessCpu:
+			if (!m_Controller.SampleProcessCpu()) {
+				return CommandStatus::Failed;
+			}
+			data.I32(static_cast<int>(m_Controller.ProcessCpu().Count()));
+			return CommandStatus::Ok;
+
+		case CommandCode::TopProcessCpu: {
+			unsigned count;
+			if (!args.U16(count)) {
+				return CommandStatus::BadArguments;
+			}
+			if (count > maxTopEntries) {
+				count = maxTopEntries;
+			}
+
+			m_State->topPids.resize(count);
+			m_State->topUtilization.resize(count);
+			size_t found = count > 0 ? m_Controller.ProcessCpu().Top(count, m_State->topPids.data(), m_State->topUtilization.data()) : 0;
+			data.U16(static_cast<unsigned>(found));
+			for (size_t i = 0; i < found; i++) {
+				data.U32(m_State->topPids[i]);
+				data.F32(m_State->topUtilization[i]);
+			}
+			return CommandStatus::Ok;
+		}
+
+		case CommandCode::CancelApplies:
+			m_Requests.CancelRunning();
+			return CommandStatus::Ok;
+
+		default:
+			return CommandStatus::UnknownCommand;
+		}
+	}
+}
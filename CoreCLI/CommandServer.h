@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "CommandProtocol.h"
+#include "RequestQueue.h"
+
+namespace Core
+{
+    class CommandListener;
+    class NativeController;
+
+    // Serializes the command server's batches with the other callers of the controller.
+    class ControllerLock
+    {
+    public:
+        virtual ~ControllerLock() {}
+
+        virtual void Lock() = 0;
+        virtual void Unlock() = 0;
+    };
+
+    // Serves the binary protocol of CommandProtocol.h to local clients, so callers that
+    // issue many commands skip the text parsing and string marshalling of the managed
+    // pipe. Each connection has a thread of its own that runs its requests in order. A
+    // batch holds the controller lock from its first command to its last, apart from
+    // CancelApplies, which never takes it and so reaches an apply running on another
+    // connection. Bulk applies go through the request queue of the controller's owner, so
+    // they supersede its pending requests and CancelApplies stops whichever apply runs.
+    class CommandServer
+    {
+    public:
+        // requests is the queue every other submitter uses, and lock what its consumer holds
+        // from Take to Finish. lock may be null when the server is the only caller of controller.
+        CommandServer(NativeController& controller, RequestQueue& requests, ControllerLock* lock = nullptr);
+        ~CommandServer();
+
+        CommandServer(const CommandServer&) = delete;
+        CommandServer& operator=(const CommandServer&) = delete;
+
+        // Listens on name with the transport of the platform, see CreateCommandListener.
+        bool Start(const wchar_t* name);
+        bool Start(std::unique_ptr<CommandListener> listener, const wchar_t* name);
+        // Closes every connection after the batch it is running.
+        void Stop();
+        std::size_t ConnectionCount() const;
+
+        // Runs one request body and appends its response frame. False when the body is not a
+        // well-formed request, which ends the connection it came from.
+        bool HandleRequest(const unsigned char* body, std::size_t length, std::vector<unsigned char>& response);
+
+    private:
+        struct Connection;
+        struct State;
+
+        CommandStatus Execute(CommandCode code, FrameReader& args, FrameWriter& data);
+        CommandStatus RunRequest(const ControllerRequest& request, FrameWriter& data);
+        void AcceptLoop();
+        void Serve(Connection& connection);
+
+        NativeController& m_Controller;
+        ControllerLock* m_Lock;
+        RequestQueue& m_Requests;
+        std::unique_ptr<State> m_State;
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+
+namespace Core
+{
+    // One connected client of the command server, a byte stream in both directions.
+    class CommandChannel
+    {
+    public:
+        virtual ~CommandChannel() {}
+
+        // Both block until every byte moved, and fail once the peer is gone or Close was called.
+        virtual bool Read(void* buffer, std::size_t length) = 0;
+        virtual bool Write(const void* data, std::size_t length) = 0;
+        // Safe to call from another thread, and makes a blocked Read or Write fail.
+        virtual void Close() = 0;
+    };
+
+    // Accepts clients on a named endpoint: a pipe name such as \\.\pipe\name on Windows and a
+    // socket path on Linux.
+    class CommandListener
+    {
+    public:
+        virtual ~CommandListener() {}
+
+        virtual bool Listen(const wchar_t* name) = 0;
+        // Null when no client connected within timeoutMs.
+        virtual std::unique_ptr<CommandChannel> Accept(unsigned timeoutMs) = 0;
+        virtual void Close() = 0;
+    };
+
+    // The transport of the platform: named pipes on Windows and Unix-domain sockets on Linux.
+    std::unique_ptr<CommandListener> CreateCommandListener();
+    // Client end of the same transport, null when nobody listens on name.
+    std::unique_ptr<CommandChannel> ConnectCommandChannel(const wchar_t* name);
+}
@@ -0,0 +1,74 @@
+#include "CoreFeatureTable.h"
+
+namespace Core
+{
+	void CoreFeatureTable::Clear()
+	{
+		m_Features.clear();
+		m_Group.clear();
+		m_Index.clear();
+		m_CoreType.clear();
+		m_BaseMhz.clear();
+		m_MaxMhz.clear();
+	}
+
+	void CoreFeatureTable::Reserve(std::size_t cores)
+	{
+		m_Features.reserve(cores);
+		m_Group.reserve(cores);
+		m_Index.reserve(cores);
+		m_CoreType.reserve(cores);
+		m_BaseMhz.reserve(cores);
+		m_MaxMhz.reserve(cores);
+	}
+
+	void CoreFeatureTable::Add(const LogicalCore& core, uint64_t features, unsigned char coreType, unsigned baseMhz, unsigned maxMhz)
+	{
+		features &= ~(FeatureBit(CoreFeature::Efficiency) | FeatureBit(CoreFeature::Performance));
+		m_Features.push_back(features | FeatureBit(core.coreClass));
+		m_Group.push_back(core.group);
+		m_Index.push_back(core.index);
+		m_CoreType.push_back(coreType);
+		m_BaseMhz.push_back(static_cast<unsigned short>(baseMhz));
+		m_MaxMhz.push_back(static_cast<unsigned short>(maxMhz));
+	}
+
+	void CoreFeatureTable::SetFlag(std::size_t core, CoreFeature flag, bool set)
+	{
+		if (core >= m_Features.size()) {
+			return;
+		}
+		m_Features[core] = set ? (m_Features[core] | FeatureBit(flag)) : (m_Features[core] & ~FeatureBit(flag));
+	}
+
+	CpuMask CoreFeatureTable::Select(uint64_t required, uint64_t excluded) const
+	{
+		// branch-free per core, so the scan over the feature words can be vectorized
+		return Collect([&](std::size_t i) {
+			return ((m_Features[i] & required) == required) & ((m_Features[i] & excluded) == 0);
+		});
+	}
+
+	CpuMask CoreFeatureTable::OfCoreType(unsigned char coreType) const
+	{
+		return Collect([&](std::size_t i) { return m_CoreType[i] == coreType; });
+	}
+
+	CpuMask CoreFeatureTable::MaxFrequencyAtLeast(unsigned minimumMhz) const
+	{
+		return Collect([&](std::size_t i) { return m_MaxMhz[i] >= minimumMhz; });
+	}
+
+	uint64_t CoreFeatureTable::CommonFeatures(const CpuMask& mask) const
+	{
+		uint64_t common = ~uint64_t(0);
+		bool any = false;
+		for (std::size_t i = 0; i < m_Features.size(); i++) {
+			if (mask.Test(m_Group[i], m_Index[i])) {
+				common &= m_Features[i];
+				any = true;
+			}
+		}
+		return any ? common : 0;
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CoreTopology.h"
+#include "CpuMask.h"
+
+namespace Core
+{
+    // Bit positions in a core's feature word. The ISA bits follow the declaration order
+    // of the CPUID flags in LOGICAL_PROCESSOR_INFO.
+    enum class CoreFeature : unsigned
+    {
+        SSE, AVX, AVX2, AVX512, AVX512F, AVX512DQ, AVX512PF, AVX512ER, AVX512CD, AVX512BW, AVX512VL,
+        AVX512_IFMA, AVX512_VBMI, AVX512_VBMI2, AVX512_VNNI, AVX512_BITALG, AVX512_VPOPCNTDQ,
+        AVX512_4VNNIW, AVX512_4FMAPS, AVX512_VP2INTERSECT, SGX, SHA,
+
+        // state reported by the OS for the CPU set
+        Parked = 32, Allocated, RealTime,
+
+        // exactly one class bit is set on every core
+        Efficiency = 48, Performance
+    };
+
+    inline uint64_t FeatureBit(CoreFeature feature)
+    {
+        return uint64_t(1) << static_cast<unsigned>(feature);
+    }
+
+    inline uint64_t FeatureBit(CoreClass coreClass)
+    {
+        return FeatureBit(coreClass == CoreClass::Performance ? CoreFeature::Performance : CoreFeature::Efficiency);
+    }
+
+    // Per-logical-processor features in structure-of-arrays form: one feature word per core
+    // with parallel arrays for its position, core type and frequencies. Queries scan the
+    // feature words and return a CpuMask, so a placement is decided by mask arithmetic.
+    class CoreFeatureTable
+    {
+    public:
+        void Clear();
+        void Reserve(std::size_t cores);
+        void Add(const LogicalCore& core, uint64_t features, unsigned char coreType, unsigned baseMhz, unsigned maxMhz);
+
+        // Updates the OS state bits of one core, e.g. after parking changes.
+        void SetFlag(std::size_t core, CoreFeature flag, bool set);
+
+        // Logical processors whose feature word has every bit of required and none of excluded.
+        CpuMask Select(uint64_t required, uint64_t excluded = 0) const;
+
+        // Logical processors of a core type as reported by CPUID leaf 0x1A.
+        CpuMask OfCoreType(unsigned char coreType) const;
+
+        // Logical processors whose maximum frequency is at least minimumMhz.
+        CpuMask MaxFrequencyAtLeast(unsigned minimumMhz) const;
+
+        // Features every logical processor in mask has, 0 for an empty mask.
+        uint64_t CommonFeatures(const CpuMask& mask) const;
+
+        std::size_t Size() const { return m_Features.size(); }
+        uint64_t Features(std::size_t core) const { return m_Features[core]; }
+
+    private:
+        // Builds the mask of cores for which match(i) is 1, one group word at a time.
+        template <typename Match>
+        CpuMask Collect(Match match) const
+        {
+            std::array<uint64_t, CpuMask::MaxGroups> words = {};
+            for (std::size_t i = 0; i < m_Features.size(); i++) {
+                words[m_Group[i] % CpuMask::MaxGroups] |= uint64_t(match(i)) << m_Index[i];
+            }
+
+            CpuMask mask;
+            for (unsigned group = 0; group < CpuMask::MaxGroups; group++) {
+                mask.SetGroup(group, words[group]);
+            }
+            return mask;
+        }
+
+        std::vector<uint64_t> m_Features;
+        std::vector<unsigned short> m_Group;
+        std::vector<unsigned char> m_Index;
+        std::vector<unsigned char> m_CoreType;
+        std::vector<unsigned short> m_BaseMhz;
+        std::vector<unsigned short> m_MaxMhz;
+    };
+}
@@ -0,0 +1,88 @@
+#include "CoreTopology.h"
+
+#include <algorithm>
+
+namespace Core
+{
+	void CoreTopology::Build(const std::vector<LogicalCore>& logicalCores)
+	{
+		m_LogicalCores = logicalCores;
+		m_ECoreMasks.clear();
+		m_PCoreMasks.clear();
+		m_Masks.clear();
+		m_ECpuSets.clear();
+		m_PCpuSets.clear();
+		m_AllMask.Clear();
+		m_GroupCount = 0;
+
+		// Order logical processors by physical core so that SMT siblings sit next to each other
+		std::vector<const LogicalCore*> ordered;
+		ordered.reserve(m_LogicalCores.size());
+		for (const LogicalCore& core : m_LogicalCores) {
+			ordered.push_back(&core);
+		}
+		std::stable_sort(ordered.begin(), ordered.end(), [](const LogicalCore* a, const LogicalCore* b) {
+			if (a->group != b->group) {
+				return a->group < b->group;
+			}
+			return a->coreIndex < b->coreIndex;
+		});
+
+		const LogicalCore* previous = nullptr;
+		for (const LogicalCore* core : ordered) {
+			bool samePhysicalCore = previous != nullptr
+				&& previous->group == core->group
+				&& previous->coreIndex == core->coreIndex
+				&& previous->coreClass == core->coreClass;
+
+			std::vector<CpuMask>& coreMasks = core->coreClass == CoreClass::Performance ? m_PCoreMasks : m_ECoreMasks;
+			if (!samePhysicalCore) {
+				coreMasks.push_back(CpuMask());
+			}
+			coreMasks.back().Set(core->group, core->index);
+			(core->coreClass == CoreClass::Performance ? m_PCpuSets : m_ECpuSets).push_back(core->cpuSetId);
+			m_AllMask.Set(core->group, core->index);
+
+			if (core->group + 1u > m_GroupCount) {
+				m_GroupCount = core->group + 1u;
+			}
+			previous = core;
+		}
+
+		// Each entry extends its neighbour by one physical core
+		int eCount = EfficiencyCoreCount();
+		int pCount = PerformanceCoreCount();
+		m_Masks.resize((eCount + 1) * (pCount + 1));
+		for (int e = 0; e <= eCount; e++) {
+			for (int p = 0; p <= pCount; p++) {
+				CpuMask& mask = m_Masks[e * (pCount + 1) + p];
+				if (p > 0) {
+					mask = m_Masks[e * (pCount + 1) + p - 1] | m_PCoreMasks[p - 1];
+				}
+				else if (e > 0) {
+					mask = m_Masks[(e - 1) * (pCount + 1)] | m_ECoreMasks[e - 1];
+				}
+			}
+		}
+	}
+
+	void CoreTopology::CpuSets(const CpuMask& mask, std::vector<unsigned long>& cpuSets) const
+	{
+		cpuSets.clear();
+		for (const LogicalCore& core : m_LogicalCores) {
+			if (mask.Test(core.group, core.index)) {
+				cpuSets.push_back(core.cpuSetId);
+			}
+		}
+	}
+
+	const CpuMask& CoreTopology::Mask(int eCores, int pCores) const
+	{
+		int eCount = EfficiencyCoreCount();
+		int pCount = PerformanceCoreCount();
+		if (eCores < 0 || pCores < 0 || eCores > eCount || pCores > pCount) {
+			return m_EmptyMask;
+		}
+		return m_Masks[eCores * (pCount + 1) + pCores];
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+
+#include "CpuMask.h"
+
+namespace Core
+{
+    enum class CoreClass : unsigned char
+    {
+        Efficiency,
+        Performance
+    };
+
+    // One logical processor as reported by the OS.
+    struct LogicalCore
+    {
+        unsigned short group = 0;
+        unsigned char index = 0;            // processor number within its group
+        unsigned char coreIndex = 0;        // group-relative index of the physical core
+        unsigned char efficiencyClass = 0;  // higher is more performant
+        CoreClass coreClass = CoreClass::Performance;
+        unsigned long cpuSetId = 0;         // CPU set ID on Windows, CPU number on Linux
+    };
+
+    // Physical cores grouped by class, built from per-logical-processor data rather
+    // than from assumptions about enumeration order or SMT. The mask for every
+    // "N P-cores, M E-cores" combination is computed once when the topology is built.
+    class CoreTopology
+    {
+    public:
+        void Build(const std::vector<LogicalCore>& logicalCores);
+
+        int LogicalCoreCount() const { return static_cast<int>(m_LogicalCores.size()); }
+        int PerformanceCoreCount() const { return static_cast<int>(m_PCoreMasks.size()); }
+        int EfficiencyCoreCount() const { return static_cast<int>(m_ECoreMasks.size()); }
+        unsigned GroupCount() const { return m_GroupCount; }
+
+        // Mask covering every logical processor of the first eCores E-cores and the
+        // first pCores P-cores. Returns an empty mask when a count is out of range.
+        const CpuMask& Mask(int eCores, int pCores) const;
+
+        const CpuMask& AllMask() const { return m_AllMask; }
+        const CpuMask& EfficiencyMask() const { return Mask(EfficiencyCoreCount(), 0); }
+        const CpuMask& PerformanceMask() const { return Mask(0, PerformanceCoreCount()); }
+
+        const std::vector<LogicalCore>& LogicalCores() const { return m_LogicalCores; }
+
+        // CPU set IDs of every logical processor of a class, for thread-level placement.
+        const std::vector<unsigned long>& CpuSets(CoreClass coreClass) const
+        {
+            return coreClass == CoreClass::Performance ? m_PCpuSets : m_ECpuSets;
+        }
+
+        // CPU set IDs of the logical processors in mask.
+        void CpuSets(const CpuMask& mask, std::vector<unsigned long>& cpuSets) const;
+
+    private:
+        std::vector<LogicalCore> m_LogicalCores;
+        std::vector<CpuMask> m_ECoreMasks;      // logical processors of each E-core
+        std::vector<CpuMask> m_PCoreMasks;      // logical processors of each P-core
+        std::vector<CpuMask> m_Masks;           // (E + 1) x (P + 1) table indexed by [e][p]
+        std::vector<unsigned long> m_ECpuSets;
+        std::vector<unsigned long> m_PCpuSets;
+        CpuMask m_AllMask;
+        CpuMask m_EmptyMask;
+        unsigned m_GroupCount = 0;
+    };
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Core
+{
+    inline unsigned PopCount64(uint64_t bits)
+    {
+#ifdef _MSC_VER
+        return static_cast<unsigned>(__popcnt64(bits));
+#else
+        return static_cast<unsigned>(__builtin_popcountll(bits));
+#endif
+    }
+
+    // Affinity mask over every logical processor in the system, stored as one
+    // 64-bit word per processor group. Windows places at most 64 logical
+    // processors in a group, so (group, index) addresses every processor.
+    class CpuMask
+    {
+    public:
+        enum : unsigned { MaxGroups = 32, BitsPerGroup = 64 };
+
+        CpuMask() : m_Words(), m_Used(0) {}
+
+        static CpuMask FromGroup(unsigned group, uint64_t bits)
+        {
+            CpuMask mask;
+            mask.SetGroup(group, bits);
+            return mask;
+        }
+
+        void Set(unsigned group, unsigned index)
+        {
+            if (group >= MaxGroups || index >= BitsPerGroup) return;
+            m_Words[group] |= uint64_t(1) << index;
+            if (group >= m_Used) m_Used = group + 1;
+        }
+
+        void Reset(unsigned group, unsigned index)
+        {
+            if (group >= MaxGroups || index >= BitsPerGroup) return;
+            m_Words[group] &= ~(uint64_t(1) << index);
+        }
+
+        bool Test(unsigned group, unsigned index) const
+        {
+            if (group >= m_Used || index >= BitsPerGroup) return false;
+            return (m_Words[group] >> index) & 1;
+        }
+
+        uint64_t Group(unsigned group) const
+        {
+            return group < m_Used ? m_Words[group] : 0;
+        }
+
+        void SetGroup(unsigned group, uint64_t bits)
+        {
+            if (group >= MaxGroups) return;
+            m_Words[group] = bits;
+            if (bits && group >= m_Used) m_Used = group + 1;
+        }
+
+        // One past the highest group that may hold a set bit.
+        unsigned GroupSpan() const { return m_Used; }
+
+        unsigned Count() const
+        {
+            unsigned count = 0;
+            for (unsigned g = 0; g < m_Used; g++) count += PopCount64(m_Words[g]);
+            return count;
+        }
+
+        bool Empty() const
+        {
+            for (unsigned g = 0; g < m_Used; g++) if (m_Words[g]) return false;
+            return true;
+        }
+
+        // Number of groups with at least one processor set.
+        unsigned GroupCount() const
+        {
+            unsigned count = 0;
+            for (unsigned g = 0; g < m_Used; g++) if (m_Words[g]) count++;
+            return count;
+        }
+
+        // Index of the only group with processors set, or -1 when empty or spanning groups.
+        int SingleGroup() const
+        {
+            int found = -1;
+            for (unsigned g = 0; g < m_Used; g++) {
+                if (!m_Words[g]) continue;
+                if (found != -1) return -1;
+                found = static_cast<int>(g);
+            }
+            return found;
+        }
+
+        void Clear()
+        {
+            for (unsigned g = 0; g < m_Used; g++) m_Words[g] = 0;
+            m_Used = 0;
+        }
+
+        CpuMask& operator|=(const CpuMask& other)
+        {
+            for (unsigned g = 0; g < other.m_Used; g++) m_Words[g] |= other.m_Words[g];
+            if (other.m_Used > m_Used) m_Used = other.m_Used;
+            return *this;
+        }
+
+        CpuMask& operator&=(const CpuMask& other)
+        {
+            for (unsigned g = 0; g < m_Used; g++) m_Words[g] &= other.Group(g);
+            return *this;
+        }
+
+        // Removes every processor that is set in other.
+        CpuMask& Subtract(const CpuMask& other)
+        {
+            unsigned span = m_Used < other.m_Used ? m_Used : other.m_Used;
+            for (unsigned g = 0; g < span; g++) m_Words[g] &= ~other.m_Words[g];
+            return *this;
+        }
+
+        friend CpuMask operator|(CpuMask a, const CpuMask& b) { return a |= b; }
+        friend CpuMask operator&(CpuMask a, const CpuMask& b) { return a &= b; }
+
+        bool operator==(const CpuMask& other) const
+        {
+            unsigned span = m_Used > other.m_Used ? m_Used : other.m_Used;
+            for (unsigned g = 0; g < span; g++) {
+                if (Group(g) != other.Group(g)) return false;
+            }
+            return true;
+        }
+
+        bool operator!=(const CpuMask& other) const { return !(*this == other); }
+
+    private:
+        std::array<uint64_t, MaxGroups> m_Words;
+        unsigned m_Used;
+    };
+}
@@ -0,0 +1,101 @@
+#ifdef __linux__
+
+#include "FrequencySource.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+
+namespace Core
+{
+	// Reads an unsigned decimal value from the start of an open sysfs attribute.
+	bool ReadSysfsValue(int fd, unsigned long& value)
+	{
+		char buffer[32];
+		ssize_t length = pread(fd, buffer, sizeof(buffer), 0);
+		if (length <= 0) {
+			return false;
+		}
+
+		value = 0;
+		for (ssize_t i = 0; i < length && buffer[i] >= '0' && buffer[i] <= '9'; i++) {
+			value = value * 10 + (buffer[i] - '0');
+		}
+		return true;
+	}
+
+	// cpufreq scaling attributes, kept open so a read is one pread per attribute and core.
+	// cpufreq does not expose the current idle state, it always reads as 0.
+	class CpufreqFrequencySource : public FrequencySource
+	{
+	public:
+		CpufreqFrequencySource();
+		~CpufreqFrequencySource() override;
+
+		unsigned CoreCount() const override;
+		bool Read(unsigned* currentMhz, unsigned* mhzLimit, unsigned* idleState) override;
+
+	private:
+		std::vector<int> m_CurrentFiles;
+		std::vector<int> m_LimitFiles;
+	};
+
+	int OpenCpufreqAttribute(unsigned cpu, const char* attribute)
+	{
+		char path[128];
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpufreq/%s", cpu, attribute);
+		return open(path, O_RDONLY | O_CLOEXEC);
+	}
+
+	CpufreqFrequencySource::CpufreqFrequencySource()
+	{
+		long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+		for (long cpu = 0; cpu < cpuCount; cpu++) {
+			m_CurrentFiles.push_back(OpenCpufreqAttribute(static_cast<unsigned>(cpu), "scaling_cur_freq"));
+			m_LimitFiles.push_back(OpenCpufreqAttribute(static_cast<unsigned>(cpu), "scaling_max_freq"));
+		}
+	}
+
+	CpufreqFrequencySource::~CpufreqFrequencySource()
+	{
+		for (size_t i = 0; i < m_CurrentFiles.size(); i++) {
+			if (m_CurrentFiles[i] >= 0) {
+				close(m_CurrentFiles[i]);
+			}
+			if (m_LimitFiles[i] >= 0) {
+				close(m_LimitFiles[i]);
+			}
+		}
+	}
+
+	unsigned CpufreqFrequencySource::CoreCount() const
+	{
+		return static_cast<unsigned>(m_CurrentFiles.size());
+	}
+
+	bool CpufreqFrequencySource::Read(unsigned* currentMhz, unsigned* mhzLimit, unsigned* idleState)
+	{
+		bool anyRead = false;
+		for (size_t i = 0; i < m_CurrentFiles.size(); i++) {
+			// offline processors and those without a cpufreq driver read as 0
+			unsigned long currentKhz = 0, limitKhz = 0;
+			if (m_CurrentFiles[i] >= 0 && ReadSysfsValue(m_CurrentFiles[i], currentKhz)) {
+				anyRead = true;
+			}
+			if (m_LimitFiles[i] >= 0) {
+				ReadSysfsValue(m_LimitFiles[i], limitKhz);
+			}
+			currentMhz[i] = static_cast<unsigned>(currentKhz / 1000);
+			mhzLimit[i] = static_cast<unsigned>(limitKhz / 1000);
+			idleState[i] = 0;
+		}
+		return anyRead;
+	}
+
+	std::unique_ptr<FrequencySource> CreateFrequencySource()
+	{
+		return std::unique_ptr<FrequencySource>(new CpufreqFrequencySource());
+	}
+}
+
+#endif
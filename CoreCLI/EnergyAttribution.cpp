@@ -0,0 +1,42 @@
+#include "EnergyAttribution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Core
+{
+	void EnergyAttributor::SetCoefficients(const EnergyCoefficients& coefficients)
+	{
+		m_Coefficients = coefficients;
+	}
+
+	void EnergyAttributor::Attribute(const EnergyInterval& interval, std::size_t count, const unsigned long* pids,
+		const float* cores, const float* eShare)
+	{
+		m_Pids.assign(pids, pids + count);
+		m_Joules.resize(count);
+		m_ModelJoules = 0;
+		m_AttributedJoules = 0;
+
+		// joules per core-second on each class, the same for every process in the interval
+		double eJoules = m_Coefficients.eCoreWatts * std::pow(interval.eCoreMhz / 1000.0, m_Coefficients.exponent) * interval.seconds;
+		double pJoules = m_Coefficients.pCoreWatts * std::pow(interval.pCoreMhz / 1000.0, m_Coefficients.exponent) * interval.seconds;
+
+		for (std::size_t i = 0; i < count; i++) {
+			double joules = cores[i] * (eShare[i] * eJoules + (1.0 - eShare[i]) * pJoules);
+			m_Joules[i] = static_cast<float>(joules);
+			m_ModelJoules += joules;
+		}
+
+		double scale = 1.0;
+		if (interval.packageJoules >= 0 && m_ModelJoules > 0) {
+			double attributable = std::max(0.0, interval.packageJoules - m_Coefficients.baseWatts * interval.seconds);
+			scale = attributable / m_ModelJoules;
+		}
+
+		for (std::size_t i = 0; i < count; i++) {
+			m_Joules[i] = static_cast<float>(m_Joules[i] * scale);
+		}
+		m_AttributedJoules = m_ModelJoules * scale;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace Core
+{
+    // Calibration of the per-process energy model. A busy logical processor draws
+    // coreWatts * GHz^exponent, and baseWatts of the package is not attributed to any process.
+    struct EnergyCoefficients
+    {
+        double eCoreWatts = 0.5;
+        double pCoreWatts = 1.5;
+        double exponent = 2.0;
+        double baseWatts = 3.0;
+    };
+
+    // What was measured over one attribution interval.
+    struct EnergyInterval
+    {
+        double seconds = 0;
+        double eCoreMhz = 0;            // mean current frequency of each class
+        double pCoreMhz = 0;
+        double packageJoules = -1;      // measured package energy, negative when not known
+    };
+
+    // Estimates the energy each process used over an interval from its CPU use on each core
+    // class. Without a package measurement the model's joules are reported as they are. With
+    // one, they are scaled so that together they account for the package energy above
+    // baseWatts, which absorbs calibration error. Results are parallel arrays reused between
+    // intervals, so attribution does not allocate once they have grown.
+    class EnergyAttributor
+    {
+    public:
+        void SetCoefficients(const EnergyCoefficients& coefficients);
+        const EnergyCoefficients& Coefficients() const { return m_Coefficients; }
+
+        // cores[i] is the use of process i in cores, eShare[i] the part of it on E-cores.
+        void Attribute(const EnergyInterval& interval, std::size_t count, const unsigned long* pids,
+            const float* cores, const float* eShare);
+
+        std::size_t Count() const { return m_Pids.size(); }
+        const unsigned long* Pids() const { return m_Pids.data(); }
+        const float* Joules() const { return m_Joules.data(); }
+
+        // Sum of the model's estimates before scaling, and of the joules attributed.
+        double ModelJoules() const { return m_ModelJoules; }
+        double AttributedJoules() const { return m_AttributedJoules; }
+
+    private:
+        EnergyCoefficients m_Coefficients;
+        std::vector<unsigned long> m_Pids;
+        std::vector<float> m_Joules;
+        double m_ModelJoules = 0;
+        double m_AttributedJoules = 0;
+    };
+}
@@ -0,0 +1,112 @@
+#include "EnergyCounterSource.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace Core
+{
+#ifdef _WIN32
+	std::unique_ptr<EnergyCounterSource> CreateEnergyCounterSource()
+	{
+		return std::unique_ptr<EnergyCounterSource>();
+	}
+#endif
+
+	bool PlatformHasEnergyCounters()
+	{
+#ifdef _WIN32
+		return false;
+#else
+		return true;
+#endif
+	}
+
+	void ReplayEnergySource::AddDomain(const std::string& name, unsigned long long range)
+	{
+		m_Names.push_back(name);
+		m_Ranges.push_back(range);
+	}
+
+	void ReplayEnergySource::AddFrame(unsigned long long timestampUs, const std::vector<unsigned long long>& microjoules)
+	{
+		// missing domains read as 0
+		std::size_t frame = m_Frames.size();
+		m_Frames.resize(frame + 1 + m_Names.size(), 0);
+		m_Frames[frame] = timestampUs;
+		std::copy_n(microjoules.begin(), std::min(microjoules.size(), m_Names.size()), m_Frames.begin() + frame + 1);
+	}
+
+	void ReplayEnergySource::Rewind()
+	{
+		m_Next = 0;
+	}
+
+	bool ReplayEnergySource::Load(const char* path)
+	{
+		std::ifstream file(path);
+		std::string line;
+		if (!file || !std::getline(file, line)) {
+			return false;
+		}
+
+		m_Names.clear();
+		m_Ranges.clear();
+		m_Frames.clear();
+		m_Next = 0;
+
+		std::istringstream header(line);
+		std::string name;
+		unsigned long long range = 0;
+		while (header >> name >> range) {
+			AddDomain(name, range);
+		}
+		if (m_Names.empty()) {
+			return false;
+		}
+
+		std::vector<unsigned long long> counters(m_Names.size());
+		while (std::getline(file, line)) {
+			std::istringstream fields(line);
+			unsigned long long timestampUs = 0;
+			if (!(fields >> timestampUs)) {
+				continue;
+			}
+			for (unsigned long long& counter : counters) {
+				counter = 0;
+				fields >> counter;
+			}
+			AddFrame(timestampUs, counters);
+		}
+		return true;
+	}
+
+	unsigned ReplayEnergySource::DomainCount() const
+	{
+		return static_cast<unsigned>(m_Names.size());
+	}
+
+	const char* ReplayEnergySource::DomainName(unsigned domain) const
+	{
+		return m_Names[domain].c_str();
+	}
+
+	unsigned long long ReplayEnergySource::Range(unsigned domain) const
+	{
+		return m_Ranges[domain];
+	}
+
+	bool ReplayEnergySource::Read(unsigned long long& timestampUs, unsigned long long* microjoules)
+	{
+		std::size_t frameSize = 1 + m_Names.size();
+		if ((m_Next + 1) * frameSize > m_Frames.size()) {
+			return false;
+		}
+
+		const unsigned long long* frame = m_Frames.data() + m_Next * frameSize;
+		timestampUs = frame[0];
+		std::copy_n(frame + 1, m_Names.size(), microjoules);
+		m_Next++;
+		return true;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Core
+{
+    // Reads the raw energy counters of the power domains of the system (package, cores,
+    // uncore, DRAM and so on) into a caller array of DomainCount() entries, in microjoules.
+    // Counters wrap around at Range(domain). Implementations must not allocate in Read, it
+    // runs at sampling rates of 100 Hz and more.
+    class EnergyCounterSource
+    {
+    public:
+        virtual ~EnergyCounterSource() {}
+
+        virtual unsigned DomainCount() const = 0;
+        virtual const char* DomainName(unsigned domain) const = 0;
+        virtual unsigned long long Range(unsigned domain) const = 0;
+
+        // timestampUs is on the steady clock for live sources and recorded for replays.
+        virtual bool Read(unsigned long long& timestampUs, unsigned long long* microjoules) = 0;
+    };
+
+    // The native source of the platform, or null when it has none. On Linux this is the
+    // powercap RAPL zones, falling back to the RAPL MSRs. Windows only exposes RAPL through
+    // kernel drivers, so there is no source and package power has to be measured elsewhere.
+    std::unique_ptr<EnergyCounterSource> CreateEnergyCounterSource();
+    // False when the platform has no source at all, so CreateEnergyCounterSource always returns null.
+    bool PlatformHasEnergyCounters();
+
+#ifdef __linux__
+    // Each source is null when its interface is missing or not readable.
+    std::unique_ptr<EnergyCounterSource> CreatePowercapEnergySource();
+    std::unique_ptr<EnergyCounterSource> CreateMsrEnergySource();
+#endif
+
+    // Plays back recorded counter frames in order, for tests and offline analysis.
+    class ReplayEnergySource : public EnergyCounterSource
+    {
+    public:
+        void AddDomain(const std::string& name, unsigned long long range);
+        // One counter per domain, in microjoules.
+        void AddFrame(unsigned long long timestampUs, const std::vector<unsigned long long>& microjoules);
+        void Rewind();
+
+        // Reads a recording: a header line of "name range" pairs, then one line per frame of
+        // the timestamp in microseconds followed by each domain's counter.
+        bool Load(const char* path);
+
+        unsigned DomainCount() const override;
+        const char* DomainName(unsigned domain) const override;
+        unsigned long long Range(unsigned domain) const override;
+
+        // Fails once every frame has been played.
+        bool Read(unsigned long long& timestampUs, unsigned long long* microjoules) override;
+
+    private:
+        std::vector<std::string> m_Names;
+        std::vector<unsigned long long> m_Ranges;
+        std::vector<unsigned long long> m_Frames;   // timestamp then one counter per domain
+        std::size_t m_Next = 0;
+    };
+}
@@ -0,0 +1,165 @@
+#include "EnergySampler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace Core
+{
+	const unsigned EnergySampler::MaxDomains;
+
+	struct EnergySampler::Ring
+	{
+		std::vector<Slot> slots;
+		std::atomic<unsigned long long> head{ 0 };     // samples written
+		std::atomic<unsigned long long> tail{ 0 };     // samples consumed
+		std::atomic<unsigned long long> dropped{ 0 };
+		std::atomic<bool> running{ false };
+		std::thread thread;
+	};
+
+	EnergySampler::EnergySampler(std::unique_ptr<EnergyCounterSource> source, std::size_t capacity)
+		: m_Source(std::move(source)), m_Ring(new Ring())
+	{
+		m_DomainCount = m_Source ? std::min(m_Source->DomainCount(), MaxDomains) : 0;
+		m_Counters.resize(m_Source ? m_Source->DomainCount() : 0);
+		m_Ring->slots.resize(std::max<std::size_t>(capacity, 2));
+	}
+
+	EnergySampler::~EnergySampler()
+	{
+		Stop();
+	}
+
+	bool EnergySampler::Start(unsigned rateHz)
+	{
+		Stop();
+		if (m_DomainCount == 0 || rateHz == 0) {
+			return false;
+		}
+
+		m_Ring->running = true;
+		m_Ring->thread = std::thread(&EnergySampler::SampleLoop, this, rateHz);
+		return true;
+	}
+
+	void EnergySampler::Stop()
+	{
+		m_Ring->running = false;
+		if (m_Ring->thread.joinable()) {
+			m_Ring->thread.join();
+		}
+	}
+
+	bool EnergySampler::Running() const
+	{
+		return m_Ring->running;
+	}
+
+	// Sleeps to fixed deadlines so the rate does not drift by the time each read takes.
+	void EnergySampler::SampleLoop(unsigned rateHz)
+	{
+		auto period = std::chrono::microseconds(1000000 / rateHz);
+		auto next = std::chrono::steady_clock::now();
+		while (m_Ring->running) {
+			Sample();
+			next += period;
+			auto now = std::chrono::steady_clock::now();
+			if (next < now) {
+				// fell behind, skip the missed deadlines rather than sampling in a burst
+				next = now;
+			}
+			std::this_thread::sleep_until(next);
+		}
+	}
+
+	bool EnergySampler::Sample()
+	{
+		if (m_DomainCount == 0) {
+			return false;
+		}
+
+		unsigned long long timestampUs = 0;
+		if (!m_Source->Read(timestampUs, m_Counters.data())) {
+			return false;
+		}
+		const unsigned long long* counters = m_Counters.data();
+
+		for (unsigned d = 0; d < m_DomainCount; d++) {
+			if (m_Primed) {
+				// a counter below the previous one has wrapped, at most once per sample at these rates
+				unsigned long long range = m_Source->Range(d);
+				m_Unwrapped[d] += counters[d] >= m_Raw[d] ? counters[d] - m_Raw[d] : counters[d] + range - m_Raw[d];
+			}
+			m_Raw[d] = counters[d];
+		}
+		m_Primed = true;
+
+		unsigned long long head = m_Ring->head.load(std::memory_order_relaxed);
+		if (head - m_Ring->tail.load(std::memory_order_acquire) >= m_Ring->slots.size()) {
+			m_Ring->dropped.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		Slot& slot = m_Ring->slots[head % m_Ring->slots.size()];
+		slot.timestampUs = timestampUs;
+		std::copy_n(m_Unwrapped, m_DomainCount, slot.microjoules);
+		m_Ring->head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::size_t EnergySampler::Update()
+	{
+		unsigned long long tail = m_Ring->tail.load(std::memory_order_relaxed);
+		unsigned long long head = m_Ring->head.load(std::memory_order_acquire);
+		if (head == tail) {
+			return 0;
+		}
+
+		// only the newest sample matters for the totals, the others are skipped over
+		const Slot& newest = m_Ring->slots[(head - 1) % m_Ring->slots.size()];
+		Slot previous = m_HasLatest ? m_Latest : m_Ring->slots[tail % m_Ring->slots.size()];
+		m_Latest = newest;
+		m_Ring->tail.store(head, std::memory_order_release);
+
+		if (m_Latest.timestampUs > previous.timestampUs) {
+			double seconds = (m_Latest.timestampUs - previous.timestampUs) / 1000000.0;
+			for (unsigned d = 0; d < m_DomainCount; d++) {
+				m_Watts[d] = (m_Latest.microjoules[d] - previous.microjoules[d]) / 1000000.0 / seconds;
+			}
+		}
+		m_HasLatest = true;
+		return static_cast<std::size_t>(head - tail);
+	}
+
+	unsigned EnergySampler::DomainCount() const
+	{
+		return m_DomainCount;
+	}
+
+	const char* EnergySampler::DomainName(unsigned domain) const
+	{
+		return m_Source->DomainName(domain);
+	}
+
+	double EnergySampler::Joules(unsigned domain) const
+	{
+		return m_HasLatest ? m_Latest.microjoules[domain] / 1000000.0 : 0;
+	}
+
+	double EnergySampler::Watts(unsigned domain) const
+	{
+		return m_Watts[domain];
+	}
+
+	unsigned long long EnergySampler::LastTimestampUs() const
+	{
+		return m_Latest.timestampUs;
+	}
+
+	unsigned long long EnergySampler::Dropped() const
+	{
+		return m_Ring->dropped.load(std::memory_order_relaxed);
+	}
+}
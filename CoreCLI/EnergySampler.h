@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "EnergyCounterSource.h"
+
+namespace Core
+{
+    // Samples an EnergyCounterSource at a high rate, on a thread of its own, into a
+    // single-producer single-consumer ring. The sampling thread unwraps the counters into
+    // cumulative microjoules, so a wrap between two samples is never lost. The consumer
+    // moves samples out of the ring with Update, which never blocks the sampling thread.
+    // Storage is allocated once. Producer and consumer must each be a single thread.
+    class EnergySampler
+    {
+    public:
+        static const unsigned MaxDomains = 8;
+
+        EnergySampler(std::unique_ptr<EnergyCounterSource> source, std::size_t capacity = 4096);
+        ~EnergySampler();
+
+        EnergySampler(const EnergySampler&) = delete;
+        EnergySampler& operator=(const EnergySampler&) = delete;
+
+        bool Start(unsigned rateHz);
+        void Stop();
+        bool Running() const;
+
+        // Takes one sample on the calling thread, for replays and for callers without the thread.
+        bool Sample();
+
+        // Consumes every sample in the ring. Returns the number consumed.
+        std::size_t Update();
+
+        // Domains beyond MaxDomains are not sampled.
+        unsigned DomainCount() const;
+        const char* DomainName(unsigned domain) const;
+
+        // Energy since the first sample, and mean power between the samples consumed by the
+        // previous Update and this one. Both keep their values when no new samples arrived.
+        double Joules(unsigned domain) const;
+        double Watts(unsigned domain) const;
+        unsigned long long LastTimestampUs() const;
+
+        // Samples lost because the consumer fell a whole ring behind.
+        unsigned long long Dropped() const;
+
+    private:
+        struct Slot
+        {
+            unsigned long long timestampUs = 0;
+            unsigned long long microjoules[MaxDomains] = {};
+        };
+        struct Ring;
+
+        void SampleLoop(unsigned rateHz);
+
+        std::unique_ptr<EnergyCounterSource> m_Source;
+        unsigned m_DomainCount;
+        std::unique_ptr<Ring> m_Ring;
+
+        // producer state
+        std::vector<unsigned long long> m_Counters;     // every domain of the source
+        unsigned long long m_Raw[MaxDomains] = {};
+        unsigned long long m_Unwrapped[MaxDomains] = {};
+        bool m_Primed = false;
+
+        // consumer state
+        Slot m_Latest;
+        double m_Watts[MaxDomains] = {};
+        bool m_HasLatest = false;
+    };
+}
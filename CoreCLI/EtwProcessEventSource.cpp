@@ -0,0 +1,197 @@
+#include "ProcessEventSource.h"
+#include "ProcessEventQueue.h"
+
+#include <windows.h>
+#include <evntrace.h>
+#include <evntcons.h>
+#include <tdh.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#pragma comment(lib, "advapi32.lib")
+#pragma comment(lib, "tdh.lib")
+
+namespace Core
+{
+	// Microsoft-Windows-Kernel-Process
+	const GUID kernelProcessProvider = { 0x22fb2cd6, 0x0e7b, 0x422b, { 0xa0, 0xc7, 0x2f, 0xad, 0x1f, 0xd0, 0xe7, 0x16 } };
+	const ULONGLONG processKeyword = 0x10;
+	const USHORT processStartEvent = 1;
+	const USHORT processStopEvent = 2;
+
+	const wchar_t sessionName[] = L"EnergyPerformance-ProcessEvents";
+
+	// Real-time sessions only deliver events when a buffer is flushed, keep the wait short.
+	const ULONG flushIntervalMs = 10;
+
+	// Real-time ETW session on the kernel process provider.
+	class EtwProcessEventSource : public ProcessEventSource
+	{
+	public:
+		~EtwProcessEventSource() override;
+
+		bool Start(ProcessEventQueue& queue) override;
+		void Stop() override;
+
+	private:
+		static void WINAPI OnEvent(PEVENT_RECORD record);
+		void HandleEvent(PEVENT_RECORD record);
+		EVENT_TRACE_PROPERTIES* ResetProperties();
+		void StopSession();
+
+		ProcessEventQueue* m_Queue = nullptr;
+		TRACEHANDLE m_Session = 0;
+		TRACEHANDLE m_Trace = INVALID_PROCESSTRACE_HANDLE;
+		std::vector<unsigned char> m_Properties;
+		std::thread m_Thread;
+	};
+
+	bool ReadProperty(PEVENT_RECORD record, const wchar_t* name, void* buffer, ULONG bufferSize, ULONG& size) {
+		PROPERTY_DATA_DESCRIPTOR descriptor = {};
+		descriptor.PropertyName = reinterpret_cast<ULONGLONG>(name);
+		descriptor.ArrayIndex = ULONG_MAX;
+
+		if (TdhGetPropertySize(record, 0, NULL, 1, &descriptor, &size) != ERROR_SUCCESS || size > bufferSize) {
+			return false;
+		}
+		return TdhGetProperty(record, 0, NULL, 1, &descriptor, size, static_cast<PBYTE>(buffer)) == ERROR_SUCCESS;
+	}
+
+	EtwProcessEventSource::~EtwProcessEventSource()
+	{
+		Stop();
+	}
+
+	EVENT_TRACE_PROPERTIES* EtwProcessEventSource::ResetProperties()
+	{
+		m_Properties.assign(sizeof(EVENT_TRACE_PROPERTIES) + sizeof(sessionName), 0);
+
+		EVENT_TRACE_PROPERTIES* properties = reinterpret_cast<EVENT_TRACE_PROPERTIES*>(m_Properties.data());
+		properties->Wnode.BufferSize = static_cast<ULONG>(m_Properties.size());
+		properties->Wnode.Flags = WNODE_FLAG_TRACED_GUID;
+		properties->Wnode.ClientContext = 1;
+		properties->LogFileMode = EVENT_TRACE_REAL_TIME_MODE | EVENT_TRACE_USE_MS_FLUSH_TIMER;
+		properties->FlushTimer = flushIntervalMs;
+		properties->LoggerNameOffset = sizeof(EVENT_TRACE_PROPERTIES);
+		return properties;
+	}
+
+	bool EtwProcessEventSource::Start(ProcessEventQueue& queue)
+	{
+		if (m_Thread.joinable()) {
+			return true;
+		}
+
+		ULONG status = StartTraceW(&m_Session, sessionName, ResetProperties());
+		if (status == ERROR_ALREADY_EXISTS) {
+			// left behind by a previous run that did not shut down cleanly
+			ControlTraceW(0, sessionName, ResetProperties(), EVENT_TRACE_CONTROL_STOP);
+			status = StartTraceW(&m_Session, sessionName, ResetProperties());
+		}
+		if (status != ERROR_SUCCESS) {
+			std::cout << "Could not start the process event session: " << status << std::endl;
+			m_Session = 0;
+			return false;
+		}
+
+		status = EnableTraceEx2(m_Session, &kernelProcessProvider, EVENT_CONTROL_CODE_ENABLE_PROVIDER,
+			TRACE_LEVEL_INFORMATION, processKeyword, 0, 0, NULL);
+		if (status != ERROR_SUCCESS) {
+			std::cout << "Could not enable the kernel process provider: " << status << std::endl;
+			StopSession();
+			return false;
+		}
+
+		EVENT_TRACE_LOGFILEW logFile = {};
+		logFile.LoggerName = const_cast<LPWSTR>(sessionName);
+		logFile.ProcessTraceMode = PROCESS_TRACE_MODE_REAL_TIME | PROCESS_TRACE_MODE_EVENT_RECORD;
+		logFile.EventRecordCallback = &EtwProcessEventSource::OnEvent;
+		logFile.Context = this;
+
+		m_Queue = &queue;
+		m_Trace = OpenTraceW(&logFile);
+		if (m_Trace == INVALID_PROCESSTRACE_HANDLE) {
+			std::cout << "Could not open the process event session: " << GetLastError() << std::endl;
+			StopSession();
+			m_Queue = nullptr;
+			return false;
+		}
+
+		m_Thread = std::thread([this] {
+			TRACEHANDLE trace = m_Trace;
+			ProcessTrace(&trace, 1, NULL, NULL);
+		});
+		return true;
+	}
+
+	void EtwProcessEventSource::Stop()
+	{
+		StopSession();
+
+		// closing the trace makes ProcessTrace return once the buffered events are delivered
+		if (m_Trace != INVALID_PROCESSTRACE_HANDLE) {
+			CloseTrace(m_Trace);
+			m_Trace = INVALID_PROCESSTRACE_HANDLE;
+		}
+		if (m_Thread.joinable()) {
+			m_Thread.join();
+		}
+		m_Queue = nullptr;
+	}
+
+	void EtwProcessEventSource::StopSession()
+	{
+		if (m_Session != 0) {
+			ControlTraceW(m_Session, NULL, ResetProperties(), EVENT_TRACE_CONTROL_STOP);
+			m_Session = 0;
+		}
+	}
+
+	void WINAPI EtwProcessEventSource::OnEvent(PEVENT_RECORD record)
+	{
+		static_cast<EtwProcessEventSource*>(record->UserContext)->HandleEvent(record);
+	}
+
+	void EtwProcessEventSource::HandleEvent(PEVENT_RECORD record)
+	{
+		if (!IsEqualGUID(record->EventHeader.ProviderId, kernelProcessProvider)) {
+			return;
+		}
+
+		ProcessEvent event;
+		USHORT id = record->EventHeader.EventDescriptor.Id;
+		if (id == processStartEvent) {
+			event.type = ProcessEventType::Started;
+		}
+		else if (id == processStopEvent) {
+			event.type = ProcessEventType::Exited;
+		}
+		else {
+			return;
+		}
+
+		// the header holds the process that logged the event, the payload the one started or stopped
+		ULONG pid = 0;
+		ULONG size = 0;
+		if (!ReadProperty(record, L"ProcessID", &pid, sizeof(pid), size)) {
+			return;
+		}
+		event.pid = pid;
+
+		if (event.type == ProcessEventType::Started) {
+			// a device path such as \Device\HarddiskVolume3\Windows\System32\notepad.exe
+			wchar_t imageName[MAX_PATH];
+			if (ReadProperty(record, L"ImageName", imageName, sizeof(imageName), size)) {
+				event.SetExeName(imageName, wcsnlen(imageName, size / sizeof(wchar_t)));
+			}
+		}
+
+		m_Queue->Push(event);
+	}
+
+	std::unique_ptr<ProcessEventSource> CreateProcessEventSource()
+	{
+		return std::unique_ptr<ProcessEventSource>(new EtwProcessEventSource());
+	}
+}
@@ -0,0 +1,98 @@
+#include "FrequencySampler.h"
+
+#include <chrono>
+
+namespace Core
+{
+	FrequencySampler::FrequencySampler(std::unique_ptr<FrequencySource> source, std::size_t capacity)
+		: m_Source(std::move(source)), m_CoreCount(m_Source ? m_Source->CoreCount() : 0), m_Capacity(capacity > 0 ? capacity : 1)
+	{
+		m_Timestamps.resize(m_Capacity);
+		m_CurrentMhz.resize(m_Capacity * m_CoreCount);
+		m_MhzLimit.resize(m_Capacity * m_CoreCount);
+		m_IdleState.resize(m_Capacity * m_CoreCount);
+	}
+
+	bool FrequencySampler::Sample()
+	{
+		auto now = std::chrono::steady_clock::now().time_since_epoch();
+		return Sample(static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(now).count()));
+	}
+
+	bool FrequencySampler::Sample(unsigned long long timestampUs)
+	{
+		if (m_CoreCount == 0) {
+			return false;
+		}
+
+		std::size_t slot = static_cast<std::size_t>(m_Total % m_Capacity);
+		std::size_t row = slot * m_CoreCount;
+		if (!m_Source->Read(&m_CurrentMhz[row], &m_MhzLimit[row], &m_IdleState[row])) {
+			return false;
+		}
+
+		m_Timestamps[slot] = timestampUs;
+		m_Total++;
+		return true;
+	}
+
+	bool FrequencySampler::Read(std::size_t index, FrequencySampleView& sample) const
+	{
+		if (index >= Count()) {
+			return false;
+		}
+
+		std::size_t slot = static_cast<std::size_t>((m_Total - Count() + index) % m_Capacity);
+		std::size_t row = slot * m_CoreCount;
+		sample.timestampUs = m_Timestamps[slot];
+		sample.coreCount = m_CoreCount;
+		sample.currentMhz = &m_CurrentMhz[row];
+		sample.mhzLimit = &m_MhzLimit[row];
+		sample.idleState = &m_IdleState[row];
+		return true;
+	}
+
+	bool FrequencySampler::Latest(FrequencySampleView& sample) const
+	{
+		return Count() > 0 && Read(Count() - 1, sample);
+	}
+
+	std::size_t FrequencySampler::Average(std::size_t samples, unsigned* currentMhz, unsigned* mhzLimit) const
+	{
+		if (samples > Count()) {
+			samples = Count();
+		}
+
+		for (unsigned core = 0; core < m_CoreCount; core++) {
+			unsigned long long currentSum = 0, limitSum = 0;
+			for (std::size_t i = Count() - samples; i < Count(); i++) {
+				std::size_t row = static_cast<std::size_t>((m_Total - Count() + i) % m_Capacity) * m_CoreCount;
+				currentSum += m_CurrentMhz[row + core];
+				limitSum += m_MhzLimit[row + core];
+			}
+			currentMhz[core] = samples > 0 ? static_cast<unsigned>(currentSum / samples) : 0;
+			mhzLimit[core] = samples > 0 ? static_cast<unsigned>(limitSum / samples) : 0;
+		}
+		return samples;
+	}
+
+	unsigned FrequencySampler::CoreCount() const
+	{
+		return m_CoreCount;
+	}
+
+	std::size_t FrequencySampler::Capacity() const
+	{
+		return m_Capacity;
+	}
+
+	std::size_t FrequencySampler::Count() const
+	{
+		return m_Total < m_Capacity ? static_cast<std::size_t>(m_Total) : m_Capacity;
+	}
+
+	unsigned long long FrequencySampler::Total() const
+	{
+		return m_Total;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "FrequencySource.h"
+
+namespace Core
+{
+    // One sample as stored in the ring. The arrays hold one entry per core and stay valid
+    // until the slot is overwritten, CoreCount samples later.
+    struct FrequencySampleView
+    {
+        unsigned long long timestampUs = 0;
+        unsigned coreCount = 0;
+        const unsigned* currentMhz = nullptr;
+        const unsigned* mhzLimit = nullptr;
+        const unsigned* idleState = nullptr;
+    };
+
+    // Samples a FrequencySource into a fixed ring of the most recent samples. Storage is
+    // allocated once in structure-of-arrays layout: the source writes straight into the
+    // next slot's rows, so sampling and reading never allocate. Not thread-safe, the owner
+    // samples and reads from one thread.
+    class FrequencySampler
+    {
+    public:
+        FrequencySampler(std::unique_ptr<FrequencySource> source, std::size_t capacity = 1024);
+
+        FrequencySampler(const FrequencySampler&) = delete;
+        FrequencySampler& operator=(const FrequencySampler&) = delete;
+
+        // Takes one sample stamped with the steady clock, or with the given time.
+        bool Sample();
+        bool Sample(unsigned long long timestampUs);
+
+        // index 0 is the oldest sample still held.
+        bool Read(std::size_t index, FrequencySampleView& sample) const;
+        bool Latest(FrequencySampleView& sample) const;
+
+        // Per-core mean over the most recent samples, into caller arrays of CoreCount entries.
+        // Returns the number of samples averaged.
+        std::size_t Average(std::size_t samples, unsigned* currentMhz, unsigned* mhzLimit) const;
+
+        unsigned CoreCount() const;
+        std::size_t Capacity() const;
+        std::size_t Count() const;
+        unsigned long long Total() const;
+
+    private:
+        std::unique_ptr<FrequencySource> m_Source;
+        unsigned m_CoreCount;
+        std::size_t m_Capacity;
+
+        std::vector<unsigned long long> m_Timestamps;
+        std::vector<unsigned> m_CurrentMhz;
+        std::vector<unsigned> m_MhzLimit;
+        std::vector<unsigned> m_IdleState;
+
+        // samples taken since creation, the next slot is m_Total % m_Capacity
+        unsigned long long m_Total = 0;
+    };
+}
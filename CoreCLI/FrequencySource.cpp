@@ -0,0 +1,46 @@
+#include "FrequencySource.h"
+
+#include <algorithm>
+
+namespace Core
+{
+	ReplayFrequencySource::ReplayFrequencySource(unsigned coreCount)
+		: m_CoreCount(coreCount)
+	{
+	}
+
+	void ReplayFrequencySource::AddFrame(const std::vector<unsigned>& currentMhz, const std::vector<unsigned>& mhzLimit,
+		const std::vector<unsigned>& idleState)
+	{
+		// frames are stored back to back as currentMhz, mhzLimit, idleState; missing cores read as 0
+		std::size_t frame = m_Frames.size();
+		m_Frames.resize(frame + 3 * m_CoreCount, 0);
+		std::copy_n(currentMhz.begin(), std::min<std::size_t>(currentMhz.size(), m_CoreCount), m_Frames.begin() + frame);
+		std::copy_n(mhzLimit.begin(), std::min<std::size_t>(mhzLimit.size(), m_CoreCount), m_Frames.begin() + frame + m_CoreCount);
+		std::copy_n(idleState.begin(), std::min<std::size_t>(idleState.size(), m_CoreCount), m_Frames.begin() + frame + 2 * m_CoreCount);
+	}
+
+	void ReplayFrequencySource::Rewind()
+	{
+		m_Next = 0;
+	}
+
+	unsigned ReplayFrequencySource::CoreCount() const
+	{
+		return m_CoreCount;
+	}
+
+	bool ReplayFrequencySource::Read(unsigned* currentMhz, unsigned* mhzLimit, unsigned* idleState)
+	{
+		if (m_Next + 3 * m_CoreCount > m_Frames.size() || m_CoreCount == 0) {
+			return false;
+		}
+
+		const unsigned* frame = m_Frames.data() + m_Next;
+		std::copy_n(frame, m_CoreCount, currentMhz);
+		std::copy_n(frame + m_CoreCount, m_CoreCount, mhzLimit);
+		std::copy_n(frame + 2 * m_CoreCount, m_CoreCount, idleState);
+		m_Next += 3 * m_CoreCount;
+		return true;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Core
+{
+    // Reads the frequency and idle state of every logical processor into caller-owned
+    // arrays of CoreCount() entries. Implementations must not allocate in Read, it runs
+    // at telemetry rates.
+    class FrequencySource
+    {
+    public:
+        virtual ~FrequencySource() {}
+
+        virtual unsigned CoreCount() const = 0;
+        virtual bool Read(unsigned* currentMhz, unsigned* mhzLimit, unsigned* idleState) = 0;
+    };
+
+    // The native source of the platform: CallNtPowerInformation on Windows and cpufreq on Linux.
+    std::unique_ptr<FrequencySource> CreateFrequencySource();
+
+    // Plays back recorded frames in order, for tests and offline analysis.
+    class ReplayFrequencySource : public FrequencySource
+    {
+    public:
+        explicit ReplayFrequencySource(unsigned coreCount);
+
+        // Each array holds one entry per core.
+        void AddFrame(const std::vector<unsigned>& currentMhz, const std::vector<unsigned>& mhzLimit,
+            const std::vector<unsigned>& idleState);
+        void Rewind();
+
+        unsigned CoreCount() const override;
+
+        // Fails once every frame has been played.
+        bool Read(unsigned* currentMhz, unsigned* mhzLimit, unsigned* idleState) override;
+
+    private:
+        unsigned m_CoreCount;
+        std::vector<unsigned> m_Frames;
+        std::size_t m_Next = 0;
+    };
+}
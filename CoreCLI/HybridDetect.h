@@ -10,7 +10,6 @@
 #include <malloc.h>    
 #include <stdio.h>
 #include <bitset>
-#include <map>
 #include <assert.h>
 #include <Powrprof.h>
 #include <thread>
@@ -50,7 +49,7 @@
 #define ENABLE_CPU_SETS
 
 // Simple conversion from an ordinal, n, to a set bit at position n
-#define IndexToMask(n)  (1UL << n)
+#define IndexToMask(n)  (1ULL << (n))
 
 // Macros to store values for CPUID register ordinals
 #define CPUID_EAX								0
@@ -85,6 +84,42 @@ enum CoreTypes
 	MAX = 6
 };
 
+// Slot of a core type in a CORE_TYPE_TABLE. ANY takes slot 0 and the CPUID core types
+// follow in order; values CPUID does not define share the NONE slot.
+constexpr unsigned CoreTypeIndex(int type)
+{
+	return type == CoreTypes::ANY ? 0
+		: (type >= CoreTypes::NONE && type <= CoreTypes::INTEL_CORE && (type & 0x0F) == 0) ? (type >> 4) + 1
+		: 1;
+}
+
+static_assert(CoreTypeIndex(CoreTypes::INTEL_CORE) == CoreTypes::MAX - 1, "every core type needs its own slot");
+
+// One entry per core type in a fixed array, so a lookup never searches or allocates.
+template <typename T>
+struct CORE_TYPE_TABLE
+{
+	std::array<T, CoreTypes::MAX>		slots = {};
+
+	T& operator[](int type) { return slots[CoreTypeIndex(type)]; }
+	const T& operator[](int type) const { return slots[CoreTypeIndex(type)]; }
+
+	void clear() { for (T& slot : slots) slot = T(); }
+};
+
+// Non-owning view of CPU set IDs. Converts from a vector, so callers can pass either.
+typedef struct _CPU_SET_SPAN
+{
+	const ULONG*						data = nullptr;
+	size_t								size = 0;
+
+	_CPU_SET_SPAN() {}
+	_CPU_SET_SPAN(const ULONG* ids, size_t count) : data(ids), size(count) {}
+	_CPU_SET_SPAN(const std::vector<ULONG>& ids) : data(ids.data()), size(ids.size()) {}
+
+	bool empty() const { return size == 0; }
+} CPU_SET_SPAN;
+
 // Struct to store information for each Cache.
 typedef struct _CACHE_INFO
 {
@@ -190,15 +225,14 @@ typedef struct _PROCESSOR_INFO
 	std::vector<CACHE_INFO>				caches;
 	std::vector<LOGICAL_PROCESSOR_INFO>	cores;
 
-	// Store map of logical processors returned from GLPI. 
-	// short = Core Type, ULONG64 = 64-bit processor mask 
-	std::map<short, ULONG64>			coreMasks;
+	// Logical processors returned from GLPI, indexed by Core Type.
+	// ULONG64 = 64-bit processor mask
+	CORE_TYPE_TABLE<ULONG64>			coreMasks;
 #ifdef ENABLE_CPU_SETS
 
-	// Store map of logical processors returned from GetSystemCPUSetInformation. 
-	// unsined custom logical cluster key, use short to store EffeciencyClass as a key 
-	// std::vector<ULONG> = list of CPU Set IDs 
-	std::map<unsigned, std::vector<ULONG>>	cpuSets;
+	// Logical processors returned from GetSystemCPUSetInformation, indexed by Core Type.
+	// std::vector<ULONG> = list of CPU Set IDs
+	CORE_TYPE_TABLE<std::vector<ULONG>>	cpuSets;
 
 #endif
 	unsigned							osMajorVersion;
@@ -477,16 +511,19 @@ inline bool GetLogicalProcessors(PROCESSOR_INFO& procInfo)
 inline bool GetLogicalProcessorsEx(PROCESSOR_INFO& procInfo)
 {
 #ifdef ENABLE_HYBRID_DETECT
+	// A single RelationGroup record describes every active group
 	for (EnumLogicalProcessorInformation enumInfo(RelationGroup);
 		auto pinfo = enumInfo.Current(); enumInfo.MoveNext()) {
-		GROUP_INFO group;
-		procInfo.numGroups++;
-		group.activeGroupCount = pinfo->Group.ActiveGroupCount;
-		group.maximumGroupCount = pinfo->Group.MaximumGroupCount;
-		group.activeProcessorCount = pinfo->Group.GroupInfo->ActiveProcessorCount;
-		group.maximumProcessorCount = pinfo->Group.GroupInfo->MaximumProcessorCount;
-		group.activeProcessorMask = (ULONG)pinfo->Group.GroupInfo->ActiveProcessorMask;
-		procInfo.groups.push_back(group);
+		for (WORD groupIndex = 0; groupIndex < pinfo->Group.ActiveGroupCount; groupIndex++) {
+			GROUP_INFO group;
+			procInfo.numGroups++;
+			group.activeGroupCount = pinfo->Group.ActiveGroupCount;
+			group.maximumGroupCount = pinfo->Group.MaximumGroupCount;
+			group.activeProcessorCount = pinfo->Group.GroupInfo[groupIndex].ActiveProcessorCount;
+			group.maximumProcessorCount = pinfo->Group.GroupInfo[groupIndex].MaximumProcessorCount;
+			group.activeProcessorMask = (ULONG64)pinfo->Group.GroupInfo[groupIndex].ActiveProcessorMask;
+			procInfo.groups.push_back(group);
+		}
 	}
 
 	for (EnumLogicalProcessorInformation enumInfo(RelationNumaNode);
@@ -495,7 +532,7 @@ inline bool GetLogicalProcessorsEx(PROCESSOR_INFO& procInfo)
 		procInfo.numNUMANodes++;
 		node.nodeNumber = pinfo->NumaNode.NodeNumber;
 		node.group = pinfo->NumaNode.GroupMask.Group;
-		node.mask = (ULONG)pinfo->NumaNode.GroupMask.Mask;
+		node.mask = (ULONG64)pinfo->NumaNode.GroupMask.Mask;
 		procInfo.nodes.push_back(node);
 	}
 
@@ -546,6 +583,114 @@ inline void UpdateProcessorInfo(PROCESSOR_INFO& procInfo)
 	}
 }
 
+// Time GetProcessorInfo waits for the per-core probes to be scheduled.
+#define CORE_PROBE_TIMEOUT_MS					500
+
+struct _CORE_PROBE_BATCH;
+
+// CPUID leaves that can differ between logical processors, read on the processor itself.
+typedef struct _CORE_PROBE
+{
+	std::array<unsigned, 4>				extendedState = {};
+	std::array<unsigned, 4>				featureFlags = {};
+	std::array<unsigned, 4>				frequency = {};
+	std::array<unsigned, 4>				hybrid = {};
+	bool								pinned = false;
+	bool								completed = false;
+	_CORE_PROBE_BATCH*					batch = nullptr;
+} CORE_PROBE, * PCORE_PROBE;
+
+// Shared by the caller and the probe threads. A probe that misses the timeout may still
+// run afterwards, so whichever side finishes last frees the batch.
+typedef struct _CORE_PROBE_BATCH
+{
+	volatile LONG						references = 1;
+	std::vector<CORE_PROBE>				probes;
+} CORE_PROBE_BATCH, * PCORE_PROBE_BATCH;
+
+inline void ReleaseCoreProbeBatch(PCORE_PROBE_BATCH batch)
+{
+	if (InterlockedDecrement(&batch->references) == 0)
+	{
+		delete batch;
+	}
+}
+
+inline DWORD WINAPI CoreProbeThread(LPVOID parameter)
+{
+	PCORE_PROBE probe = static_cast<PCORE_PROBE>(parameter);
+
+	// A probe that could not be pinned would read some other processor's leaves
+	if (probe->pinned)
+	{
+		CallCPUID(LEAF_EXTENDED_STATE, probe->extendedState);
+		CallCPUID(LEAF_EXTENDED_FEATURE_FLAGS, probe->featureFlags);
+		CallCPUID(LEAF_FREQUENCY_INFORMATION, probe->frequency);
+		CallCPUID(LEAF_HYBRID_INFORMATION, probe->hybrid);
+		probe->completed = true;
+	}
+
+	ReleaseCoreProbeBatch(probe->batch);
+	return 0;
+}
+
+// Reads the per-core CPUID leaves on every target processor concurrently. Each probe thread
+// is created suspended with its group affinity already set, so it starts on its processor
+// instead of waiting to be migrated there. results[i] belongs to targets[i]; probes that
+// were not scheduled within timeoutMs are left incomplete. Returns the completed count.
+inline unsigned ProbeLogicalProcessors(const std::vector<GROUP_AFFINITY>& targets, std::vector<CORE_PROBE>& results, DWORD timeoutMs = CORE_PROBE_TIMEOUT_MS)
+{
+	PCORE_PROBE_BATCH batch = new CORE_PROBE_BATCH();
+	batch->probes.resize(targets.size());
+	std::vector<HANDLE> threads(targets.size(), nullptr);
+
+	for (size_t i = 0; i < targets.size(); i++)
+	{
+		PCORE_PROBE probe = &batch->probes[i];
+		probe->batch = batch;
+		if (targets[i].Mask == 0) continue;
+
+		InterlockedIncrement(&batch->references);
+		threads[i] = CreateThread(nullptr, 64 * 1024, CoreProbeThread, probe, CREATE_SUSPENDED | STACK_SIZE_PARAM_IS_A_RESERVATION, nullptr);
+		if (threads[i] == nullptr)
+		{
+			ReleaseCoreProbeBatch(batch);
+			continue;
+		}
+
+		GROUP_AFFINITY affinity = targets[i];
+		probe->pinned = SetThreadGroupAffinity(threads[i], &affinity, nullptr) != FALSE;
+	}
+
+	// Start them only once all are created, so creation does not compete with the probes
+	for (HANDLE thread : threads)
+	{
+		if (thread != nullptr) ResumeThread(thread);
+	}
+
+	results.assign(targets.size(), CORE_PROBE());
+	unsigned completed = 0;
+	ULONGLONG deadline = GetTickCount64() + timeoutMs;
+
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		if (threads[i] == nullptr) continue;
+
+		ULONGLONG now = GetTickCount64();
+		DWORD remaining = now < deadline ? (DWORD)(deadline - now) : 0;
+		if (WaitForSingleObject(threads[i], remaining) == WAIT_OBJECT_0 && batch->probes[i].completed)
+		{
+			results[i] = batch->probes[i];
+			results[i].batch = nullptr;
+			completed++;
+		}
+		CloseHandle(threads[i]);
+	}
+
+	ReleaseCoreProbeBatch(batch);
+	return completed;
+}
+
 // Calls CPUID & GetLogicalProcessors & CallNTPowerInformation to fill in PROCESSOR_INFO
 inline void GetProcessorInfo(PROCESSOR_INFO& procInfo)
 {
@@ -563,20 +708,10 @@ inline void GetProcessorInfo(PROCESSOR_INFO& procInfo)
 	DWORD_PTR           sysAffinityMask;
 	std::bitset<32>     bits;
 
-	procInfo.coreMasks.emplace(CoreTypes::ANY, 0);
-	procInfo.coreMasks.emplace(CoreTypes::NONE, 0);
-	procInfo.coreMasks.emplace(CoreTypes::RESERVED0, 0);
-	procInfo.coreMasks.emplace(CoreTypes::INTEL_ATOM, 0);
-	procInfo.coreMasks.emplace(CoreTypes::RESERVED1, 0);
-	procInfo.coreMasks.emplace(CoreTypes::INTEL_CORE, 0);
+	procInfo.coreMasks.clear();
 
 #ifdef ENABLE_CPU_SETS
-	procInfo.cpuSets.emplace(CoreTypes::ANY, std::vector<ULONG>());
-	procInfo.cpuSets.emplace(CoreTypes::NONE, std::vector<ULONG>());
-	procInfo.cpuSets.emplace(CoreTypes::RESERVED0, std::vector<ULONG>());
-	procInfo.cpuSets.emplace(CoreTypes::INTEL_ATOM, std::vector<ULONG>());
-	procInfo.cpuSets.emplace(CoreTypes::RESERVED1, std::vector<ULONG>());
-	procInfo.cpuSets.emplace(CoreTypes::INTEL_CORE, std::vector<ULONG>());
+	procInfo.cpuSets.clear();
 #endif
 
 	//Basic CPUID Information
@@ -633,39 +768,50 @@ inline void GetProcessorInfo(PROCESSOR_INFO& procInfo)
 		DWORD size = sizeof(LOGICAL_PROCESSOR_POWER_INFORMATION) * procInfo.numLogicalCores;
 		CallNtPowerInformation(ProcessorInformation, nullptr, 0, &pwrInfo[0], size);
 
+		// Probe every logical processor at once rather than moving this thread across them in turn.
+		// The process affinity mask only applies to the primary group.
+		std::vector<GROUP_AFFINITY> probeTargets;
 		for (unsigned group = 0; group < procInfo.numGroups; group++)
 		{
-			// TODO Use Thread Group Affinity https://docs.microsoft.com/en-us/windows/win32/api/processtopologyapi/nf-processtopologyapi-setthreadgroupaffinity
-			GROUP_AFFINITY nextGroup;
-			GROUP_AFFINITY prevGroup;
-			nextGroup.Group = group;
-			nextGroup.Mask = 0xffffffff;
+			for (unsigned core = 0; core < procInfo.groups[group].activeProcessorCount; core++)
+			{
+				GROUP_AFFINITY coreGroup = {};
+				coreGroup.Group = group;
+				coreGroup.Mask = (group == 0) ? (processAffinityMask & IndexToMask(core)) : IndexToMask(core);
+				probeTargets.push_back(coreGroup);
+			}
+		}
+
+		std::vector<CORE_PROBE> probes;
+		ProbeLogicalProcessors(probeTargets, probes);
 
-			SetThreadGroupAffinity(GetCurrentThread(), &nextGroup, &prevGroup);
+		// Index of the first logical processor of the current group in procInfo.cores
+		unsigned groupOffset = 0;
 
-			// Enumerate each logical core. Need active or maximum processor count?
-			for (unsigned core = 0; core < procInfo.groups[group].maximumProcessorCount; core++)
+		for (unsigned group = 0; group < procInfo.numGroups; group++)
+		{
+			// Enumerate each active logical core of the group.
+			for (unsigned core = 0; core < procInfo.groups[group].activeProcessorCount; core++)
 			{
 				// Logical Processor Info struct for storage.
 #ifdef ENABLE_CPU_SETS
-				LOGICAL_PROCESSOR_INFO& logicalCore = procInfo.cores[core];
+				if (groupOffset + core >= procInfo.cores.size()) break;
+				LOGICAL_PROCESSOR_INFO& logicalCore = procInfo.cores[groupOffset + core];
 #else
 				LOGICAL_PROCESSOR_INFO					logicalCore;
+				logicalCore.group = group;
 				logicalCore.logicalProcessorIndex = core;
 #endif
-				// Get the ID of the current processor;
-				int                                     prevProcessor = GetCurrentProcessorNumber();
+				// Leaves read by this processor's probe, all zero if it never ran.
+				const CORE_PROBE&						probe = probes[groupOffset + core];
 
 				// Convert the oridinal position to an affinity mask.
-				affinityMask = (DWORD)IndexToMask(core);
-
-				// Thread Affinity Mask is enough to switch to current thread immediatlely. 
-				SetThreadAffinityMask(GetCurrentThread(), processAffinityMask & affinityMask);
+				affinityMask = (DWORD_PTR)IndexToMask(core);
 
 				logicalCore.processorMask = std::bitset<64>(affinityMask);
 
 				// Processor Extended State Enumeration Main Leaf (EAX = 0DH, ECX = 0)
-				CallCPUID(LEAF_EXTENDED_STATE, cpuInfo);
+				cpuInfo = probe.extendedState;
 				{
 					bits = cpuInfo[CPUID_EAX];
 					logicalCore.SSE = bits[1];
@@ -674,7 +820,7 @@ inline void GetProcessorInfo(PROCESSOR_INFO& procInfo)
 				}
 
 				// Structured Extended Feature Flags Enumeration Leaf (Output depends on ECX input value)
-				CallCPUID(LEAF_EXTENDED_FEATURE_FLAGS, cpuInfo);
+				cpuInfo = probe.featureFlags;
 				{
 					bits = cpuInfo[CPUID_EBX];
 					logicalCore.AVX2 = bits[5];
@@ -703,7 +849,7 @@ inline void GetProcessorInfo(PROCESSOR_INFO& procInfo)
 				}
 
 				// Processor Frequency Information Leaf  function 0x16 only works on Sky-lake or newer.
-				CallCPUID(LEAF_FREQUENCY_INFORMATION, cpuInfo);
+				cpuInfo = probe.frequency;
 				{
 					logicalCore.baseFrequency = cpuInfo[CPUID_EAX];
 					logicalCore.maximumFrequency = cpuInfo[CPUID_EBX];
@@ -712,16 +858,16 @@ inline void GetProcessorInfo(PROCESSOR_INFO& procInfo)
 					// Fall-back to ProcessorPowerInfo for older CPUs
 					if (logicalCore.baseFrequency == 0)
 					{
-						logicalCore.baseFrequency = pwrInfo[core].mhzLimit;
-						logicalCore.maximumFrequency = pwrInfo[core].mhzLimit;
+						logicalCore.baseFrequency = pwrInfo[groupOffset + core].mhzLimit;
+						logicalCore.maximumFrequency = pwrInfo[groupOffset + core].mhzLimit;
 					}
 
-					logicalCore.currentFrequency = pwrInfo[core].currentMhz;
-					logicalCore.powerInformation = pwrInfo[core];
+					logicalCore.currentFrequency = pwrInfo[groupOffset + core].currentMhz;
+					logicalCore.powerInformation = pwrInfo[groupOffset + core];
 				}
 
 				// Hybrid Information Sub - leaf(EAX = 1AH, ECX = 0)
-				CallCPUID(LEAF_HYBRID_INFORMATION, cpuInfo);
+				cpuInfo = probe.hybrid;
 				{
 #ifndef ENABLE_SOFTWARE_PROXY
 					std::bitset<8> coreTypeBits;    // Bits 31 - 24: Core type
@@ -772,14 +918,8 @@ inline void GetProcessorInfo(PROCESSOR_INFO& procInfo)
 				//pwrInfo.clear();
 			}
 
-			
-
-			// Reset Group Affinity
-			SetThreadGroupAffinity(GetCurrentThread(), &prevGroup, nullptr);
+			groupOffset += procInfo.groups[group].activeProcessorCount;
 		}
-
-		// Reset Process Affinity Mask
-		SetThreadAffinityMask(GetCurrentThread(), processAffinityMask);
 	}
 #endif
 }
@@ -836,30 +976,31 @@ inline bool AutoPowerThrottling(HANDLE threadHandle)
 
 #ifdef ENABLE_CPU_SETS
 
-inline short RunOnCPUSet(PROCESSOR_INFO& procInfo, HANDLE threadHandle, std::vector<ULONG> cpuSet, std::vector<ULONG> fallbackSet = {})
+// The CPU set overloads take non-owning views and do not allocate, so they can run on hot paths.
+inline short RunOnCPUSet(PROCESSOR_INFO& procInfo, HANDLE threadHandle, CPU_SET_SPAN cpuSet, CPU_SET_SPAN fallbackSet = CPU_SET_SPAN())
 {
 #ifdef ENABLE_RUNON
-	if (cpuSet.size() > 0)
+	if (!cpuSet.empty())
 	{
-		if (SetThreadSelectedCpuSets(threadHandle, &cpuSet[0], cpuSet.size()))
+		if (SetThreadSelectedCpuSets(threadHandle, cpuSet.data, (ULONG)cpuSet.size))
 		{
 			return 1;
 		}
 	}
 
-	if (fallbackSet.size() > 0)
+	if (!fallbackSet.empty())
 	{
-		if (SetThreadSelectedCpuSets(threadHandle, &fallbackSet[0], fallbackSet.size()))
+		if (SetThreadSelectedCpuSets(threadHandle, fallbackSet.data, (ULONG)fallbackSet.size))
 		{
 			return 0;
 		}
 	}
 
-	std::vector<ULONG> anySet = procInfo.cpuSets[CoreTypes::ANY];
+	const std::vector<ULONG>& anySet = procInfo.cpuSets[CoreTypes::ANY];
 
 	if (anySet.size() > 0)
 	{
-		if (SetThreadSelectedCpuSets(threadHandle, &anySet[0], anySet.size()))
+		if (SetThreadSelectedCpuSets(threadHandle, anySet.data(), (ULONG)anySet.size()))
 		{
 			return -1;
 		}
@@ -870,7 +1011,7 @@ inline short RunOnCPUSet(PROCESSOR_INFO& procInfo, HANDLE threadHandle, std::vec
 }
 
 // Run A Thread On the Atom or Core Logical Processor Cluster
-inline short RunOn(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const CoreTypes type, const std::vector<ULONG> fallbackSet = {})
+inline short RunOn(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const CoreTypes type, CPU_SET_SPAN fallbackSet = CPU_SET_SPAN())
 {
 #ifdef ENABLE_RUNON_PRIORITY
 	switch (type)
@@ -920,10 +1061,9 @@ inline short RunOn(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const CoreType
 #ifdef ENABLE_RUNON
 	//assert(procInfo.coreMasks.size());
 
-	if (procInfo.cpuSets.size() > 0)
+	if (!procInfo.cpuSets[CoreTypes::ANY].empty())
 	{
-		std::vector<ULONG> cpuSet = procInfo.cpuSets[type];
-		return RunOnCPUSet(procInfo, threadHandle, cpuSet, fallbackSet);
+		return RunOnCPUSet(procInfo, threadHandle, procInfo.cpuSets[type], fallbackSet);
 	}
 
 	return RunOnCPUSet(procInfo, threadHandle, fallbackSet);
@@ -933,7 +1073,7 @@ inline short RunOn(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const CoreType
 }
 
 // Run The Current Thread On Atom or Core Logical Processor Cluster
-inline short RunOn(PROCESSOR_INFO& procInfo, const CoreTypes type, const std::vector<ULONG> fallbackSet = {})
+inline short RunOn(PROCESSOR_INFO& procInfo, const CoreTypes type, CPU_SET_SPAN fallbackSet = CPU_SET_SPAN())
 {
 #ifdef ENABLE_RUNON
 	HANDLE threadHandle = GetCurrentThread();
@@ -944,7 +1084,7 @@ inline short RunOn(PROCESSOR_INFO& procInfo, const CoreTypes type, const std::ve
 }
 
 // Run A Thread On Any Logical Processor
-inline short RunOnAny(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const std::vector<ULONG> fallbackSet = {})
+inline short RunOnAny(PROCESSOR_INFO& procInfo, HANDLE threadHandle, CPU_SET_SPAN fallbackSet = CPU_SET_SPAN())
 {
 #ifdef ENABLE_RUNON
 	return RunOn(procInfo, threadHandle, CoreTypes::ANY, fallbackSet);
@@ -954,7 +1094,7 @@ inline short RunOnAny(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const std::
 }
 
 // Run The Current Thread On Any Logical Processor
-inline short RunOnAny(PROCESSOR_INFO& procInfo, const std::vector<ULONG> fallbackSet = {})
+inline short RunOnAny(PROCESSOR_INFO& procInfo, CPU_SET_SPAN fallbackSet = CPU_SET_SPAN())
 {
 #ifdef ENABLE_RUNON
 	HANDLE threadHandle = GetCurrentThread();
@@ -965,7 +1105,7 @@ inline short RunOnAny(PROCESSOR_INFO& procInfo, const std::vector<ULONG> fallbac
 }
 
 // Run A Thread On One Logical Processor
-inline short RunOnOne(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const short coreID, const std::vector<ULONG> fallbackSet = {})
+inline short RunOnOne(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const short coreID, CPU_SET_SPAN fallbackSet = CPU_SET_SPAN())
 {
 #ifdef ENABLE_RUNON
 	bool succeeded = false;
@@ -976,8 +1116,8 @@ inline short RunOnOne(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const short
 #endif
 	if (coreID < procInfo.numLogicalCores)
 	{
-		std::vector<ULONG> coreSet = { procInfo.cores[coreID].id };
-		short succeeded = RunOnCPUSet(procInfo, threadHandle, coreSet, fallbackSet);
+		ULONG coreSet = procInfo.cores[coreID].id;
+		short succeeded = RunOnCPUSet(procInfo, threadHandle, CPU_SET_SPAN(&coreSet, 1), fallbackSet);
 
 #ifdef _DEBUG
 		// Check to see if the core is masked
@@ -1011,7 +1151,7 @@ inline short RunOnOne(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const short
 }
 
 // Run The Current Thread On One Logical Processor
-inline bool RunOnOne(PROCESSOR_INFO& procInfo, const short coreID, const std::vector<ULONG> fallbackSet = {})
+inline bool RunOnOne(PROCESSOR_INFO& procInfo, const short coreID, CPU_SET_SPAN fallbackSet = CPU_SET_SPAN())
 {
 #ifdef ENABLE_RUNON
 	HANDLE threadHandle = GetCurrentThread();
@@ -1096,7 +1236,7 @@ inline short RunOn(PROCESSOR_INFO& procInfo, HANDLE threadHandle, const CoreType
 #ifdef ENABLE_RUNON
 	//assert(procInfo.coreMasks.size());
 
-	if (procInfo.coreMasks.size())
+	if (procInfo.coreMasks[CoreTypes::ANY])
 	{
 		ULONG64 threadMask = procInfo.coreMasks[type];
 		return RunOnMask(procInfo, threadHandle, threadMask, fallbackMask);
@@ -0,0 +1,599 @@
+#ifdef __linux__
+
+#include "OsBackend.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "CoreFeatureTable.h"
+#include "ProcessTimeSource.h"
+
+namespace Core
+{
+	// Linux has no processor groups, CPU n is bit n % 64 of group n / 64 so masks keep their layout.
+	const unsigned cpusPerGroup = 64;
+
+	// CPUID core types of CoreTypes in HybridDetect.h, as reported by the hybrid PMUs.
+	const unsigned char atomCoreType = 0x20;
+	const unsigned char coreCoreType = 0x40;
+
+	// Reads a whole small file such as a sysfs attribute, false when it is missing or unreadable.
+	bool ReadSysfsText(const char* path, std::string& text)
+	{
+		text.clear();
+		int fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return false;
+		}
+
+		char buffer[4096];
+		ssize_t length;
+		while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+			text.append(buffer, static_cast<size_t>(length));
+		}
+		close(fd);
+		return length == 0;
+	}
+
+	unsigned long ReadSysfsNumber(const char* path, unsigned long fallback)
+	{
+		std::string text;
+		if (!ReadSysfsText(path, text)) {
+			return fallback;
+		}
+		char* end = nullptr;
+		unsigned long value = strtoul(text.c_str(), &end, 10);
+		return end == text.c_str() ? fallback : value;
+	}
+
+	// Parses a CPU list such as "0-3,8,10-11".
+	void ParseCpuList(const std::string& text, std::vector<unsigned>& cpus)
+	{
+		cpus.clear();
+		const char* p = text.c_str();
+		while (*p != '\0') {
+			char* end = nullptr;
+			unsigned long first = strtoul(p, &end, 10);
+			if (end == p) {
+				break;
+			}
+			unsigned long last = first;
+			p = end;
+			if (*p == '-') {
+				last = strtoul(p + 1, &end, 10);
+				p = end;
+			}
+			for (unsigned long cpu = first; cpu <= last; cpu++) {
+				cpus.push_back(static_cast<unsigned>(cpu));
+			}
+			if (*p != ',') {
+				break;
+			}
+			p++;
+		}
+	}
+
+	// CoreFeature bits of each processor from the flags lines of /proc/cpuinfo, indexed by CPU number.
+	void ReadCpuFlags(std::vector<uint64_t>& features)
+	{
+		static const std::pair<const char*, CoreFeature> flagNames[] = {
+			{ "sse", CoreFeature::SSE }, { "avx", CoreFeature::AVX }, { "avx2", CoreFeature::AVX2 },
+			{ "avx512f", CoreFeature::AVX512 }, { "avx512f", CoreFeature::AVX512F }, { "avx512dq", CoreFeature::AVX512DQ },
+			{ "avx512pf", CoreFeature::AVX512PF }, { "avx512er", CoreFeature::AVX512ER }, { "avx512cd", CoreFeature::AVX512CD },
+			{ "avx512bw", CoreFeature::AVX512BW }, { "avx512vl", CoreFeature::AVX512VL }, { "avx512ifma", CoreFeature::AVX512_IFMA },
+			{ "avx512vbmi", CoreFeature::AVX512_VBMI }, { "avx512_vbmi2", CoreFeature::AVX512_VBMI2 },
+			{ "avx512_vnni", CoreFeature::AVX512_VNNI }, { "avx512_bitalg", CoreFeature::AVX512_BITALG },
+			{ "avx512_vpopcntdq", CoreFeature::AVX512_VPOPCNTDQ }, { "avx512_4vnniw", CoreFeature::AVX512_4VNNIW },
+			{ "avx512_4fmaps", CoreFeature::AVX512_4FMAPS }, { "avx512_vp2intersect", CoreFeature::AVX512_VP2INTERSECT },
+			{ "sgx", CoreFeature::SGX }, { "sha_ni", CoreFeature::SHA }
+		};
+
+		features.clear();
+		FILE* file = fopen("/proc/cpuinfo", "r");
+		if (file == nullptr) {
+			return;
+		}
+
+		char line[8192];
+		unsigned long cpu = 0;
+		while (fgets(line, sizeof(line), file) != nullptr) {
+			const char* value = strchr(line, ':');
+			if (value == nullptr) {
+				continue;
+			}
+			value++;
+			if (strncmp(line, "processor", 9) == 0) {
+				cpu = strtoul(value, nullptr, 10);
+			}
+			else if (strncmp(line, "flags", 5) == 0) {
+				if (features.size() <= cpu) {
+					features.resize(cpu + 1, 0);
+				}
+				// flags are space separated, match whole words only
+				std::string flags = std::string(" ") + value;
+				flags.back() = ' ';
+				for (const auto& flag : flagNames) {
+					if (flags.find(std::string(" ") + flag.first + " ") != std::string::npos) {
+						features[cpu] |= FeatureBit(flag.second);
+					}
+				}
+			}
+		}
+		fclose(file);
+	}
+
+	// The file name of a process's executable, falling back to its command name when the
+	// executable link cannot be read, as for kernel threads and other users' processes.
+	bool ReadProcessName(unsigned long pid, std::wstring& name)
+	{
+		char path[64];
+		char buffer[4096];
+		snprintf(path, sizeof(path), "/proc/%lu/exe", pid);
+		ssize_t length = readlink(path, buffer, sizeof(buffer));
+		size_t start = 0;
+		if (length <= 0) {
+			snprintf(path, sizeof(path), "/proc/%lu/comm", pid);
+			int fd = open(path, O_RDONLY | O_CLOEXEC);
+			if (fd < 0) {
+				return false;
+			}
+			length = read(fd, buffer, sizeof(buffer));
+			close(fd);
+			while (length > 0 && buffer[length - 1] == '\n') {
+				length--;
+			}
+			if (length <= 0) {
+				return false;
+			}
+		}
+		else {
+			for (ssize_t i = 0; i < length; i++) {
+				if (buffer[i] == '/') {
+					start = static_cast<size_t>(i) + 1;
+				}
+			}
+		}
+
+		// widened byte by byte like the names of process events, so both match the same rules,
+		// and in place so a reused name does not allocate
+		name.resize(static_cast<size_t>(length) - start);
+		for (size_t i = 0; i < name.size(); i++) {
+			name[i] = static_cast<wchar_t>(buffer[start + i]);
+		}
+		return true;
+	}
+
+	std::string EncodeUtf8(const wchar_t* text)
+	{
+		std::string encoded;
+		for (; *text != L'\0'; text++) {
+			unsigned long c = static_cast<unsigned long>(*text);
+			if (c < 0x80) {
+				encoded += static_cast<char>(c);
+			}
+			else if (c < 0x800) {
+				encoded += static_cast<char>(0xC0 | (c >> 6));
+				encoded += static_cast<char>(0x80 | (c & 0x3F));
+			}
+			else if (c < 0x10000) {
+				encoded += static_cast<char>(0xE0 | (c >> 12));
+				encoded += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				encoded += static_cast<char>(0x80 | (c & 0x3F));
+			}
+			else {
+				encoded += static_cast<char>(0xF0 | (c >> 18));
+				encoded += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+				encoded += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				encoded += static_cast<char>(0x80 | (c & 0x3F));
+			}
+		}
+		return encoded;
+	}
+
+	// Invalid sequences decode to U+FFFD.
+	void DecodeUtf8(const std::string& encoded, std::wstring& text)
+	{
+		text.clear();
+		text.reserve(encoded.size());
+		for (size_t i = 0; i < encoded.size();) {
+			unsigned char lead = static_cast<unsigned char>(encoded[i]);
+			size_t extra = lead < 0x80 ? 0 : lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 4;
+			unsigned long c = extra == 0 ? lead : extra == 1 ? (lead & 0x1Fu) : extra == 2 ? (lead & 0x0Fu) : (lead & 0x07u);
+			if (extra > 3 || i + extra >= encoded.size()) {
+				text += static_cast<wchar_t>(0xFFFD);
+				i++;
+				continue;
+			}
+
+			bool valid = true;
+			for (size_t k = 1; k <= extra; k++) {
+				unsigned char next = static_cast<unsigned char>(encoded[i + k]);
+				valid = valid && (next & 0xC0) == 0x80;
+				c = (c << 6) | (next & 0x3Fu);
+			}
+			text += valid ? static_cast<wchar_t>(c) : static_cast<wchar_t>(0xFFFD);
+			i += valid ? extra + 1 : 1;
+		}
+	}
+
+	bool WriteTextFully(int fd, const std::string& text)
+	{
+		for (size_t written = 0; written < text.size();) {
+			ssize_t length = write(fd, text.data() + written, text.size() - written);
+			if (length < 0 && errno == EINTR) {
+				continue;
+			}
+			if (length <= 0) {
+				return false;
+			}
+			written += static_cast<size_t>(length);
+		}
+		return true;
+	}
+
+	// sched_setaffinity and setpriority act on one thread, so process-wide calls go to every
+	// thread. Returns the first error other than a thread exiting meanwhile.
+	template <typename Apply>
+	int ForEachThread(pid_t pid, Apply apply)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/%d/task", static_cast<int>(pid));
+		DIR* directory = opendir(path);
+		if (directory == nullptr) {
+			return apply(pid) == 0 ? 0 : errno;
+		}
+
+		int error = 0;
+		while (dirent* entry = readdir(directory)) {
+			char* end = nullptr;
+			unsigned long tid = strtoul(entry->d_name, &end, 10);
+			if (end == entry->d_name || *end != '\0') {
+				continue;
+			}
+			if (apply(static_cast<pid_t>(tid)) != 0 && errno != ESRCH && error == 0) {
+				error = errno;
+			}
+		}
+		closedir(directory);
+		return error;
+	}
+
+	OsStatus ErrnoStatus(int error)
+	{
+		return error == 0 ? OsStatus::Ok : error == EPERM || error == EACCES ? OsStatus::AccessDenied : OsStatus::Failed;
+	}
+
+	// The handle of an open process. It holds no descriptor, so the handle cache can keep one
+	// for every process: the start time in /proc/<pid>/stat tells a reused PID from this process.
+	struct LinuxProcess
+	{
+		pid_t pid = 0;
+		unsigned long long startTicks = 0;
+	};
+
+	// sched_setaffinity, setpriority, /proc and sysfs. Hybrid parts are found through the
+	// cpu_core and cpu_atom PMUs of Intel hybrid CPUs, other systems are classed by CPU
+	// capacity when it differs. Linux has no soft affinity, soft placements are applied
+	// as affinity masks, and no per-process power throttling or memory priority.
+	class LinuxOsBackend : public OsBackend
+	{
+	public:
+		LinuxOsBackend()
+		{
+			long count = sysconf(_SC_NPROCESSORS_CONF);
+			for (long cpu = 0; cpu < count; cpu++) {
+				m_AllCpus.push_back(static_cast<unsigned long>(cpu));
+			}
+		}
+
+		bool DetectTopology(bool allowCached, std::vector<ProcessorDescription>& processors) override
+		{
+			// sysfs is cheap to read, there is nothing worth caching
+			(void)allowCached;
+			processors.clear();
+
+			std::string text;
+			std::vector<unsigned> online;
+			if (!ReadSysfsText("/sys/devices/system/cpu/online", text)) {
+				return false;
+			}
+			ParseCpuList(text, online);
+
+			std::vector<unsigned> pCpus, eCpus;
+			bool hybrid = ReadSysfsText("/sys/devices/cpu_core/cpus", text);
+			ParseCpuList(text, pCpus);
+			hybrid = ReadSysfsText("/sys/devices/cpu_atom/cpus", text) && hybrid;
+			ParseCpuList(text, eCpus);
+			hybrid = hybrid && !pCpus.empty() && !eCpus.empty();
+
+			std::vector<uint64_t> flags;
+			ReadCpuFlags(flags);
+
+			// physical cores are numbered within each group in order of first appearance
+			std::map<std::pair<unsigned, std::pair<unsigned long, unsigned long>>, unsigned> coreIndices;
+			std::vector<unsigned> groupCoreCounts;
+			std::vector<unsigned long> ranks;
+			char path[128];
+			for (unsigned cpu : online) {
+				ProcessorDescription processor;
+				processor.core.group = static_cast<unsigned short>(cpu / cpusPerGroup);
+				processor.core.index = static_cast<unsigned char>(cpu % cpusPerGroup);
+				processor.core.cpuSetId = cpu;
+
+				snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+				unsigned long package = ReadSysfsNumber(path, 0);
+				snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+				unsigned long coreId = ReadSysfsNumber(path, cpu);
+				unsigned group = processor.core.group;
+				if (groupCoreCounts.size() <= group) {
+					groupCoreCounts.resize(group + 1, 0);
+				}
+				auto inserted = coreIndices.insert(std::make_pair(std::make_pair(group, std::make_pair(package, coreId)), groupCoreCounts[group]));
+				if (inserted.second) {
+					groupCoreCounts[group]++;
+				}
+				processor.core.coreIndex = static_cast<unsigned char>(inserted.first->second);
+
+				snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpufreq/cpuinfo_max_freq", cpu);
+				processor.maxMhz = static_cast<unsigned>(ReadSysfsNumber(path, 0) / 1000);
+				snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpufreq/base_frequency", cpu);
+				processor.baseMhz = static_cast<unsigned>(ReadSysfsNumber(path, 0) / 1000);
+				if (cpu < flags.size()) {
+					processor.features = flags[cpu];
+				}
+
+				if (hybrid) {
+					bool atom = std::find(eCpus.begin(), eCpus.end(), cpu) != eCpus.end();
+					processor.coreType = atom ? atomCoreType : coreCoreType;
+					ranks.push_back(atom ? 0 : 1);
+				}
+				else {
+					// cpu_capacity is set on asymmetric Arm systems. Elsewhere every CPU is one class:
+					// Turbo Boost Max 3.0 gives a few identical cores a higher maximum frequency,
+					// so it cannot tell core types apart.
+					snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpu_capacity", cpu);
+					ranks.push_back(ReadSysfsNumber(path, 0));
+				}
+				processors.push_back(processor);
+			}
+
+			// efficiency classes number the distinct ranks from the lowest, the highest class
+			// marks the P-cores, so a system with a single class has no E-cores
+			std::vector<unsigned long> distinct(ranks);
+			std::sort(distinct.begin(), distinct.end());
+			distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+			for (size_t i = 0; i < processors.size(); i++) {
+				size_t efficiencyClass = std::lower_bound(distinct.begin(), distinct.end(), ranks[i]) - distinct.begin();
+				processors[i].core.efficiencyClass = static_cast<unsigned char>(efficiencyClass);
+				processors[i].core.coreClass = efficiencyClass + 1 == distinct.size() ? CoreClass::Performance : CoreClass::Efficiency;
+			}
+			return !processors.empty();
+		}
+
+		bool EnumerateProcesses(ProcessList& processes) override
+		{
+			processes.Clear();
+			DIR* proc = opendir("/proc");
+			if (proc == nullptr) {
+				return false;
+			}
+
+			std::wstring name;
+			while (dirent* entry = readdir(proc)) {
+				char* end = nullptr;
+				unsigned long pid = strtoul(entry->d_name, &end, 10);
+				if (end == entry->d_name || *end != '\0' || pid == 0) {
+					continue;
+				}
+				// processes that exit during the walk are left out
+				if (ReadProcessName(pid, name)) {
+					processes.Add(pid, name.c_str(), name.size());
+				}
+			}
+			closedir(proc);
+			return true;
+		}
+
+		OsStatus OpenProcess(unsigned long pid, ProcessHandle& process) override
+		{
+			unsigned long long cpuTicks = 0, startTicks = 0;
+			if (!ReadProcessStat(pid, cpuTicks, startTicks)) {
+				return OsStatus::Failed;
+			}
+
+			LinuxProcess* linuxProcess = new LinuxProcess();
+			linuxProcess->pid = static_cast<pid_t>(pid);
+			linuxProcess->startTicks = startTicks;
+			process.handle = linuxProcess;
+			process.creationTime = startTicks;
+			return OsStatus::Ok;
+		}
+
+		bool HasExited(void* handle) override
+		{
+			const LinuxProcess* process = static_cast<const LinuxProcess*>(handle);
+			unsigned long long cpuTicks = 0, startTicks = 0;
+			return !ReadProcessStat(static_cast<unsigned long>(process->pid), cpuTicks, startTicks) || startTicks != process->startTicks;
+		}
+
+		void CloseProcess(void* handle) override
+		{
+			delete static_cast<LinuxProcess*>(handle);
+		}
+
+		// Cached processes hold no descriptors, only a little memory each
+		std::size_t MaxCachedHandles() override
+		{
+			return 65536;
+		}
+
+		bool ProcessImagePath(void* handle, std::wstring& path) override
+		{
+			char link[64];
+			char buffer[4096];
+			snprintf(link, sizeof(link), "/proc/%d/exe", static_cast<int>(static_cast<const LinuxProcess*>(handle)->pid));
+			ssize_t length = readlink(link, buffer, sizeof(buffer));
+			if (length <= 0) {
+				path.clear();
+				return false;
+			}
+			path.assign(buffer, buffer + length);
+			return true;
+		}
+
+		OsStatus ApplyPlacement(void* handle, const Placement& placement, bool clearCpuSets, const CpuMask& allMask, unsigned groupCount) override
+		{
+			(void)clearCpuSets;
+			(void)allMask;
+			(void)groupCount;
+			if (placement.mask.Empty()) {
+				return OsStatus::Failed;
+			}
+
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			for (unsigned group = 0; group < placement.mask.GroupSpan(); group++) {
+				uint64_t bits = placement.mask.Group(group);
+				for (unsigned bit = 0; bit < cpusPerGroup; bit++) {
+					unsigned cpu = group * cpusPerGroup + bit;
+					if (((bits >> bit) & 1u) != 0 && cpu < CPU_SETSIZE) {
+						CPU_SET(cpu, &set);
+					}
+				}
+			}
+
+			pid_t pid = static_cast<const LinuxProcess*>(handle)->pid;
+			return ErrnoStatus(ForEachThread(pid, [&](pid_t tid) { return sched_setaffinity(tid, sizeof(set), &set); }));
+		}
+
+		void EndBackgroundMode(void* handle) override
+		{
+			// Linux has no background processing mode
+			(void)handle;
+		}
+
+		bool SetPriority(void* handle, PriorityClass priority) override
+		{
+			int nice = 0;
+			switch (priority) {
+			case PriorityClass::Idle: nice = 19; break;
+			case PriorityClass::BelowNormal: nice = 10; break;
+			case PriorityClass::Normal: nice = 0; break;
+			case PriorityClass::AboveNormal: nice = -5; break;
+			case PriorityClass::High: nice = -10; break;
+			default: return true;
+			}
+
+			pid_t pid = static_cast<const LinuxProcess*>(handle)->pid;
+			return ForEachThread(pid, [&](pid_t tid) { return setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice); }) == 0;
+		}
+
+		bool SetPowerThrottling(void* handle, PowerThrottling throttling) override
+		{
+			(void)handle;
+			return throttling == PowerThrottling::Unchanged;
+		}
+
+		bool SetMemoryPriority(void* handle, MemoryPriority priority) override
+		{
+			(void)handle;
+			return priority == MemoryPriority::Unchanged;
+		}
+
+		bool EnumerateThreads(unsigned long pid, std::vector<ThreadSample>& threads) override
+		{
+			return Core::EnumerateThreads(pid, threads);
+		}
+
+		bool SetThreadCpus(unsigned long tid, const std::vector<unsigned long>& cpuSets) override
+		{
+			return Core::SetThreadCpus(tid, cpuSets.empty() ? m_AllCpus : cpuSets);
+		}
+
+		bool SetCurrentThreadCpus(const std::vector<unsigned long>& cpuSets) override
+		{
+			// thread ID 0 is the calling thread
+			return SetThreadCpus(0, cpuSets);
+		}
+
+		bool ReadTextFile(const wchar_t* path, std::wstring& text) override
+		{
+			std::string contents;
+			if (!ReadSysfsText(EncodeUtf8(path).c_str(), contents)) {
+				return false;
+			}
+			DecodeUtf8(contents, text);
+			return true;
+		}
+
+		bool WriteTextFile(const wchar_t* path, const std::string& text) override
+		{
+			std::string target = EncodeUtf8(path);
+			struct stat status;
+			bool exists = stat(target.c_str(), &status) == 0;
+			if (exists && S_ISSOCK(status.st_mode)) {
+				sockaddr_un address = {};
+				address.sun_family = AF_UNIX;
+				if (target.size() >= sizeof(address.sun_path)) {
+					return false;
+				}
+				memcpy(address.sun_path, target.c_str(), target.size() + 1);
+
+				int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+				if (fd < 0) {
+					return false;
+				}
+				bool ok = connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 && WriteTextFully(fd, text);
+				close(fd);
+				return ok;
+			}
+			if (exists && S_ISFIFO(status.st_mode)) {
+				// without a reader the open fails rather than blocking the controller
+				int fd = open(target.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+				if (fd < 0) {
+					return false;
+				}
+				bool ok = WriteTextFully(fd, text);
+				close(fd);
+				return ok;
+			}
+
+			std::string temporary = target + ".tmp";
+			int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (fd < 0) {
+				return false;
+			}
+			bool ok = WriteTextFully(fd, text);
+			ok = close(fd) == 0 && ok;
+			if (!ok || rename(temporary.c_str(), target.c_str()) != 0) {
+				unlink(temporary.c_str());
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		std::vector<unsigned long> m_AllCpus;
+	};
+
+	std::unique_ptr<OsBackend> CreateOsBackend()
+	{
+		return std::unique_ptr<OsBackend>(new LinuxOsBackend());
+	}
+}
+
+#endif
@@ -1,71 +1,825 @@
 ﻿#include "ManagedController.h"
 
 #include <iostream>
+#include <cstring>
 #include <ostream>
 #include <string>
+#include <vector>
+#include <msclr\lock.h>
 #include <msclr\marshal.h>
 #include <msclr\marshal_cppstd.h>
+#include <vcclr.h>
+
+#include "AdaptivePlacement.h"
+#include "EnergySampler.h"
+#include "ProcessCpuSampler.h"
 
 using namespace CLI;
 
+// PIDs cross into managed arrays as raw memory, which relies on the Windows 32-bit long.
+static_assert(sizeof(unsigned long) == sizeof(System::UInt32), "PID arrays are copied as raw memory");
+
+// How long the event thread waits for process events before checking whether it should stop.
+static const unsigned eventWaitMs = 100;
+
+namespace CLI
+{
+    // The Task of a queued request and the registration that cancels it.
+    ref class PendingRequest
+    {
+    public:
+        System::Threading::Tasks::TaskCompletionSource<int>^ completion;
+        System::Threading::CancellationTokenRegistration registration;
+    };
+
+    // Lets the native command server take m_Lock, so its batches and the managed calls
+    // never run at the same time.
+    class MonitorLock : public Core::ControllerLock
+    {
+    public:
+        explicit MonitorLock(System::Object^ lock) : m_Lock(lock) {}
+
+        void Lock() override
+        {
+            System::Threading::Monitor::Enter(m_Lock);
+        }
+
+        void Unlock() override
+        {
+            System::Threading::Monitor::Exit(m_Lock);
+        }
+
+    private:
+        gcroot<System::Object^> m_Lock;
+    };
+
+    // Ends the Tasks of queued requests that a command server batch superseded.
+    class SupersededListener : public Core::RequestListener
+    {
+    public:
+        explicit SupersededListener(System::Action<System::UInt64>^ superseded) : m_Superseded(superseded) {}
+
+        void Superseded(unsigned long long token) override
+        {
+            m_Superseded->Invoke(token);
+        }
+
+    private:
+        gcroot<System::Action<System::UInt64>^> m_Superseded;
+    };
+}
+
 ManagedController::ManagedController()
 {
     this->m_NativeController = new Core::NativeController();
+    this->m_Lock = gcnew System::Object();
+    this->m_RequestListener = new SupersededListener(gcnew System::Action<System::UInt64>(this, &ManagedController::SupersedeRequest));
+    this->m_Requests = new Core::RequestQueue(*m_NativeController, m_RequestListener);
+    this->m_PendingRequests = gcnew System::Collections::Generic::Dictionary<System::UInt64, PendingRequest^>();
+    this->m_ServerLock = new MonitorLock(m_Lock);
+    // the server queues its bulk applies with ours, so each supersedes and cancels the other's
+    this->m_CommandServer = new Core::CommandServer(*m_NativeController, *m_Requests, m_ServerLock);
 }
 
 ManagedController::~ManagedController()
 {
+    StopCommandServer();
+    StopRequests();
+    StopAdaptivePlacement();
+    StopProcessEvents();
+    delete this->m_CommandServer;
+    delete this->m_ServerLock;
+    delete this->m_Requests;
+    delete this->m_RequestListener;
     delete this->m_NativeController;
 }
 
 ManagedController::!ManagedController()
 {
+    delete this->m_CommandServer;
+    delete this->m_ServerLock;
+    delete this->m_Requests;
+    delete this->m_RequestListener;
     delete this->m_NativeController;
 }
 
 void ManagedController::DetectCoreCount()
 {
+    msclr::lock lock(m_Lock);
     m_NativeController->DetectCoreCount();
 }
 
 int ManagedController::TotalCoreCount()
 {
+    msclr::lock lock(m_Lock);
     return m_NativeController->TotalCoreCount();
 }
 
 int ManagedController::EfficiencyCoreCount()
 {
+    msclr::lock lock(m_Lock);
     return m_NativeController->EfficiencyCoreCount();
 }
 
 int ManagedController::PerformanceCoreCount()
 {
+    msclr::lock lock(m_Lock);
     return m_NativeController->PerformanceCoreCount();
 }
 
+int ManagedController::LastBoundCount()
+{
+    msclr::lock lock(m_Lock);
+    return m_NativeController->LastApplyResult().bound;
+}
+
+int ManagedController::LastSkippedCount()
+{
+    msclr::lock lock(m_Lock);
+    return m_NativeController->LastApplyResult().skipped;
+}
+
+int ManagedController::LastFailedCount()
+{
+    msclr::lock lock(m_Lock);
+    return m_NativeController->LastApplyResult().failed;
+}
+
+int ManagedController::LastDeniedCount()
+{
+    msclr::lock lock(m_Lock);
+    return m_NativeController->LastApplyResult().denied;
+}
+
+int ManagedController::LastUnsupportedCount()
+{
+    msclr::lock lock(m_Lock);
+    return m_NativeController->LastApplyResult().unsupported;
+}
+
+static LatencyMetrics ToLatencyMetrics(const Core::LatencyHistogram& histogram)
+{
+    LatencyMetrics latency;
+    latency.Count = histogram.count;
+    latency.TotalMilliseconds = histogram.totalNs / 1e6;
+    latency.MaxMilliseconds = histogram.maxNs / 1e6;
+    latency.Buckets = gcnew array<System::UInt64>(Core::LatencyHistogram::BucketCount);
+    for (unsigned i = 0; i < Core::LatencyHistogram::BucketCount; i++)
+    {
+        latency.Buckets[i] = histogram.buckets[i];
+    }
+    return latency;
+}
+
+// Metrics are recorded without locks, so they are read without taking m_Lock and can be
+// polled while a long apply is running.
+ControllerMetrics ManagedController::GetMetrics()
+{
+    Core::MetricsSnapshot snapshot = m_NativeController->Metrics();
+    ControllerMetrics metrics;
+    metrics.Applies = snapshot.Counter(Core::MetricCounter::Applies);
+    metrics.Scanned = snapshot.Counter(Core::MetricCounter::Scanned);
+    metrics.Bound = snapshot.Counter(Core::MetricCounter::Bound);
+    metrics.Skipped = snapshot.Counter(Core::MetricCounter::Skipped);
+    metrics.Failed = snapshot.Counter(Core::MetricCounter::Failed);
+    metrics.Denied = snapshot.Counter(Core::MetricCounter::Denied);
+    metrics.Snapshot = ToLatencyMetrics(snapshot.Latency(Core::MetricOperation::Snapshot));
+    metrics.Open = ToLatencyMetrics(snapshot.Latency(Core::MetricOperation::Open));
+    metrics.SetAffinity = ToLatencyMetrics(snapshot.Latency(Core::MetricOperation::SetAffinity));
+    metrics.Apply = ToLatencyMetrics(snapshot.Latency(Core::MetricOperation::Apply));
+    return metrics;
+}
+
+void ManagedController::ResetMetrics()
+{
+    m_NativeController->ResetMetrics();
+}
+
+// Writes the metrics in the OpenMetrics text format to a file, or to a named pipe such as
+// \\.\pipe\name that a collector is listening on.
+bool ManagedController::ExportMetrics(System::String^ path)
+{
+    std::wstring str = msclr::interop::marshal_as<std::wstring>(path);
+    return m_NativeController->ExportMetrics(str.c_str());
+}
+
+void ManagedController::SetApplyConcurrency(int workers)
+{
+    msclr::lock lock(m_Lock);
+    m_NativeController->SetApplyConcurrency(workers);
+}
+
 void ManagedController::MoveAllAppsToEfficiencyCores()
 {
+    msclr::lock lock(m_Lock);
     m_NativeController->MoveAllAppsToEfficiencyCores();
 }
 
 void ManagedController::MoveAllAppsToSomeEfficiencyCores()
 {
+    msclr::lock lock(m_Lock);
     m_NativeController->MoveAllAppsToSomeEfficiencyCores();
 }
 
 bool ManagedController::MoveAppToHybridCores(System::String^ target, int eCores, int pCores)
 {
+    return MoveAppToHybridCores(target, eCores, pCores, PlacementMode::Hard);
+}
+
+bool ManagedController::MoveAppToHybridCores(System::String^ target, int eCores, int pCores, PlacementMode mode)
+{
+    msclr::lock lock(m_Lock);
     std::wstring str = msclr::interop::marshal_as<std::wstring>(target);
     const wchar_t* wstr = str.c_str();
-    return m_NativeController->MoveAppToHybridCores(wstr, eCores, pCores);
+    return m_NativeController->MoveAppToHybridCores(wstr, eCores, pCores, static_cast<Core::PlacementMode>(mode));
+}
+
+bool ManagedController::MoveAppToFeatureCores(System::String^ target, System::UInt64 requiredFeatures, PlacementMode mode)
+{
+    msclr::lock lock(m_Lock);
+    std::wstring str = msclr::interop::marshal_as<std::wstring>(target);
+    return m_NativeController->MoveAppToFeatureCores(str.c_str(), requiredFeatures, static_cast<Core::PlacementMode>(mode));
+}
+
+array<bool>^ ManagedController::MoveAppsToHybridCores(array<System::String^>^ targets, array<int>^ eCores, array<int>^ pCores)
+{
+    msclr::lock lock(m_Lock);
+    if (targets->Length != eCores->Length || targets->Length != pCores->Length)
+    {
+        throw gcnew System::ArgumentException("targets, eCores and pCores must have the same length");
+    }
+
+    std::vector<Core::HybridTarget> nativeTargets(targets->Length);
+    for (int i = 0; i < targets->Length; i++)
+    {
+        nativeTargets[i].exeName = msclr::interop::marshal_as<std::wstring>(targets[i]);
+        nativeTargets[i].eCores = eCores[i];
+        nativeTargets[i].pCores = pCores[i];
+    }
+
+    std::vector<bool> results = m_NativeController->MoveAppsToHybridCores(nativeTargets);
+
+    array<bool>^ managedResults = gcnew array<bool>(targets->Length);
+    for (int i = 0; i < targets->Length; i++)
+    {
+        managedResults[i] = results[i];
+    }
+    return managedResults;
 }
 
 void ManagedController::MoveAllAppsToHybridCores(int eCores, int pCores)
 {
-    m_NativeController->MoveAllAppsToHybridCores(eCores, pCores);
+    MoveAllAppsToHybridCores(eCores, pCores, PlacementMode::Hard);
+}
+
+void ManagedController::MoveAllAppsToHybridCores(int eCores, int pCores, PlacementMode mode)
+{
+    msclr::lock lock(m_Lock);
+    m_NativeController->MoveAllAppsToHybridCores(eCores, pCores, static_cast<Core::PlacementMode>(mode));
+}
+
+int ManagedController::PlaceAppThreads(System::String^ target, double performanceShare, int maxPerformanceThreads)
+{
+    msclr::lock lock(m_Lock);
+    std::wstring str = msclr::interop::marshal_as<std::wstring>(target);
+
+    Core::ThreadPlacementPolicy policy;
+    policy.performanceShare = performanceShare;
+    policy.maxPerformanceThreads = maxPerformanceThreads;
+    return m_NativeController->PlaceAppThreads(str.c_str(), policy);
 }
 
 void ManagedController::ResetToDefaultCores()
 {
+    msclr::lock lock(m_Lock);
     m_NativeController->ResetToDefaultCores();
 }
+
+// The Async methods queue the operation and return at once. The Task completes with what the
+// synchronous call would return, bound processes for bulk applies, or is cancelled when the
+// token is cancelled or a later request supersedes it before it starts. A bulk apply that is
+// cancelled while running stops at its next process and leaves the rest as they were.
+System::Threading::Tasks::Task<int>^ ManagedController::MoveAllAppsToEfficiencyCoresAsync(System::Threading::CancellationToken cancellation)
+{
+    Core::ControllerRequest request;
+    request.type = Core::RequestType::MoveAllAppsToEfficiencyCores;
+    return SubmitRequest(request, cancellation);
+}
+
+System::Threading::Tasks::Task<int>^ ManagedController::MoveAllAppsToSomeEfficiencyCoresAsync(System::Threading::CancellationToken cancellation)
+{
+    Core::ControllerRequest request;
+    request.type = Core::RequestType::MoveAllAppsToSomeEfficiencyCores;
+    return SubmitRequest(request, cancellation);
+}
+
+System::Threading::Tasks::Task<int>^ ManagedController::MoveAllAppsToHybridCoresAsync(int eCores, int pCores, PlacementMode mode, System::Threading::CancellationToken cancellation)
+{
+    Core::ControllerRequest request;
+    request.type = Core::RequestType::MoveAllAppsToHybridCores;
+    request.eCores = eCores;
+    request.pCores = pCores;
+    request.mode = static_cast<Core::PlacementMode>(mode);
+    return SubmitRequest(request, cancellation);
+}
+
+// Completes with 1 when any instance of target was bound, 0 otherwise.
+System::Threading::Tasks::Task<int>^ ManagedController::MoveAppToHybridCoresAsync(System::String^ target, int eCores, int pCores, PlacementMode mode, System::Threading::CancellationToken cancellation)
+{
+    Core::ControllerRequest request;
+    request.type = Core::RequestType::MoveAppToHybridCores;
+    request.target = msclr::interop::marshal_as<std::wstring>(target);
+    request.eCores = eCores;
+    request.pCores = pCores;
+    request.mode = static_cast<Core::PlacementMode>(mode);
+    return SubmitRequest(request, cancellation);
+}
+
+System::Threading::Tasks::Task<int>^ ManagedController::ResetToDefaultCoresAsync(System::Threading::CancellationToken cancellation)
+{
+    Core::ControllerRequest request;
+    request.type = Core::RequestType::ResetToDefaultCores;
+    return SubmitRequest(request, cancellation);
+}
+
+System::Threading::Tasks::Task<int>^ ManagedController::ApplyPlacementPolicyAsync(System::Threading::CancellationToken cancellation)
+{
+    Core::ControllerRequest request;
+    request.type = Core::RequestType::ApplyPlacementPolicy;
+    return SubmitRequest(request, cancellation);
+}
+
+// The settings requests complete with 1 when accepted and 0 otherwise. Queued, they take
+// effect after the requests submitted before them, without waiting for m_Lock on the caller.
+System::Threading::Tasks::Task<int>^ ManagedController::WatchAppAsync(System::String^ target, int eCores, int pCores, PlacementMode mode, System::Threading::CancellationToken cancellation)
+{
+    Core::ControllerRequest request;
+    request.type = Core::RequestType::WatchApp;
+    request.target = msclr::interop::marshal_as<std::wstring>(target);
+    request.eCores = eCores;
+    request.pCores = pCores;
+    request.mode = static_cast<Core::PlacementMode>(mode);
+    return SubmitRequest(request, cancellation);
+}
+
+System::Threading::Tasks::Task<int>^ ManagedController::UnwatchAppAsync(System::String^ target, System::Threading::CancellationToken cancellation)
+{
+    Core::ControllerRequest request;
+    request.type = Core::RequestType::UnwatchApp;
+    request.target = msclr::interop::marshal_as<std::wstring>(target);
+    return SubmitRequest(request, cancellation);
+}
+
+System::Threading::Tasks::Task<int>^ ManagedController::LoadPlacementPolicyAsync(System::String^ path, System::Threading::CancellationToken cancellation)
+{
+    Core::ControllerRequest request;
+    request.type = Core::RequestType::LoadPlacementPolicy;
+    request.target = msclr::interop::marshal_as<std::wstring>(path);
+    return SubmitRequest(request, cancellation);
+}
+
+int ManagedController::PendingRequestCount()
+{
+    return static_cast<int>(m_Requests->PendingCount());
+}
+
+System::Threading::Tasks::Task<int>^ ManagedController::SubmitRequest(const Core::ControllerRequest& request, System::Threading::CancellationToken cancellation)
+{
+    if (cancellation.IsCancellationRequested)
+    {
+        return System::Threading::Tasks::Task::FromCanceled<int>(cancellation);
+    }
+
+    // continuations run on the pool rather than on the request thread
+    PendingRequest^ pending = gcnew PendingRequest();
+    pending->completion = gcnew System::Threading::Tasks::TaskCompletionSource<int>(
+        System::Threading::Tasks::TaskCreationOptions::RunContinuationsAsynchronously);
+
+    std::vector<unsigned long long> superseded;
+    System::UInt64 token;
+    {
+        // held across Submit so the request thread cannot finish the request before it is listed
+        msclr::lock lock(m_PendingRequests);
+        if (m_RequestThread == nullptr)
+        {
+            m_RequestsRunning = true;
+            m_RequestThread = gcnew System::Threading::Thread(gcnew System::Threading::ThreadStart(this, &ManagedController::RequestLoop));
+            m_RequestThread->IsBackground = true;
+            m_RequestThread->Name = "ControllerRequests";
+            m_RequestThread->Start();
+        }
+        token = m_Requests->Submit(request, superseded);
+        m_PendingRequests->Add(token, pending);
+    }
+
+    if (cancellation.CanBeCanceled)
+    {
+        pending->registration = cancellation.Register(gcnew System::Action<System::Object^>(this, &ManagedController::CancelRequest), token);
+    }
+    for (unsigned long long supersededToken : superseded)
+    {
+        CompleteRequest(supersededToken, Core::RequestStatus::Superseded, 0, nullptr);
+    }
+    return pending->completion->Task;
+}
+
+// Runs on the cancelling thread. It never takes m_Lock, which the request thread holds for
+// the whole apply, and stops a running apply through the thread-safe CancelApplies.
+void ManagedController::CancelRequest(System::Object^ state)
+{
+    System::UInt64 token = safe_cast<System::UInt64>(state);
+    if (m_Requests->Cancel(token) == Core::RequestStatus::Cancelled)
+    {
+        CompleteRequest(token, Core::RequestStatus::Cancelled, 0, nullptr);
+    }
+}
+
+void ManagedController::CompleteRequest(System::UInt64 token, Core::RequestStatus status, int result, System::Exception^ error)
+{
+    PendingRequest^ pending;
+    {
+        msclr::lock lock(m_PendingRequests);
+        if (!m_PendingRequests->TryGetValue(token, pending))
+        {
+            return;
+        }
+        m_PendingRequests->Remove(token);
+    }
+
+    // waits for a running cancel callback, so it must not hold the lock that callback takes
+    pending->registration.Dispose();
+    if (error != nullptr)
+    {
+        pending->completion->TrySetException(error);
+    }
+    else if (status == Core::RequestStatus::Completed)
+    {
+        pending->completion->TrySetResult(result);
+    }
+    else
+    {
+        pending->completion->TrySetCanceled();
+    }
+}
+
+// Runs on a command server connection, which holds m_Lock but never m_PendingRequests.
+void ManagedController::SupersedeRequest(System::UInt64 token)
+{
+    CompleteRequest(token, Core::RequestStatus::Superseded, 0, nullptr);
+}
+
+// Stops the request thread after the request it is running and cancels the Tasks of the
+// requests still queued.
+void ManagedController::StopRequests()
+{
+    if (m_RequestThread != nullptr)
+    {
+        m_RequestsRunning = false;
+        m_RequestThread->Join();
+        m_RequestThread = nullptr;
+    }
+
+    Core::ControllerRequest request;
+    unsigned long long token;
+    while (m_Requests->Take(request, token))
+    {
+        m_Requests->Finish(token);
+        CompleteRequest(token, Core::RequestStatus::Cancelled, 0, nullptr);
+    }
+}
+
+// Serves the binary command protocol on a named pipe such as \\.\pipe\name, for clients
+// that send commands faster than the text pipe of the elevated helper parses them.
+bool ManagedController::StartCommandServer(System::String^ name)
+{
+    std::wstring str = msclr::interop::marshal_as<std::wstring>(name);
+    return m_CommandServer->Start(str.c_str());
+}
+
+// Not under m_Lock, which the connections may be waiting for.
+void ManagedController::StopCommandServer()
+{
+    m_CommandServer->Stop();
+}
+
+bool ManagedController::StartProcessEvents()
+{
+    StopProcessEvents();
+
+    {
+        msclr::lock lock(m_Lock);
+        if (!m_NativeController->StartProcessEvents())
+        {
+            return false;
+        }
+    }
+
+    m_EventsRunning = true;
+    m_EventThread = gcnew System::Threading::Thread(gcnew System::Threading::ThreadStart(this, &ManagedController::ProcessEventLoop));
+    m_EventThread->IsBackground = true;
+    m_EventThread->Name = "ProcessEvents";
+    m_EventThread->Start();
+    return true;
+}
+
+void ManagedController::StopProcessEvents()
+{
+    if (m_EventThread != nullptr)
+    {
+        m_EventsRunning = false;
+        m_EventThread->Join();
+        m_EventThread = nullptr;
+    }
+
+    msclr::lock lock(m_Lock);
+    m_NativeController->StopProcessEvents();
+}
+
+bool ManagedController::WatchApp(System::String^ target, int eCores, int pCores)
+{
+    return WatchApp(target, eCores, pCores, PlacementMode::Hard);
+}
+
+bool ManagedController::WatchApp(System::String^ target, int eCores, int pCores, PlacementMode mode)
+{
+    msclr::lock lock(m_Lock);
+    std::wstring str = msclr::interop::marshal_as<std::wstring>(target);
+    return m_NativeController->WatchApp(str.c_str(), eCores, pCores, static_cast<Core::PlacementMode>(mode));
+}
+
+void ManagedController::UnwatchApp(System::String^ target)
+{
+    msclr::lock lock(m_Lock);
+    std::wstring str = msclr::interop::marshal_as<std::wstring>(target);
+    m_NativeController->UnwatchApp(str.c_str());
+}
+
+bool ManagedController::LoadPlacementPolicy(System::String^ path)
+{
+    msclr::lock lock(m_Lock);
+    std::wstring str = msclr::interop::marshal_as<std::wstring>(path);
+    return m_NativeController->LoadPlacementPolicy(str.c_str());
+}
+
+int ManagedController::ApplyPlacementPolicy()
+{
+    msclr::lock lock(m_Lock);
+    return m_NativeController->ApplyPlacementPolicy();
+}
+
+void ManagedController::StartAdaptivePlacement(double promoteAbove, double demoteBelow, int minDwellMs, int intervalMs)
+{
+    StopAdaptivePlacement();
+
+    {
+        msclr::lock lock(m_Lock);
+        Core::AdaptivePolicy policy;
+        policy.promoteAbove = promoteAbove;
+        policy.demoteBelow = demoteBelow;
+        policy.minDwellMs = static_cast<unsigned>(minDwellMs);
+        policy.intervalMs = static_cast<unsigned>(intervalMs);
+        m_NativeController->SetAdaptivePolicy(policy);
+    }
+
+    m_AdaptiveRunning = true;
+    m_AdaptiveThread = gcnew System::Threading::Thread(gcnew System::Threading::ThreadStart(this, &ManagedController::AdaptiveLoop));
+    m_AdaptiveThread->IsBackground = true;
+    m_AdaptiveThread->Name = "AdaptivePlacement";
+    m_AdaptiveThread->Start();
+}
+
+void ManagedController::StopAdaptivePlacement()
+{
+    if (m_AdaptiveThread != nullptr)
+    {
+        m_AdaptiveRunning = false;
+        m_AdaptiveThread->Join();
+        m_AdaptiveThread = nullptr;
+    }
+}
+
+bool ManagedController::AdaptApp(System::String^ target)
+{
+    msclr::lock lock(m_Lock);
+    std::wstring str = msclr::interop::marshal_as<std::wstring>(target);
+    return m_NativeController->AdaptApp(str.c_str());
+}
+
+void ManagedController::StopAdaptingApp(System::String^ target)
+{
+    msclr::lock lock(m_Lock);
+    std::wstring str = msclr::interop::marshal_as<std::wstring>(target);
+    m_NativeController->StopAdaptingApp(str.c_str());
+}
+
+bool ManagedController::SampleProcessCpu()
+{
+    msclr::lock lock(m_Lock);
+    return m_NativeController->SampleProcessCpu();
+}
+
+int ManagedController::ProcessCpuCount()
+{
+    msclr::lock lock(m_Lock);
+    return static_cast<int>(m_NativeController->ProcessCpu().Count());
+}
+
+double ManagedController::TotalProcessCpu()
+{
+    msclr::lock lock(m_Lock);
+    return m_NativeController->ProcessCpu().TotalUtilization();
+}
+
+// Copies the last sample into the arrays, up to their length, with the arrays pinned so
+// the whole sample crosses over in one pass. Use is in cores. Returns the entries copied.
+int ManagedController::CopyProcessCpu(array<System::UInt32>^ pids, array<float>^ utilization)
+{
+    msclr::lock lock(m_Lock);
+    const Core::ProcessCpuSampler& sampler = m_NativeController->ProcessCpu();
+    int count = static_cast<int>(sampler.Count());
+    count = System::Math::Min(count, System::Math::Min(pids->Length, utilization->Length));
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    pin_ptr<System::UInt32> pidsPinned = &pids[0];
+    pin_ptr<float> utilizationPinned = &utilization[0];
+    memcpy(pidsPinned, sampler.Pids(), count * sizeof(unsigned long));
+    memcpy(utilizationPinned, sampler.Utilization(), count * sizeof(float));
+    return count;
+}
+
+// The busiest processes of the last sample, as many as the arrays hold, busiest first.
+int ManagedController::TopProcessCpu(array<System::UInt32>^ pids, array<float>^ utilization)
+{
+    msclr::lock lock(m_Lock);
+    int count = System::Math::Min(pids->Length, utilization->Length);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    pin_ptr<System::UInt32> pidsPinned = &pids[0];
+    pin_ptr<float> utilizationPinned = &utilization[0];
+    return static_cast<int>(m_NativeController->ProcessCpu().Top(count, reinterpret_cast<unsigned long*>(pidsPinned), utilizationPinned));
+}
+
+bool ManagedController::SampleEnergy(double packageWatts)
+{
+    msclr::lock lock(m_Lock);
+    return m_NativeController->SampleEnergy(packageWatts);
+}
+
+void ManagedController::SetEnergyCoefficients(double eCoreWatts, double pCoreWatts, double exponent, double baseWatts)
+{
+    msclr::lock lock(m_Lock);
+    Core::EnergyCoefficients coefficients;
+    coefficients.eCoreWatts = eCoreWatts;
+    coefficients.pCoreWatts = pCoreWatts;
+    coefficients.exponent = exponent;
+    coefficients.baseWatts = baseWatts;
+    m_NativeController->SetEnergyCoefficients(coefficients);
+}
+
+// Copies the joules of the last SampleEnergy like CopyProcessCpu. Returns the entries copied.
+int ManagedController::CopyProcessEnergy(array<System::UInt32>^ pids, array<float>^ joules)
+{
+    msclr::lock lock(m_Lock);
+    const Core::EnergyAttributor& energy = m_NativeController->Energy();
+    int count = static_cast<int>(energy.Count());
+    count = System::Math::Min(count, System::Math::Min(pids->Length, joules->Length));
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    pin_ptr<System::UInt32> pidsPinned = &pids[0];
+    pin_ptr<float> joulesPinned = &joules[0];
+    memcpy(pidsPinned, energy.Pids(), count * sizeof(unsigned long));
+    memcpy(joulesPinned, energy.Joules(), count * sizeof(float));
+    return count;
+}
+
+bool ManagedController::StartEnergyCounters(int rateHz)
+{
+    if (!Core::PlatformHasEnergyCounters())
+    {
+        throw gcnew System::PlatformNotSupportedException("Energy counters are not readable on this platform, Windows only exposes RAPL to kernel drivers");
+    }
+
+    msclr::lock lock(m_Lock);
+    return rateHz > 0 && m_NativeController->StartEnergyCounters(static_cast<unsigned>(rateHz));
+}
+
+void ManagedController::StopEnergyCounters()
+{
+    msclr::lock lock(m_Lock);
+    m_NativeController->StopEnergyCounters();
+}
+
+int ManagedController::EnergyDomainCount()
+{
+    msclr::lock lock(m_Lock);
+    Core::EnergySampler* counters = m_NativeController->EnergyCounters();
+    return counters != nullptr ? static_cast<int>(counters->DomainCount()) : 0;
+}
+
+System::String^ ManagedController::EnergyDomainName(int domain)
+{
+    msclr::lock lock(m_Lock);
+    Core::EnergySampler* counters = m_NativeController->EnergyCounters();
+    if (counters == nullptr || domain < 0 || domain >= static_cast<int>(counters->DomainCount()))
+    {
+        return nullptr;
+    }
+    return gcnew System::String(counters->DomainName(domain));
+}
+
+// Cumulative joules and the mean watts since the previous read of every domain, as many as
+// the arrays hold. Returns the domains written.
+int ManagedController::ReadEnergyCounters(array<double>^ joules, array<double>^ watts)
+{
+    msclr::lock lock(m_Lock);
+    Core::EnergySampler* counters = m_NativeController->EnergyCounters();
+    if (counters == nullptr)
+    {
+        return 0;
+    }
+
+    counters->Update();
+    int count = System::Math::Min(static_cast<int>(counters->DomainCount()), System::Math::Min(joules->Length, watts->Length));
+    for (int d = 0; d < count; d++)
+    {
+        joules[d] = counters->Joules(d);
+        watts[d] = counters->Watts(d);
+    }
+    return count;
+}
+
+// Steps adaptive placement once per policy interval. The thread wakes every eventWaitMs
+// so stopping does not wait out a whole interval.
+void ManagedController::AdaptiveLoop()
+{
+    while (m_AdaptiveRunning)
+    {
+        System::Threading::Thread::Sleep(eventWaitMs);
+
+        msclr::lock lock(m_Lock);
+        if (m_NativeController->AdaptivePlacementDue())
+        {
+            m_NativeController->StepAdaptivePlacement();
+        }
+    }
+}
+
+// Runs queued requests one at a time in submission order. Each runs under m_Lock like the
+// synchronous calls, so the two never interleave, and the wait happens outside it.
+void ManagedController::RequestLoop()
+{
+    while (m_RequestsRunning)
+    {
+        if (!m_Requests->WaitForRequests(eventWaitMs))
+        {
+            continue;
+        }
+
+        Core::ControllerRequest request;
+        unsigned long long token;
+        int result = 0;
+        System::Exception^ error = nullptr;
+        Core::RequestStatus status;
+        {
+            msclr::lock lock(m_Lock);
+            if (!m_Requests->Take(request, token))
+            {
+                continue;
+            }
+
+            try
+            {
+                result = Core::ExecuteRequest(*m_NativeController, request);
+            }
+            catch (System::Exception^ e)
+            {
+                error = e;
+            }
+            status = m_Requests->Finish(token);
+        }
+        CompleteRequest(token, status, result, error);
+    }
+}
+
+// Drains the native event queue as events arrive, so started apps are bound within
+// milliseconds. The wait happens outside the lock so other calls are not held up.
+void ManagedController::ProcessEventLoop()
+{
+    while (m_EventsRunning)
+    {
+        if (m_NativeController->WaitForProcessEvents(eventWaitMs))
+        {
+            msclr::lock lock(m_Lock);
+            m_NativeController->DrainProcessEvents();
+        }
+    }
+}
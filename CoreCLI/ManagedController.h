@@ -1,14 +1,73 @@
 ﻿#pragma once
 #include <string>
 
+#include "CommandServer.h"
 #include "NativeController.h"
+#include "RequestQueue.h"
 
 namespace CLI
 {
+    // Mirrors Core::PlacementMode: Hard sets an affinity mask, Soft sets default CPU sets
+    // that the scheduler may leave when other cores are idle.
+    public enum class PlacementMode
+    {
+        Hard,
+        Soft
+    };
+
+    // Latency distribution of one operation. Buckets[0] counts operations under 1us,
+    // Buckets[i] those from 2^(i-1)us up to 2^i us, and the last bucket everything slower.
+    public value struct LatencyMetrics
+    {
+        System::UInt64 Count;
+        double TotalMilliseconds;
+        double MaxMilliseconds;
+        array<System::UInt64>^ Buckets;
+    };
+
+    // Mirrors Core::MetricsSnapshot: counters and latencies since the controller was created
+    // or its metrics were last reset.
+    public value struct ControllerMetrics
+    {
+        System::UInt64 Applies;
+        System::UInt64 Scanned;
+        System::UInt64 Bound;
+        System::UInt64 Skipped;
+        System::UInt64 Failed;
+        System::UInt64 Denied;
+        LatencyMetrics Snapshot;
+        LatencyMetrics Open;
+        LatencyMetrics SetAffinity;
+        LatencyMetrics Apply;
+    };
+
+    ref class PendingRequest;
+
     public ref class ManagedController
     {
     private:
         Core::NativeController* m_NativeController;
+        System::Object^ m_Lock;
+        System::Threading::Thread^ m_EventThread;
+        volatile bool m_EventsRunning;
+        System::Threading::Thread^ m_AdaptiveThread;
+        volatile bool m_AdaptiveRunning;
+        Core::RequestListener* m_RequestListener;
+        Core::RequestQueue* m_Requests;
+        System::Collections::Generic::Dictionary<System::UInt64, PendingRequest^>^ m_PendingRequests;
+        System::Threading::Thread^ m_RequestThread;
+        volatile bool m_RequestsRunning;
+        Core::ControllerLock* m_ServerLock;
+        Core::CommandServer* m_CommandServer;
+
+        void ProcessEventLoop();
+        void AdaptiveLoop();
+        void RequestLoop();
+        System::Threading::Tasks::Task<int>^ SubmitRequest(const Core::ControllerRequest& request, System::Threading::CancellationToken cancellation);
+        void CancelRequest(System::Object^ token);
+        void CompleteRequest(System::UInt64 token, Core::RequestStatus status, int result, System::Exception^ error);
+        void SupersedeRequest(System::UInt64 token);
+        void StopRequests();
     public:
         ManagedController();
         ~ManagedController();
@@ -16,12 +75,67 @@ namespace CLI
         void MoveAllAppsToEfficiencyCores();
         void MoveAllAppsToSomeEfficiencyCores();
         bool MoveAppToHybridCores(System::String^ target, int eCores, int pCores);
+        bool MoveAppToHybridCores(System::String^ target, int eCores, int pCores, PlacementMode mode);
+        // Binds several apps after one process walk. Called for the pipe's MoveAppsToHybridCores
+        // message, whose arguments the elevated process parses with HybridCoreBatch.
+        array<bool>^ MoveAppsToHybridCores(array<System::String^>^ targets, array<int>^ eCores, array<int>^ pCores);
         void MoveAllAppsToHybridCores(int eCores, int pCores);
+        void MoveAllAppsToHybridCores(int eCores, int pCores, PlacementMode mode);
+        bool MoveAppToFeatureCores(System::String^ target, System::UInt64 requiredFeatures, PlacementMode mode);
+        int PlaceAppThreads(System::String^ target, double performanceShare, int maxPerformanceThreads);
         void ResetToDefaultCores();
+        System::Threading::Tasks::Task<int>^ MoveAllAppsToEfficiencyCoresAsync(System::Threading::CancellationToken cancellation);
+        System::Threading::Tasks::Task<int>^ MoveAllAppsToSomeEfficiencyCoresAsync(System::Threading::CancellationToken cancellation);
+        System::Threading::Tasks::Task<int>^ MoveAllAppsToHybridCoresAsync(int eCores, int pCores, PlacementMode mode, System::Threading::CancellationToken cancellation);
+        System::Threading::Tasks::Task<int>^ MoveAppToHybridCoresAsync(System::String^ target, int eCores, int pCores, PlacementMode mode, System::Threading::CancellationToken cancellation);
+        System::Threading::Tasks::Task<int>^ ResetToDefaultCoresAsync(System::Threading::CancellationToken cancellation);
+        System::Threading::Tasks::Task<int>^ ApplyPlacementPolicyAsync(System::Threading::CancellationToken cancellation);
+        System::Threading::Tasks::Task<int>^ WatchAppAsync(System::String^ target, int eCores, int pCores, PlacementMode mode, System::Threading::CancellationToken cancellation);
+        System::Threading::Tasks::Task<int>^ UnwatchAppAsync(System::String^ target, System::Threading::CancellationToken cancellation);
+        System::Threading::Tasks::Task<int>^ LoadPlacementPolicyAsync(System::String^ path, System::Threading::CancellationToken cancellation);
+        int PendingRequestCount();
+        bool StartCommandServer(System::String^ name);
+        void StopCommandServer();
         void DetectCoreCount();
         int TotalCoreCount();
         int EfficiencyCoreCount();
         int PerformanceCoreCount();
+        int LastBoundCount();
+        int LastSkippedCount();
+        int LastFailedCount();
+        int LastDeniedCount();
+        int LastUnsupportedCount();
+        ControllerMetrics GetMetrics();
+        void ResetMetrics();
+        bool ExportMetrics(System::String^ path);
+        void SetApplyConcurrency(int workers);
+        bool StartProcessEvents();
+        void StopProcessEvents();
+        bool WatchApp(System::String^ target, int eCores, int pCores);
+        bool WatchApp(System::String^ target, int eCores, int pCores, PlacementMode mode);
+        void UnwatchApp(System::String^ target);
+        bool LoadPlacementPolicy(System::String^ path);
+        int ApplyPlacementPolicy();
+        void StartAdaptivePlacement(double promoteAbove, double demoteBelow, int minDwellMs, int intervalMs);
+        void StopAdaptivePlacement();
+        bool AdaptApp(System::String^ target);
+        void StopAdaptingApp(System::String^ target);
+        bool SampleProcessCpu();
+        int ProcessCpuCount();
+        double TotalProcessCpu();
+        int CopyProcessCpu(array<System::UInt32>^ pids, array<float>^ utilization);
+        int TopProcessCpu(array<System::UInt32>^ pids, array<float>^ utilization);
+        bool SampleEnergy(double packageWatts);
+        void SetEnergyCoefficients(double eCoreWatts, double pCoreWatts, double exponent, double baseWatts);
+        int CopyProcessEnergy(array<System::UInt32>^ pids, array<float>^ joules);
+        // Native energy counters. Only Linux has a source, see Core::CreateEnergyCounterSource, so on
+        // Windows StartEnergyCounters throws PlatformNotSupportedException and the readers below
+        // stay empty. Package power there comes from LibreHardwareMonitor instead.
+        bool StartEnergyCounters(int rateHz);
+        void StopEnergyCounters();
+        int EnergyDomainCount();
+        System::String^ EnergyDomainName(int domain);
+        int ReadEnergyCounters(array<double>^ joules, array<double>^ watts);
     };
 
 }
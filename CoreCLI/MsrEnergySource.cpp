@@ -0,0 +1,113 @@
+#ifdef __linux__
+
+#include "EnergyCounterSource.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace Core
+{
+	const uint32_t msrRaplPowerUnit = 0x606;
+
+	// The RAPL energy status registers, read through the msr driver.
+	struct MsrDomain
+	{
+		const char* name;
+		uint32_t address;
+	};
+
+	const MsrDomain msrDomains[] = {
+		{ "package-0", 0x611 },
+		{ "package-0/core", 0x639 },
+		{ "package-0/uncore", 0x641 },
+		{ "package-0/dram", 0x619 },
+		{ "psys", 0x64d }
+	};
+
+	// The RAPL MSRs of the first package. The status registers are 32-bit counters in the
+	// energy unit of MSR_RAPL_POWER_UNIT, converted to microjoules on read. Needs the msr
+	// module and CAP_SYS_RAWIO, which is why powercap is preferred.
+	class MsrEnergySource : public EnergyCounterSource
+	{
+	public:
+		~MsrEnergySource() override
+		{
+			if (m_File >= 0) {
+				close(m_File);
+			}
+		}
+
+		bool Open()
+		{
+			m_File = open("/dev/cpu/0/msr", O_RDONLY | O_CLOEXEC);
+			uint64_t units = 0;
+			if (m_File < 0 || !ReadMsr(msrRaplPowerUnit, units)) {
+				return false;
+			}
+
+			// energy status units are 1 / 2^ESU joules, ESU in bits 12:8
+			m_MicrojoulesPerUnit = 1000000.0 / std::ldexp(1.0, static_cast<int>((units >> 8) & 0x1F));
+
+			// registers the processor does not implement fail to read and are left out
+			for (const MsrDomain& domain : msrDomains) {
+				uint64_t value = 0;
+				if (ReadMsr(domain.address, value)) {
+					m_Domains.push_back(&domain);
+				}
+			}
+			return !m_Domains.empty();
+		}
+
+		unsigned DomainCount() const override
+		{
+			return static_cast<unsigned>(m_Domains.size());
+		}
+
+		const char* DomainName(unsigned domain) const override
+		{
+			return m_Domains[domain]->name;
+		}
+
+		unsigned long long Range(unsigned) const override
+		{
+			return static_cast<unsigned long long>(std::ldexp(m_MicrojoulesPerUnit, 32));
+		}
+
+		bool Read(unsigned long long& timestampUs, unsigned long long* microjoules) override
+		{
+			timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			for (std::size_t i = 0; i < m_Domains.size(); i++) {
+				uint64_t value = 0;
+				if (!ReadMsr(m_Domains[i]->address, value)) {
+					return false;
+				}
+				microjoules[i] = static_cast<unsigned long long>((value & 0xFFFFFFFFu) * m_MicrojoulesPerUnit);
+			}
+			return true;
+		}
+
+	private:
+		bool ReadMsr(uint32_t address, uint64_t& value)
+		{
+			return pread(m_File, &value, sizeof(value), address) == sizeof(value);
+		}
+
+		int m_File = -1;
+		double m_MicrojoulesPerUnit = 0;
+		std::vector<const MsrDomain*> m_Domains;
+	};
+
+	std::unique_ptr<EnergyCounterSource> CreateMsrEnergySource()
+	{
+		std::unique_ptr<MsrEnergySource> source(new MsrEnergySource());
+		if (!source->Open()) {
+			return std::unique_ptr<EnergyCounterSource>();
+		}
+		return source;
+	}
+}
+
+#endif
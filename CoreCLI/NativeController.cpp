@@ -1,14 +1,23 @@
 // Refactored code from original Energy Balance CLI application developed by James Bown (Intel)
 
-#include "HybridDetect.h"
-#include <windows.h>
-#include <TlHelp32.h>
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <cstring>
 #include <stdio.h>
 #include <iostream>
 #include <vector>
-#include <cmath>
 #include "NativeController.h"
+#include "AdaptivePlacement.h"
+#include "ProcessEventQueue.h"
+#include "ProcessEventSource.h"
+#include "EnergySampler.h"
+#include "FrequencySampler.h"
+#include "PlacementPolicy.h"
+#include "ProcessCpuSampler.h"
+#include "ProcessTimeSource.h"
+#include "ThreadPlacement.h"
+#include "WorkerPool.h"
 #include <iostream>
 
 using namespace std;
@@ -16,232 +25,1082 @@ using namespace std;
 namespace Core
 {
 	vector<int> coreMapArr;
-	int eCoreCount;
-	int pCoreCount;
-	int lCoreCount;
-	int hyperthreadCores;
 
-	int affinityOffset;
-	int tmpAffinity;
-
-	int eCoreMask;
-	int pCoreMask;
-	int lCoreMask;
-
-	int AffinityMaskGenerator(int coreCount) {
-		int affintyMask = 0;
-
-		for (int i = 0; i < coreCount; i++) {
-			affintyMask += pow(2, i);
-		}
-		return affintyMask;
-	}
+	// Kept out of the header, which is also compiled as managed code.
+	struct ApplyControl
+	{
+		std::atomic<bool> cancelled{ false };
+	};
 
 	NativeController::NativeController()
+		: NativeController(CreateOsBackend())
 	{
-		pCoreCount = 0;
-		lCoreCount = 0;
-		eCoreCount = 0;
-		DetectCoreCount();
-		int coreOffset = eCoreCount + lCoreCount;
+	}
 
-		int affinityOffset = AffinityMaskGenerator(hyperthreadCores);
+	NativeController::NativeController(std::unique_ptr<OsBackend> backend)
+		: m_Backend(std::move(backend)), m_HandleCache(*m_Backend), m_ApplyControl(new ApplyControl())
+	{
+		m_HandleCache.SetMetrics(&m_Metrics);
+		BuildTopology(true);
+		std::cout << "Created the Controller object." << std::endl;
+	}
 
-		int tmpAffinity = AffinityMaskGenerator(lCoreCount);
+	NativeController::~NativeController()
+	{
+		StopProcessEvents();
+	}
 
-		int eCoreMask = tmpAffinity - affinityOffset;
-		int pCoreMask = AffinityMaskGenerator(hyperthreadCores);
-		int lCoreMask = AffinityMaskGenerator(lCoreCount);
-		std::cout << "Created the Controller object." << std::endl;
+	bool SameExeName(const wchar_t* a, const wchar_t* b) {
+		while (*a != L'\0' && FoldExeName(*a) == FoldExeName(*b)) {
+			a++;
+			b++;
+		}
+		return FoldExeName(*a) == FoldExeName(*b);
 	}
 
-	// detect the number of P-cores and E-cores on the system
+	// detect the P-cores and E-cores on the system and precompute their masks
 	void NativeController::DetectCoreCount() {
-		lCoreCount = 0;
-		for (EnumLogicalProcessorInformation enumInfo(RelationGroup);
-			auto pinfo = enumInfo.Current(); enumInfo.MoveNext()) {
-			lCoreCount = pinfo->Group.GroupInfo->MaximumProcessorCount;
-		}
+		BuildTopology(false);
+	}
 
-		pCoreCount = 0;
-		eCoreCount = 0;
-		int i = 0;
+	// Precomputes the class masks and the feature table from the processors the backend reports.
+	// Detection can be slow, so startup lets the backend reuse a topology detected on an earlier run.
+	void NativeController::BuildTopology(bool allowCached) {
+		vector<ProcessorDescription> processors;
+		if (!m_Backend->DetectTopology(allowCached, processors)) {
+			cout << "ERROR -- Cannot detect the processor topology" << endl;
+		}
 
-		for (EnumLogicalProcessorInformation enumInfo(RelationProcessorCore);
-			auto pinfo = enumInfo.Current(); enumInfo.MoveNext()) {
-			for (UINT GroupIndex = 0; GroupIndex < pinfo->Processor.GroupCount; GroupIndex++) {
+		vector<LogicalCore> logicalCores;
+		logicalCores.reserve(processors.size());
+		for (const ProcessorDescription& processor : processors) {
+			logicalCores.push_back(processor.core);
+		}
+		m_Topology.Build(logicalCores);
 
-				if ((int)pinfo->Processor.EfficiencyClass == 1)
-				{
-					pCoreCount++;
-				}
-				else {
-					eCoreCount++;
-				}
+		m_FeatureTable.Clear();
+		m_FeatureTable.Reserve(processors.size());
+		for (const ProcessorDescription& processor : processors) {
+			m_FeatureTable.Add(processor.core, processor.features, processor.coreType, processor.baseMhz, processor.maxMhz);
+		}
 
-			}
+		// frequency sources number processors group by group
+		vector<const LogicalCore*> ordered;
+		for (const LogicalCore& core : logicalCores) {
+			ordered.push_back(&core);
+		}
+		sort(ordered.begin(), ordered.end(), [](const LogicalCore* a, const LogicalCore* b) {
+			return a->group != b->group ? a->group < b->group : a->index < b->index;
+		});
+		m_FrequencyClasses.clear();
+		for (const LogicalCore* core : ordered) {
+			m_FrequencyClasses.push_back(core->coreClass);
+		}
 
+		// policy placements hold masks of the previous topology
+		if (!m_PolicyRules.empty()) {
+			SetPlacementPolicy(vector<PlacementRule>(m_PolicyRules));
 		}
-		hyperthreadCores = lCoreCount - eCoreCount;
-		
 	}
 
+	Placement NativeController::CreatePlacement(const CpuMask& mask, PlacementMode mode) {
+		Placement placement;
+		placement.mask = mask;
+		placement.mode = mode;
 
+		// a soft placement over every core clears the preference rather than listing all of them
+		if (mode == PlacementMode::Soft && mask != m_Topology.AllMask()) {
+			m_Topology.CpuSets(mask, placement.cpuSets);
+		}
+		return placement;
+	}
 
-	bool FindAndBind(const wchar_t* target, int selectedAffinity) {
-		PROCESSENTRY32 entry;
-		entry.dwSize = sizeof(PROCESSENTRY32);
-		BOOL found = FALSE;
-
-		HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, NULL);
+	// Sets the affinity of a single process and records it in the binding table,
+	// so a later bulk apply only rebinds the process if its mask differs.
+	bool NativeController::BindProcess(unsigned long pid, const Placement& placement) {
+		ProcessHandle process = m_HandleCache.Acquire(pid);
+		bool clearCpuSets = process.handle != nullptr && m_BindingTable.IsSoft(pid, process.creationTime);
+		m_BindingTable.Forget(pid);
+		if (process.handle == nullptr) {
+			m_Metrics.Add(MetricCounter::Failed);
+			return false;
+		}
 
-		if (Process32First(snapshot, &entry) == TRUE) {
-			while (Process32Next(snapshot, &entry) == TRUE) {
-				if (wcscmp(entry.szExeFile, target) == 0) {
+		OsStatus status;
+		{
+			MetricTimer timer(m_Metrics, MetricOperation::SetAffinity);
+			status = m_Backend->ApplyPlacement(process.handle, placement, clearCpuSets, m_Topology.AllMask(), m_Topology.GroupCount());
+		}
+		m_Backend->EndBackgroundMode(process.handle);
+		if (status == OsStatus::Ok && process.creationTime != 0) {
+			m_BindingTable.Record(pid, process.creationTime, placement.mask, placement.mode);
+		}
+		m_HandleCache.Release(process);
+		m_Metrics.Add(status == OsStatus::Ok ? MetricCounter::Bound : status == OsStatus::AccessDenied ? MetricCounter::Denied : MetricCounter::Failed);
+		return status == OsStatus::Ok;
+	}
 
-					HANDLE hProcess = OpenProcess(PROCESS_SET_INFORMATION, TRUE, entry.th32ProcessID);
+	bool NativeController::FindAndBind(const wchar_t* target, const Placement& placement) {
+		bool found = false;
 
-					DWORD_PTR processAffinityMask = selectedAffinity;
-					BOOL success = SetProcessAffinityMask(hProcess, processAffinityMask);
-					SetPriorityClass(hProcess, PROCESS_MODE_BACKGROUND_END);
-					if (success == TRUE) {
+		if (SnapshotProcesses() && m_Processes.Count() > 0) {
+			for (size_t i = 0; i < m_Processes.Count(); i++) {
+				if (SameExeName(m_Processes.Name(i), target)) {
+					if (BindProcess(m_Processes.Pid(i), placement)) {
 						cout << " Bind was successful" << endl;
-						found = TRUE;
-						//system("pause");
+						found = true;
 					}
 					else {
 						cout << " ERROR -- Retry bind" << endl;
-						//system("pause");
 					}
-					CloseHandle(hProcess);
 				}
 			}
 		}
 		else {
 			cout << "ERROR -- #" << endl;
-			//system("pause");
 		}
-		if (found == FALSE) {
+		if (!found) {
 			cout << "ERROR -- Program is not currenlty running" << endl;
-			//system("pause");
 		}
 		cout << "\n" << endl;
-		CloseHandle(snapshot);
-		return found == TRUE;
+		return found;
 	}
 
+	// Refreshes m_Processes from the backend, timed as one snapshot.
+	bool NativeController::SnapshotProcesses() {
+		MetricTimer timer(m_Metrics, MetricOperation::Snapshot);
+		return m_Backend->EnumerateProcesses(m_Processes);
+	}
 
-	void ProcessesSnapShot(int mask) {
-		//int mask = affinityMaskGenerator(coreSelected);
+	// Indexes every running process by executable name from a single snapshot.
+	bool NativeController::IndexProcesses() {
+		m_NameIndex.Clear();
+		if (!SnapshotProcesses()) {
+			return false;
+		}
+
+		for (size_t i = 0; i < m_Processes.Count(); i++) {
+			m_NameIndex.Add(m_Processes.Name(i), m_Processes.Pid(i));
+		}
+		return true;
+	}
 
-		HANDLE hProcessSnap;
-		HANDLE hProcess;
-		PROCESSENTRY32 pe32;
-		DWORD dwPriorityClass;
 
-		hProcessSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-		if (hProcessSnap == INVALID_HANDLE_VALUE) {
-			cout << "Error";
+	enum class BindStatus : unsigned char
+	{
+		Bound,
+		Skipped,
+		Failed,
+		AccessDenied,
+		Unsupported,
+		Cancelled
+	};
+
+	// One process of a bulk apply. Workers only write to their own items, every change to the
+	// handle cache and binding table happens afterwards on the calling thread in snapshot order.
+	struct ApplyItem
+	{
+		unsigned long pid = 0;
+		ProcessHandle process;
+		bool stale = false;
+		BindStatus status = BindStatus::Failed;
+	};
+
+	// Processes handed to each worker before a parallel apply pays for the hand-off.
+	const size_t minItemsPerWorker = 32;
+	const int defaultApplyConcurrency = 4;
+
+	BindStatus ToBindStatus(OsStatus status) {
+		switch (status) {
+		case OsStatus::Ok: return BindStatus::Bound;
+		case OsStatus::AccessDenied: return BindStatus::AccessDenied;
+		case OsStatus::Unsupported: return BindStatus::Unsupported;
+		default: return BindStatus::Failed;
+		}
+	}
+
+	void ApplyToProcess(ApplyItem& item, const Placement& placement, const BindingTable& bindingTable,
+		const ProcessHandleCache& handleCache, OsBackend& backend, const CpuMask& allMask, unsigned groupCount,
+		OperationMetrics& metrics, const ApplyControl& control) {
+		if (control.cancelled.load(std::memory_order_relaxed)) {
+			item.status = BindStatus::Cancelled;
+			return;
 		}
-		pe32.dwSize = sizeof(PROCESSENTRY32);
 
-		if (!Process32First(hProcessSnap, &pe32)) {
-			cout << "Error loading first";
-			CloseHandle(hProcessSnap);
+		if (item.process.handle != nullptr && handleCache.HasExited(item.process.handle)) {
+			// the cached handle belongs to an exited process, the PID may have been reused
+			item.stale = true;
+			item.process = ProcessHandle();
+		}
+
+		if (item.process.handle == nullptr) {
+			OsStatus status = handleCache.Open(item.pid, item.process);
+			if (status != OsStatus::Ok) {
+				item.status = ToBindStatus(status);
+				return;
+			}
 		}
-		do {
-			cout << pe32.th32ProcessID << endl;
-			HANDLE hProcess = OpenProcess(PROCESS_SET_INFORMATION, TRUE, pe32.th32ProcessID);
 
-			DWORD_PTR processAffinityMask = mask;
-			BOOL success = SetProcessAffinityMask(hProcess, mask);
-			SetPriorityClass(hProcess, PROCESS_MODE_BACKGROUND_END);
+		if (item.process.creationTime != 0
+			&& bindingTable.IsBound(item.pid, item.process.creationTime, placement.mask, placement.mode)) {
+			item.status = BindStatus::Skipped;
+			return;
+		}
 
-		} while (Process32Next(hProcessSnap, &pe32));
-		CloseHandle(hProcessSnap);
+		OsStatus status;
+		{
+			MetricTimer timer(metrics, MetricOperation::SetAffinity);
+			bool clearCpuSets = bindingTable.IsSoft(item.pid, item.process.creationTime);
+			status = backend.ApplyPlacement(item.process.handle, placement, clearCpuSets, allMask, groupCount);
+		}
+		backend.EndBackgroundMode(item.process.handle);
+		item.status = ToBindStatus(status);
 	}
 
-// Remaing code added by Author for the Main Application
+	// Returns the pool for a bulk apply over itemCount processes, or nullptr to apply on the calling thread.
+	// Workers are pinned to the E-cores so a large apply does not compete with the foreground on P-cores.
+	WorkerPool* NativeController::ApplyPool(size_t itemCount) {
+		int workers = m_ApplyConcurrency;
+		if (workers <= 0) {
+			int eCores = m_Topology.EfficiencyCoreCount();
+			workers = (eCores > 0 && eCores < defaultApplyConcurrency) ? eCores : defaultApplyConcurrency;
+		}
 
-	void NativeController::MoveAllAppsToEfficiencyCores()
-	{
-		ProcessesSnapShot(eCoreMask);
+		if (workers <= 1 || itemCount < minItemsPerWorker * 2) {
+			return nullptr;
+		}
+
+		if (!m_WorkerPool) {
+			m_WorkerPool.reset(new WorkerPool(workers));
+			const vector<unsigned long>& efficiencySet = m_Topology.CpuSets(CoreClass::Efficiency);
+			if (!efficiencySet.empty()) {
+				m_WorkerPool->Run([&](unsigned) {
+					m_Backend->SetCurrentThreadCpus(efficiencySet);
+				});
+			}
+		}
+		return m_WorkerPool.get();
 	}
 
-	int NativeController::CreateAffinityMask(int eCores, int pCores)
-	{
-		int affinityMask;
-		// check if the p core and e core count passed in is larger than the number of p core or e core
-		if (eCores <= 0 && pCores <= 0 || eCores > eCoreCount || pCores > pCoreCount) {
-			return -1;
+	// Applies the placement to every process, skipping processes that already hold it from an earlier apply.
+	void NativeController::ProcessesSnapShot(const Placement& placement) {
+		MetricTimer timer(m_Metrics, MetricOperation::Apply);
+		m_Metrics.Add(MetricCounter::Applies);
+		ApplyResult result;
+
+		if (!SnapshotProcesses()) {
+			cout << "Error";
+			m_LastApplyResult = result;
+			return;
+		}
+
+		if (m_Processes.Count() == 0) {
+			cout << "Error loading first";
+			m_LastApplyResult = result;
+			return;
 		}
 
-		// assuming every p core has two threads
-		int hThreadAffinity = AffinityMaskGenerator(pCores*2);
+		// a cache smaller than the process list would reopen the overflow on every apply
+		m_HandleCache.EnsureCapacity(m_Processes.Count());
 
-		int coreOffset = eCores + hyperthreadCores;
+		vector<ApplyItem> items;
+		items.reserve(m_Processes.Count());
+		for (size_t i = 0; i < m_Processes.Count(); i++) {
+			ApplyItem item;
+			item.pid = m_Processes.Pid(i);
+			m_HandleCache.Lookup(item.pid, item.process);
+			items.push_back(item);
+		}
 
-		affinityOffset = AffinityMaskGenerator(hyperthreadCores);
-		int tmpAffinity = AffinityMaskGenerator(coreOffset);
-		int eCoreAffinity = tmpAffinity - affinityOffset;
-		if (pCores > 0) {
-			int hybridAffinity = eCoreAffinity + hThreadAffinity;
-			affinityMask = hybridAffinity;
+		unsigned groupCount = m_Topology.GroupCount();
+		WorkerPool* pool = ApplyPool(items.size());
+		if (pool != nullptr) {
+			// each worker takes one contiguous slice of the snapshot
+			pool->Run([&](unsigned worker) {
+				size_t begin = items.size() * worker / pool->Size();
+				size_t end = items.size() * (worker + 1) / pool->Size();
+				for (size_t i = begin; i < end; i++) {
+					ApplyToProcess(items[i], placement, m_BindingTable, m_HandleCache, *m_Backend, m_Topology.AllMask(), groupCount, m_Metrics, *m_ApplyControl);
+				}
+			});
 		}
 		else {
-			affinityMask = eCoreAffinity;
+			for (ApplyItem& item : items) {
+				ApplyToProcess(item, placement, m_BindingTable, m_HandleCache, *m_Backend, m_Topology.AllMask(), groupCount, m_Metrics, *m_ApplyControl);
+			}
 		}
 
-		return affinityMask;
+		m_BindingTable.BeginSweep();
+		m_HandleCache.BeginSweep();
+		for (ApplyItem& item : items) {
+			if (item.status != BindStatus::Cancelled) {
+				result.scanned++;
+			}
+
+			if (item.stale) {
+				m_HandleCache.Evict(item.pid);
+			}
+			if (item.process.handle != nullptr) {
+				if (item.process.cached) {
+					m_HandleCache.Touch(item.pid);
+				}
+				else if (!m_HandleCache.Insert(item.pid, item.process)) {
+					m_HandleCache.Release(item.process);
+				}
+			}
+
+			switch (item.status) {
+			case BindStatus::Bound:
+				result.bound++;
+				if (item.process.creationTime != 0) {
+					m_BindingTable.Record(item.pid, item.process.creationTime, placement.mask, placement.mode);
+				}
+				break;
+			case BindStatus::Skipped:
+				result.skipped++;
+				m_BindingTable.Touch(item.pid);
+				break;
+			case BindStatus::AccessDenied:
+				result.denied++;
+				break;
+			case BindStatus::Unsupported:
+				result.unsupported++;
+				break;
+			case BindStatus::Cancelled:
+				// the process keeps the placement it had, so its binding stays valid
+				result.cancelled++;
+				m_BindingTable.Touch(item.pid);
+				break;
+			default:
+				result.failed++;
+				break;
+			}
+		}
+		m_HandleCache.EndSweep();
+		m_BindingTable.EndSweep();
+
+		m_Metrics.Add(MetricCounter::Scanned, result.scanned);
+		m_Metrics.Add(MetricCounter::Bound, result.bound);
+		m_Metrics.Add(MetricCounter::Skipped, result.skipped);
+		m_Metrics.Add(MetricCounter::Failed, result.failed + result.unsupported);
+		m_Metrics.Add(MetricCounter::Denied, result.denied);
+
+		cout << "Scanned " << result.scanned << " processes: " << result.bound << " bound, "
+			<< result.skipped << " skipped, " << result.failed << " failed, " << result.denied << " denied" << endl;
+		if (result.unsupported > 0) {
+			cout << "ERROR -- " << result.unsupported << " processes could not be given a hard placement across processor groups" << endl;
+		}
+		if (result.cancelled > 0) {
+			cout << "Apply cancelled, " << result.cancelled << " processes left as they were" << endl;
+		}
+		m_LastApplyResult = result;
+	}
+
+// Remaing code added by Author for the Main Application
+
+	void NativeController::MoveAllAppsToEfficiencyCores()
+	{
+		ProcessesSnapShot(CreatePlacement(m_Topology.EfficiencyMask(), PlacementMode::Hard));
+	}
+
+	const CpuMask& NativeController::CreateAffinityMask(int eCores, int pCores)
+	{
+		// every logical processor of the requested physical cores, empty when the counts are out of range
+		return m_Topology.Mask(eCores, pCores);
 	}
 
 	void NativeController::MoveAllAppsToSomeEfficiencyCores()
 	{
 		// 2-ecores effiency mode
-		if (eCoreCount < 2) {
+		if (m_Topology.EfficiencyCoreCount() < 2) {
 			return;
 		}
 
-		int affinity = CreateAffinityMask(eCoreCount, 0);
-		ProcessesSnapShot(affinity);
+		const CpuMask& affinity = CreateAffinityMask(m_Topology.EfficiencyCoreCount(), 0);
+		ProcessesSnapShot(CreatePlacement(affinity, PlacementMode::Hard));
 	}
 
-	bool NativeController::MoveAppToHybridCores(const wchar_t* target, int eCores, int pCores)
+	bool NativeController::IsValidHybridSetting(int eCores, int pCores)
 	{
-		if ((eCores <= 0 && pCores <= 0)|| eCores > eCoreCount || pCores % 2 == 1 || pCores > pCoreCount) {
+		return !((eCores <= 0 && pCores <= 0) || eCores < 0 || pCores < 0
+			|| eCores > m_Topology.EfficiencyCoreCount() || pCores > m_Topology.PerformanceCoreCount());
+	}
+
+	bool NativeController::MoveAppToHybridCores(const wchar_t* target, int eCores, int pCores, PlacementMode mode)
+	{
+		if (!IsValidHybridSetting(eCores, pCores)) {
 			return false;
 		}
 
-		int affinity = CreateAffinityMask(eCores, pCores);
-		return FindAndBind(target, affinity);
+		const CpuMask& affinity = CreateAffinityMask(eCores, pCores);
+		return FindAndBind(target, CreatePlacement(affinity, mode));
+	}
+
+	bool NativeController::MoveAppToFeatureCores(const wchar_t* target, unsigned long long requiredFeatures, PlacementMode mode)
+	{
+		CpuMask affinity = m_FeatureTable.Select(requiredFeatures, FeatureBit(CoreFeature::Parked));
+		if (affinity.Empty()) {
+			cout << "ERROR -- No cores have the requested features" << endl;
+			return false;
+		}
+		return FindAndBind(target, CreatePlacement(affinity, mode));
+	}
+
+	// Places each thread of every running instance of target on P-cores or E-cores by the CPU time it
+	// used since the previous call, through the thread's selected CPU sets. Returns the threads placed.
+	int NativeController::PlaceAppThreads(const wchar_t* target, const ThreadPlacementPolicy& policy)
+	{
+		if (!IndexProcesses()) {
+			cout << "ERROR -- #" << endl;
+			return 0;
+		}
+
+		const vector<unsigned long>* pids = m_NameIndex.Find(target);
+		if (pids == nullptr) {
+			cout << "ERROR -- Program is not currenlty running" << endl;
+			return 0;
+		}
+
+		const vector<unsigned long>& performanceSet = m_Topology.CpuSets(CoreClass::Performance);
+		const vector<unsigned long>& efficiencySet = m_Topology.CpuSets(CoreClass::Efficiency);
+
+		int placed = 0;
+		vector<ThreadSample> threads;
+		vector<ThreadAssignment> assignments;
+		for (unsigned long pid : *pids) {
+			if (!m_Backend->EnumerateThreads(pid, threads)) {
+				continue;
+			}
+			m_ThreadPlanner.Plan(pid, threads, policy, m_Topology.PerformanceCoreCount(), assignments);
+
+			for (const ThreadAssignment& assignment : assignments) {
+				const vector<unsigned long>& cpuSet = assignment.coreClass == CoreClass::Performance ? performanceSet : efficiencySet;
+				if (!cpuSet.empty() && m_Backend->SetThreadCpus(assignment.tid, cpuSet)) {
+					placed++;
+				}
+			}
+		}
+
+		cout << "Placed " << placed << " threads of " << pids->size() << " processes" << endl;
+		return placed;
+	}
+
+	std::vector<bool> NativeController::MoveAppsToHybridCores(const std::vector<HybridTarget>& targets)
+	{
+		std::vector<bool> results(targets.size(), false);
+
+		// One snapshot serves every target in the batch
+		if (!IndexProcesses()) {
+			cout << "ERROR -- #" << endl;
+			return results;
+		}
+
+		int bound = 0;
+		for (size_t i = 0; i < targets.size(); i++) {
+			const HybridTarget& target = targets[i];
+			if (!IsValidHybridSetting(target.eCores, target.pCores)) {
+				continue;
+			}
+
+			const vector<unsigned long>* pids = m_NameIndex.Find(target.exeName);
+			if (pids == nullptr) {
+				continue;
+			}
+
+			Placement placement = CreatePlacement(CreateAffinityMask(target.eCores, target.pCores), target.mode);
+			for (unsigned long pid : *pids) {
+				if (BindProcess(pid, placement)) {
+					results[i] = true;
+					bound++;
+				}
+			}
+		}
+
+		cout << "Bound " << bound << " processes for " << targets.size() << " targets" << endl;
+		return results;
 	}
 	
-	void NativeController::MoveAllAppsToHybridCores(int eCores, int pCores)
+	void NativeController::MoveAllAppsToHybridCores(int eCores, int pCores, PlacementMode mode)
 	{
-		int affinity = CreateAffinityMask(eCores, pCores);
-		if (affinity == -1) {
+		const CpuMask& affinity = CreateAffinityMask(eCores, pCores);
+		if (affinity.Empty()) {
 			return;
 		}
 		
 		// Move apps to selected cores
-		ProcessesSnapShot(affinity);
+		ProcessesSnapShot(CreatePlacement(affinity, mode));
 	}
 
 	int NativeController::TotalCoreCount() {
-		return lCoreCount;
+		return m_Topology.LogicalCoreCount();
 	}
 
 	int NativeController::EfficiencyCoreCount() {
-		return eCoreCount;
+		return m_Topology.EfficiencyCoreCount();
 	}
 
 	int NativeController::PerformanceCoreCount() {
-		return pCoreCount;
+		return m_Topology.PerformanceCoreCount();
+	}
+
+	const CoreFeatureTable& NativeController::FeatureTable() const {
+		return m_FeatureTable;
+	}
+
+	ApplyResult NativeController::LastApplyResult() {
+		return m_LastApplyResult;
+	}
+
+	OsBackend& NativeController::Backend() {
+		return *m_Backend;
+	}
+
+	MetricsSnapshot NativeController::Metrics() const {
+		MetricsSnapshot snapshot;
+		m_Metrics.Read(snapshot);
+		return snapshot;
+	}
+
+	void NativeController::ResetMetrics() {
+		m_Metrics.Reset();
+	}
+
+	bool NativeController::ExportMetrics(const wchar_t* path) {
+		std::string text;
+		FormatOpenMetrics(Metrics(), text);
+		if (!m_Backend->WriteTextFile(path, text)) {
+			cout << "ERROR -- Cannot export the metrics" << endl;
+			return false;
+		}
+		return true;
+	}
+
+	void NativeController::SetApplyConcurrency(int workers) {
+		m_ApplyConcurrency = workers;
+		m_WorkerPool.reset();
+	}
+
+	void NativeController::CancelApplies() {
+		m_ApplyControl->cancelled.store(true, std::memory_order_relaxed);
+	}
+
+	void NativeController::ResumeApplies() {
+		m_ApplyControl->cancelled.store(false, std::memory_order_relaxed);
+	}
+
+	bool NativeController::StartProcessEvents() {
+		return StartProcessEvents(CreateProcessEventSource());
+	}
+
+	bool NativeController::StartProcessEvents(std::unique_ptr<ProcessEventSource> source) {
+		StopProcessEvents();
+
+		if (!m_EventQueue) {
+			m_EventQueue.reset(new ProcessEventQueue());
+		}
+		if (!source || !source->Start(*m_EventQueue)) {
+			return false;
+		}
+		m_EventSource = std::move(source);
+		return true;
+	}
+
+	void NativeController::StopProcessEvents() {
+		if (m_EventSource) {
+			m_EventSource->Stop();
+			m_EventSource.reset();
+		}
+	}
+
+	bool NativeController::WatchApp(const wchar_t* target, int eCores, int pCores, PlacementMode mode) {
+		if (!IsValidHybridSetting(eCores, pCores)) {
+			return false;
+		}
+
+		HybridTarget* watched = FindWatchedApp(target);
+		if (watched == nullptr) {
+			m_WatchedApps.push_back(HybridTarget());
+			watched = &m_WatchedApps.back();
+			watched->exeName = target;
+		}
+		watched->eCores = eCores;
+		watched->pCores = pCores;
+		watched->mode = mode;
+		return true;
+	}
+
+	void NativeController::UnwatchApp(const wchar_t* target) {
+		for (auto it = m_WatchedApps.begin(); it != m_WatchedApps.end(); ++it) {
+			if (SameExeName(it->exeName.c_str(), target)) {
+				m_WatchedApps.erase(it);
+				return;
+			}
+		}
+	}
+
+	HybridTarget* NativeController::FindWatchedApp(const wchar_t* exeName) {
+		for (HybridTarget& watched : m_WatchedApps) {
+			if (SameExeName(watched.exeName.c_str(), exeName)) {
+				return &watched;
+			}
+		}
+		return nullptr;
+	}
+
+	bool NativeController::WaitForProcessEvents(unsigned timeoutMs) {
+		return m_EventQueue && m_EventQueue->Wait(timeoutMs);
+	}
+
+	// Binds started processes of watched apps and forgets exited ones. Must only be called
+	// from one thread at a time, since the queue has a single consumer.
+	int NativeController::DrainProcessEvents() {
+		if (!m_EventQueue) {
+			return 0;
+		}
+
+		int bound = 0;
+		ProcessEvent event;
+		while (m_EventQueue->Pop(event)) {
+			if (event.type == ProcessEventType::Exited) {
+				m_BindingTable.Forget(event.pid);
+				m_HandleCache.Evict(event.pid);
+				m_ThreadPlanner.Forget(event.pid);
+				if (m_Adaptive) {
+					m_Adaptive->Forget(event.pid);
+				}
+				continue;
+			}
+
+			if (IsAdaptedApp(event.exeName)) {
+				if (TrackAdaptedProcess(event.pid)) {
+					bound++;
+				}
+				continue;
+			}
+
+			const HybridTarget* watched = FindWatchedApp(event.exeName);
+			if (watched != nullptr) {
+				if (BindProcess(event.pid, CreatePlacement(CreateAffinityMask(watched->eCores, watched->pCores), watched->mode))) {
+					bound++;
+				}
+				continue;
+			}
+
+			int rule = ClassifyProcess(event.pid, event.exeName);
+			if (rule >= 0 && ApplyPolicyRule(event.pid, rule)) {
+				bound++;
+			}
+		}
+
+		// Starts may have been lost, so bind whatever instances of the watched apps are running
+		if (m_EventQueue->TakeDropped() != 0 && !m_WatchedApps.empty()) {
+			cout << "Process events were dropped, rescanning watched apps" << endl;
+			MoveAppsToHybridCores(m_WatchedApps);
+		}
+		return bound;
 	}
 	
+	void NativeController::SetPlacementPolicy(const vector<PlacementRule>& rules)
+	{
+		m_PolicyRules = rules;
+		m_PolicyMatcher.Compile(m_PolicyRules);
+
+		// resolve core counts once, -1 stands for every core of the class
+		m_PolicyPlacements.clear();
+		for (const PlacementRule& rule : m_PolicyRules) {
+			int eCores = rule.eCores < 0 ? m_Topology.EfficiencyCoreCount() : rule.eCores;
+			int pCores = rule.pCores < 0 ? m_Topology.PerformanceCoreCount() : rule.pCores;
+			if (eCores == 0 && pCores == 0) {
+				m_PolicyPlacements.push_back(Placement());
+				continue;
+			}
+			if (!IsValidHybridSetting(eCores, pCores)) {
+				std::wcout << L"Policy rule " << rule.pattern << L" asks for more cores than the system has, capping" << endl;
+				eCores = min(eCores, m_Topology.EfficiencyCoreCount());
+				pCores = min(pCores, m_Topology.PerformanceCoreCount());
+			}
+			m_PolicyPlacements.push_back(CreatePlacement(CreateAffinityMask(eCores, pCores), rule.mode));
+		}
+	}
+
+	bool NativeController::LoadPlacementPolicy(const wchar_t* path)
+	{
+		std::wstring text;
+		if (!m_Backend->ReadTextFile(path, text)) {
+			cout << "ERROR -- Cannot open the placement policy" << endl;
+			return false;
+		}
+
+		vector<PlacementRule> rules;
+		size_t lineNumber = 0;
+		for (size_t start = 0; start < text.size(); lineNumber++) {
+			size_t end = text.find(L'\n', start);
+			if (end == std::wstring::npos) {
+				end = text.size();
+			}
+			std::wstring line = text.substr(start, end - start);
+			if (!line.empty() && line.back() == L'\r') {
+				line.pop_back();
+			}
+			start = end + 1;
+
+			PlacementRule rule;
+			std::string error;
+			if (ParsePlacementRule(line, rule, error)) {
+				rules.push_back(rule);
+			}
+			else if (!error.empty()) {
+				cout << "ERROR -- Placement policy line " << lineNumber + 1 << ": " << error << endl;
+				return false;
+			}
+		}
+
+		SetPlacementPolicy(rules);
+		cout << "Loaded " << rules.size() << " placement rules" << endl;
+		return true;
+	}
+
+	// Rule index for a process, or -1. Path rules need the image path, which costs opening the process.
+	int NativeController::ClassifyProcess(unsigned long pid, const wchar_t* exeName)
+	{
+		if (!m_PolicyMatcher.HasPathRules()) {
+			return m_PolicyMatcher.Match(exeName);
+		}
+
+		std::wstring path;
+		ProcessHandle process = m_HandleCache.Acquire(pid);
+		if (process.handle != nullptr) {
+			m_Backend->ProcessImagePath(process.handle, path);
+			m_HandleCache.Release(process);
+		}
+		return m_PolicyMatcher.Match(exeName, !path.empty() ? path.c_str() : nullptr);
+	}
+
+	bool NativeController::ApplyPolicyRule(unsigned long pid, int rule)
+	{
+		const Placement& placement = m_PolicyPlacements[rule];
+		if (!placement.mask.Empty() && !BindProcess(pid, placement)) {
+			return false;
+		}
+
+		// BindProcess leaves the handle cached, so this does not reopen the process
+		const PlacementRule& settings = m_PolicyRules[rule];
+		ProcessHandle process = m_HandleCache.Acquire(pid);
+		if (process.handle == nullptr) {
+			return false;
+		}
+		m_Backend->SetPriority(process.handle, settings.priority);
+		m_Backend->SetPowerThrottling(process.handle, settings.throttling);
+		m_Backend->SetMemoryPriority(process.handle, settings.memoryPriority);
+		m_HandleCache.Release(process);
+		return true;
+	}
+
+	int NativeController::ApplyPlacementPolicy()
+	{
+		if (m_PolicyMatcher.Empty()) {
+			return 0;
+		}
+
+		if (!SnapshotProcesses()) {
+			cout << "ERROR -- #" << endl;
+			return 0;
+		}
+
+		int matched = 0;
+		for (size_t i = 0; i < m_Processes.Count(); i++) {
+			if (m_ApplyControl->cancelled.load(std::memory_order_relaxed)) {
+				cout << "Placement policy apply cancelled" << endl;
+				break;
+			}
+			int rule = ClassifyProcess(m_Processes.Pid(i), m_Processes.Name(i));
+			if (rule >= 0 && ApplyPolicyRule(m_Processes.Pid(i), rule)) {
+				matched++;
+			}
+		}
+
+		cout << "Placement policy applied to " << matched << " processes" << endl;
+		return matched;
+	}
+
+	AdaptivePlacer& NativeController::Adaptive()
+	{
+		if (!m_Adaptive) {
+			m_Adaptive.reset(new AdaptivePlacer(CreateProcessTimeSource()));
+		}
+		return *m_Adaptive;
+	}
+
+	void NativeController::SetAdaptivePolicy(const AdaptivePolicy& policy)
+	{
+		Adaptive().SetPolicy(policy);
+	}
+
+	// Replaces the sampler, for example with a SyntheticProcessTimeSource. Tracked processes are dropped.
+	void NativeController::SetAdaptiveTimeSource(std::unique_ptr<ProcessTimeSource> source)
+	{
+		AdaptivePolicy policy = Adaptive().Policy();
+		m_Adaptive.reset(new AdaptivePlacer(std::move(source)));
+		m_Adaptive->SetPolicy(policy);
+	}
+
+	bool NativeController::AdaptApp(const wchar_t* target)
+	{
+		if (m_Topology.EfficiencyCoreCount() == 0 || m_Topology.PerformanceCoreCount() == 0) {
+			cout << "ERROR -- Adaptive placement needs both E-cores and P-cores" << endl;
+			return false;
+		}
+
+		if (!IsAdaptedApp(target)) {
+			m_AdaptedApps.push_back(target);
+		}
+
+		if (!IndexProcesses()) {
+			cout << "ERROR -- #" << endl;
+			return true;
+		}
+
+		const vector<unsigned long>* pids = m_NameIndex.Find(target);
+		if (pids != nullptr) {
+			for (unsigned long pid : *pids) {
+				TrackAdaptedProcess(pid);
+			}
+		}
+		return true;
+	}
+
+	void NativeController::StopAdaptingApp(const wchar_t* target)
+	{
+		for (auto it = m_AdaptedApps.begin(); it != m_AdaptedApps.end(); ++it) {
+			if (SameExeName(it->c_str(), target)) {
+				m_AdaptedApps.erase(it);
+				break;
+			}
+		}
+
+		if (!m_Adaptive || !IndexProcesses()) {
+			return;
+		}
+
+		// the processes keep the placement they had last
+		const vector<unsigned long>* pids = m_NameIndex.Find(target);
+		if (pids != nullptr) {
+			for (unsigned long pid : *pids) {
+				m_Adaptive->Forget(pid);
+			}
+		}
+	}
+
+	bool NativeController::IsAdaptedApp(const wchar_t* exeName) const
+	{
+		for (const std::wstring& adapted : m_AdaptedApps) {
+			if (SameExeName(adapted.c_str(), exeName)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Starts tracking a process on the idle placement. Processes already tracked keep their class.
+	bool NativeController::TrackAdaptedProcess(unsigned long pid)
+	{
+		AdaptivePlacer& adaptive = Adaptive();
+		if (adaptive.IsTracked(pid)) {
+			return false;
+		}
+
+		adaptive.Track(pid, CoreClass::Efficiency);
+		Placement placement = AdaptivePlacementFor(CoreClass::Efficiency);
+		return !placement.mask.Empty() && BindProcess(pid, placement);
+	}
+
+	Placement NativeController::AdaptivePlacementFor(CoreClass coreClass)
+	{
+		const AdaptivePolicy& policy = Adaptive().Policy();
+		int eCores = coreClass == CoreClass::Performance ? policy.busyECores : policy.idleECores;
+		int pCores = coreClass == CoreClass::Performance ? policy.busyPCores : policy.idlePCores;
+		eCores = eCores < 0 ? m_Topology.EfficiencyCoreCount() : min(eCores, m_Topology.EfficiencyCoreCount());
+		pCores = pCores < 0 ? m_Topology.PerformanceCoreCount() : min(pCores, m_Topology.PerformanceCoreCount());
+		return CreatePlacement(CreateAffinityMask(eCores, pCores), PlacementMode::Hard);
+	}
+
+	bool NativeController::AdaptivePlacementDue()
+	{
+		return !m_AdaptedApps.empty() && Adaptive().Due();
+	}
+
+	int NativeController::StepAdaptivePlacement()
+	{
+		if (m_AdaptedApps.empty()) {
+			return 0;
+		}
+
+		// without process events, started instances are only found by looking
+		if (!m_EventSource && IndexProcesses()) {
+			for (const std::wstring& adapted : m_AdaptedApps) {
+				const vector<unsigned long>* pids = m_NameIndex.Find(adapted);
+				if (pids != nullptr) {
+					for (unsigned long pid : *pids) {
+						TrackAdaptedProcess(pid);
+					}
+				}
+			}
+		}
+
+		vector<AdaptiveDecision> decisions;
+		Adaptive().Step(decisions);
+
+		int moved = 0;
+		Placement idle = AdaptivePlacementFor(CoreClass::Efficiency);
+		Placement busy = AdaptivePlacementFor(CoreClass::Performance);
+		for (const AdaptiveDecision& decision : decisions) {
+			const Placement& placement = decision.coreClass == CoreClass::Performance ? busy : idle;
+			if (!placement.mask.Empty() && BindProcess(decision.pid, placement)) {
+				moved++;
+			}
+		}
+
+		if (moved > 0) {
+			cout << "Adaptive placement moved " << moved << " processes" << endl;
+		}
+		return moved;
+	}
+
+	ProcessCpuSampler& NativeController::ProcessCpu()
+	{
+		if (!m_ProcessCpu) {
+			m_ProcessCpu.reset(new ProcessCpuSampler(CreateProcessTimeSource()));
+		}
+		return *m_ProcessCpu;
+	}
+
+	bool NativeController::SampleProcessCpu()
+	{
+		return ProcessCpu().Sample();
+	}
+
+	void NativeController::SetEnergyCoefficients(const EnergyCoefficients& coefficients)
+	{
+		m_Energy.SetCoefficients(coefficients);
+	}
+
+	const EnergyAttributor& NativeController::Energy() const
+	{
+		return m_Energy;
+	}
+
+	// Mean current frequency of each core class from a fresh frequency sample, 0 when unavailable.
+	void NativeController::ClassFrequencies(double& eCoreMhz, double& pCoreMhz)
+	{
+		eCoreMhz = 0;
+		pCoreMhz = 0;
+		if (!m_Frequency) {
+			m_Frequency.reset(new FrequencySampler(CreateFrequencySource(), 16));
+		}
+
+		FrequencySampleView sample;
+		if (!m_Frequency->Sample() || !m_Frequency->Latest(sample)) {
+			return;
+		}
+
+		unsigned eCount = 0, pCount = 0;
+		unsigned count = min(sample.coreCount, static_cast<unsigned>(m_FrequencyClasses.size()));
+		for (unsigned i = 0; i < count; i++) {
+			if (m_FrequencyClasses[i] == CoreClass::Performance) {
+				pCoreMhz += sample.currentMhz[i];
+				pCount++;
+			}
+			else {
+				eCoreMhz += sample.currentMhz[i];
+				eCount++;
+			}
+		}
+		eCoreMhz = eCount > 0 ? eCoreMhz / eCount : 0;
+		pCoreMhz = pCount > 0 ? pCoreMhz / pCount : 0;
+	}
+
+	// The CPU time of each process is split between the classes by its placement. Processes
+	// that were never bound may run anywhere and are split by the logical processors of each class.
+	bool NativeController::SampleEnergy(double packageWatts)
+	{
+		ProcessCpuSampler& cpu = ProcessCpu();
+		if (!cpu.Sample()) {
+			return false;
+		}
+
+		EnergyInterval interval;
+		interval.seconds = cpu.IntervalSeconds();
+		ClassFrequencies(interval.eCoreMhz, interval.pCoreMhz);
+		// classes without a reading fall back to the other class, so their time still costs something
+		if (interval.eCoreMhz == 0) interval.eCoreMhz = interval.pCoreMhz;
+		if (interval.pCoreMhz == 0) interval.pCoreMhz = interval.eCoreMhz;
+		interval.packageJoules = packageWatts >= 0 ? packageWatts * interval.seconds : -1;
+
+		// the counters give the exact package energy of the interval, summed over packages
+		if (packageWatts < 0 && m_EnergyCounters) {
+			m_EnergyCounters->Update();
+			double packageJoules = 0;
+			for (unsigned d = 0; d < m_EnergyCounters->DomainCount(); d++) {
+				const char* name = m_EnergyCounters->DomainName(d);
+				if (strncmp(name, "package", 7) == 0 && strchr(name, '/') == nullptr) {
+					packageJoules += m_EnergyCounters->Joules(d);
+				}
+			}
+			if (m_LastPackageJoules >= 0 && interval.seconds > 0) {
+				interval.packageJoules = packageJoules - m_LastPackageJoules;
+			}
+			m_LastPackageJoules = packageJoules;
+		}
+
+		const CpuMask& efficiencyMask = m_Topology.EfficiencyMask();
+		unsigned allCount = m_Topology.AllMask().Count();
+		float defaultShare = allCount > 0 ? static_cast<float>(efficiencyMask.Count()) / allCount : 0.0f;
+
+		const unsigned long* pids = cpu.Pids();
+		m_EnergyShare.resize(cpu.Count());
+		for (size_t i = 0; i < cpu.Count(); i++) {
+			const CpuMask* mask = m_BindingTable.Find(pids[i]);
+			unsigned maskCount = mask != nullptr ? mask->Count() : 0;
+			m_EnergyShare[i] = maskCount > 0 ? static_cast<float>((*mask & efficiencyMask).Count()) / maskCount : defaultShare;
+		}
+
+		m_Energy.Attribute(interval, cpu.Count(), pids, cpu.Utilization(), m_EnergyShare.data());
+		return true;
+	}
+
+	bool NativeController::StartEnergyCounters(unsigned rateHz)
+	{
+		StopEnergyCounters();
+
+		std::unique_ptr<EnergyCounterSource> source = CreateEnergyCounterSource();
+		if (!source) {
+			cout << "ERROR -- No readable energy counters" << endl;
+			return false;
+		}
+
+		m_EnergyCounters.reset(new EnergySampler(std::move(source)));
+		if (!m_EnergyCounters->Start(rateHz)) {
+			m_EnergyCounters.reset();
+			return false;
+		}
+		return true;
+	}
+
+	void NativeController::StopEnergyCounters()
+	{
+		m_EnergyCounters.reset();
+		m_LastPackageJoules = -1;
+	}
+
+	EnergySampler* NativeController::EnergyCounters()
+	{
+		return m_EnergyCounters.get();
+	}
+
 	void NativeController::ResetToDefaultCores()
 	{
-		ProcessesSnapShot(AffinityMaskGenerator(lCoreCount));
+		// soft over every core also clears default CPU sets left by soft placements
+		ProcessesSnapShot(CreatePlacement(m_Topology.AllMask(), PlacementMode::Soft));
 	}
 	
 }
\ No newline at end of file
@@ -1,22 +1,195 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BindingTable.h"
+#include "CoreFeatureTable.h"
+#include "CoreTopology.h"
+#include "CpuMask.h"
+#include "EnergyAttribution.h"
+#include "OperationMetrics.h"
+#include "OsBackend.h"
+#include "PlacementPolicy.h"
+#include "ProcessHandleCache.h"
+#include "ProcessNameIndex.h"
+#include "ThreadPlacement.h"
+
 namespace Core
 {
+    class AdaptivePlacer;
+    struct ApplyControl;
+    struct AdaptivePolicy;
+    class EnergySampler;
+    class FrequencySampler;
+    class ProcessCpuSampler;
+    class ProcessEventQueue;
+    class ProcessEventSource;
+    class ProcessTimeSource;
+    class WorkerPool;
+
+    // Summary of the last bulk apply over the process list.
+    struct ApplyResult
+    {
+        int scanned = 0;
+        int bound = 0;
+        int skipped = 0;
+        int failed = 0;
+        int denied = 0;
+        int unsupported = 0;    // hard placements the OS cannot enforce, such as masks across processor groups
+        int cancelled = 0;      // processes left untouched because the apply was cancelled
+    };
+
+    // One executable to bind as part of a batch.
+    struct HybridTarget
+    {
+        std::wstring exeName;
+        int eCores = 0;
+        int pCores = 0;
+        PlacementMode mode = PlacementMode::Hard;
+    };
+
+    // Executable names compare as the platform's file names do: case-insensitively on Windows,
+    // exactly elsewhere.
+    bool SameExeName(const wchar_t* a, const wchar_t* b);
+
     class NativeController
     {
     public:
         NativeController();
+        // Runs the placement logic against backend instead of the platform's own.
+        explicit NativeController(std::unique_ptr<OsBackend> backend);
+        ~NativeController();
         void MoveAllAppsToEfficiencyCores();
         void MoveAllAppsToSomeEfficiencyCores();
-        bool MoveAppToHybridCores(const wchar_t* target, int eCores, int pCores);
-        void MoveAllAppsToHybridCores(int eCores, int pCores);
+        bool MoveAppToHybridCores(const wchar_t* target, int eCores, int pCores, PlacementMode mode = PlacementMode::Hard);
+        std::vector<bool> MoveAppsToHybridCores(const std::vector<HybridTarget>& targets);
+        void MoveAllAppsToHybridCores(int eCores, int pCores, PlacementMode mode = PlacementMode::Hard);
+        // Places target on the unparked logical processors that have every feature in requiredFeatures,
+        // a combination of FeatureBit values. Fails when no processor qualifies.
+        bool MoveAppToFeatureCores(const wchar_t* target, unsigned long long requiredFeatures, PlacementMode mode = PlacementMode::Hard);
+        int PlaceAppThreads(const wchar_t* target, const ThreadPlacementPolicy& policy);
         void ResetToDefaultCores();
+        // Detects the topology from scratch and refreshes the topology cache. The constructor
+        // lets the backend load the cached topology instead when the hardware is unchanged.
         void DetectCoreCount();
         int TotalCoreCount();
         int EfficiencyCoreCount();
         int PerformanceCoreCount();
+        const CoreFeatureTable& FeatureTable() const;
+        ApplyResult LastApplyResult();
+        OsBackend& Backend();
+
+        // Counters and latency histograms since the controller was created or last reset.
+        MetricsSnapshot Metrics() const;
+        void ResetMetrics();
+        // Writes the metrics in the OpenMetrics text format to a file, pipe or socket, see OsBackend::WriteTextFile.
+        bool ExportMetrics(const wchar_t* path);
+
+        // Number of workers used for bulk applies, 0 picks a default and 1 applies on the calling thread.
+        void SetApplyConcurrency(int workers);
+
+        // Makes bulk applies stop at their next process until ResumeApplies. The processes
+        // already placed keep their placement. These two are safe to call from any thread,
+        // including while another thread is inside an apply.
+        void CancelApplies();
+        void ResumeApplies();
+
+        // Binds started processes of watched apps as soon as their start is reported,
+        // instead of waiting for the next explicit apply.
+        bool StartProcessEvents();
+        bool StartProcessEvents(std::unique_ptr<ProcessEventSource> source);
+        void StopProcessEvents();
+        bool WatchApp(const wchar_t* target, int eCores, int pCores, PlacementMode mode = PlacementMode::Hard);
+        void UnwatchApp(const wchar_t* target);
+        bool WaitForProcessEvents(unsigned timeoutMs);
+        int DrainProcessEvents();
+
+        // Rules are compiled once and then classify every process of a policy apply and every
+        // started process, so placement no longer has to be pushed in one app at a time.
+        void SetPlacementPolicy(const std::vector<PlacementRule>& rules);
+        // Reads one rule per line, see ParsePlacementRule. Keeps the current policy on errors.
+        bool LoadPlacementPolicy(const wchar_t* path);
+        // Applies the policy to every running process and returns the processes it matched.
+        int ApplyPlacementPolicy();
+
+        // Adapted apps start on the idle placement and move between it and the busy placement
+        // by their measured CPU load, see AdaptivePlacer. Started instances are picked up from
+        // process events when those are running, and by a rescan on every step otherwise.
+        void SetAdaptivePolicy(const AdaptivePolicy& policy);
+        void SetAdaptiveTimeSource(std::unique_ptr<ProcessTimeSource> source);
+        bool AdaptApp(const wchar_t* target);
+        void StopAdaptingApp(const wchar_t* target);
+        bool AdaptivePlacementDue();
+        // Samples the adapted processes and moves those that crossed a threshold. Returns the processes moved.
+        int StepAdaptivePlacement();
+
+        // Per-process CPU use of every process, refreshed by each SampleProcessCpu.
+        bool SampleProcessCpu();
+        ProcessCpuSampler& ProcessCpu();
+
+        // Samples every process and estimates the energy each used since the previous call,
+        // see EnergyAttributor. packageWatts is the mean package power measured over the
+        // interval, negative to take it from the energy counters when they are running.
+        bool SampleEnergy(double packageWatts);
+        void SetEnergyCoefficients(const EnergyCoefficients& coefficients);
+        const EnergyAttributor& Energy() const;
+
+        // Samples the native energy counters at rateHz in the background, see EnergySampler.
+        // Fails when the system has no counters the process can read.
+        bool StartEnergyCounters(unsigned rateHz);
+        void StopEnergyCounters();
+        // Null until StartEnergyCounters succeeded.
+        EnergySampler* EnergyCounters();
 
     private:
-        int CreateAffinityMask(int eCores, int pCores);
+        const CpuMask& CreateAffinityMask(int eCores, int pCores);
+        bool IsValidHybridSetting(int eCores, int pCores);
+        Placement CreatePlacement(const CpuMask& mask, PlacementMode mode);
+        bool BindProcess(unsigned long pid, const Placement& placement);
+        bool FindAndBind(const wchar_t* target, const Placement& placement);
+        bool SnapshotProcesses();
+        bool IndexProcesses();
+        void ProcessesSnapShot(const Placement& placement);
+        WorkerPool* ApplyPool(size_t itemCount);
+        HybridTarget* FindWatchedApp(const wchar_t* exeName);
+        void BuildTopology(bool allowCached);
+        int ClassifyProcess(unsigned long pid, const wchar_t* exeName);
+        bool ApplyPolicyRule(unsigned long pid, int rule);
+        AdaptivePlacer& Adaptive();
+        bool IsAdaptedApp(const wchar_t* exeName) const;
+        bool TrackAdaptedProcess(unsigned long pid);
+        Placement AdaptivePlacementFor(CoreClass coreClass);
+        void ClassFrequencies(double& eCoreMhz, double& pCoreMhz);
+
+        std::unique_ptr<OsBackend> m_Backend;
+        OperationMetrics m_Metrics;
+        CoreTopology m_Topology;
+        CoreFeatureTable m_FeatureTable;
+        BindingTable m_BindingTable;
+        ProcessHandleCache m_HandleCache;
+        ProcessList m_Processes;
+        ProcessNameIndex m_NameIndex;
+        ThreadPlanner m_ThreadPlanner;
+        ApplyResult m_LastApplyResult;
+        std::unique_ptr<WorkerPool> m_WorkerPool;
+        std::unique_ptr<ApplyControl> m_ApplyControl;
+        int m_ApplyConcurrency = 0;
+        std::vector<HybridTarget> m_WatchedApps;
+        std::unique_ptr<ProcessEventQueue> m_EventQueue;
+        std::unique_ptr<ProcessEventSource> m_EventSource;
+        std::vector<PlacementRule> m_PolicyRules;
+        std::vector<Placement> m_PolicyPlacements;      // indexed by rule, an empty mask keeps the affinity
+        PolicyMatcher m_PolicyMatcher;
+        std::unique_ptr<AdaptivePlacer> m_Adaptive;
+        std::vector<std::wstring> m_AdaptedApps;
+        std::unique_ptr<ProcessCpuSampler> m_ProcessCpu;
+        std::unique_ptr<FrequencySampler> m_Frequency;
+        std::vector<CoreClass> m_FrequencyClasses;      // class of each frequency source core
+        std::vector<float> m_EnergyShare;
+        EnergyAttributor m_Energy;
+        std::unique_ptr<EnergySampler> m_EnergyCounters;
+        double m_LastPackageJoules = -1;
     };
-}
\ No newline at end of file
+}
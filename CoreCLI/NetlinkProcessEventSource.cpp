@@ -0,0 +1,195 @@
+#ifdef __linux__
+
+#include "ProcessEventSource.h"
+#include "ProcessEventQueue.h"
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace Core
+{
+	// How often the reader checks whether it has been asked to stop.
+	const int pollIntervalMs = 100;
+
+	// Process events from the netlink proc connector. Listening requires CAP_NET_ADMIN.
+	class NetlinkProcessEventSource : public ProcessEventSource
+	{
+	public:
+		~NetlinkProcessEventSource() override;
+
+		bool Start(ProcessEventQueue& queue) override;
+		void Stop() override;
+
+	private:
+		bool SetListening(bool listen);
+		void ReadLoop();
+		void HandleMessage(const proc_event& procEvent);
+
+		ProcessEventQueue* m_Queue = nullptr;
+		int m_Socket = -1;
+		std::atomic<bool> m_Running{ false };
+		std::thread m_Thread;
+	};
+
+	// Reads the executable name of a process, falling back to its command name.
+	void ReadExeName(unsigned long pid, ProcessEvent& event) {
+		std::string path = "/proc/" + std::to_string(pid) + "/exe";
+		char buffer[4096];
+		ssize_t length = readlink(path.c_str(), buffer, sizeof(buffer));
+		if (length > 0) {
+			event.SetExeName(buffer, static_cast<std::size_t>(length));
+			return;
+		}
+
+		path = "/proc/" + std::to_string(pid) + "/comm";
+		FILE* file = fopen(path.c_str(), "r");
+		if (file != nullptr) {
+			std::size_t read = fread(buffer, 1, sizeof(buffer), file);
+			fclose(file);
+			while (read > 0 && buffer[read - 1] == '\n') {
+				read--;
+			}
+			event.SetExeName(buffer, read);
+		}
+	}
+
+	NetlinkProcessEventSource::~NetlinkProcessEventSource()
+	{
+		Stop();
+	}
+
+	bool NetlinkProcessEventSource::Start(ProcessEventQueue& queue)
+	{
+		if (m_Thread.joinable()) {
+			return true;
+		}
+
+		m_Socket = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+		if (m_Socket < 0) {
+			std::cout << "Could not open the proc connector: " << errno << std::endl;
+			return false;
+		}
+
+		sockaddr_nl address = {};
+		address.nl_family = AF_NETLINK;
+		address.nl_groups = CN_IDX_PROC;
+		if (bind(m_Socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || !SetListening(true)) {
+			std::cout << "Could not subscribe to process events: " << errno << std::endl;
+			close(m_Socket);
+			m_Socket = -1;
+			return false;
+		}
+
+		m_Queue = &queue;
+		m_Running = true;
+		m_Thread = std::thread(&NetlinkProcessEventSource::ReadLoop, this);
+		return true;
+	}
+
+	void NetlinkProcessEventSource::Stop()
+	{
+		m_Running = false;
+		if (m_Thread.joinable()) {
+			m_Thread.join();
+		}
+		if (m_Socket >= 0) {
+			SetListening(false);
+			close(m_Socket);
+			m_Socket = -1;
+		}
+		m_Queue = nullptr;
+	}
+
+	bool NetlinkProcessEventSource::SetListening(bool listen)
+	{
+		char buffer[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+
+		nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+		header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+		header->nlmsg_type = NLMSG_DONE;
+		header->nlmsg_pid = getpid();
+
+		cn_msg* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+		message->id.idx = CN_IDX_PROC;
+		message->id.val = CN_VAL_PROC;
+		message->len = sizeof(proc_cn_mcast_op);
+
+		proc_cn_mcast_op op = listen ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE;
+		memcpy(message->data, &op, sizeof(op));
+
+		return send(m_Socket, buffer, header->nlmsg_len, 0) >= 0;
+	}
+
+	void NetlinkProcessEventSource::ReadLoop()
+	{
+		alignas(nlmsghdr) char buffer[8192];
+
+		while (m_Running) {
+			pollfd descriptor = { m_Socket, POLLIN, 0 };
+			if (poll(&descriptor, 1, pollIntervalMs) <= 0) {
+				continue;
+			}
+
+			ssize_t length = recv(m_Socket, buffer, sizeof(buffer), 0);
+			if (length < 0) {
+				if (errno == ENOBUFS) {
+					// the kernel dropped events because we fell behind
+					m_Queue->AddDropped(1);
+				}
+				continue;
+			}
+
+			int remaining = static_cast<int>(length);
+			for (nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer); NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+				const cn_msg* message = static_cast<const cn_msg*>(NLMSG_DATA(header));
+				if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) {
+					continue;
+				}
+				HandleMessage(*reinterpret_cast<const proc_event*>(message->data));
+			}
+		}
+	}
+
+	void NetlinkProcessEventSource::HandleMessage(const proc_event& procEvent)
+	{
+		ProcessEvent event;
+
+		// exec rather than fork, so the event carries the name of the program being run
+		if (procEvent.what == proc_event::PROC_EVENT_EXEC) {
+			event.type = ProcessEventType::Started;
+			event.pid = procEvent.event_data.exec.process_tgid;
+			ReadExeName(event.pid, event);
+		}
+		else if (procEvent.what == proc_event::PROC_EVENT_EXIT) {
+			// only the exit of the main thread ends the process
+			if (procEvent.event_data.exit.process_pid != procEvent.event_data.exit.process_tgid) {
+				return;
+			}
+			event.type = ProcessEventType::Exited;
+			event.pid = procEvent.event_data.exit.process_tgid;
+		}
+		else {
+			return;
+		}
+
+		m_Queue->Push(event);
+	}
+
+	std::unique_ptr<ProcessEventSource> CreateProcessEventSource()
+	{
+		return std::unique_ptr<ProcessEventSource>(new NetlinkProcessEventSource());
+	}
+}
+
+#endif
@@ -0,0 +1,190 @@
+#include "OperationMetrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+namespace Core
+{
+	const unsigned LatencyHistogram::BucketCount;
+
+	// Threads beyond this share shards, which stays correct and only costs contention.
+	const unsigned shardCount = 16;
+
+	const size_t counterCount = static_cast<size_t>(MetricCounter::Count);
+	const size_t operationCount = static_cast<size_t>(MetricOperation::Count);
+
+	std::atomic<unsigned> nextMetricShard{ 0 };
+
+	struct OperationMetrics::Shard
+	{
+		std::atomic<unsigned long long> counters[counterCount];
+		std::atomic<unsigned long long> buckets[operationCount][LatencyHistogram::BucketCount];
+		std::atomic<unsigned long long> totalNs[operationCount];
+		std::atomic<unsigned long long> maxNs[operationCount];
+		char padding[64];       // keeps the next shard off this one's last cache line
+	};
+
+	unsigned long long LatencyHistogram::BucketLimitUs(unsigned bucket)
+	{
+		return bucket + 1 < BucketCount ? 1ULL << bucket : 0;
+	}
+
+	OperationMetrics::OperationMetrics()
+		: m_Shards(new Shard[shardCount])
+	{
+		Reset();
+	}
+
+	OperationMetrics::~OperationMetrics()
+	{
+	}
+
+	// Threads keep the shard they were first given for their lifetime, across every instance.
+	OperationMetrics::Shard& OperationMetrics::LocalShard()
+	{
+		static thread_local unsigned shard = nextMetricShard.fetch_add(1, std::memory_order_relaxed) % shardCount;
+		return m_Shards[shard];
+	}
+
+	void OperationMetrics::Add(MetricCounter counter, unsigned long long amount)
+	{
+		LocalShard().counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	void OperationMetrics::Record(MetricOperation operation, unsigned long long ns)
+	{
+		size_t op = static_cast<size_t>(operation);
+		// the bucket is the bit length of the microseconds
+		unsigned bucket = 0;
+		for (unsigned long long us = ns / 1000; us != 0 && bucket + 1 < LatencyHistogram::BucketCount; us >>= 1) {
+			bucket++;
+		}
+
+		// the count is the sum of the buckets, two atomic adds are all a record costs
+		Shard& shard = LocalShard();
+		shard.buckets[op][bucket].fetch_add(1, std::memory_order_relaxed);
+		shard.totalNs[op].fetch_add(ns, std::memory_order_relaxed);
+		unsigned long long max = shard.maxNs[op].load(std::memory_order_relaxed);
+		while (ns > max && !shard.maxNs[op].compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+		}
+	}
+
+	void OperationMetrics::Read(MetricsSnapshot& snapshot) const
+	{
+		snapshot = MetricsSnapshot();
+		for (unsigned s = 0; s < shardCount; s++) {
+			const Shard& shard = m_Shards[s];
+			for (size_t c = 0; c < counterCount; c++) {
+				snapshot.counters[c] += shard.counters[c].load(std::memory_order_relaxed);
+			}
+			for (size_t op = 0; op < operationCount; op++) {
+				LatencyHistogram& histogram = snapshot.latency[op];
+				for (unsigned b = 0; b < LatencyHistogram::BucketCount; b++) {
+					unsigned long long count = shard.buckets[op][b].load(std::memory_order_relaxed);
+					histogram.buckets[b] += count;
+					histogram.count += count;
+				}
+				histogram.totalNs += shard.totalNs[op].load(std::memory_order_relaxed);
+				unsigned long long max = shard.maxNs[op].load(std::memory_order_relaxed);
+				if (max > histogram.maxNs) {
+					histogram.maxNs = max;
+				}
+			}
+		}
+	}
+
+	void OperationMetrics::Reset()
+	{
+		for (unsigned s = 0; s < shardCount; s++) {
+			Shard& shard = m_Shards[s];
+			for (auto& counter : shard.counters) {
+				counter.store(0, std::memory_order_relaxed);
+			}
+			for (size_t op = 0; op < operationCount; op++) {
+				for (auto& bucket : shard.buckets[op]) {
+					bucket.store(0, std::memory_order_relaxed);
+				}
+				shard.totalNs[op].store(0, std::memory_order_relaxed);
+				shard.maxNs[op].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	unsigned long long OperationMetrics::Now()
+	{
+		return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	struct MetricName
+	{
+		const char* name;
+		const char* help;
+	};
+
+	const MetricName counterNames[counterCount] = {
+		{ "hybrid_applies", "Bulk applies over the process list" },
+		{ "hybrid_processes_scanned", "Processes looked at by bulk applies" },
+		{ "hybrid_processes_bound", "Processes given a placement" },
+		{ "hybrid_processes_skipped", "Processes that already held the placement" },
+		{ "hybrid_processes_failed", "Processes that could not be placed" },
+		{ "hybrid_processes_denied", "Processes that refused access" }
+	};
+
+	const MetricName operationNames[operationCount] = {
+		{ "hybrid_snapshot_seconds", "Time to enumerate the running processes" },
+		{ "hybrid_open_seconds", "Time to open a process that was not cached" },
+		{ "hybrid_set_affinity_seconds", "Time to apply a placement to one process" },
+		{ "hybrid_apply_seconds", "Time of one whole bulk apply" }
+	};
+
+	void AppendMetricHeader(std::string& text, const MetricName& metric, const char* type)
+	{
+		text.append("# TYPE ").append(metric.name).append(" ").append(type).append("\n");
+		text.append("# HELP ").append(metric.name).append(" ").append(metric.help).append("\n");
+	}
+
+	void AppendMetricSample(std::string& text, const char* name, const char* suffix, unsigned long long value)
+	{
+		char number[24];
+		snprintf(number, sizeof(number), " %llu\n", value);
+		text.append(name).append(suffix).append(number);
+	}
+
+	void FormatOpenMetrics(const MetricsSnapshot& snapshot, std::string& text)
+	{
+		for (size_t c = 0; c < counterCount; c++) {
+			AppendMetricHeader(text, counterNames[c], "counter");
+			AppendMetricSample(text, counterNames[c].name, "_total", snapshot.counters[c]);
+		}
+
+		for (size_t op = 0; op < operationCount; op++) {
+			const MetricName& metric = operationNames[op];
+			const LatencyHistogram& histogram = snapshot.latency[op];
+			AppendMetricHeader(text, metric, "histogram");
+			text.append("# UNIT ").append(metric.name).append(" seconds\n");
+
+			// buckets are cumulative in the exposition format
+			unsigned long long cumulative = 0;
+			for (unsigned b = 0; b < LatencyHistogram::BucketCount; b++) {
+				cumulative += histogram.buckets[b];
+				unsigned long long limitUs = LatencyHistogram::BucketLimitUs(b);
+				char label[32];
+				if (limitUs != 0) {
+					snprintf(label, sizeof(label), "_bucket{le=\"%g\"}", limitUs / 1e6);
+				}
+				else {
+					snprintf(label, sizeof(label), "_bucket{le=\"+Inf\"}");
+				}
+				AppendMetricSample(text, metric.name, label, cumulative);
+			}
+
+			char sum[40];
+			snprintf(sum, sizeof(sum), "_sum %.9f\n", histogram.totalNs / 1e9);
+			text.append(metric.name).append(sum);
+			AppendMetricSample(text, metric.name, "_count", histogram.count);
+		}
+		text.append("# EOF\n");
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace Core
+{
+    enum class MetricCounter : unsigned char
+    {
+        Applies,        // bulk applies over the process list
+        Scanned,        // processes a bulk apply looked at
+        Bound,          // processes given a placement, by bulk applies and single binds
+        Skipped,        // processes that already held the placement
+        Failed,
+        Denied,
+        Count
+    };
+
+    enum class MetricOperation : unsigned char
+    {
+        Snapshot,       // one enumeration of the running processes
+        Open,           // opening a process that was not in the handle cache
+        SetAffinity,    // applying a placement to one process
+        Apply,          // one whole bulk apply
+        Count
+    };
+
+    // Latency distribution of one operation. buckets[0] counts operations under 1us,
+    // buckets[i] those from 2^(i-1)us up to 2^i us, and the last bucket everything slower.
+    struct LatencyHistogram
+    {
+        static const unsigned BucketCount = 24;
+
+        unsigned long long buckets[BucketCount] = {};
+        unsigned long long count = 0;
+        unsigned long long totalNs = 0;
+        unsigned long long maxNs = 0;
+
+        // Upper bound of bucket i in microseconds, 0 for the unbounded last bucket.
+        static unsigned long long BucketLimitUs(unsigned bucket);
+    };
+
+    struct MetricsSnapshot
+    {
+        unsigned long long counters[static_cast<std::size_t>(MetricCounter::Count)] = {};
+        LatencyHistogram latency[static_cast<std::size_t>(MetricOperation::Count)];
+
+        unsigned long long Counter(MetricCounter counter) const { return counters[static_cast<std::size_t>(counter)]; }
+        const LatencyHistogram& Latency(MetricOperation operation) const { return latency[static_cast<std::size_t>(operation)]; }
+    };
+
+    // Counters and latency histograms of the controller's operations, cheap enough to stay
+    // on in every apply. Each thread records into a shard of its own without taking a lock,
+    // and a reader sums the shards, so apply workers never contend on a shared cache line.
+    class OperationMetrics
+    {
+    public:
+        OperationMetrics();
+        ~OperationMetrics();
+
+        OperationMetrics(const OperationMetrics&) = delete;
+        OperationMetrics& operator=(const OperationMetrics&) = delete;
+
+        // Safe to call from any thread.
+        void Add(MetricCounter counter, unsigned long long amount = 1);
+        void Record(MetricOperation operation, unsigned long long ns);
+
+        // A reader racing with writers sees every update either before or after, never torn.
+        void Read(MetricsSnapshot& snapshot) const;
+        // Updates recorded while the reset runs may survive it.
+        void Reset();
+
+        // Monotonic clock in nanoseconds, for timing operations.
+        static unsigned long long Now();
+
+    private:
+        struct Shard;
+
+        Shard& LocalShard();
+
+        std::unique_ptr<Shard[]> m_Shards;
+    };
+
+    // Times one operation from construction to destruction.
+    class MetricTimer
+    {
+    public:
+        MetricTimer(OperationMetrics& metrics, MetricOperation operation)
+            : m_Metrics(metrics), m_Operation(operation), m_Start(OperationMetrics::Now())
+        {
+        }
+
+        ~MetricTimer()
+        {
+            m_Metrics.Record(m_Operation, OperationMetrics::Now() - m_Start);
+        }
+
+        MetricTimer(const MetricTimer&) = delete;
+        MetricTimer& operator=(const MetricTimer&) = delete;
+
+    private:
+        OperationMetrics& m_Metrics;
+        MetricOperation m_Operation;
+        unsigned long long m_Start;
+    };
+
+    // Appends the snapshot in the OpenMetrics text exposition format, ending with # EOF.
+    void FormatOpenMetrics(const MetricsSnapshot& snapshot, std::string& text);
+}
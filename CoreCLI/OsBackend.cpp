@@ -0,0 +1,26 @@
+#include "OsBackend.h"
+
+#include <cwchar>
+
+namespace Core
+{
+	void ProcessList::Clear()
+	{
+		m_Pids.clear();
+		m_NameOffsets.clear();
+		m_Names.clear();
+	}
+
+	void ProcessList::Add(unsigned long pid, const wchar_t* exeName)
+	{
+		Add(pid, exeName, wcslen(exeName));
+	}
+
+	void ProcessList::Add(unsigned long pid, const wchar_t* exeName, std::size_t length)
+	{
+		m_Pids.push_back(pid);
+		m_NameOffsets.push_back(m_Names.size());
+		m_Names.insert(m_Names.end(), exeName, exeName + length);
+		m_Names.push_back(L'\0');
+	}
+}
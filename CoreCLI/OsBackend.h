@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CoreTopology.h"
+#include "CpuMask.h"
+#include "PlacementPolicy.h"
+#include "ThreadPlacement.h"
+
+namespace Core
+{
+    // An open process handle together with the creation time of the process it refers to.
+    struct ProcessHandle
+    {
+        void* handle = nullptr;
+        unsigned long long creationTime = 0;
+        bool cached = false;
+    };
+
+    // The cores a bind applies and how. Soft placements carry the CPU set IDs of the mask,
+    // an empty list clears the process's default CPU sets.
+    struct Placement
+    {
+        CpuMask mask;
+        PlacementMode mode = PlacementMode::Hard;
+        std::vector<unsigned long> cpuSets;
+    };
+
+    // One logical processor with what the feature table keeps about it.
+    struct ProcessorDescription
+    {
+        LogicalCore core;
+        uint64_t features = 0;          // CoreFeature bits, the class bits are added from core
+        unsigned char coreType = 0;     // CPUID leaf 0x1A core type, 0 when unknown
+        unsigned baseMhz = 0;
+        unsigned maxMhz = 0;
+    };
+
+    // Every running process from one enumeration. Names are stored back to back in one
+    // buffer, so a list reused across snapshots stops allocating once it has grown.
+    class ProcessList
+    {
+    public:
+        void Clear();
+        void Add(unsigned long pid, const wchar_t* exeName);
+        void Add(unsigned long pid, const wchar_t* exeName, std::size_t length);
+
+        std::size_t Count() const { return m_Pids.size(); }
+        unsigned long Pid(std::size_t i) const { return m_Pids[i]; }
+        const wchar_t* Name(std::size_t i) const { return m_Names.data() + m_NameOffsets[i]; }
+
+    private:
+        std::vector<unsigned long> m_Pids;
+        std::vector<std::size_t> m_NameOffsets;
+        std::vector<wchar_t> m_Names;
+    };
+
+    enum class OsStatus : unsigned char
+    {
+        Ok,
+        AccessDenied,
+        Failed,
+        Unsupported     // the OS cannot enforce the placement as asked, e.g. a hard mask across processor groups
+    };
+
+    // Every call NativeController makes into the operating system, so the same placement
+    // logic drives Windows, Linux or a simulated system. Calls on process handles run on
+    // the apply workers, several at a time, and must be safe to make concurrently.
+    class OsBackend
+    {
+    public:
+        virtual ~OsBackend() {}
+
+        // Describes every logical processor. With allowCached the backend may reuse a
+        // topology it detected on an earlier run on the same hardware.
+        virtual bool DetectTopology(bool allowCached, std::vector<ProcessorDescription>& processors) = 0;
+
+        // Replaces the contents of processes with every running process.
+        virtual bool EnumerateProcesses(ProcessList& processes) = 0;
+
+        // Opens a process for placement. creationTime tells the process from a later one
+        // reusing its PID, 0 when it cannot be read.
+        virtual OsStatus OpenProcess(unsigned long pid, ProcessHandle& process) = 0;
+        virtual bool HasExited(void* handle) = 0;
+        virtual void CloseProcess(void* handle) = 0;
+        virtual bool ProcessImagePath(void* handle, std::wstring& path) = 0;
+        // How many opened processes may be kept open at once. The handle cache never holds more.
+        virtual std::size_t MaxCachedHandles() = 0;
+
+        // allMask and groupCount describe the whole topology, a soft placement first widens
+        // the hard affinity to allMask. clearCpuSets asks a hard placement to also drop the
+        // CPU sets of an earlier soft placement, which costs a call on every process otherwise.
+        virtual OsStatus ApplyPlacement(void* handle, const Placement& placement, bool clearCpuSets, const CpuMask& allMask, unsigned groupCount) = 0;
+        // Takes a bound process out of background processing mode, where the OS would keep it at low priority.
+        virtual void EndBackgroundMode(void* handle) = 0;
+        virtual bool SetPriority(void* handle, PriorityClass priority) = 0;
+        virtual bool SetPowerThrottling(void* handle, PowerThrottling throttling) = 0;
+        virtual bool SetMemoryPriority(void* handle, MemoryPriority priority) = 0;
+
+        virtual bool EnumerateThreads(unsigned long pid, std::vector<ThreadSample>& threads) = 0;
+        // cpuSets holds LogicalCore::cpuSetId values. An empty list lets the thread run anywhere.
+        virtual bool SetThreadCpus(unsigned long tid, const std::vector<unsigned long>& cpuSets) = 0;
+        virtual bool SetCurrentThreadCpus(const std::vector<unsigned long>& cpuSets) = 0;
+
+        // Reads a UTF-8 text file.
+        virtual bool ReadTextFile(const wchar_t* path, std::wstring& text) = 0;
+        // Replaces a file with text through a temporary file, so readers never see it half
+        // written. When path is a named pipe or a Unix-domain socket, text is sent to it instead.
+        virtual bool WriteTextFile(const wchar_t* path, const std::string& text) = 0;
+    };
+
+    // The backend of the platform: Win32 on Windows, sched_setaffinity, /proc and sysfs on Linux.
+    std::unique_ptr<OsBackend> CreateOsBackend();
+}
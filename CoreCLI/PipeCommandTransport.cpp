@@ -0,0 +1,222 @@
+#include "CommandTransport.h"
+
+#include <windows.h>
+#include <sddl.h>
+#include <iostream>
+#include <string>
+
+#pragma comment(lib, "advapi32.lib")
+
+namespace Core
+{
+	const DWORD pipeBufferSize = 64 * 1024;
+
+	// The helper runs elevated while the app that sends it commands does not, so interactive
+	// users may read and write the pipe, and only SYSTEM and administrators may do the rest.
+	const wchar_t pipeSecurity[] = L"D:(A;;GA;;;SY)(A;;GA;;;BA)(A;;GRGW;;;IU)";
+
+	// Overlapped pipe end, so Close can end a read that is waiting for a client.
+	class PipeCommandChannel : public CommandChannel
+	{
+	public:
+		PipeCommandChannel(HANDLE pipe, bool server)
+			: m_Pipe(pipe), m_Server(server)
+		{
+			m_IoEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+			m_Closed = CreateEventW(NULL, TRUE, FALSE, NULL);
+		}
+
+		~PipeCommandChannel() override
+		{
+			if (m_Server) {
+				DisconnectNamedPipe(m_Pipe);
+			}
+			CloseHandle(m_Pipe);
+			CloseHandle(m_IoEvent);
+			CloseHandle(m_Closed);
+		}
+
+		bool Read(void* buffer, std::size_t length) override
+		{
+			return Transfer(false, static_cast<char*>(buffer), length);
+		}
+
+		bool Write(const void* data, std::size_t length) override
+		{
+			return Transfer(true, const_cast<char*>(static_cast<const char*>(data)), length);
+		}
+
+		void Close() override
+		{
+			SetEvent(m_Closed);
+		}
+
+	private:
+		bool Transfer(bool write, char* bytes, std::size_t length)
+		{
+			while (length > 0) {
+				if (WaitForSingleObject(m_Closed, 0) == WAIT_OBJECT_0) {
+					return false;
+				}
+
+				OVERLAPPED overlapped = {};
+				overlapped.hEvent = m_IoEvent;
+				DWORD chunk = length > pipeBufferSize ? pipeBufferSize : static_cast<DWORD>(length);
+				BOOL done = write ? WriteFile(m_Pipe, bytes, chunk, NULL, &overlapped) : ReadFile(m_Pipe, bytes, chunk, NULL, &overlapped);
+				if (!done && GetLastError() != ERROR_IO_PENDING) {
+					return false;
+				}
+
+				DWORD moved = 0;
+				if (!done) {
+					HANDLE events[] = { m_IoEvent, m_Closed };
+					if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0) {
+						// the system still owns overlapped until the cancelled operation completes
+						CancelIoEx(m_Pipe, &overlapped);
+						GetOverlappedResult(m_Pipe, &overlapped, &moved, TRUE);
+						return false;
+					}
+				}
+				if (!GetOverlappedResult(m_Pipe, &overlapped, &moved, FALSE) || moved == 0) {
+					return false;
+				}
+				bytes += moved;
+				length -= moved;
+			}
+			return true;
+		}
+
+		HANDLE m_Pipe;
+		HANDLE m_IoEvent;
+		HANDLE m_Closed;
+		bool m_Server;
+	};
+
+	// Keeps one pipe instance waiting for a client, and creates the next once it connects.
+	class PipeCommandListener : public CommandListener
+	{
+	public:
+		PipeCommandListener()
+		{
+			m_ConnectEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+		}
+
+		~PipeCommandListener() override
+		{
+			Close();
+			CloseHandle(m_ConnectEvent);
+		}
+
+		bool Listen(const wchar_t* name) override
+		{
+			Close();
+
+			if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(pipeSecurity, SDDL_REVISION_1, &m_Security, NULL)) {
+				m_Security = NULL;
+				return false;
+			}
+			m_Name = name;
+			if (!CreateInstance(true)) {
+				std::cout << "Could not create the command pipe: " << GetLastError() << std::endl;
+				Close();
+				return false;
+			}
+			return true;
+		}
+
+		std::unique_ptr<CommandChannel> Accept(unsigned timeoutMs) override
+		{
+			if (m_Pending == INVALID_HANDLE_VALUE && (m_Security == NULL || !CreateInstance(false))) {
+				return nullptr;
+			}
+
+			if (!m_Connecting) {
+				ResetEvent(m_ConnectEvent);
+				m_Overlapped = {};
+				m_Overlapped.hEvent = m_ConnectEvent;
+				if (!ConnectNamedPipe(m_Pending, &m_Overlapped)) {
+					DWORD error = GetLastError();
+					if (error == ERROR_IO_PENDING) {
+						m_Connecting = true;
+					}
+					else if (error != ERROR_PIPE_CONNECTED) {
+						// the client left between connecting and now, start over with a fresh instance
+						CloseHandle(m_Pending);
+						m_Pending = INVALID_HANDLE_VALUE;
+						return nullptr;
+					}
+				}
+			}
+
+			if (m_Connecting) {
+				if (WaitForSingleObject(m_ConnectEvent, timeoutMs) != WAIT_OBJECT_0) {
+					return nullptr;
+				}
+				m_Connecting = false;
+				DWORD unused;
+				if (!GetOverlappedResult(m_Pending, &m_Overlapped, &unused, FALSE)) {
+					CloseHandle(m_Pending);
+					m_Pending = INVALID_HANDLE_VALUE;
+					return nullptr;
+				}
+			}
+
+			HANDLE connected = m_Pending;
+			m_Pending = INVALID_HANDLE_VALUE;
+			return std::unique_ptr<CommandChannel>(new PipeCommandChannel(connected, true));
+		}
+
+		void Close() override
+		{
+			if (m_Pending != INVALID_HANDLE_VALUE) {
+				if (m_Connecting) {
+					DWORD unused;
+					CancelIoEx(m_Pending, &m_Overlapped);
+					GetOverlappedResult(m_Pending, &m_Overlapped, &unused, TRUE);
+					m_Connecting = false;
+				}
+				CloseHandle(m_Pending);
+				m_Pending = INVALID_HANDLE_VALUE;
+			}
+			if (m_Security != NULL) {
+				LocalFree(m_Security);
+				m_Security = NULL;
+			}
+		}
+
+	private:
+		bool CreateInstance(bool first)
+		{
+			SECURITY_ATTRIBUTES attributes = { sizeof(attributes), m_Security, FALSE };
+			// the first instance claims the name, so a second server cannot listen beside this one
+			DWORD openMode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+			m_Pending = CreateNamedPipeW(m_Name.c_str(), openMode, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+				PIPE_UNLIMITED_INSTANCES, pipeBufferSize, pipeBufferSize, 0, &attributes);
+			return m_Pending != INVALID_HANDLE_VALUE;
+		}
+
+		std::wstring m_Name;
+		PSECURITY_DESCRIPTOR m_Security = NULL;
+		HANDLE m_Pending = INVALID_HANDLE_VALUE;
+		HANDLE m_ConnectEvent;
+		OVERLAPPED m_Overlapped = {};
+		bool m_Connecting = false;
+	};
+
+	std::unique_ptr<CommandListener> CreateCommandListener()
+	{
+		return std::unique_ptr<CommandListener>(new PipeCommandListener());
+	}
+
+	std::unique_ptr<CommandChannel> ConnectCommandChannel(const wchar_t* name)
+	{
+		HANDLE pipe = CreateFileW(name, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+		if (pipe == INVALID_HANDLE_VALUE && GetLastError() == ERROR_PIPE_BUSY && WaitNamedPipeW(name, 1000)) {
+			pipe = CreateFileW(name, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+		}
+		if (pipe == INVALID_HANDLE_VALUE) {
+			return nullptr;
+		}
+		return std::unique_ptr<CommandChannel>(new PipeCommandChannel(pipe, false));
+	}
+}
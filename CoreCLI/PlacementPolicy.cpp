@@ -0,0 +1,292 @@
+#include "PlacementPolicy.h"
+
+#include <cwchar>
+#include <cwctype>
+#include <sstream>
+
+namespace Core
+{
+	wchar_t Fold(wchar_t c)
+	{
+		return static_cast<wchar_t>(towlower(c));
+	}
+
+	uint64_t HashName(const wchar_t* name)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (; *name != L'\0'; name++) {
+			hash = (hash ^ static_cast<uint32_t>(Fold(*name))) * 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	// Case-insensitive glob match of * and ?, backtracking only to the last *.
+	bool GlobMatch(const wchar_t* pattern, const wchar_t* text)
+	{
+		const wchar_t* star = nullptr;
+		const wchar_t* resume = nullptr;
+
+		while (*text != L'\0') {
+			if (*pattern == L'*') {
+				star = pattern++;
+				resume = text;
+			}
+			else if (*pattern == L'?' || (*pattern != L'\0' && *pattern == Fold(*text))) {
+				pattern++;
+				text++;
+			}
+			else if (star != nullptr) {
+				pattern = star + 1;
+				text = ++resume;
+			}
+			else {
+				return false;
+			}
+		}
+
+		while (*pattern == L'*') {
+			pattern++;
+		}
+		return *pattern == L'\0';
+	}
+
+	void PolicyMatcher::Trie::Clear()
+	{
+		edges.clear();
+		rules.assign(1, INT_MAX);
+	}
+
+	void PolicyMatcher::Trie::Insert(const std::wstring& key, int rule)
+	{
+		if (rules.empty()) {
+			rules.assign(1, INT_MAX);
+		}
+
+		int node = 0;
+		for (wchar_t c : key) {
+			auto it = edges.find(Edge(node, c));
+			if (it == edges.end()) {
+				rules.push_back(INT_MAX);
+				it = edges.emplace(Edge(node, c), static_cast<int>(rules.size() - 1)).first;
+			}
+			node = it->second;
+		}
+
+		if (rule < rules[node]) {
+			rules[node] = rule;
+		}
+	}
+
+	void PolicyMatcher::Clear()
+	{
+		m_Exact.clear();
+		m_ExactNames.clear();
+		m_Prefixes.Clear();
+		m_Suffixes.Clear();
+		m_Globs.clear();
+		m_RuleCount = 0;
+		m_HasPathRules = false;
+	}
+
+	void PolicyMatcher::Compile(const std::vector<PlacementRule>& rules)
+	{
+		Clear();
+		m_RuleCount = rules.size();
+		m_ExactNames.resize(rules.size());
+
+		for (std::size_t i = 0; i < rules.size(); i++) {
+			int rule = static_cast<int>(i);
+			std::wstring pattern;
+			for (wchar_t c : rules[i].pattern) {
+				pattern.push_back(Fold(c));
+			}
+
+			bool path = pattern.find_first_of(L"\\/") != std::wstring::npos;
+			std::size_t firstWildcard = pattern.find_first_of(L"*?");
+			std::size_t lastWildcard = pattern.find_last_of(L"*?");
+
+			if (path) {
+				m_Globs.push_back({ rule, true, pattern });
+				m_HasPathRules = true;
+			}
+			else if (firstWildcard == std::wstring::npos) {
+				m_Exact.emplace(HashName(pattern.c_str()), rule);
+				m_ExactNames[i] = pattern;
+			}
+			else if (firstWildcard == lastWildcard && firstWildcard == pattern.size() - 1 && pattern.back() == L'*') {
+				m_Prefixes.Insert(pattern.substr(0, pattern.size() - 1), rule);
+			}
+			else if (firstWildcard == lastWildcard && firstWildcard == 0 && pattern.front() == L'*') {
+				m_Suffixes.Insert(std::wstring(pattern.rbegin(), pattern.rend() - 1), rule);
+			}
+			else {
+				m_Globs.push_back({ rule, false, pattern });
+			}
+		}
+	}
+
+	int PolicyMatcher::Match(const wchar_t* exeName, const wchar_t* path) const
+	{
+		if (m_RuleCount == 0 || exeName == nullptr) {
+			return -1;
+		}
+
+		int best = INT_MAX;
+
+		auto range = m_Exact.equal_range(HashName(exeName));
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second < best && GlobMatch(m_ExactNames[it->second].c_str(), exeName)) {
+				best = it->second;
+			}
+		}
+
+		std::size_t length = wcslen(exeName);
+		if (!m_Prefixes.rules.empty()) {
+			int node = 0;
+			for (std::size_t i = 0; ; i++) {
+				if (m_Prefixes.rules[node] < best) {
+					best = m_Prefixes.rules[node];
+				}
+				if (i == length) {
+					break;
+				}
+				auto it = m_Prefixes.edges.find(Edge(node, Fold(exeName[i])));
+				if (it == m_Prefixes.edges.end()) {
+					break;
+				}
+				node = it->second;
+			}
+		}
+
+		if (!m_Suffixes.rules.empty()) {
+			int node = 0;
+			for (std::size_t i = length; ; i--) {
+				if (m_Suffixes.rules[node] < best) {
+					best = m_Suffixes.rules[node];
+				}
+				if (i == 0) {
+					break;
+				}
+				auto it = m_Suffixes.edges.find(Edge(node, Fold(exeName[i - 1])));
+				if (it == m_Suffixes.edges.end()) {
+					break;
+				}
+				node = it->second;
+			}
+		}
+
+		// globs are in rule order, so stop at the first that could not improve on best
+		for (const GlobRule& glob : m_Globs) {
+			if (glob.rule >= best) {
+				break;
+			}
+			const wchar_t* text = glob.path ? path : exeName;
+			if (text != nullptr && GlobMatch(glob.pattern.c_str(), text)) {
+				best = glob.rule;
+			}
+		}
+
+		return best == INT_MAX ? -1 : best;
+	}
+
+	bool ParseCoreCount(const std::wstring& value, int& count)
+	{
+		if (value == L"all") {
+			count = -1;
+			return true;
+		}
+
+		wchar_t* end = nullptr;
+		long parsed = wcstol(value.c_str(), &end, 10);
+		if (value.empty() || *end != L'\0' || parsed < 0) {
+			return false;
+		}
+		count = static_cast<int>(parsed);
+		return true;
+	}
+
+	bool ParsePlacementRule(const std::wstring& line, PlacementRule& rule, std::string& error)
+	{
+		error.clear();
+		rule = PlacementRule();
+
+		std::wistringstream stream(line);
+		stream >> std::ws;
+		if (stream.eof() || stream.peek() == L'#') {
+			return false;
+		}
+
+		if (stream.peek() == L'"') {
+			stream.get();
+			std::getline(stream, rule.pattern, L'"');
+		}
+		else {
+			stream >> rule.pattern;
+		}
+		if (rule.pattern.empty()) {
+			error = "missing pattern";
+			return false;
+		}
+
+		std::wstring token;
+		while (stream >> token) {
+			std::size_t separator = token.find(L'=');
+			std::wstring key = token.substr(0, separator);
+			std::wstring value = separator == std::wstring::npos ? std::wstring() : token.substr(separator + 1);
+			for (wchar_t& c : value) {
+				c = Fold(c);
+			}
+
+			bool valid = true;
+			if (key == L"e") {
+				valid = ParseCoreCount(value, rule.eCores);
+			}
+			else if (key == L"p") {
+				valid = ParseCoreCount(value, rule.pCores);
+			}
+			else if (key == L"class") {
+				valid = value == L"e" || value == L"p";
+				rule.eCores = value == L"e" ? -1 : 0;
+				rule.pCores = value == L"p" ? -1 : 0;
+			}
+			else if (key == L"mode") {
+				valid = value == L"hard" || value == L"soft";
+				rule.mode = value == L"soft" ? PlacementMode::Soft : PlacementMode::Hard;
+			}
+			else if (key == L"priority") {
+				if (value == L"idle") rule.priority = PriorityClass::Idle;
+				else if (value == L"belownormal") rule.priority = PriorityClass::BelowNormal;
+				else if (value == L"normal") rule.priority = PriorityClass::Normal;
+				else if (value == L"abovenormal") rule.priority = PriorityClass::AboveNormal;
+				else if (value == L"high") rule.priority = PriorityClass::High;
+				else valid = false;
+			}
+			else if (key == L"throttle") {
+				if (value == L"on") rule.throttling = PowerThrottling::On;
+				else if (value == L"off") rule.throttling = PowerThrottling::Off;
+				else if (value == L"auto") rule.throttling = PowerThrottling::Auto;
+				else valid = false;
+			}
+			else if (key == L"memory") {
+				if (value == L"verylow") rule.memoryPriority = MemoryPriority::VeryLow;
+				else if (value == L"low") rule.memoryPriority = MemoryPriority::Low;
+				else if (value == L"medium") rule.memoryPriority = MemoryPriority::Medium;
+				else if (value == L"belownormal") rule.memoryPriority = MemoryPriority::BelowNormal;
+				else if (value == L"normal") rule.memoryPriority = MemoryPriority::Normal;
+				else valid = false;
+			}
+			else {
+				valid = false;
+			}
+
+			if (!valid) {
+				error = "invalid setting ";
+				for (wchar_t c : token) {
+					error.push_back(c < 0x80 ? static_cast<char>(c) : '?');
+				}
+				return false;
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BindingTable.h"
+
+namespace Core
+{
+    enum class PriorityClass : unsigned char
+    {
+        Unchanged,
+        Idle,
+        BelowNormal,
+        Normal,
+        AboveNormal,
+        High
+    };
+
+    // On requests EcoQoS, Auto hands the decision back to the OS.
+    enum class PowerThrottling : unsigned char
+    {
+        Unchanged,
+        On,
+        Off,
+        Auto
+    };
+
+    // Values after Unchanged match the Windows MEMORY_PRIORITY_* levels.
+    enum class MemoryPriority : unsigned char
+    {
+        Unchanged,
+        VeryLow,
+        Low,
+        Medium,
+        BelowNormal,
+        Normal
+    };
+
+    // What to do with the processes whose executable matches pattern. Patterns are
+    // case-insensitive and may use * and ?. A pattern with a path separator is matched
+    // against the full image path instead of the executable name. eCores or pCores of -1
+    // select every core of that class, and 0 for both leaves the affinity alone.
+    struct PlacementRule
+    {
+        std::wstring pattern;
+        int eCores = 0;
+        int pCores = 0;
+        PlacementMode mode = PlacementMode::Hard;
+        PriorityClass priority = PriorityClass::Unchanged;
+        PowerThrottling throttling = PowerThrottling::Unchanged;
+        MemoryPriority memoryPriority = MemoryPriority::Unchanged;
+    };
+
+    // Parses one rule of the form "<pattern> key=value ...", for example
+    //   msedge*.exe class=e mode=soft priority=belownormal throttle=on memory=low
+    // Keys are e, p, class (e or p), mode, priority, throttle and memory. The pattern may be
+    // quoted when it contains spaces. Blank lines and lines starting with # return false
+    // with error left empty.
+    bool ParsePlacementRule(const std::wstring& line, PlacementRule& rule, std::string& error);
+
+    // Rule patterns compiled for classifying processes in time linear in the name: exact
+    // names are hashed, prefix and suffix patterns share a trie each, and only patterns
+    // with wildcards inside them are tried one by one. The first rule in declaration order
+    // that matches wins.
+    class PolicyMatcher
+    {
+    public:
+        void Compile(const std::vector<PlacementRule>& rules);
+        void Clear();
+
+        // Index of the matching rule, or -1. path may be null when it is not known.
+        int Match(const wchar_t* exeName, const wchar_t* path = nullptr) const;
+
+        bool HasPathRules() const { return m_HasPathRules; }
+        bool Empty() const { return m_RuleCount == 0; }
+
+    private:
+        struct GlobRule
+        {
+            int rule;
+            bool path;
+            std::wstring pattern;
+        };
+
+        // A trie stored as one edge table keyed by (node, character).
+        struct Trie
+        {
+            std::unordered_map<uint64_t, int> edges;
+            std::vector<int> rules;     // lowest rule ending at each node, INT_MAX for none
+
+            void Clear();
+            void Insert(const std::wstring& key, int rule);
+        };
+
+        static uint64_t Edge(int node, wchar_t c) { return (uint64_t(node) << 32) | uint32_t(c); }
+
+        std::unordered_multimap<uint64_t, int> m_Exact;     // hash of the lower-case name
+        std::vector<std::wstring> m_ExactNames;             // indexed by rule
+        Trie m_Prefixes;
+        Trie m_Suffixes;                                    // keys stored reversed
+        std::vector<GlobRule> m_Globs;
+        std::size_t m_RuleCount = 0;
+        bool m_HasPathRules = false;
+    };
+}
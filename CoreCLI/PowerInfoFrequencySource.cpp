@@ -0,0 +1,54 @@
+#ifdef _WIN32
+
+#include "FrequencySource.h"
+
+#include "HybridDetect.h"
+
+namespace Core
+{
+	// Per-processor power information from CallNtPowerInformation, read into a buffer
+	// allocated once for the processors active when the source was created.
+	class PowerInfoFrequencySource : public FrequencySource
+	{
+	public:
+		PowerInfoFrequencySource();
+
+		unsigned CoreCount() const override;
+		bool Read(unsigned* currentMhz, unsigned* mhzLimit, unsigned* idleState) override;
+
+	private:
+		std::vector<LOGICAL_PROCESSOR_POWER_INFORMATION> m_PowerInfo;
+	};
+
+	PowerInfoFrequencySource::PowerInfoFrequencySource()
+		: m_PowerInfo(GetActiveProcessorCount(ALL_PROCESSOR_GROUPS))
+	{
+	}
+
+	unsigned PowerInfoFrequencySource::CoreCount() const
+	{
+		return static_cast<unsigned>(m_PowerInfo.size());
+	}
+
+	bool PowerInfoFrequencySource::Read(unsigned* currentMhz, unsigned* mhzLimit, unsigned* idleState)
+	{
+		ULONG size = static_cast<ULONG>(sizeof(LOGICAL_PROCESSOR_POWER_INFORMATION) * m_PowerInfo.size());
+		if (m_PowerInfo.empty() || CallNtPowerInformation(ProcessorInformation, nullptr, 0, m_PowerInfo.data(), size) != 0) {
+			return false;
+		}
+
+		for (size_t i = 0; i < m_PowerInfo.size(); i++) {
+			currentMhz[i] = m_PowerInfo[i].currentMhz;
+			mhzLimit[i] = m_PowerInfo[i].mhzLimit;
+			idleState[i] = m_PowerInfo[i].currentIdleState;
+		}
+		return true;
+	}
+
+	std::unique_ptr<FrequencySource> CreateFrequencySource()
+	{
+		return std::unique_ptr<FrequencySource>(new PowerInfoFrequencySource());
+	}
+}
+
+#endif
@@ -0,0 +1,161 @@
+#ifdef __linux__
+
+#include "EnergyCounterSource.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace Core
+{
+	// Reads an unsigned decimal counter from the start of an open sysfs attribute.
+	bool ReadEnergyAttribute(int fd, unsigned long long& value)
+	{
+		char buffer[32];
+		ssize_t length = pread(fd, buffer, sizeof(buffer), 0);
+		if (length <= 0) {
+			return false;
+		}
+
+		value = 0;
+		for (ssize_t i = 0; i < length && buffer[i] >= '0' && buffer[i] <= '9'; i++) {
+			value = value * 10 + (buffer[i] - '0');
+		}
+		return true;
+	}
+
+	// Reads a short text attribute such as a zone name, without the trailing newline.
+	std::string ReadZoneText(const std::string& path)
+	{
+		char buffer[64] = {};
+		FILE* file = fopen(path.c_str(), "r");
+		if (file == nullptr) {
+			return std::string();
+		}
+		if (fgets(buffer, sizeof(buffer), file) == nullptr) {
+			buffer[0] = '\0';
+		}
+		fclose(file);
+		buffer[strcspn(buffer, "\n")] = '\0';
+		return buffer;
+	}
+
+	// The RAPL zones of the powercap framework, package zones and their subzones. The
+	// energy_uj attributes are kept open, so a read is one pread per domain.
+	class PowercapEnergySource : public EnergyCounterSource
+	{
+	public:
+		~PowercapEnergySource() override
+		{
+			for (int fd : m_Files) {
+				close(fd);
+			}
+		}
+
+		bool Open()
+		{
+			const char* root = "/sys/class/powercap";
+			DIR* dir = opendir(root);
+			if (dir == nullptr) {
+				return false;
+			}
+
+			std::vector<std::string> zones;
+			while (dirent* entry = readdir(dir)) {
+				// the MMIO interface reports the same package energy again
+				if (strncmp(entry->d_name, "intel-rapl:", 11) == 0) {
+					zones.push_back(entry->d_name);
+				}
+			}
+			closedir(dir);
+			std::sort(zones.begin(), zones.end());
+
+			for (const std::string& zone : zones) {
+				std::string path = std::string(root) + "/" + zone;
+				unsigned long long range = 0;
+				int rangeFile = open((path + "/max_energy_range_uj").c_str(), O_RDONLY | O_CLOEXEC);
+				bool hasRange = rangeFile >= 0 && ReadEnergyAttribute(rangeFile, range);
+				if (rangeFile >= 0) {
+					close(rangeFile);
+				}
+
+				// energy_uj is only readable by root on recent kernels
+				int fd = open((path + "/energy_uj").c_str(), O_RDONLY | O_CLOEXEC);
+				unsigned long long value = 0;
+				if (fd < 0 || !hasRange || !ReadEnergyAttribute(fd, value)) {
+					if (fd >= 0) {
+						close(fd);
+					}
+					continue;
+				}
+
+				// subzone names such as core repeat across packages, so qualify them with their package
+				std::string name = ReadZoneText(path + "/name");
+				std::size_t subzone = zone.find(':', 11);
+				if (subzone != std::string::npos) {
+					name = ReadZoneText(std::string(root) + "/" + zone.substr(0, subzone) + "/name") + "/" + name;
+				}
+
+				m_Names.push_back(name);
+				m_Ranges.push_back(range);
+				m_Files.push_back(fd);
+			}
+			return !m_Files.empty();
+		}
+
+		unsigned DomainCount() const override
+		{
+			return static_cast<unsigned>(m_Files.size());
+		}
+
+		const char* DomainName(unsigned domain) const override
+		{
+			return m_Names[domain].c_str();
+		}
+
+		unsigned long long Range(unsigned domain) const override
+		{
+			return m_Ranges[domain];
+		}
+
+		bool Read(unsigned long long& timestampUs, unsigned long long* microjoules) override
+		{
+			timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			for (std::size_t i = 0; i < m_Files.size(); i++) {
+				if (!ReadEnergyAttribute(m_Files[i], microjoules[i])) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+	private:
+		std::vector<std::string> m_Names;
+		std::vector<unsigned long long> m_Ranges;
+		std::vector<int> m_Files;
+	};
+
+	std::unique_ptr<EnergyCounterSource> CreatePowercapEnergySource()
+	{
+		std::unique_ptr<PowercapEnergySource> source(new PowercapEnergySource());
+		if (!source->Open()) {
+			return std::unique_ptr<EnergyCounterSource>();
+		}
+		return source;
+	}
+
+	std::unique_ptr<EnergyCounterSource> CreateEnergyCounterSource()
+	{
+		std::unique_ptr<EnergyCounterSource> source = CreatePowercapEnergySource();
+		if (!source) {
+			source = CreateMsrEnergySource();
+		}
+		return source;
+	}
+}
+
+#endif
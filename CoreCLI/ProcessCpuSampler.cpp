@@ -0,0 +1,123 @@
+#include "ProcessCpuSampler.h"
+
+#include <algorithm>
+
+namespace Core
+{
+	ProcessCpuSampler::ProcessCpuSampler(std::unique_ptr<ProcessTimeSource> source)
+		: m_Source(std::move(source))
+	{
+	}
+
+	std::size_t ProcessCpuSampler::Hash(unsigned long pid)
+	{
+		// Windows PIDs are multiples of 4, so mix the bits before masking
+		unsigned hash = static_cast<unsigned>(pid);
+		hash ^= hash >> 16;
+		hash *= 0x45d9f3bu;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	const ProcessCpuSampler::Slot* ProcessCpuSampler::Find(const std::vector<Slot>& table, unsigned long pid) const
+	{
+		if (table.empty()) {
+			return nullptr;
+		}
+
+		std::size_t mask = table.size() - 1;
+		for (std::size_t i = Hash(pid) & mask; ; i = (i + 1) & mask) {
+			if (table[i].pid == pid) {
+				return &table[i];
+			}
+			if (table[i].pid == 0) {
+				return nullptr;
+			}
+		}
+	}
+
+	ProcessCpuSampler::Slot& ProcessCpuSampler::Insert(std::vector<Slot>& table, unsigned long pid)
+	{
+		std::size_t mask = table.size() - 1;
+		std::size_t i = Hash(pid) & mask;
+		while (table[i].pid != 0 && table[i].pid != pid) {
+			i = (i + 1) & mask;
+		}
+		table[i].pid = pid;
+		return table[i];
+	}
+
+	bool ProcessCpuSampler::Sample()
+	{
+		unsigned long long now = m_Source->Now();
+		if (!m_Source->ReadAll(m_Times)) {
+			return false;
+		}
+
+		// keep the table at most half full, a power of two so probing can mask
+		std::size_t capacity = m_Current.empty() ? 256 : m_Current.size();
+		while (capacity < m_Times.size() * 2) {
+			capacity *= 2;
+		}
+		if (capacity != m_Current.size()) {
+			m_Current.resize(capacity);
+		}
+		std::fill(m_Current.begin(), m_Current.end(), Slot());
+
+		m_Pids.resize(m_Times.size());
+		m_Utilization.resize(m_Times.size());
+		m_TotalUtilization = 0;
+
+		double elapsed = m_Sampled && now > m_LastSample ? static_cast<double>(now - m_LastSample) : 0;
+		m_IntervalSeconds = elapsed / 10000000.0;
+		for (std::size_t i = 0; i < m_Times.size(); i++) {
+			const ProcessCpuTime& time = m_Times[i];
+
+			float utilization = 0;
+			const Slot* previous = Find(m_Previous, time.pid);
+			if (previous != nullptr && previous->startTime == time.startTime && time.cpuTime >= previous->cpuTime && elapsed > 0) {
+				utilization = static_cast<float>((time.cpuTime - previous->cpuTime) / elapsed);
+			}
+
+			Slot& slot = Insert(m_Current, time.pid);
+			slot.index = static_cast<unsigned>(i);
+			slot.startTime = time.startTime;
+			slot.cpuTime = time.cpuTime;
+
+			m_Pids[i] = time.pid;
+			m_Utilization[i] = utilization;
+			m_TotalUtilization += utilization;
+		}
+
+		m_Previous.swap(m_Current);
+		m_LastSample = now;
+		m_Sampled = true;
+		return true;
+	}
+
+	float ProcessCpuSampler::Utilization(unsigned long pid) const
+	{
+		// after Sample the latest table is m_Previous
+		const Slot* slot = Find(m_Previous, pid);
+		return slot != nullptr ? m_Utilization[slot->index] : -1.0f;
+	}
+
+	std::size_t ProcessCpuSampler::Top(std::size_t n, unsigned long* pids, float* utilization)
+	{
+		n = std::min(n, m_Pids.size());
+		m_Order.resize(m_Pids.size());
+		for (std::size_t i = 0; i < m_Order.size(); i++) {
+			m_Order[i] = static_cast<unsigned>(i);
+		}
+
+		std::partial_sort(m_Order.begin(), m_Order.begin() + n, m_Order.end(), [this](unsigned a, unsigned b) {
+			return m_Utilization[a] > m_Utilization[b];
+		});
+
+		for (std::size_t i = 0; i < n; i++) {
+			pids[i] = m_Pids[m_Order[i]];
+			utilization[i] = m_Utilization[m_Order[i]];
+		}
+		return n;
+	}
+}
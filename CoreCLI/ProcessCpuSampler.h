@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "ProcessTimeSource.h"
+
+namespace Core
+{
+    // Samples the CPU use of every process with one ProcessTimeSource::ReadAll per tick.
+    // The previous tick's times live in an open-addressing table keyed by PID, and the
+    // results are kept as parallel arrays, so after the first few ticks sampling does not
+    // allocate and callers can copy the arrays out in one go. Not thread-safe.
+    class ProcessCpuSampler
+    {
+    public:
+        explicit ProcessCpuSampler(std::unique_ptr<ProcessTimeSource> source);
+
+        ProcessCpuSampler(const ProcessCpuSampler&) = delete;
+        ProcessCpuSampler& operator=(const ProcessCpuSampler&) = delete;
+
+        // Reads every process and computes its use since the previous sample. Processes
+        // seen for the first time, or whose PID was reused, report 0 until the next sample.
+        bool Sample();
+
+        // Use is in cores, the share of one core the process kept busy over the interval.
+        std::size_t Count() const { return m_Pids.size(); }
+        const unsigned long* Pids() const { return m_Pids.data(); }
+        const float* Utilization() const { return m_Utilization.data(); }
+        // -1 when the process was not in the last sample.
+        float Utilization(unsigned long pid) const;
+        double TotalUtilization() const { return m_TotalUtilization; }
+        // Length of the interval the last sample measured, 0 after the first sample.
+        double IntervalSeconds() const { return m_IntervalSeconds; }
+
+        // The n busiest processes of the last sample, busiest first, into caller arrays of n
+        // entries. Returns the number written.
+        std::size_t Top(std::size_t n, unsigned long* pids, float* utilization);
+
+    private:
+        struct Slot
+        {
+            unsigned long pid = 0;      // 0 marks an empty slot
+            unsigned index = 0;         // into the result arrays
+            unsigned long long startTime = 0;
+            unsigned long long cpuTime = 0;
+        };
+
+        static std::size_t Hash(unsigned long pid);
+        const Slot* Find(const std::vector<Slot>& table, unsigned long pid) const;
+        Slot& Insert(std::vector<Slot>& table, unsigned long pid);
+
+        std::unique_ptr<ProcessTimeSource> m_Source;
+        std::vector<ProcessCpuTime> m_Times;
+        std::vector<Slot> m_Previous;
+        std::vector<Slot> m_Current;
+        unsigned long long m_LastSample = 0;
+        bool m_Sampled = false;
+
+        std::vector<unsigned long> m_Pids;
+        std::vector<float> m_Utilization;
+        std::vector<unsigned> m_Order;
+        double m_TotalUtilization = 0;
+        double m_IntervalSeconds = 0;
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+
+namespace Core
+{
+    enum class ProcessEventType : unsigned char
+    {
+        Started,
+        Exited
+    };
+
+    // A process start or exit reported by a ProcessEventSource. The executable name is
+    // stored inline so events can be passed through the queue without allocating.
+    struct ProcessEvent
+    {
+        enum : unsigned { MaxExeName = 64 };
+
+        ProcessEventType type = ProcessEventType::Started;
+        unsigned long pid = 0;
+        wchar_t exeName[MaxExeName] = {};
+
+        // Stores the file name part of path, truncated to fit.
+        template <typename Char>
+        void SetExeName(const Char* path, std::size_t length)
+        {
+            std::size_t start = length;
+            while (start > 0 && path[start - 1] != '\\' && path[start - 1] != '/') {
+                start--;
+            }
+
+            std::size_t count = 0;
+            for (std::size_t i = start; i < length && count + 1 < MaxExeName; i++) {
+                exeName[count++] = static_cast<wchar_t>(path[i]);
+            }
+            exeName[count] = L'\0';
+        }
+    };
+}
@@ -0,0 +1,82 @@
+#include "ProcessEventQueue.h"
+
+#include <chrono>
+
+namespace Core
+{
+	ProcessEventQueue::ProcessEventQueue(std::size_t capacity)
+		: m_Head(0), m_Tail(0), m_Dropped(0), m_Waiting(false)
+	{
+		std::size_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		m_Slots.resize(size);
+		m_Mask = size - 1;
+	}
+
+	bool ProcessEventQueue::Push(const ProcessEvent& event)
+	{
+		std::size_t tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_Head.load(std::memory_order_acquire) == m_Slots.size()) {
+			m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		m_Slots[tail & m_Mask] = event;
+		m_Tail.store(tail + 1);
+
+		// Both the tail store above and the flag read are sequentially consistent, so either
+		// the waiting consumer sees the new event or this sees the consumer waiting.
+		if (m_Waiting.load()) {
+			std::lock_guard<std::mutex> lock(m_WaitMutex);
+			m_WaitSignal.notify_one();
+		}
+		return true;
+	}
+
+	void ProcessEventQueue::AddDropped(unsigned long long count)
+	{
+		m_Dropped.fetch_add(count, std::memory_order_relaxed);
+	}
+
+	bool ProcessEventQueue::Pop(ProcessEvent& event)
+	{
+		std::size_t head = m_Head.load(std::memory_order_relaxed);
+		if (head == m_Tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		event = m_Slots[head & m_Mask];
+		m_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool ProcessEventQueue::Wait(unsigned timeoutMs)
+	{
+		if (!Empty()) {
+			return true;
+		}
+
+		std::unique_lock<std::mutex> lock(m_WaitMutex);
+		m_Waiting.store(true);
+		bool ready = m_WaitSignal.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return !Empty(); });
+		m_Waiting.store(false);
+		return ready;
+	}
+
+	unsigned long long ProcessEventQueue::TakeDropped()
+	{
+		return m_Dropped.exchange(0, std::memory_order_relaxed);
+	}
+
+	bool ProcessEventQueue::Empty() const
+	{
+		return m_Head.load(std::memory_order_relaxed) == m_Tail.load();
+	}
+
+	std::size_t ProcessEventQueue::Capacity() const
+	{
+		return m_Slots.size();
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "ProcessEvent.h"
+
+namespace Core
+{
+    // Bounded single-producer/single-consumer ring of process events. The event source
+    // thread pushes without taking a lock, and the consumer drains whenever it is ready.
+    // Events that arrive while the ring is full are counted so the consumer can rescan.
+    class ProcessEventQueue
+    {
+    public:
+        // capacity is rounded up to a power of two.
+        explicit ProcessEventQueue(std::size_t capacity = 1024);
+
+        ProcessEventQueue(const ProcessEventQueue&) = delete;
+        ProcessEventQueue& operator=(const ProcessEventQueue&) = delete;
+
+        // Producer side.
+        bool Push(const ProcessEvent& event);
+        void AddDropped(unsigned long long count);
+
+        // Consumer side.
+        bool Pop(ProcessEvent& event);
+        bool Wait(unsigned timeoutMs);
+        unsigned long long TakeDropped();
+
+        bool Empty() const;
+        std::size_t Capacity() const;
+
+    private:
+        std::vector<ProcessEvent> m_Slots;
+        std::size_t m_Mask;
+
+        // head and tail are written by different threads, keep them on separate cache lines
+        std::atomic<std::size_t> m_Head;
+        char m_HeadPadding[64];
+        std::atomic<std::size_t> m_Tail;
+        char m_TailPadding[64];
+
+        std::atomic<unsigned long long> m_Dropped;
+        std::atomic<bool> m_Waiting;
+        std::mutex m_WaitMutex;
+        std::condition_variable m_WaitSignal;
+    };
+}
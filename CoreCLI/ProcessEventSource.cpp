@@ -0,0 +1,33 @@
+#include "ProcessEventSource.h"
+#include "ProcessEventQueue.h"
+
+#include <cwchar>
+
+namespace Core
+{
+	bool MockProcessEventSource::Start(ProcessEventQueue& queue)
+	{
+		m_Queue = &queue;
+		return true;
+	}
+
+	void MockProcessEventSource::Stop()
+	{
+		m_Queue = nullptr;
+	}
+
+	bool MockProcessEventSource::Push(ProcessEventType type, unsigned long pid, const wchar_t* exeName)
+	{
+		if (m_Queue == nullptr) {
+			return false;
+		}
+
+		ProcessEvent event;
+		event.type = type;
+		event.pid = pid;
+		if (exeName != nullptr) {
+			event.SetExeName(exeName, wcslen(exeName));
+		}
+		return m_Queue->Push(event);
+	}
+}
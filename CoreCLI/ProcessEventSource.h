@@ -0,0 +1,37 @@
+#pragma once
+#include <memory>
+
+#include "ProcessEvent.h"
+
+namespace Core
+{
+    class ProcessEventQueue;
+
+    // Reports process starts and exits into a ProcessEventQueue from its own thread.
+    class ProcessEventSource
+    {
+    public:
+        virtual ~ProcessEventSource() {}
+
+        // Returns false if the facility is unavailable, usually for lack of privileges.
+        virtual bool Start(ProcessEventQueue& queue) = 0;
+        virtual void Stop() = 0;
+    };
+
+    // The native source of the platform: ETW on Windows and the proc connector on Linux.
+    std::unique_ptr<ProcessEventSource> CreateProcessEventSource();
+
+    // Source fed by hand, for tests and replaying recorded activity.
+    class MockProcessEventSource : public ProcessEventSource
+    {
+    public:
+        bool Start(ProcessEventQueue& queue) override;
+        void Stop() override;
+
+        // Must be called from one thread at a time, as the queue has a single producer.
+        bool Push(ProcessEventType type, unsigned long pid, const wchar_t* exeName);
+
+    private:
+        ProcessEventQueue* m_Queue = nullptr;
+    };
+}
@@ -0,0 +1,184 @@
+#include "ProcessHandleCache.h"
+
+#include <algorithm>
+
+namespace Core
+{
+	ProcessHandleCache::ProcessHandleCache(OsBackend& backend, std::size_t capacity)
+		: m_Backend(backend), m_Capacity(std::min(capacity, backend.MaxCachedHandles()))
+	{
+		m_Entries.reserve(m_Capacity);
+	}
+
+	ProcessHandleCache::~ProcessHandleCache()
+	{
+		Clear();
+	}
+
+	ProcessHandle ProcessHandleCache::Acquire(unsigned long pid)
+	{
+		ProcessHandle process;
+
+		if (Lookup(pid, process)) {
+			if (!HasExited(process.handle)) {
+				Touch(pid);
+				return process;
+			}
+
+			// the process has exited, the PID may now belong to a new process
+			Evict(pid);
+		}
+
+		process = ProcessHandle();
+		if (Open(pid, process) == OsStatus::Ok) {
+			Insert(pid, process);
+		}
+		return process;
+	}
+
+	bool ProcessHandleCache::Lookup(unsigned long pid, ProcessHandle& process) const
+	{
+		auto it = m_Entries.find(pid);
+		if (it == m_Entries.end()) {
+			return false;
+		}
+
+		process.handle = it->second.handle;
+		process.creationTime = it->second.creationTime;
+		process.cached = true;
+		return true;
+	}
+
+	bool ProcessHandleCache::Insert(unsigned long pid, ProcessHandle& process)
+	{
+		// a full cache is scanned for exited processes once until something leaves it,
+		// not again for every process that does not fit
+		if (m_Entries.size() >= m_Capacity && !m_FullScanned) {
+			EvictExited();
+			m_FullScanned = m_Entries.size() >= m_Capacity;
+		}
+
+		if (m_Entries.size() >= m_Capacity) {
+			return false;
+		}
+
+		Entry& entry = m_Entries[pid];
+		if (entry.handle != nullptr && entry.handle != process.handle) {
+			m_Backend.CloseProcess(entry.handle);
+		}
+		entry.handle = process.handle;
+		entry.creationTime = process.creationTime;
+		entry.sweep = m_Sweep;
+		process.cached = true;
+		return true;
+	}
+
+	void ProcessHandleCache::Touch(unsigned long pid)
+	{
+		auto it = m_Entries.find(pid);
+		if (it != m_Entries.end()) {
+			it->second.sweep = m_Sweep;
+		}
+	}
+
+	// Safe to call from several threads, it does not touch the cache.
+	OsStatus ProcessHandleCache::Open(unsigned long pid, ProcessHandle& process) const
+	{
+		unsigned long long start = m_Metrics != nullptr ? OperationMetrics::Now() : 0;
+		OsStatus status = m_Backend.OpenProcess(pid, process);
+		if (status != OsStatus::Ok) {
+			process.handle = nullptr;
+		}
+		if (m_Metrics != nullptr) {
+			m_Metrics->Record(MetricOperation::Open, OperationMetrics::Now() - start);
+		}
+		return status;
+	}
+
+	void ProcessHandleCache::SetMetrics(OperationMetrics* metrics)
+	{
+		m_Metrics = metrics;
+	}
+
+	bool ProcessHandleCache::HasExited(void* handle) const
+	{
+		return m_Backend.HasExited(handle);
+	}
+
+	void ProcessHandleCache::Release(const ProcessHandle& process)
+	{
+		if (process.handle != nullptr && !process.cached) {
+			m_Backend.CloseProcess(process.handle);
+		}
+	}
+
+	void ProcessHandleCache::Evict(unsigned long pid)
+	{
+		auto it = m_Entries.find(pid);
+		if (it != m_Entries.end()) {
+			m_Backend.CloseProcess(it->second.handle);
+			m_Entries.erase(it);
+			m_FullScanned = false;
+		}
+	}
+
+	void ProcessHandleCache::EvictExited()
+	{
+		for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+			if (HasExited(it->second.handle)) {
+				m_Backend.CloseProcess(it->second.handle);
+				it = m_Entries.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	void ProcessHandleCache::Clear()
+	{
+		for (auto& entry : m_Entries) {
+			m_Backend.CloseProcess(entry.second.handle);
+		}
+		m_Entries.clear();
+		m_FullScanned = false;
+	}
+
+	void ProcessHandleCache::EnsureCapacity(std::size_t count)
+	{
+		std::size_t maxCount = m_Backend.MaxCachedHandles();
+		if (count > maxCount) {
+			count = maxCount;
+		}
+		if (count > m_Capacity) {
+			m_Capacity = count;
+			m_Entries.reserve(count);
+			m_FullScanned = false;
+		}
+	}
+
+	void ProcessHandleCache::BeginSweep()
+	{
+		m_Sweep++;
+		m_FullScanned = false;
+	}
+
+	void ProcessHandleCache::EndSweep()
+	{
+		for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+			if (it->second.sweep != m_Sweep) {
+				m_Backend.CloseProcess(it->second.handle);
+				it = m_Entries.erase(it);
+				m_FullScanned = false;
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	std::size_t ProcessHandleCache::Size() const
+	{
+		return m_Entries.size();
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+
+#include "OsBackend.h"
+#include "OperationMetrics.h"
+
+namespace Core
+{
+    // Keeps process handles open across operations so repeated applies do not pay for
+    // opening, reading the creation time and closing every process each time. A held handle
+    // keeps its PID from being reused, and a handle is dropped as soon as its process
+    // has exited, so a cached entry always refers to the process currently using the PID.
+    // The capacity grows to the process count of each bulk apply, see EnsureCapacity, so a
+    // steady system keeps every handle. Processes beyond the backend's MaxCachedHandles are
+    // opened every time.
+    class ProcessHandleCache
+    {
+    public:
+        explicit ProcessHandleCache(OsBackend& backend, std::size_t capacity = 2048);
+        ~ProcessHandleCache();
+
+        ProcessHandleCache(const ProcessHandleCache&) = delete;
+        ProcessHandleCache& operator=(const ProcessHandleCache&) = delete;
+
+        // Returns a handle with set-information access, or a null handle if the process
+        // cannot be opened. Handles that did not fit in the cache must be released.
+        ProcessHandle Acquire(unsigned long pid);
+        void Release(const ProcessHandle& process);
+
+        // Lower-level steps of Acquire, so the system calls can run on several threads
+        // while every change to the cache itself stays on the calling thread.
+        bool Lookup(unsigned long pid, ProcessHandle& process) const;
+        bool Insert(unsigned long pid, ProcessHandle& process);
+        void Touch(unsigned long pid);
+        OsStatus Open(unsigned long pid, ProcessHandle& process) const;
+        // Opens are timed into metrics from then on.
+        void SetMetrics(OperationMetrics* metrics);
+        bool HasExited(void* handle) const;
+
+        void Evict(unsigned long pid);
+        void Clear();
+
+        // Raises the capacity to hold count handles, up to the backend's MaxCachedHandles.
+        // Never shrinks it.
+        void EnsureCapacity(std::size_t count);
+
+        // A sweep brackets one walk over the process list. Handles that were not
+        // acquired during the sweep belong to exited processes and are closed.
+        void BeginSweep();
+        void EndSweep();
+
+        std::size_t Size() const;
+
+    private:
+        struct Entry
+        {
+            void* handle = nullptr;
+            unsigned long long creationTime = 0;
+            unsigned sweep = 0;
+        };
+
+        void EvictExited();
+
+        OsBackend& m_Backend;
+        OperationMetrics* m_Metrics = nullptr;
+        std::unordered_map<unsigned long, Entry> m_Entries;
+        std::size_t m_Capacity;
+        unsigned m_Sweep = 0;
+        bool m_FullScanned = false;     // full, and no entry has exited since the last scan
+    };
+}
@@ -0,0 +1,50 @@
+#include "ProcessNameIndex.h"
+
+#include <cwctype>
+
+namespace Core
+{
+	wchar_t FoldExeName(wchar_t c)
+	{
+#ifdef _WIN32
+		return static_cast<wchar_t>(towlower(c));
+#else
+		return c;
+#endif
+	}
+
+	void FoldExeName(const wchar_t* exeName, std::wstring& key)
+	{
+		key.clear();
+		for (; *exeName != L'\0'; exeName++) {
+			key.push_back(FoldExeName(*exeName));
+		}
+	}
+
+	void ProcessNameIndex::Add(const wchar_t* exeName, unsigned long pid)
+	{
+		FoldExeName(exeName, m_Key);
+		m_Pids[m_Key].push_back(pid);
+	}
+
+	void ProcessNameIndex::Clear()
+	{
+		m_Pids.clear();
+	}
+
+	const std::vector<unsigned long>* ProcessNameIndex::Find(const std::wstring& exeName) const
+	{
+		std::wstring key;
+		FoldExeName(exeName.c_str(), key);
+		auto it = m_Pids.find(key);
+		if (it == m_Pids.end()) {
+			return nullptr;
+		}
+		return &it->second;
+	}
+
+	std::size_t ProcessNameIndex::Size() const
+	{
+		return m_Pids.size();
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Core
+{
+    // Folds a character of an executable name so that names which SameExeName treats
+    // as equal fold to the same key: to lower case on Windows, unchanged elsewhere.
+    wchar_t FoldExeName(wchar_t c);
+
+    // Maps executable names to the PIDs currently running them, built from a
+    // single walk over the process list so many targets can be resolved at once.
+    // Names are keyed by their folded form and match as SameExeName does.
+    class ProcessNameIndex
+    {
+    public:
+        void Add(const wchar_t* exeName, unsigned long pid);
+        void Clear();
+
+        // Returns the PIDs running the executable, or nullptr if none are running.
+        const std::vector<unsigned long>* Find(const std::wstring& exeName) const;
+
+        std::size_t Size() const;
+
+    private:
+        std::unordered_map<std::wstring, std::vector<unsigned long>> m_Pids;
+        // reused by Add so that building the index does not allocate a key per process
+        std::wstring m_Key;
+    };
+}
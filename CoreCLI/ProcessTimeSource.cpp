@@ -0,0 +1,268 @@
+#include "ProcessTimeSource.h"
+
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+namespace Core
+{
+#ifdef _WIN32
+	typedef LONG (WINAPI* NtQuerySystemInformationFn)(ULONG, PVOID, ULONG, PULONG);
+
+	const ULONG systemProcessInformation = 5;
+	const LONG statusInfoLengthMismatch = static_cast<LONG>(0xC0000004);
+
+	// The leading fields of SYSTEM_PROCESS_INFORMATION, which winternl.h declares as reserved.
+	struct SystemProcessEntry
+	{
+		ULONG NextEntryOffset;
+		ULONG NumberOfThreads;
+		LARGE_INTEGER WorkingSetPrivateSize;
+		ULONG HardFaultCount;
+		ULONG NumberOfThreadsHighWatermark;
+		ULONGLONG CycleTime;
+		LARGE_INTEGER CreateTime;
+		LARGE_INTEGER UserTime;
+		LARGE_INTEGER KernelTime;
+		USHORT ImageNameLength;
+		USHORT ImageNameMaximumLength;
+		PWSTR ImageNameBuffer;
+		LONG BasePriority;
+		HANDLE UniqueProcessId;
+	};
+
+	class ProcessTimesSource : public ProcessTimeSource
+	{
+	public:
+		// One NtQuerySystemInformation call returns the times of every process. The buffer is
+		// kept between calls and only grows when the process list outgrows it.
+		bool ReadAll(std::vector<ProcessCpuTime>& times) override
+		{
+			static NtQuerySystemInformationFn ntQuerySystemInformation = reinterpret_cast<NtQuerySystemInformationFn>(
+				GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQuerySystemInformation"));
+			times.clear();
+			if (ntQuerySystemInformation == nullptr) {
+				return false;
+			}
+
+			if (m_Buffer.empty()) {
+				m_Buffer.resize(64 * 1024);
+			}
+
+			LONG status;
+			for (;;) {
+				ULONG needed = 0;
+				ULONG size = static_cast<ULONG>(m_Buffer.size() * sizeof(m_Buffer[0]));
+				status = ntQuerySystemInformation(systemProcessInformation, m_Buffer.data(), size, &needed);
+				if (status != statusInfoLengthMismatch) {
+					break;
+				}
+				// leave room for processes started before the next call
+				m_Buffer.resize((needed + needed / 4) / sizeof(m_Buffer[0]) + 1);
+			}
+			if (status < 0) {
+				return false;
+			}
+
+			const unsigned char* entry = reinterpret_cast<const unsigned char*>(m_Buffer.data());
+			for (;;) {
+				const SystemProcessEntry* process = reinterpret_cast<const SystemProcessEntry*>(entry);
+				ProcessCpuTime time;
+				time.pid = static_cast<unsigned long>(reinterpret_cast<ULONG_PTR>(process->UniqueProcessId));
+				time.startTime = static_cast<unsigned long long>(process->CreateTime.QuadPart);
+				time.cpuTime = static_cast<unsigned long long>(process->UserTime.QuadPart + process->KernelTime.QuadPart);
+				// the idle process reports idle time, not use
+				if (time.pid != 0) {
+					times.push_back(time);
+				}
+
+				if (process->NextEntryOffset == 0) {
+					break;
+				}
+				entry += process->NextEntryOffset;
+			}
+			return true;
+		}
+
+		bool CpuTime(unsigned long pid, unsigned long long& cpuTime) override
+		{
+			HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+			if (process == NULL) {
+				return false;
+			}
+
+			FILETIME creationTime, exitTime, kernelTime, userTime;
+			BOOL success = GetProcessTimes(process, &creationTime, &exitTime, &kernelTime, &userTime);
+			DWORD exitCode = 0;
+			bool running = GetExitCodeProcess(process, &exitCode) && exitCode == STILL_ACTIVE;
+			CloseHandle(process);
+			if (!success || !running) {
+				return false;
+			}
+
+			cpuTime = ((static_cast<unsigned long long>(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime)
+				+ ((static_cast<unsigned long long>(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime);
+			return true;
+		}
+
+		unsigned long long Now() override
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() / 100;
+		}
+
+	private:
+		// ULONGLONG keeps the entries 8-byte aligned
+		std::vector<ULONGLONG> m_Buffer;
+	};
+#else
+	// Reads the CPU time and start time, both in clock ticks, of a live process from /proc/<pid>/stat.
+	bool ReadProcessStat(unsigned long pid, unsigned long long& cpuTicks, unsigned long long& startTicks)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/%lu/stat", pid);
+		int fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return false;
+		}
+
+		char buffer[1024];
+		ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+		close(fd);
+		if (length <= 0) {
+			return false;
+		}
+		buffer[length] = '\0';
+
+		// the command name can contain spaces, the remaining fields start after its closing parenthesis
+		const char* fields = strrchr(buffer, ')');
+		char state = 0;
+		unsigned long long utime = 0, stime = 0;
+		if (fields == nullptr
+			|| sscanf(fields + 2, "%c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu %*d %*d %*d %*d %*d %*d %llu",
+				&state, &utime, &stime, &startTicks) != 4
+			|| state == 'Z') {
+			return false;
+		}
+		cpuTicks = utime + stime;
+		return true;
+	}
+
+	class ProcStatTimeSource : public ProcessTimeSource
+	{
+	public:
+		bool CpuTime(unsigned long pid, unsigned long long& cpuTime) override
+		{
+			unsigned long long cpuTicks = 0, startTicks = 0;
+			if (!ReadProcessStat(pid, cpuTicks, startTicks)) {
+				return false;
+			}
+			cpuTime = cpuTicks * TickLength();
+			return true;
+		}
+
+		// One pass over /proc. Processes that exit during the pass are left out.
+		bool ReadAll(std::vector<ProcessCpuTime>& times) override
+		{
+			times.clear();
+			DIR* proc = opendir("/proc");
+			if (proc == nullptr) {
+				return false;
+			}
+
+			unsigned long long tickLength = TickLength();
+			while (dirent* entry = readdir(proc)) {
+				char* end = nullptr;
+				unsigned long pid = strtoul(entry->d_name, &end, 10);
+				if (*end != '\0' || pid == 0) {
+					continue;
+				}
+
+				ProcessCpuTime time;
+				if (ReadProcessStat(pid, time.cpuTime, time.startTime)) {
+					time.pid = pid;
+					time.cpuTime *= tickLength;
+					times.push_back(time);
+				}
+			}
+			closedir(proc);
+			return true;
+		}
+
+		unsigned long long Now() override
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() / 100;
+		}
+
+	private:
+		// 100ns units per clock tick
+		static unsigned long long TickLength()
+		{
+			static const unsigned long long tickLength = 10000000ULL / static_cast<unsigned long long>(sysconf(_SC_CLK_TCK));
+			return tickLength;
+		}
+	};
+#endif
+
+	std::unique_ptr<ProcessTimeSource> CreateProcessTimeSource()
+	{
+#ifdef _WIN32
+		return std::unique_ptr<ProcessTimeSource>(new ProcessTimesSource());
+#else
+		return std::unique_ptr<ProcessTimeSource>(new ProcStatTimeSource());
+#endif
+	}
+
+	void SyntheticProcessTimeSource::SetLoad(unsigned long pid, double cores)
+	{
+		m_Processes[pid].load = cores;
+	}
+
+	void SyntheticProcessTimeSource::Remove(unsigned long pid)
+	{
+		m_Processes.erase(pid);
+	}
+
+	void SyntheticProcessTimeSource::Advance(unsigned long long ticks)
+	{
+		m_Now += ticks;
+		for (auto& process : m_Processes) {
+			process.second.cpuTime += process.second.load * static_cast<double>(ticks);
+		}
+	}
+
+	bool SyntheticProcessTimeSource::CpuTime(unsigned long pid, unsigned long long& cpuTime)
+	{
+		auto it = m_Processes.find(pid);
+		if (it == m_Processes.end()) {
+			return false;
+		}
+		cpuTime = static_cast<unsigned long long>(it->second.cpuTime);
+		return true;
+	}
+
+	bool SyntheticProcessTimeSource::ReadAll(std::vector<ProcessCpuTime>& times)
+	{
+		times.clear();
+		for (const auto& process : m_Processes) {
+			ProcessCpuTime time;
+			time.pid = process.first;
+			time.cpuTime = static_cast<unsigned long long>(process.second.cpuTime);
+			times.push_back(time);
+		}
+		return true;
+	}
+
+	unsigned long long SyntheticProcessTimeSource::Now()
+	{
+		return m_Now;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Core
+{
+    // CPU time of one process from a sweep over every process. startTime tells a reused PID
+    // from the process that had it before, its unit depends on the source.
+    struct ProcessCpuTime
+    {
+        unsigned long pid = 0;
+        unsigned long long startTime = 0;
+        unsigned long long cpuTime = 0;
+    };
+
+    // Reads the CPU time of processes. Times are in 100ns units, like ThreadSample.
+    class ProcessTimeSource
+    {
+    public:
+        virtual ~ProcessTimeSource() {}
+
+        // User plus kernel time the process has used. Fails once the process has exited.
+        virtual bool CpuTime(unsigned long pid, unsigned long long& cpuTime) = 0;
+
+        // CPU times of every running process in one sweep, replacing the contents of times.
+        virtual bool ReadAll(std::vector<ProcessCpuTime>& times) = 0;
+
+        // Monotonic clock the CPU times are compared against.
+        virtual unsigned long long Now() = 0;
+    };
+
+    // GetProcessTimes on Windows, /proc/<pid>/stat on Linux.
+    std::unique_ptr<ProcessTimeSource> CreateProcessTimeSource();
+
+#ifndef _WIN32
+    // Reads the CPU time and start time, both in clock ticks, of a live process from /proc/<pid>/stat.
+    bool ReadProcessStat(unsigned long pid, unsigned long long& cpuTicks, unsigned long long& startTicks);
+#endif
+
+    // Processes with a scripted load on a clock that only moves when advanced, for tests.
+    class SyntheticProcessTimeSource : public ProcessTimeSource
+    {
+    public:
+        // cores is the share of one core the process keeps busy from now on.
+        void SetLoad(unsigned long pid, double cores);
+        void Remove(unsigned long pid);
+        void Advance(unsigned long long ticks);
+
+        bool CpuTime(unsigned long pid, unsigned long long& cpuTime) override;
+        bool ReadAll(std::vector<ProcessCpuTime>& times) override;
+        unsigned long long Now() override;
+
+    private:
+        struct Process
+        {
+            double load = 0;
+            double cpuTime = 0;
+        };
+
+        std::unordered_map<unsigned long, Process> m_Processes;
+        unsigned long long m_Now = 0;
+    };
+}
@@ -0,0 +1,230 @@
+#include "RequestQueue.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "NativeController.h"
+
+namespace Core
+{
+	bool IsSettingRequest(RequestType type)
+	{
+		return type == RequestType::WatchApp || type == RequestType::UnwatchApp || type == RequestType::LoadPlacementPolicy;
+	}
+
+	bool IsBulkRequest(RequestType type)
+	{
+		return type != RequestType::MoveAppToHybridCores && type != RequestType::ApplyPlacementPolicy && !IsSettingRequest(type);
+	}
+
+	bool Supersedes(const ControllerRequest& later, const ControllerRequest& earlier)
+	{
+		if (IsSettingRequest(later.type) || IsSettingRequest(earlier.type)) {
+			return false;
+		}
+		// a bulk apply does not run the policy rules, so it must not drop a pending policy apply
+		if (later.type == RequestType::ApplyPlacementPolicy || earlier.type == RequestType::ApplyPlacementPolicy) {
+			return later.type == earlier.type;
+		}
+		if (IsBulkRequest(later.type) || IsBulkRequest(earlier.type)) {
+			return IsBulkRequest(later.type) && IsBulkRequest(earlier.type);
+		}
+		return SameExeName(later.target.c_str(), earlier.target.c_str());
+	}
+
+	int ExecuteRequest(NativeController& controller, const ControllerRequest& request)
+	{
+		if (request.type == RequestType::MoveAppToHybridCores) {
+			return controller.MoveAppToHybridCores(request.target.c_str(), request.eCores, request.pCores, request.mode) ? 1 : 0;
+		}
+		if (request.type == RequestType::ApplyPlacementPolicy) {
+			return controller.ApplyPlacementPolicy();
+		}
+		if (request.type == RequestType::WatchApp) {
+			return controller.WatchApp(request.target.c_str(), request.eCores, request.pCores, request.mode) ? 1 : 0;
+		}
+		if (request.type == RequestType::UnwatchApp) {
+			controller.UnwatchApp(request.target.c_str());
+			return 1;
+		}
+		if (request.type == RequestType::LoadPlacementPolicy) {
+			return controller.LoadPlacementPolicy(request.target.c_str()) ? 1 : 0;
+		}
+
+		// some modes return without applying when the topology cannot serve them
+		unsigned long long applies = controller.Metrics().Counter(MetricCounter::Applies);
+		switch (request.type) {
+		case RequestType::MoveAllAppsToEfficiencyCores:
+			controller.MoveAllAppsToEfficiencyCores();
+			break;
+		case RequestType::MoveAllAppsToSomeEfficiencyCores:
+			controller.MoveAllAppsToSomeEfficiencyCores();
+			break;
+		case RequestType::ResetToDefaultCores:
+			controller.ResetToDefaultCores();
+			break;
+		default:
+			controller.MoveAllAppsToHybridCores(request.eCores, request.pCores, request.mode);
+			break;
+		}
+		return controller.Metrics().Counter(MetricCounter::Applies) != applies ? controller.LastApplyResult().bound : 0;
+	}
+
+	struct RequestQueue::State
+	{
+		struct Entry
+		{
+			unsigned long long token = 0;
+			ControllerRequest request;
+		};
+
+		mutable std::mutex mutex;
+		std::condition_variable submitted;
+		std::deque<Entry> pending;
+		unsigned long long nextToken = 1;
+		unsigned long long running = 0;     // token of the request between Take and Finish, 0 for none
+		bool runningCancelled = false;
+	};
+
+	RequestQueue::RequestQueue(NativeController& controller, RequestListener* listener)
+		: m_Controller(controller), m_Listener(listener), m_State(new State())
+	{
+	}
+
+	RequestQueue::~RequestQueue()
+	{
+	}
+
+	unsigned long long RequestQueue::Submit(const ControllerRequest& request, std::vector<unsigned long long>& superseded)
+	{
+		superseded.clear();
+		unsigned long long token;
+		{
+			std::lock_guard<std::mutex> lock(m_State->mutex);
+			std::deque<State::Entry>& pending = m_State->pending;
+			for (auto it = pending.begin(); it != pending.end();) {
+				if (Supersedes(request, it->request)) {
+					superseded.push_back(it->token);
+					it = pending.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+
+			token = m_State->nextToken++;
+			State::Entry entry;
+			entry.token = token;
+			entry.request = request;
+			pending.push_back(entry);
+		}
+		m_State->submitted.notify_one();
+		return token;
+	}
+
+	unsigned long long RequestQueue::Submit(const ControllerRequest& request)
+	{
+		std::vector<unsigned long long> superseded;
+		unsigned long long token = Submit(request, superseded);
+		if (m_Listener != nullptr) {
+			for (unsigned long long supersededToken : superseded) {
+				m_Listener->Superseded(supersededToken);
+			}
+		}
+		return token;
+	}
+
+	RequestStatus RequestQueue::Cancel(unsigned long long token)
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		std::deque<State::Entry>& pending = m_State->pending;
+		for (auto it = pending.begin(); it != pending.end(); ++it) {
+			if (it->token == token) {
+				pending.erase(it);
+				return RequestStatus::Cancelled;
+			}
+		}
+
+		if (token != 0 && m_State->running == token) {
+			m_State->runningCancelled = true;
+			m_Controller.CancelApplies();
+			return RequestStatus::Cancelled;
+		}
+		return RequestStatus::Unknown;
+	}
+
+	RequestStatus RequestQueue::CancelRunning()
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		if (m_State->running == 0) {
+			return RequestStatus::Unknown;
+		}
+		m_State->runningCancelled = true;
+		m_Controller.CancelApplies();
+		return RequestStatus::Cancelled;
+	}
+
+	bool RequestQueue::WaitForRequests(unsigned timeoutMs)
+	{
+		std::unique_lock<std::mutex> lock(m_State->mutex);
+		return m_State->submitted.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] {
+			return !m_State->pending.empty();
+		});
+	}
+
+	bool RequestQueue::Take(ControllerRequest& request, unsigned long long& token)
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		if (m_State->pending.empty()) {
+			return false;
+		}
+
+		State::Entry& entry = m_State->pending.front();
+		token = entry.token;
+		request = std::move(entry.request);
+		m_State->pending.pop_front();
+		m_State->running = token;
+		m_State->runningCancelled = false;
+		return true;
+	}
+
+	bool RequestQueue::Take(unsigned long long token, ControllerRequest& request)
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		std::deque<State::Entry>& pending = m_State->pending;
+		for (auto it = pending.begin(); it != pending.end(); ++it) {
+			if (it->token == token) {
+				request = std::move(it->request);
+				pending.erase(it);
+				m_State->running = token;
+				m_State->runningCancelled = false;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	RequestStatus RequestQueue::Finish(unsigned long long token)
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		if (token == 0 || m_State->running != token) {
+			return RequestStatus::Unknown;
+		}
+
+		m_State->running = 0;
+		if (!m_State->runningCancelled) {
+			return RequestStatus::Completed;
+		}
+		m_State->runningCancelled = false;
+		m_Controller.ResumeApplies();
+		return RequestStatus::Cancelled;
+	}
+
+	size_t RequestQueue::PendingCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		return m_State->pending.size();
+	}
+}
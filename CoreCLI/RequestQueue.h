@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PlacementPolicy.h"
+
+namespace Core
+{
+    class NativeController;
+
+    enum class RequestType : unsigned char
+    {
+        MoveAllAppsToEfficiencyCores,
+        MoveAllAppsToSomeEfficiencyCores,
+        MoveAllAppsToHybridCores,
+        ResetToDefaultCores,
+        ApplyPlacementPolicy,
+        MoveAppToHybridCores,
+        WatchApp,
+        UnwatchApp,
+        LoadPlacementPolicy
+    };
+
+    // One controller operation, queued instead of called.
+    struct ControllerRequest
+    {
+        RequestType type = RequestType::MoveAllAppsToHybridCores;
+        std::wstring target;            // the app of MoveAppToHybridCores and the watch requests, the path of LoadPlacementPolicy
+        int eCores = 0;
+        int pCores = 0;
+        PlacementMode mode = PlacementMode::Hard;
+    };
+
+    enum class RequestStatus : unsigned char
+    {
+        Completed,
+        Superseded,     // replaced by a later request before it started
+        Cancelled,      // removed before it started, or stopped while running
+        Unknown         // not queued, or already finished
+    };
+
+    // Every bulk apply replaces the placement of every process, so a later one makes a pending
+    // one pointless, as does a later bind of the same app. A policy apply only gives way to a
+    // later policy apply, since no bulk apply runs its rules. Watching an app, unwatching it and
+    // loading a policy change what later requests do, so they are never superseded and supersede nothing.
+    bool Supersedes(const ControllerRequest& later, const ControllerRequest& earlier);
+
+    // Runs request on controller. Returns the processes bound or matched, for
+    // MoveAppToHybridCores 1 when any instance was bound, and for the settings requests 1 when
+    // the setting was accepted.
+    int ExecuteRequest(NativeController& controller, const ControllerRequest& request);
+
+    // Told about pending requests that a submitter which does not track them superseded, so
+    // their owner can end them. Called without the queue's mutex held.
+    class RequestListener
+    {
+    public:
+        virtual ~RequestListener() {}
+
+        virtual void Superseded(unsigned long long token) = 0;
+    };
+
+    // Requests waiting for the controller, in submission order, with one consumer taking them
+    // one at a time. Submitters never wait for an apply. A request drops pending requests it
+    // supersedes, and the running one can be cancelled through the controller's CancelApplies.
+    // Tokens identify requests from submission to completion and are never reused.
+    class RequestQueue
+    {
+    public:
+        // listener may be null when every submitter handles the tokens Submit returns.
+        explicit RequestQueue(NativeController& controller, RequestListener* listener = nullptr);
+        ~RequestQueue();
+
+        RequestQueue(const RequestQueue&) = delete;
+        RequestQueue& operator=(const RequestQueue&) = delete;
+
+        // Returns the token of the request, and the tokens of the pending requests it superseded.
+        unsigned long long Submit(const ControllerRequest& request, std::vector<unsigned long long>& superseded);
+        // Reports the superseded requests to the listener instead.
+        unsigned long long Submit(const ControllerRequest& request);
+
+        // Cancelled when the request was pending, which then never runs, or running, which then
+        // stops at its next process and finishes as Cancelled. Unknown otherwise.
+        RequestStatus Cancel(unsigned long long token);
+        // Cancels the running request like Cancel, for callers that do not know its token.
+        RequestStatus CancelRunning();
+
+        // Consumer side. Take marks the oldest request running and returns false when none is
+        // pending, Finish reports how it ended. Consumers must hold whatever serializes calls
+        // into the controller from Take to Finish, so a cancel reaches only its request.
+        bool WaitForRequests(unsigned timeoutMs);
+        bool Take(ControllerRequest& request, unsigned long long& token);
+        // Takes the given request, for a submitter that runs its own requests. False when it
+        // is no longer pending, as when a later request superseded it.
+        bool Take(unsigned long long token, ControllerRequest& request);
+        RequestStatus Finish(unsigned long long token);
+
+        std::size_t PendingCount() const;
+
+    private:
+        struct State;
+
+        NativeController& m_Controller;
+        RequestListener* m_Listener;
+        std::unique_ptr<State> m_State;
+    };
+}
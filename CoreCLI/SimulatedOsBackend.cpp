@@ -0,0 +1,698 @@
+#include "SimulatedOsBackend.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+namespace Core
+{
+	// Splits a description line at whitespace. Double quotes group text with spaces and are dropped.
+	void SplitSimulatedLine(const std::string& line, std::vector<std::string>& fields)
+	{
+		fields.clear();
+		std::string field;
+		bool quoted = false;
+		bool inField = false;
+		for (char c : line) {
+			if (c == '"') {
+				quoted = !quoted;
+				inField = true;
+			}
+			else if (!quoted && (c == ' ' || c == '\t' || c == '\r')) {
+				if (inField) {
+					fields.push_back(field);
+					field.clear();
+					inField = false;
+				}
+			}
+			else {
+				field.push_back(c);
+				inField = true;
+			}
+		}
+		if (inField) {
+			fields.push_back(field);
+		}
+	}
+
+	// Decimal, or hexadecimal with 0x.
+	bool ParseSimulatedNumber(const std::string& text, unsigned long long& value)
+	{
+		if (text.empty() || text[0] == '-') {
+			return false;
+		}
+		char* end = nullptr;
+		value = strtoull(text.c_str(), &end, 0);
+		return *end == '\0';
+	}
+
+	std::wstring WidenSimulatedText(const std::string& text)
+	{
+		std::wstring wide(text.size(), L'\0');
+		for (size_t i = 0; i < text.size(); i++) {
+			wide[i] = static_cast<wchar_t>(static_cast<unsigned char>(text[i]));
+		}
+		return wide;
+	}
+
+	void SimulatedOsBackend::SetGroupSize(unsigned groupSize)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_GroupSize = std::max(1u, std::min(groupSize, static_cast<unsigned>(CpuMask::BitsPerGroup)));
+	}
+
+	void SimulatedOsBackend::AddCores(CoreClass coreClass, unsigned count, unsigned threadsPerCore, uint64_t features, unsigned maxMhz)
+	{
+		ProcessorDescription processor;
+		processor.core.coreClass = coreClass;
+		processor.core.efficiencyClass = coreClass == CoreClass::Performance ? 1 : 0;
+		processor.features = features;
+		processor.maxMhz = maxMhz;
+		AddCores(processor, count, threadsPerCore);
+	}
+
+	void SimulatedOsBackend::AddCores(const ProcessorDescription& processor, unsigned count, unsigned threadsPerCore)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		threadsPerCore = std::max(1u, std::min(threadsPerCore, m_GroupSize));
+		for (unsigned i = 0; i < count; i++) {
+			// Windows never splits a core across groups.
+			if (m_NextProcessor % m_GroupSize + threadsPerCore > m_GroupSize) {
+				m_NextProcessor += m_GroupSize - m_NextProcessor % m_GroupSize;
+			}
+			unsigned group = m_NextProcessor / m_GroupSize;
+			if (group >= CpuMask::MaxGroups) {
+				return;
+			}
+			if (m_GroupCores.size() <= group) {
+				m_GroupCores.resize(group + 1, 0);
+			}
+			unsigned coreIndex = m_GroupCores[group]++;
+
+			for (unsigned thread = 0; thread < threadsPerCore; thread++) {
+				ProcessorDescription logical = processor;
+				logical.core.group = static_cast<unsigned short>(group);
+				logical.core.index = static_cast<unsigned char>(m_NextProcessor % m_GroupSize);
+				logical.core.coreIndex = static_cast<unsigned char>(coreIndex);
+				logical.core.cpuSetId = static_cast<unsigned long>(m_Processors.size());
+				m_Processors.push_back(logical);
+				m_NextProcessor++;
+			}
+		}
+	}
+
+	void SimulatedOsBackend::AddProcessor(const ProcessorDescription& processor)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		ProcessorDescription logical = processor;
+		logical.core.cpuSetId = static_cast<unsigned long>(m_Processors.size());
+		m_Processors.push_back(logical);
+
+		// Cores generated later must not reuse its core index.
+		if (m_GroupCores.size() <= logical.core.group) {
+			m_GroupCores.resize(logical.core.group + 1, 0);
+		}
+		m_GroupCores[logical.core.group] = std::max(m_GroupCores[logical.core.group], logical.core.coreIndex + 1u);
+	}
+
+	void SimulatedOsBackend::ClearTopology()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Processors.clear();
+		m_GroupCores.clear();
+		m_NextProcessor = 0;
+	}
+
+	bool SimulatedOsBackend::LoadTopology(const char* path, std::string& error)
+	{
+		std::ifstream file(path);
+		if (!file) {
+			error = std::string("cannot open ") + path;
+			return false;
+		}
+
+		std::string line;
+		std::vector<std::string> fields;
+		for (unsigned lineNumber = 1; std::getline(file, line); lineNumber++) {
+			SplitSimulatedLine(line, fields);
+			if (fields.empty() || fields[0][0] == '#') {
+				continue;
+			}
+
+			const std::string& statement = fields[0];
+			std::string where = "line " + std::to_string(lineNumber) + ": ";
+			unsigned long long count = 0;
+			if (statement == "group-size") {
+				if (fields.size() != 2 || !ParseSimulatedNumber(fields[1], count) || count == 0 || count > CpuMask::BitsPerGroup) {
+					error = where + "group-size takes a number from 1 to 64";
+					return false;
+				}
+				SetGroupSize(static_cast<unsigned>(count));
+				continue;
+			}
+
+			bool coreLine = statement == "p-cores" || statement == "e-cores";
+			if (!coreLine && statement != "cpu") {
+				error = where + "unknown statement " + statement;
+				return false;
+			}
+			size_t first = 1;
+			if (coreLine) {
+				if (fields.size() < 2 || !ParseSimulatedNumber(fields[1], count)) {
+					error = where + statement + " takes a core count";
+					return false;
+				}
+				first = 2;
+			}
+
+			ProcessorDescription processor;
+			processor.core.coreClass = statement == "e-cores" ? CoreClass::Efficiency : CoreClass::Performance;
+			bool efficiencySet = false;
+			unsigned long long threads = 1;
+			for (size_t i = first; i < fields.size(); i++) {
+				size_t equals = fields[i].find('=');
+				std::string key = fields[i].substr(0, equals);
+				std::string text = equals == std::string::npos ? std::string() : fields[i].substr(equals + 1);
+				unsigned long long value = 0;
+				if (key == "class" && !coreLine && (text == "p" || text == "e")) {
+					processor.core.coreClass = text == "p" ? CoreClass::Performance : CoreClass::Efficiency;
+					continue;
+				}
+				if (!ParseSimulatedNumber(text, value)) {
+					error = where + "bad field " + fields[i];
+					return false;
+				}
+				if (key == "features") {
+					processor.features = value;
+				}
+				else if (key == "max") {
+					processor.maxMhz = static_cast<unsigned>(value);
+				}
+				else if (key == "base") {
+					processor.baseMhz = static_cast<unsigned>(value);
+				}
+				else if (key == "type") {
+					processor.coreType = static_cast<unsigned char>(value);
+				}
+				else if (key == "efficiency") {
+					processor.core.efficiencyClass = static_cast<unsigned char>(value);
+					efficiencySet = true;
+				}
+				else if (key == "threads" && coreLine) {
+					threads = value;
+				}
+				else if (key == "group" && !coreLine && value < CpuMask::MaxGroups) {
+					processor.core.group = static_cast<unsigned short>(value);
+				}
+				else if (key == "index" && !coreLine && value < CpuMask::BitsPerGroup) {
+					processor.core.index = static_cast<unsigned char>(value);
+				}
+				else if (key == "core" && !coreLine && value < 256) {
+					processor.core.coreIndex = static_cast<unsigned char>(value);
+				}
+				else {
+					error = where + "bad field " + fields[i];
+					return false;
+				}
+			}
+			if (!efficiencySet) {
+				processor.core.efficiencyClass = processor.core.coreClass == CoreClass::Performance ? 1 : 0;
+			}
+
+			if (coreLine) {
+				AddCores(processor, static_cast<unsigned>(count), static_cast<unsigned>(threads));
+			}
+			else {
+				AddProcessor(processor);
+			}
+		}
+		return true;
+	}
+
+	void SimulatedOsBackend::AddProcess(const SimulatedProcess& process)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		SimulatedProcess added = process;
+		if (added.creationTime == 0) {
+			added.creationTime = m_NextCreationTime;
+		}
+		m_NextCreationTime = std::max(m_NextCreationTime, added.creationTime) + 1;
+
+		auto found = m_ProcessIndex.find(added.pid);
+		if (found != m_ProcessIndex.end()) {
+			m_Processes[found->second] = added;
+			return;
+		}
+		m_ProcessIndex[added.pid] = m_Processes.size();
+		m_Processes.push_back(added);
+	}
+
+	void SimulatedOsBackend::RemoveProcess(unsigned long pid)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto found = m_ProcessIndex.find(pid);
+		if (found == m_ProcessIndex.end()) {
+			return;
+		}
+		size_t index = found->second;
+		m_Processes.erase(m_Processes.begin() + index);
+		m_ProcessIndex.erase(found);
+		for (auto& entry : m_ProcessIndex) {
+			if (entry.second > index) {
+				entry.second--;
+			}
+		}
+	}
+
+	void SimulatedOsBackend::ClearProcesses()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Processes.clear();
+		m_ProcessIndex.clear();
+	}
+
+	bool SimulatedOsBackend::SetCpuTime(unsigned long pid, unsigned long long cpuTime)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto found = m_ProcessIndex.find(pid);
+		if (found == m_ProcessIndex.end()) {
+			return false;
+		}
+		m_Processes[found->second].cpuTime = cpuTime;
+		return true;
+	}
+
+	bool SimulatedOsBackend::LoadProcesses(const char* path, std::string& error)
+	{
+		std::ifstream file(path);
+		if (!file) {
+			error = std::string("cannot open ") + path;
+			return false;
+		}
+
+		std::string line;
+		std::vector<std::string> fields;
+		for (unsigned lineNumber = 1; std::getline(file, line); lineNumber++) {
+			SplitSimulatedLine(line, fields);
+			if (fields.empty() || fields[0][0] == '#') {
+				continue;
+			}
+
+			std::string where = "line " + std::to_string(lineNumber) + ": ";
+			unsigned long long pid = 0;
+			if (fields.size() < 2 || !ParseSimulatedNumber(fields[0], pid)) {
+				error = where + "expected a PID and a name";
+				return false;
+			}
+
+			SimulatedProcess process;
+			process.pid = static_cast<unsigned long>(pid);
+			process.exeName = WidenSimulatedText(fields[1]);
+			for (size_t i = 2; i < fields.size(); i++) {
+				size_t equals = fields[i].find('=');
+				std::string key = fields[i].substr(0, equals);
+				std::string text = equals == std::string::npos ? std::string() : fields[i].substr(equals + 1);
+				unsigned long long value = 0;
+				if (key == "denied" && equals == std::string::npos) {
+					process.accessDenied = true;
+				}
+				else if (key == "path" && !text.empty()) {
+					process.imagePath = WidenSimulatedText(text);
+				}
+				else if (key == "cpu" && !text.empty()) {
+					char* end = nullptr;
+					double seconds = strtod(text.c_str(), &end);
+					if (*end != '\0' || seconds < 0) {
+						error = where + "bad field " + fields[i];
+						return false;
+					}
+					process.cpuTime = static_cast<unsigned long long>(seconds * 10000000.0);
+				}
+				else if (key == "threads" && ParseSimulatedNumber(text, value) && value > 0) {
+					process.threadCount = static_cast<unsigned>(value);
+				}
+				else if (key == "start" && ParseSimulatedNumber(text, value)) {
+					process.creationTime = value;
+				}
+				else {
+					error = where + "bad field " + fields[i];
+					return false;
+				}
+			}
+			AddProcess(process);
+		}
+		return true;
+	}
+
+	bool SimulatedOsBackend::FindProcess(unsigned long pid, SimulatedProcess& process) const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto found = m_ProcessIndex.find(pid);
+		if (found == m_ProcessIndex.end()) {
+			return false;
+		}
+		process = m_Processes[found->second];
+		return true;
+	}
+
+	size_t SimulatedOsBackend::ProcessCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Processes.size();
+	}
+
+	void SimulatedOsBackend::SetFile(const std::wstring& path, const std::wstring& text)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Files[path] = text;
+	}
+
+	bool SimulatedOsBackend::GetFile(const std::wstring& path, std::wstring& text) const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto found = m_Files.find(path);
+		if (found == m_Files.end()) {
+			return false;
+		}
+		text = found->second;
+		return true;
+	}
+
+	void SimulatedOsBackend::SetRecording(bool recording)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Recording = recording;
+	}
+
+	std::vector<SimulatedCall> SimulatedOsBackend::Calls() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Calls;
+	}
+
+	void SimulatedOsBackend::ClearCalls()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Calls.clear();
+		std::fill(std::begin(m_CallCounts), std::end(m_CallCounts), 0ULL);
+	}
+
+	unsigned long long SimulatedOsBackend::CallCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		unsigned long long total = 0;
+		for (unsigned long long count : m_CallCounts) {
+			total += count;
+		}
+		return total;
+	}
+
+	unsigned long long SimulatedOsBackend::CallCount(SimulatedCallType type) const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return type < SimulatedCallType::Count ? m_CallCounts[static_cast<size_t>(type)] : 0;
+	}
+
+	size_t SimulatedOsBackend::OpenHandles() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_OpenHandles;
+	}
+
+	void SimulatedOsBackend::SetMaxCachedHandles(size_t count)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_MaxCachedHandles = count;
+	}
+
+	bool SimulatedOsBackend::DetectTopology(bool allowCached, std::vector<ProcessorDescription>& processors)
+	{
+		(void)allowCached;
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::DetectTopology);
+		processors = m_Processors;
+		return !processors.empty();
+	}
+
+	bool SimulatedOsBackend::EnumerateProcesses(ProcessList& processes)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::EnumerateProcesses);
+		processes.Clear();
+		for (const SimulatedProcess& process : m_Processes) {
+			processes.Add(process.pid, process.exeName.c_str(), process.exeName.size());
+		}
+		return true;
+	}
+
+	OsStatus SimulatedOsBackend::OpenProcess(unsigned long pid, ProcessHandle& process)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::OpenProcess);
+		SimulatedCall call;
+		call.type = SimulatedCallType::OpenProcess;
+		call.id = pid;
+
+		auto found = m_ProcessIndex.find(pid);
+		if (found == m_ProcessIndex.end()) {
+			call.status = OsStatus::Failed;
+		}
+		else if (m_Processes[found->second].accessDenied) {
+			call.status = OsStatus::AccessDenied;
+		}
+		else {
+			Handle* handle = new Handle;
+			handle->pid = pid;
+			handle->creationTime = m_Processes[found->second].creationTime;
+			process.handle = handle;
+			process.creationTime = handle->creationTime;
+			m_OpenHandles++;
+		}
+		Record(call);
+		return call.status;
+	}
+
+	bool SimulatedOsBackend::HasExited(void* handle)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::HasExited);
+		return Live(handle) == nullptr;
+	}
+
+	void SimulatedOsBackend::CloseProcess(void* handle)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::CloseProcess);
+		if (handle != nullptr) {
+			delete static_cast<Handle*>(handle);
+			m_OpenHandles--;
+		}
+	}
+
+	bool SimulatedOsBackend::ProcessImagePath(void* handle, std::wstring& path)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::ProcessImagePath);
+		SimulatedProcess* process = Live(handle);
+		if (process == nullptr || process->imagePath.empty()) {
+			return false;
+		}
+		path = process->imagePath;
+		return true;
+	}
+
+	size_t SimulatedOsBackend::MaxCachedHandles()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_MaxCachedHandles;
+	}
+
+	OsStatus SimulatedOsBackend::ApplyPlacement(void* handle, const Placement& placement, bool clearCpuSets, const CpuMask& allMask, unsigned groupCount)
+	{
+		(void)allMask;
+		(void)groupCount;
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::ApplyPlacement);
+		SimulatedCall call;
+		call.type = SimulatedCallType::ApplyPlacement;
+		call.mask = placement.mask;
+		call.mode = placement.mode;
+		call.value = static_cast<unsigned>(placement.cpuSets.size());
+
+		SimulatedProcess* process = Live(handle);
+		if (process == nullptr) {
+			call.status = OsStatus::Failed;
+		}
+		else {
+			call.id = process->pid;
+			process->mask = placement.mask;
+			process->mode = placement.mode;
+			// like Windows, a hard mask leaves the CPU sets alone unless asked to clear them
+			if (placement.mode == PlacementMode::Soft || clearCpuSets) {
+				process->cpuSets = placement.cpuSets;
+			}
+		}
+		Record(call);
+		return call.status;
+	}
+
+	void SimulatedOsBackend::EndBackgroundMode(void* handle)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::EndBackgroundMode);
+		SimulatedProcess* process = Live(handle);
+		SimulatedCall call;
+		call.type = SimulatedCallType::EndBackgroundMode;
+		call.id = process != nullptr ? process->pid : 0;
+		call.status = process != nullptr ? OsStatus::Ok : OsStatus::Failed;
+		Record(call);
+	}
+
+	bool SimulatedOsBackend::SetPriority(void* handle, PriorityClass priority)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::SetPriority);
+		SimulatedProcess* process = Live(handle);
+		SimulatedCall call;
+		call.type = SimulatedCallType::SetPriority;
+		call.value = static_cast<unsigned>(priority);
+		call.status = process != nullptr ? OsStatus::Ok : OsStatus::Failed;
+		if (process != nullptr) {
+			call.id = process->pid;
+			if (priority != PriorityClass::Unchanged) {
+				process->priority = priority;
+			}
+		}
+		Record(call);
+		return process != nullptr;
+	}
+
+	bool SimulatedOsBackend::SetPowerThrottling(void* handle, PowerThrottling throttling)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::SetPowerThrottling);
+		SimulatedProcess* process = Live(handle);
+		SimulatedCall call;
+		call.type = SimulatedCallType::SetPowerThrottling;
+		call.value = static_cast<unsigned>(throttling);
+		call.status = process != nullptr ? OsStatus::Ok : OsStatus::Failed;
+		if (process != nullptr) {
+			call.id = process->pid;
+			if (throttling != PowerThrottling::Unchanged) {
+				process->throttling = throttling;
+			}
+		}
+		Record(call);
+		return process != nullptr;
+	}
+
+	bool SimulatedOsBackend::SetMemoryPriority(void* handle, MemoryPriority priority)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::SetMemoryPriority);
+		SimulatedProcess* process = Live(handle);
+		SimulatedCall call;
+		call.type = SimulatedCallType::SetMemoryPriority;
+		call.value = static_cast<unsigned>(priority);
+		call.status = process != nullptr ? OsStatus::Ok : OsStatus::Failed;
+		if (process != nullptr) {
+			call.id = process->pid;
+			if (priority != MemoryPriority::Unchanged) {
+				process->memoryPriority = priority;
+			}
+		}
+		Record(call);
+		return process != nullptr;
+	}
+
+	bool SimulatedOsBackend::EnumerateThreads(unsigned long pid, std::vector<ThreadSample>& threads)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::EnumerateThreads);
+		threads.clear();
+		auto found = m_ProcessIndex.find(pid);
+		if (found == m_ProcessIndex.end()) {
+			return false;
+		}
+
+		const SimulatedProcess& process = m_Processes[found->second];
+		unsigned long long remaining = process.cpuTime;
+		for (unsigned i = 0; i < process.threadCount; i++) {
+			ThreadSample thread;
+			thread.tid = pid * 1024 + i + 1;
+			thread.cpuTime = i + 1 == process.threadCount ? remaining : remaining / 2;
+			remaining -= thread.cpuTime;
+			threads.push_back(thread);
+		}
+		return true;
+	}
+
+	bool SimulatedOsBackend::SetThreadCpus(unsigned long tid, const std::vector<unsigned long>& cpuSets)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::SetThreadCpus);
+		SimulatedCall call;
+		call.type = SimulatedCallType::SetThreadCpus;
+		call.id = tid;
+		call.value = static_cast<unsigned>(cpuSets.size());
+		call.status = m_ProcessIndex.count(tid / 1024) != 0 ? OsStatus::Ok : OsStatus::Failed;
+		Record(call);
+		return call.status == OsStatus::Ok;
+	}
+
+	bool SimulatedOsBackend::SetCurrentThreadCpus(const std::vector<unsigned long>& cpuSets)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::SetCurrentThreadCpus);
+		SimulatedCall call;
+		call.type = SimulatedCallType::SetCurrentThreadCpus;
+		call.value = static_cast<unsigned>(cpuSets.size());
+		Record(call);
+		return true;
+	}
+
+	bool SimulatedOsBackend::ReadTextFile(const wchar_t* path, std::wstring& text)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::ReadTextFile);
+		auto found = m_Files.find(path);
+		if (found == m_Files.end()) {
+			return false;
+		}
+		text = found->second;
+		return true;
+	}
+
+	bool SimulatedOsBackend::WriteTextFile(const wchar_t* path, const std::string& text)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Count(SimulatedCallType::WriteTextFile);
+		m_Files[path] = WidenSimulatedText(text);
+		return true;
+	}
+
+	SimulatedProcess* SimulatedOsBackend::Live(void* handle)
+	{
+		if (handle == nullptr) {
+			return nullptr;
+		}
+		const Handle* open = static_cast<const Handle*>(handle);
+		auto found = m_ProcessIndex.find(open->pid);
+		if (found == m_ProcessIndex.end() || m_Processes[found->second].creationTime != open->creationTime) {
+			return nullptr;
+		}
+		return &m_Processes[found->second];
+	}
+
+	void SimulatedOsBackend::Count(SimulatedCallType type)
+	{
+		m_CallCounts[static_cast<size_t>(type)]++;
+	}
+
+	void SimulatedOsBackend::Record(const SimulatedCall& call)
+	{
+		if (m_Recording) {
+			m_Calls.push_back(call);
+		}
+	}
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "OsBackend.h"
+
+namespace Core
+{
+    // A process of the simulated system together with the state the controller set on it.
+    struct SimulatedProcess
+    {
+        unsigned long pid = 0;
+        std::wstring exeName;
+        std::wstring imagePath;             // reported by ProcessImagePath, empty to fail the query
+        unsigned long long creationTime = 0;
+        unsigned long long cpuTime = 0;     // 100ns units over all threads
+        unsigned threadCount = 1;
+        bool accessDenied = false;          // opening fails as it does for protected processes
+
+        CpuMask mask;                       // empty until a placement has been applied
+        PlacementMode mode = PlacementMode::Hard;
+        std::vector<unsigned long> cpuSets;
+        PriorityClass priority = PriorityClass::Normal;
+        PowerThrottling throttling = PowerThrottling::Auto;
+        MemoryPriority memoryPriority = MemoryPriority::Normal;
+    };
+
+    enum class SimulatedCallType : unsigned char
+    {
+        DetectTopology,
+        EnumerateProcesses,
+        OpenProcess,
+        HasExited,
+        CloseProcess,
+        ProcessImagePath,
+        ApplyPlacement,
+        EndBackgroundMode,
+        SetPriority,
+        SetPowerThrottling,
+        SetMemoryPriority,
+        EnumerateThreads,
+        SetThreadCpus,
+        SetCurrentThreadCpus,
+        ReadTextFile,
+        WriteTextFile,
+        Count
+    };
+
+    // One call that changed the state of a process or thread, in the order it was made.
+    struct SimulatedCall
+    {
+        SimulatedCallType type = SimulatedCallType::ApplyPlacement;
+        unsigned long id = 0;           // PID, or the thread ID of thread calls, 0 for the calling thread
+        OsStatus status = OsStatus::Ok;
+        CpuMask mask;                   // of ApplyPlacement
+        PlacementMode mode = PlacementMode::Hard;
+        unsigned value = 0;             // the PriorityClass, PowerThrottling or MemoryPriority set, or the CPU set count
+    };
+
+    // A system that only exists in memory: a topology of any shape and a process table of any
+    // size, loaded from description files or built in code. The controller runs on it unchanged,
+    // every call is counted, and every open and every call that changes a process or thread is
+    // recorded, so placement can be checked and measured in milliseconds on any machine.
+    //
+    // Topology files hold one statement per line, lines starting with # are comments:
+    //   group-size 64                       logical processors per group for the lines below
+    //   p-cores 6 threads=2 max=5000        physical cores of a class, numbered after the
+    //   e-cores 8 max=3800 features=0x7     previous ones and kept within one group
+    //   cpu group=1 index=3 core=7 class=e  one logical processor, for layouts the above cannot express
+    // Core lines also take base=<MHz>, type=<CPUID core type> and features=<CoreFeature bits>,
+    // cpu lines additionally efficiency=<class>.
+    //
+    // Process files hold one process per line: the PID, the executable name, then optional cpu=<seconds> threads=<count> start=<creation time>
+    // path=<image path> and denied. Values with spaces are quoted, text is read as ASCII.
+    // Logical processors get their cpuSetId from the order they were added in.
+    class SimulatedOsBackend : public OsBackend
+    {
+    public:
+        void SetGroupSize(unsigned groupSize);
+        void AddCores(CoreClass coreClass, unsigned count, unsigned threadsPerCore = 1, uint64_t features = 0, unsigned maxMhz = 0);
+        // Cores shaped like processor, only its position is assigned.
+        void AddCores(const ProcessorDescription& processor, unsigned count, unsigned threadsPerCore);
+        void AddProcessor(const ProcessorDescription& processor);
+        void ClearTopology();
+        // Fails on unreadable files and unknown statements, leaving the topology partly loaded.
+        bool LoadTopology(const char* path, std::string& error);
+
+        // Processes are enumerated in the order they were added. A process without a creation
+        // time gets a unique one. Adding a PID that exists replaces the process, as a PID reuse would.
+        void AddProcess(const SimulatedProcess& process);
+        void RemoveProcess(unsigned long pid);
+        void ClearProcesses();
+        bool SetCpuTime(unsigned long pid, unsigned long long cpuTime);
+        bool LoadProcesses(const char* path, std::string& error);
+
+        // Copies the current state of a process, false when no process has the PID.
+        bool FindProcess(unsigned long pid, SimulatedProcess& process) const;
+        std::size_t ProcessCount() const;
+
+        // Files served to ReadTextFile and written by WriteTextFile, which stores text as ASCII.
+        void SetFile(const std::wstring& path, const std::wstring& text);
+        bool GetFile(const std::wstring& path, std::wstring& text) const;
+
+        // Recording can be turned off for benchmarks, calls are counted either way.
+        void SetRecording(bool recording);
+        std::vector<SimulatedCall> Calls() const;
+        void ClearCalls();
+        unsigned long long CallCount() const;
+        unsigned long long CallCount(SimulatedCallType type) const;
+        // Handles opened and not yet closed.
+        std::size_t OpenHandles() const;
+        // Returned by MaxCachedHandles, 65536 unless set.
+        void SetMaxCachedHandles(std::size_t count);
+
+        bool DetectTopology(bool allowCached, std::vector<ProcessorDescription>& processors) override;
+        bool EnumerateProcesses(ProcessList& processes) override;
+        OsStatus OpenProcess(unsigned long pid, ProcessHandle& process) override;
+        bool HasExited(void* handle) override;
+        void CloseProcess(void* handle) override;
+        bool ProcessImagePath(void* handle, std::wstring& path) override;
+        std::size_t MaxCachedHandles() override;
+        OsStatus ApplyPlacement(void* handle, const Placement& placement, bool clearCpuSets, const CpuMask& allMask, unsigned groupCount) override;
+        void EndBackgroundMode(void* handle) override;
+        bool SetPriority(void* handle, PriorityClass priority) override;
+        bool SetPowerThrottling(void* handle, PowerThrottling throttling) override;
+        bool SetMemoryPriority(void* handle, MemoryPriority priority) override;
+        // Thread IDs are pid * 1024 + 1 and up. The first thread is the busiest, each thread
+        // used half the CPU time left by the threads before it and the last one the rest.
+        bool EnumerateThreads(unsigned long pid, std::vector<ThreadSample>& threads) override;
+        bool SetThreadCpus(unsigned long tid, const std::vector<unsigned long>& cpuSets) override;
+        bool SetCurrentThreadCpus(const std::vector<unsigned long>& cpuSets) override;
+        bool ReadTextFile(const wchar_t* path, std::wstring& text) override;
+        bool WriteTextFile(const wchar_t* path, const std::string& text) override;
+
+    private:
+        struct Handle
+        {
+            unsigned long pid = 0;
+            unsigned long long creationTime = 0;
+        };
+
+        // Callers hold m_Mutex.
+        SimulatedProcess* Live(void* handle);
+        void Count(SimulatedCallType type);
+        void Record(const SimulatedCall& call);
+
+        mutable std::mutex m_Mutex;
+        std::vector<ProcessorDescription> m_Processors;
+        std::vector<unsigned> m_GroupCores;         // physical cores numbered so far in each group
+        unsigned m_GroupSize = 64;
+        unsigned m_NextProcessor = 0;               // position of the next generated logical processor
+        std::vector<SimulatedProcess> m_Processes;
+        std::unordered_map<unsigned long, std::size_t> m_ProcessIndex;
+        unsigned long long m_NextCreationTime = 132000000000000000ULL;
+        std::unordered_map<std::wstring, std::wstring> m_Files;
+        bool m_Recording = true;
+        std::vector<SimulatedCall> m_Calls;
+        unsigned long long m_CallCounts[static_cast<std::size_t>(SimulatedCallType::Count)] = {};
+        std::size_t m_OpenHandles = 0;
+        std::size_t m_MaxCachedHandles = 65536;
+    };
+}
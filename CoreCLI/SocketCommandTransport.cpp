@@ -0,0 +1,179 @@
+#ifdef __linux__
+
+#include "CommandTransport.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace Core
+{
+	// in LinuxOsBackend.cpp
+	std::string EncodeUtf8(const wchar_t* text);
+
+	// Fills address with path, false when the path does not fit.
+	bool SocketAddress(const std::string& path, sockaddr_un& address)
+	{
+		address = {};
+		address.sun_family = AF_UNIX;
+		if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+			return false;
+		}
+		memcpy(address.sun_path, path.c_str(), path.size() + 1);
+		return true;
+	}
+
+	// Stream socket of one client.
+	class SocketCommandChannel : public CommandChannel
+	{
+	public:
+		explicit SocketCommandChannel(int fd) : m_Socket(fd) {}
+
+		~SocketCommandChannel() override
+		{
+			close(m_Socket);
+		}
+
+		bool Read(void* buffer, std::size_t length) override
+		{
+			char* bytes = static_cast<char*>(buffer);
+			while (length > 0) {
+				ssize_t read = recv(m_Socket, bytes, length, 0);
+				if (read < 0 && errno == EINTR) {
+					continue;
+				}
+				if (read <= 0) {
+					return false;
+				}
+				bytes += read;
+				length -= static_cast<std::size_t>(read);
+			}
+			return true;
+		}
+
+		bool Write(const void* data, std::size_t length) override
+		{
+			const char* bytes = static_cast<const char*>(data);
+			while (length > 0) {
+				// a client that went away must not raise SIGPIPE in the controller
+				ssize_t written = send(m_Socket, bytes, length, MSG_NOSIGNAL);
+				if (written < 0 && errno == EINTR) {
+					continue;
+				}
+				if (written <= 0) {
+					return false;
+				}
+				bytes += written;
+				length -= static_cast<std::size_t>(written);
+			}
+			return true;
+		}
+
+		// shutdown rather than close, so a thread blocked in recv returns and the descriptor
+		// cannot be reused under it
+		void Close() override
+		{
+			shutdown(m_Socket, SHUT_RDWR);
+		}
+
+	private:
+		int m_Socket;
+	};
+
+	class SocketCommandListener : public CommandListener
+	{
+	public:
+		~SocketCommandListener() override
+		{
+			Close();
+		}
+
+		bool Listen(const wchar_t* name) override
+		{
+			Close();
+
+			std::string path = EncodeUtf8(name);
+			sockaddr_un address;
+			if (!SocketAddress(path, address)) {
+				return false;
+			}
+
+			// a socket left behind by a previous run refuses the bind, anything else is kept
+			struct stat status;
+			if (stat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+				unlink(path.c_str());
+			}
+
+			m_Socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			if (m_Socket < 0) {
+				return false;
+			}
+			if (bind(m_Socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(m_Socket, SOMAXCONN) < 0) {
+				std::cout << "Could not listen on " << path << ": " << errno << std::endl;
+				close(m_Socket);
+				m_Socket = -1;
+				return false;
+			}
+			m_Path = path;
+			return true;
+		}
+
+		std::unique_ptr<CommandChannel> Accept(unsigned timeoutMs) override
+		{
+			pollfd descriptor = { m_Socket, POLLIN, 0 };
+			if (m_Socket < 0 || poll(&descriptor, 1, static_cast<int>(timeoutMs)) <= 0) {
+				return nullptr;
+			}
+
+			int client = accept4(m_Socket, nullptr, nullptr, SOCK_CLOEXEC);
+			if (client < 0) {
+				return nullptr;
+			}
+			return std::unique_ptr<CommandChannel>(new SocketCommandChannel(client));
+		}
+
+		void Close() override
+		{
+			if (m_Socket >= 0) {
+				close(m_Socket);
+				m_Socket = -1;
+				unlink(m_Path.c_str());
+			}
+		}
+
+	private:
+		int m_Socket = -1;
+		std::string m_Path;
+	};
+
+	std::unique_ptr<CommandListener> CreateCommandListener()
+	{
+		return std::unique_ptr<CommandListener>(new SocketCommandListener());
+	}
+
+	std::unique_ptr<CommandChannel> ConnectCommandChannel(const wchar_t* name)
+	{
+		sockaddr_un address;
+		if (!SocketAddress(EncodeUtf8(name), address)) {
+			return nullptr;
+		}
+
+		int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd < 0) {
+			return nullptr;
+		}
+		if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+			close(fd);
+			return nullptr;
+		}
+		return std::unique_ptr<CommandChannel>(new SocketCommandChannel(fd));
+	}
+}
+
+#endif
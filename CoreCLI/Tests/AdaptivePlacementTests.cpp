@@ -0,0 +1,195 @@
+// Promote and demote decisions of AdaptivePlacer on a scripted load, where one step is one
+// second of the synthetic clock.
+
+#include "AdaptivePlacement.h"
+#include "Check.h"
+#include "NativeController.h"
+#include "SimulatedOsBackend.h"
+
+#include <memory>
+#include <vector>
+
+using Core::AdaptiveDecision;
+using Core::AdaptivePlacer;
+using Core::AdaptivePolicy;
+using Core::CoreClass;
+using Core::CpuMask;
+using Core::SyntheticProcessTimeSource;
+
+static const unsigned long long ticksPerSecond = 10000000;
+
+struct Placer
+{
+	SyntheticProcessTimeSource* time;
+	AdaptivePlacer placer;
+	std::vector<AdaptiveDecision> decisions;
+
+	explicit Placer(const AdaptivePolicy& policy)
+		: time(new SyntheticProcessTimeSource()), placer(std::unique_ptr<Core::ProcessTimeSource>(time))
+	{
+		placer.SetPolicy(policy);
+	}
+
+	// Advances the clock by a second, then steps. Returns the number of decisions.
+	std::size_t Step()
+	{
+		time->Advance(ticksPerSecond);
+		placer.Step(decisions);
+		return decisions.size();
+	}
+};
+
+// Unsmoothed load, so each sample counts on its own.
+static AdaptivePolicy Policy(unsigned promoteSamples, unsigned demoteSamples, unsigned minDwellMs)
+{
+	AdaptivePolicy policy;
+	policy.promoteSamples = promoteSamples;
+	policy.demoteSamples = demoteSamples;
+	policy.minDwellMs = minDwellMs;
+	policy.smoothing = 1;
+	return policy;
+}
+
+TEST_CASE(AdaptivePlacement, PromotesAfterConsecutiveBusySamples)
+{
+	Placer placer(Policy(3, 5, 0));
+	placer.time->SetLoad(1, 1.0);
+	placer.placer.Track(1, CoreClass::Efficiency);
+
+	// the first step only sets the baseline
+	placer.placer.Step(placer.decisions);
+	CHECK(placer.decisions.empty());
+	CHECK(placer.Step() == 0);
+	CHECK(placer.Step() == 0);
+	CHECK(placer.Step() == 1);
+	CHECK(placer.decisions[0].pid == 1 && placer.decisions[0].coreClass == CoreClass::Performance);
+	CHECK(placer.Step() == 0);
+}
+
+TEST_CASE(AdaptivePlacement, DemotesAfterConsecutiveIdleSamples)
+{
+	Placer placer(Policy(1, 5, 0));
+	placer.time->SetLoad(1, 0.0);
+	placer.placer.Track(1, CoreClass::Performance);
+	placer.placer.Step(placer.decisions);
+	for (int i = 0; i < 4; i++) {
+		CHECK(placer.Step() == 0);
+	}
+	CHECK(placer.Step() == 1);
+	CHECK(placer.decisions[0].coreClass == CoreClass::Efficiency);
+}
+
+// A move is held back until the process has spent minDwellMs in its class, in both directions.
+TEST_CASE(AdaptivePlacement, DwellHoldsMovesBack)
+{
+	Placer placer(Policy(1, 1, 5000));
+	placer.time->SetLoad(1, 1.0);
+	placer.placer.Track(1, CoreClass::Efficiency);
+	placer.placer.Step(placer.decisions);
+	for (int second = 1; second < 5; second++) {
+		CHECK(placer.Step() == 0);
+	}
+	CHECK(placer.Step() == 1);
+	CHECK(placer.decisions[0].coreClass == CoreClass::Performance);
+
+	placer.time->SetLoad(1, 0.0);
+	for (int second = 6; second < 10; second++) {
+		CHECK(placer.Step() == 0);
+	}
+	CHECK(placer.Step() == 1);
+	CHECK(placer.decisions[0].coreClass == CoreClass::Efficiency);
+}
+
+// Load that keeps crossing the threshold resets the streak, and load between the two
+// thresholds moves the process neither way.
+TEST_CASE(AdaptivePlacement, BurstyLoadStaysPut)
+{
+	Placer placer(Policy(2, 2, 0));
+	placer.placer.Track(1, CoreClass::Efficiency);
+	placer.placer.Track(2, CoreClass::Performance);
+	placer.time->SetLoad(2, 0.3);
+	placer.placer.Step(placer.decisions);
+	for (int i = 0; i < 10; i++) {
+		placer.time->SetLoad(1, i % 2 == 0 ? 1.0 : 0.0);
+		CHECK(placer.Step() == 0);
+	}
+}
+
+TEST_CASE(AdaptivePlacement, SmoothingDelaysThePromotion)
+{
+	AdaptivePolicy policy = Policy(1, 1, 0);
+	policy.smoothing = 0.5;
+	Placer placer(policy);
+	placer.time->SetLoad(1, 0.0);
+	placer.placer.Track(1, CoreClass::Efficiency);
+	placer.placer.Step(placer.decisions);
+	CHECK(placer.Step() == 0);
+
+	// the smoothed load goes 0.4, then 0.6
+	placer.time->SetLoad(1, 0.8);
+	CHECK(placer.Step() == 0);
+	CHECK(placer.Step() == 1);
+}
+
+TEST_CASE(AdaptivePlacement, ExitedProcessesAreDropped)
+{
+	Placer placer(Policy(1, 1, 0));
+	placer.time->SetLoad(1, 1.0);
+	placer.time->SetLoad(2, 1.0);
+	placer.placer.Track(1, CoreClass::Efficiency);
+	placer.placer.Track(2, CoreClass::Efficiency);
+	placer.placer.Step(placer.decisions);
+
+	placer.time->Remove(2);
+	CHECK(placer.Step() == 1);
+	CHECK(placer.decisions[0].pid == 1);
+	CHECK(placer.placer.Size() == 1);
+	CHECK(!placer.placer.IsTracked(2));
+}
+
+TEST_CASE(AdaptivePlacement, StepsAreDueEveryInterval)
+{
+	AdaptivePolicy policy;
+	policy.intervalMs = 1000;
+	Placer placer(policy);
+	CHECK(placer.placer.Due());
+	placer.placer.Step(placer.decisions);
+	CHECK(!placer.placer.Due());
+	placer.time->Advance(ticksPerSecond - 1);
+	CHECK(!placer.placer.Due());
+	placer.time->Advance(1);
+	CHECK(placer.placer.Due());
+}
+
+// The controller binds an adapted app to the idle placement, then moves it by its load.
+TEST_CASE(AdaptivePlacement, ControllerMovesAdaptedApps)
+{
+	std::unique_ptr<Core::SimulatedOsBackend> simulated(new Core::SimulatedOsBackend());
+	simulated->AddCores(CoreClass::Performance, 2);
+	simulated->AddCores(CoreClass::Efficiency, 4);
+	Core::SimulatedProcess process;
+	process.pid = 100;
+	process.exeName = L"build.exe";
+	simulated->AddProcess(process);
+	Core::SimulatedOsBackend* backend = simulated.get();
+	Core::NativeController controller(std::move(simulated));
+
+	SyntheticProcessTimeSource* time = new SyntheticProcessTimeSource();
+	controller.SetAdaptiveTimeSource(std::unique_ptr<Core::ProcessTimeSource>(time));
+	controller.SetAdaptivePolicy(Policy(2, 2, 3000));
+	CHECK(controller.AdaptApp(L"build.exe"));
+	CHECK(backend->FindProcess(100, process) && process.mask == CpuMask::FromGroup(0, 0x3c));
+
+	time->SetLoad(100, 2.0);
+	CHECK(controller.StepAdaptivePlacement() == 0);
+	int moved = 0;
+	for (int second = 1; second <= 3; second++) {
+		time->Advance(ticksPerSecond);
+		moved += controller.StepAdaptivePlacement();
+	}
+	CHECK(moved == 1);
+	CHECK(backend->FindProcess(100, process) && process.mask == CpuMask::FromGroup(0, 0x03));
+
+	controller.StopAdaptingApp(L"build.exe");
+	CHECK(controller.StepAdaptivePlacement() == 0);
+}
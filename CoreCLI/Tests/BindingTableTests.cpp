@@ -0,0 +1,108 @@
+// Which processes the binding table lets a repeated apply skip, and which entries a sweep drops.
+
+#include "BindingTable.h"
+#include "Check.h"
+
+using Core::BindingTable;
+using Core::CpuMask;
+using Core::PlacementMode;
+
+static CpuMask Mask(unsigned long long bits)
+{
+	return CpuMask::FromGroup(0, bits);
+}
+
+TEST_CASE(BindingTable, UnknownProcessIsNotBound)
+{
+	BindingTable table;
+	CHECK(!table.IsBound(100, 1, Mask(0x3)));
+	CHECK(table.Find(100) == nullptr);
+}
+
+TEST_CASE(BindingTable, RecordedProcessIsSkipped)
+{
+	BindingTable table;
+	table.Record(100, 1, Mask(0x3));
+	CHECK(table.IsBound(100, 1, Mask(0x3)));
+	CHECK(table.IsBound(100, 1, Mask(0x3), PlacementMode::Hard));
+	CHECK(table.Find(100) != nullptr && *table.Find(100) == Mask(0x3));
+	CHECK(table.Size() == 1);
+}
+
+TEST_CASE(BindingTable, ChangedMaskOrModeIsApplied)
+{
+	BindingTable table;
+	table.Record(100, 1, Mask(0x3));
+	CHECK(!table.IsBound(100, 1, Mask(0xc)));
+	CHECK(!table.IsBound(100, 1, Mask(0x3), PlacementMode::Soft));
+
+	table.Record(100, 1, Mask(0x3), PlacementMode::Soft);
+	CHECK(table.IsBound(100, 1, Mask(0x3), PlacementMode::Soft));
+	CHECK(!table.IsBound(100, 1, Mask(0x3), PlacementMode::Hard));
+}
+
+// Only a soft placement of the same process leaves CPU sets for a hard placement to clear.
+TEST_CASE(BindingTable, SoftPlacementIsRemembered)
+{
+	BindingTable table;
+	CHECK(!table.IsSoft(100, 1));
+	table.Record(100, 1, Mask(0x3), PlacementMode::Soft);
+	CHECK(table.IsSoft(100, 1));
+	CHECK(!table.IsSoft(100, 2));
+
+	table.Record(100, 1, Mask(0x3), PlacementMode::Hard);
+	CHECK(!table.IsSoft(100, 1));
+}
+
+// A recycled PID carries the creation time of the new process, which was never bound.
+TEST_CASE(BindingTable, ReusedPidIsApplied)
+{
+	BindingTable table;
+	table.Record(100, 1, Mask(0x3));
+	CHECK(!table.IsBound(100, 2, Mask(0x3)));
+
+	table.Record(100, 2, Mask(0x3));
+	CHECK(table.IsBound(100, 2, Mask(0x3)));
+	CHECK(!table.IsBound(100, 1, Mask(0x3)));
+	CHECK(table.Size() == 1);
+}
+
+TEST_CASE(BindingTable, ForgottenProcessIsApplied)
+{
+	BindingTable table;
+	table.Record(100, 1, Mask(0x3));
+	table.Record(200, 1, Mask(0x3));
+	table.Forget(100);
+	CHECK(!table.IsBound(100, 1, Mask(0x3)));
+	CHECK(table.IsBound(200, 1, Mask(0x3)));
+
+	table.Clear();
+	CHECK(table.Size() == 0);
+}
+
+TEST_CASE(BindingTable, SweepDropsUnseenProcesses)
+{
+	BindingTable table;
+	table.BeginSweep();
+	table.Record(100, 1, Mask(0x3));
+	table.Record(200, 1, Mask(0x3));
+	table.Record(300, 1, Mask(0x3));
+	table.EndSweep();
+	CHECK(table.Size() == 3);
+
+	// 100 is skipped and touched, 200 is bound again and 300 has exited
+	table.BeginSweep();
+	table.Touch(100);
+	table.Record(200, 1, Mask(0xc));
+	table.EndSweep();
+	CHECK(table.Size() == 2);
+	CHECK(table.IsBound(100, 1, Mask(0x3)));
+	CHECK(table.IsBound(200, 1, Mask(0xc)));
+	CHECK(table.Find(300) == nullptr);
+
+	// touching a process that was never bound adds nothing
+	table.BeginSweep();
+	table.Touch(400);
+	table.EndSweep();
+	CHECK(table.Size() == 0);
+}
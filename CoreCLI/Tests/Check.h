@@ -0,0 +1,28 @@
+#pragma once
+
+namespace Tests
+{
+    typedef void (*TestFunction)();
+
+    // Adds a test to the ones TestMain runs. TEST_CASE declares one per test.
+    struct TestRegistration
+    {
+        TestRegistration(const char* suite, const char* name, TestFunction function);
+    };
+
+    // Counts a failed check against the running test and prints where it failed.
+    void Fail(const char* file, int line, const char* condition);
+}
+
+// A test of suite, run when no suite or this one is named on the command line.
+#define TEST_CASE(suite, name) \
+    static void suite##_##name(); \
+    static Tests::TestRegistration suite##_##name##_registration(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            Tests::Fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
@@ -0,0 +1,193 @@
+// The (E-cores, P-cores) mask table of CoreTopology over synthetic topologies, including
+// SMT siblings, shuffled enumeration order and processors in several groups.
+
+#include "Check.h"
+#include "CoreTopology.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using Core::CoreClass;
+using Core::CoreTopology;
+using Core::CpuMask;
+using Core::LogicalCore;
+
+static void AddCore(std::vector<LogicalCore>& cores, unsigned short group, unsigned char coreIndex,
+	CoreClass coreClass, unsigned char firstIndex, unsigned threads)
+{
+	for (unsigned t = 0; t < threads; t++) {
+		LogicalCore core;
+		core.group = group;
+		core.index = static_cast<unsigned char>(firstIndex + t);
+		core.coreIndex = coreIndex;
+		core.coreClass = coreClass;
+		core.efficiencyClass = coreClass == CoreClass::Performance ? 1 : 0;
+		core.cpuSetId = 256 + group * 64 + core.index;
+		cores.push_back(core);
+	}
+}
+
+// Two P-cores with two threads each (processors 0-3), then four E-cores (processors 4-7).
+static std::vector<LogicalCore> HybridCores()
+{
+	std::vector<LogicalCore> cores;
+	AddCore(cores, 0, 0, CoreClass::Performance, 0, 2);
+	AddCore(cores, 0, 1, CoreClass::Performance, 2, 2);
+	for (unsigned char e = 0; e < 4; e++) {
+		AddCore(cores, 0, static_cast<unsigned char>(2 + e), CoreClass::Efficiency, static_cast<unsigned char>(4 + e), 1);
+	}
+	return cores;
+}
+
+struct MaskRow
+{
+	int eCores;
+	int pCores;
+	uint64_t bits;
+};
+
+static const MaskRow hybridRows[] = {
+	{ 0, 0, 0x00 },
+	{ 0, 1, 0x03 },
+	{ 0, 2, 0x0f },
+	{ 1, 0, 0x10 },
+	{ 2, 0, 0x30 },
+	{ 4, 0, 0xf0 },
+	{ 1, 1, 0x13 },
+	{ 3, 1, 0x73 },
+	{ 2, 2, 0x3f },
+	{ 4, 2, 0xff },
+};
+
+static void CheckHybridTable(const CoreTopology& topology)
+{
+	for (const MaskRow& row : hybridRows) {
+		CHECK(topology.Mask(row.eCores, row.pCores) == CpuMask::FromGroup(0, row.bits));
+	}
+}
+
+TEST_CASE(CoreTopology, MaskTableOfAHybridGroup)
+{
+	CoreTopology topology;
+	topology.Build(HybridCores());
+	CHECK(topology.LogicalCoreCount() == 8);
+	CHECK(topology.PerformanceCoreCount() == 2);
+	CHECK(topology.EfficiencyCoreCount() == 4);
+	CHECK(topology.GroupCount() == 1);
+	CheckHybridTable(topology);
+
+	CHECK(topology.AllMask() == CpuMask::FromGroup(0, 0xff));
+	CHECK(topology.PerformanceMask() == CpuMask::FromGroup(0, 0x0f));
+	CHECK(topology.EfficiencyMask() == CpuMask::FromGroup(0, 0xf0));
+}
+
+TEST_CASE(CoreTopology, CountsOutOfRangeGiveAnEmptyMask)
+{
+	CoreTopology topology;
+	topology.Build(HybridCores());
+	CHECK(topology.Mask(-1, 0).Empty());
+	CHECK(topology.Mask(0, -1).Empty());
+	CHECK(topology.Mask(5, 0).Empty());
+	CHECK(topology.Mask(0, 3).Empty());
+	CHECK(topology.Mask(5, 3).Empty());
+
+	CoreTopology empty;
+	empty.Build(std::vector<LogicalCore>());
+	CHECK(empty.Mask(0, 0).Empty());
+	CHECK(empty.Mask(1, 0).Empty());
+	CHECK(empty.GroupCount() == 0);
+}
+
+// SMT siblings enumerated apart still make up one physical core.
+TEST_CASE(CoreTopology, EnumerationOrderDoesNotMatter)
+{
+	std::vector<LogicalCore> cores = HybridCores();
+	std::reverse(cores.begin(), cores.end());
+	CoreTopology topology;
+	topology.Build(cores);
+	CHECK(topology.PerformanceCoreCount() == 2);
+	CHECK(topology.EfficiencyCoreCount() == 4);
+	CheckHybridTable(topology);
+}
+
+TEST_CASE(CoreTopology, RebuildReplacesTheTable)
+{
+	CoreTopology topology;
+	topology.Build(HybridCores());
+
+	std::vector<LogicalCore> cores;
+	AddCore(cores, 0, 0, CoreClass::Performance, 0, 1);
+	topology.Build(cores);
+	CHECK(topology.PerformanceCoreCount() == 1);
+	CHECK(topology.EfficiencyCoreCount() == 0);
+	CHECK(topology.Mask(0, 1) == CpuMask::FromGroup(0, 0x1));
+	CHECK(topology.Mask(0, 2).Empty());
+	CHECK(topology.AllMask() == CpuMask::FromGroup(0, 0x1));
+}
+
+// A full group of 64 P-cores ends on processor 63, and the E-cores sit in a second group.
+TEST_CASE(CoreTopology, MaskTableAcrossGroups)
+{
+	std::vector<LogicalCore> cores;
+	for (unsigned char p = 0; p < 64; p++) {
+		AddCore(cores, 0, p, CoreClass::Performance, p, 1);
+	}
+	for (unsigned char e = 0; e < 4; e++) {
+		AddCore(cores, 1, e, CoreClass::Efficiency, e, 1);
+	}
+	CoreTopology topology;
+	topology.Build(cores);
+	CHECK(topology.GroupCount() == 2);
+	CHECK(topology.PerformanceCoreCount() == 64);
+	CHECK(topology.EfficiencyCoreCount() == 4);
+
+	const uint64_t topBit = uint64_t(1) << 63;
+	CHECK(topology.Mask(0, 1) == CpuMask::FromGroup(0, 0x1));
+	CHECK(topology.Mask(0, 63) == CpuMask::FromGroup(0, topBit - 1));
+	CHECK(topology.Mask(0, 64) == CpuMask::FromGroup(0, ~uint64_t(0)));
+	CHECK(topology.Mask(0, 64).Test(0, 63));
+	CHECK(topology.Mask(0, 64).SingleGroup() == 0);
+
+	CpuMask mixed = topology.Mask(2, 64);
+	CHECK(mixed.Group(0) == ~uint64_t(0));
+	CHECK(mixed.Group(1) == 0x3);
+	CHECK(mixed.GroupCount() == 2);
+	CHECK(mixed.Count() == 66);
+	CHECK(topology.EfficiencyMask() == CpuMask::FromGroup(1, 0xf));
+	CHECK(topology.EfficiencyMask().SingleGroup() == 1);
+	CHECK(topology.AllMask().Count() == 68);
+}
+
+// Both groups hold P-cores, so the first P-cores of group 1 follow all of group 0's.
+TEST_CASE(CoreTopology, ClassSpreadOverGroups)
+{
+	std::vector<LogicalCore> cores;
+	AddCore(cores, 1, 0, CoreClass::Performance, 0, 2);
+	AddCore(cores, 0, 0, CoreClass::Performance, 0, 2);
+	AddCore(cores, 0, 1, CoreClass::Efficiency, 2, 1);
+	AddCore(cores, 1, 1, CoreClass::Efficiency, 2, 1);
+	CoreTopology topology;
+	topology.Build(cores);
+
+	CHECK(topology.Mask(0, 1) == CpuMask::FromGroup(0, 0x3));
+	CHECK(topology.Mask(0, 2) == (CpuMask::FromGroup(0, 0x3) | CpuMask::FromGroup(1, 0x3)));
+	CHECK(topology.Mask(1, 0) == CpuMask::FromGroup(0, 0x4));
+	CHECK(topology.Mask(2, 1) == (CpuMask::FromGroup(0, 0x7) | CpuMask::FromGroup(1, 0x4)));
+	CHECK(topology.Mask(2, 2) == topology.AllMask());
+}
+
+TEST_CASE(CoreTopology, CpuSetsOfAMask)
+{
+	CoreTopology topology;
+	topology.Build(HybridCores());
+
+	std::vector<unsigned long> cpuSets;
+	topology.CpuSets(topology.Mask(1, 1), cpuSets);
+	CHECK((cpuSets == std::vector<unsigned long>{ 256, 257, 260 }));
+	CHECK((topology.CpuSets(CoreClass::Performance) == std::vector<unsigned long>{ 256, 257, 258, 259 }));
+	CHECK(topology.CpuSets(CoreClass::Efficiency).size() == 4);
+
+	topology.CpuSets(CpuMask(), cpuSets);
+	CHECK(cpuSets.empty());
+}
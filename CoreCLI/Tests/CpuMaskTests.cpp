@@ -0,0 +1,93 @@
+// Bit and group edges of CpuMask: the top bit of a group, indexes past it and masks that
+// span processor groups.
+
+#include "Check.h"
+#include "CpuMask.h"
+
+#include <cstdint>
+
+using Core::CpuMask;
+
+static const uint64_t topBit = uint64_t(1) << 63;
+
+TEST_CASE(CpuMask, TopBitOfAGroup)
+{
+	struct Row
+	{
+		unsigned index;
+		uint64_t bits;
+	};
+	static const Row rows[] = {
+		{ 0, 0x1 },
+		{ 31, 0x80000000ULL },
+		{ 32, 0x100000000ULL },
+		{ 62, uint64_t(1) << 62 },
+		{ 63, topBit },
+	};
+	for (const Row& row : rows) {
+		CpuMask mask;
+		mask.Set(0, row.index);
+		CHECK(mask.Group(0) == row.bits);
+		CHECK(mask.Test(0, row.index));
+		CHECK(mask.Count() == 1);
+		CHECK(mask == CpuMask::FromGroup(0, row.bits));
+
+		mask.Reset(0, row.index);
+		CHECK(mask.Empty());
+	}
+}
+
+TEST_CASE(CpuMask, IndexesPastAGroupAreIgnored)
+{
+	CpuMask mask;
+	mask.Set(0, 64);
+	mask.Set(0, 65);
+	mask.Set(CpuMask::MaxGroups, 0);
+	CHECK(mask.Empty());
+	CHECK(mask.GroupSpan() == 0);
+	CHECK(!mask.Test(0, 64));
+
+	mask.SetGroup(0, ~uint64_t(0));
+	CHECK(mask.Count() == 64);
+	CHECK(!mask.Test(0, 64));
+	CHECK(!mask.Test(1, 0));
+}
+
+TEST_CASE(CpuMask, MasksAcrossGroups)
+{
+	CpuMask mask;
+	mask.Set(0, 63);
+	mask.Set(1, 0);
+	mask.Set(CpuMask::MaxGroups - 1, 63);
+	CHECK(mask.Count() == 3);
+	CHECK(mask.GroupCount() == 3);
+	CHECK(mask.GroupSpan() == CpuMask::MaxGroups);
+	CHECK(mask.SingleGroup() == -1);
+	CHECK(mask.Group(0) == topBit && mask.Group(1) == 0x1 && mask.Group(CpuMask::MaxGroups - 1) == topBit);
+
+	CpuMask group1 = CpuMask::FromGroup(1, 0x1);
+	CHECK(group1.SingleGroup() == 1);
+	CHECK((mask & group1) == group1);
+
+	mask.Subtract(group1);
+	CHECK(mask.Count() == 2);
+	CHECK(!mask.Test(1, 0));
+	// a cleared group still counts toward the span but not toward GroupCount
+	CHECK(mask.GroupCount() == 2);
+}
+
+TEST_CASE(CpuMask, EqualityIgnoresEmptyGroups)
+{
+	CpuMask wide;
+	wide.Set(0, 1);
+	wide.Set(2, 1);
+	wide.Reset(2, 1);
+	CHECK(wide == CpuMask::FromGroup(0, 0x2));
+	CHECK(wide != CpuMask::FromGroup(1, 0x2));
+	CHECK(CpuMask() == CpuMask::FromGroup(3, 0));
+
+	CpuMask merged = CpuMask::FromGroup(0, topBit) | CpuMask::FromGroup(1, topBit);
+	CHECK(merged.Count() == 2);
+	merged.Clear();
+	CHECK(merged.Empty() && merged.GroupSpan() == 0);
+}
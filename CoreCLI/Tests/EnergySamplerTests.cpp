@@ -0,0 +1,151 @@
+// Energy counters replayed through ReplayEnergySource into EnergySampler: unwrapping,
+// joules and watts per domain, and what the ring drops.
+
+#include "Check.h"
+#include "EnergyCounterSource.h"
+#include "EnergySampler.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+using Core::EnergySampler;
+using Core::ReplayEnergySource;
+
+static bool Near(double a, double b)
+{
+	return std::fabs(a - b) < 1e-9;
+}
+
+// package wraps at 1 J, dram at 100 J. Frames are 100 ms apart.
+static std::unique_ptr<ReplayEnergySource> Recording()
+{
+	std::unique_ptr<ReplayEnergySource> source(new ReplayEnergySource());
+	source->AddDomain("package", 1000000);
+	source->AddDomain("dram", 100000000);
+	source->AddFrame(0, { 900000, 1000 });
+	source->AddFrame(100000, { 950000, 2000 });
+	source->AddFrame(200000, { 50000, 3000 });
+	return source;
+}
+
+TEST_CASE(EnergySampler, ReplayPlaysFramesInOrder)
+{
+	std::unique_ptr<ReplayEnergySource> source = Recording();
+	CHECK(source->DomainCount() == 2);
+	CHECK(std::string(source->DomainName(1)) == "dram");
+	CHECK(source->Range(0) == 1000000);
+
+	unsigned long long timestampUs = 0, counters[2] = {};
+	CHECK(source->Read(timestampUs, counters) && timestampUs == 0 && counters[0] == 900000);
+	CHECK(source->Read(timestampUs, counters) && timestampUs == 100000 && counters[1] == 2000);
+	CHECK(source->Read(timestampUs, counters) && counters[0] == 50000);
+	CHECK(!source->Read(timestampUs, counters));
+
+	source->Rewind();
+	CHECK(source->Read(timestampUs, counters) && counters[0] == 900000);
+
+	// missing domains read as 0
+	source->AddFrame(300000, { 7 });
+	source->Rewind();
+	for (int i = 0; i < 4; i++) {
+		CHECK(source->Read(timestampUs, counters));
+	}
+	CHECK(timestampUs == 300000 && counters[0] == 7 && counters[1] == 0);
+}
+
+TEST_CASE(EnergySampler, ReplayLoadsARecording)
+{
+	const char* path = "EnergySamplerTests.recording";
+	std::FILE* file = std::fopen(path, "w");
+	CHECK(file != nullptr);
+	if (file == nullptr) {
+		return;
+	}
+	std::fputs("package 262143328850 core 262143328850\n0 100 50\n\n1000 200\n", file);
+	std::fclose(file);
+
+	ReplayEnergySource source;
+	bool loaded = source.Load(path);
+	std::remove(path);
+	CHECK(loaded);
+	CHECK(source.DomainCount() == 2 && std::string(source.DomainName(1)) == "core");
+	CHECK(source.Range(1) == 262143328850ULL);
+
+	unsigned long long timestampUs = 0, counters[2] = {};
+	CHECK(source.Read(timestampUs, counters) && counters[0] == 100 && counters[1] == 50);
+	CHECK(source.Read(timestampUs, counters) && timestampUs == 1000 && counters[0] == 200 && counters[1] == 0);
+	CHECK(!source.Read(timestampUs, counters));
+
+	CHECK(!source.Load("EnergySamplerTests.missing"));
+}
+
+// The package counter wraps between the second and third frame.
+TEST_CASE(EnergySampler, UnwrapsCountersIntoJoulesAndWatts)
+{
+	EnergySampler sampler(Recording());
+	CHECK(sampler.DomainCount() == 2);
+	CHECK(sampler.Update() == 0);
+	CHECK(sampler.Joules(0) == 0);
+
+	CHECK(sampler.Sample());
+	CHECK(sampler.Sample());
+	CHECK(sampler.Update() == 2);
+	CHECK(Near(sampler.Joules(0), 0.05));
+	CHECK(Near(sampler.Watts(0), 0.5));
+	CHECK(Near(sampler.Watts(1), 0.01));
+
+	CHECK(sampler.Sample());
+	CHECK(!sampler.Sample());
+	CHECK(sampler.Update() == 1);
+	CHECK(Near(sampler.Joules(0), 0.15));
+	CHECK(Near(sampler.Watts(0), 1.0));
+	CHECK(Near(sampler.Joules(1), 0.002));
+	CHECK(sampler.LastTimestampUs() == 200000);
+
+	// no new samples keep the values
+	CHECK(sampler.Update() == 0);
+	CHECK(Near(sampler.Watts(0), 1.0));
+}
+
+// A consumer a whole ring behind loses the newest samples, not the energy they measured.
+TEST_CASE(EnergySampler, FullRingDropsSamples)
+{
+	EnergySampler sampler(Recording(), 2);
+	CHECK(sampler.Sample());
+	CHECK(sampler.Sample());
+	CHECK(sampler.Sample());
+	CHECK(sampler.Dropped() == 1);
+	CHECK(sampler.Update() == 2);
+	CHECK(sampler.LastTimestampUs() == 100000);
+	CHECK(Near(sampler.Joules(0), 0.05));
+}
+
+TEST_CASE(EnergySampler, SamplesOnItsOwnThread)
+{
+	EnergySampler sampler(Recording());
+	CHECK(!sampler.Start(0));
+	CHECK(sampler.Start(1000));
+	CHECK(sampler.Running());
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (sampler.LastTimestampUs() != 200000 && std::chrono::steady_clock::now() < deadline) {
+		sampler.Update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	sampler.Stop();
+	CHECK(!sampler.Running());
+	CHECK(Near(sampler.Joules(0), 0.15));
+}
+
+TEST_CASE(EnergySampler, NoSourceNeverSamples)
+{
+	EnergySampler sampler(nullptr);
+	CHECK(sampler.DomainCount() == 0);
+	CHECK(!sampler.Sample());
+	CHECK(!sampler.Start(100));
+	CHECK(sampler.Update() == 0);
+}
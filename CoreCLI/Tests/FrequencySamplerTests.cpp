@@ -0,0 +1,97 @@
+// Recorded frames played back through ReplayFrequencySource into the sampler's ring.
+
+#include "Check.h"
+#include "FrequencySampler.h"
+#include "FrequencySource.h"
+
+#include <memory>
+#include <vector>
+
+using Core::FrequencySampler;
+using Core::FrequencySampleView;
+using Core::ReplayFrequencySource;
+
+// Frame n reads 1000 + 100 * n MHz on core 0 and twice that on core 1, limited to 4000 MHz.
+static std::unique_ptr<ReplayFrequencySource> Frames(unsigned count)
+{
+	std::unique_ptr<ReplayFrequencySource> source(new ReplayFrequencySource(2));
+	for (unsigned n = 0; n < count; n++) {
+		unsigned mhz = 1000 + 100 * n;
+		source->AddFrame({ mhz, 2 * mhz }, { 4000, 4000 }, { n, 0 });
+	}
+	return source;
+}
+
+TEST_CASE(FrequencySampler, ReplayPlaysFramesInOrder)
+{
+	std::unique_ptr<ReplayFrequencySource> source = Frames(2);
+	unsigned current[2], limit[2], idle[2];
+	CHECK(source->CoreCount() == 2);
+	CHECK(source->Read(current, limit, idle));
+	CHECK(current[0] == 1000 && current[1] == 2000 && limit[1] == 4000 && idle[0] == 0);
+	CHECK(source->Read(current, limit, idle));
+	CHECK(current[0] == 1100 && idle[0] == 1);
+	CHECK(!source->Read(current, limit, idle));
+
+	source->Rewind();
+	CHECK(source->Read(current, limit, idle) && current[0] == 1000);
+}
+
+TEST_CASE(FrequencySampler, ReplayZeroFillsMissingCores)
+{
+	ReplayFrequencySource source(3);
+	source.AddFrame({ 1500 }, { 3000, 3000, 3000 }, {});
+	unsigned current[3], limit[3], idle[3];
+	CHECK(source.Read(current, limit, idle));
+	CHECK(current[0] == 1500 && current[1] == 0 && current[2] == 0);
+	CHECK(limit[2] == 3000 && idle[1] == 0);
+
+	ReplayFrequencySource empty(0);
+	CHECK(!empty.Read(current, limit, idle));
+}
+
+TEST_CASE(FrequencySampler, RingKeepsTheNewestSamples)
+{
+	FrequencySampler sampler(Frames(6), 4);
+	CHECK(sampler.CoreCount() == 2 && sampler.Capacity() == 4);
+	for (unsigned n = 0; n < 6; n++) {
+		CHECK(sampler.Sample(10 * n));
+	}
+	CHECK(!sampler.Sample(60));
+	CHECK(sampler.Count() == 4);
+	CHECK(sampler.Total() == 6);
+
+	// the oldest held sample is frame 2
+	FrequencySampleView sample;
+	CHECK(sampler.Read(0, sample));
+	CHECK(sample.timestampUs == 20 && sample.coreCount == 2 && sample.currentMhz[0] == 1200);
+	CHECK(sampler.Read(3, sample) && sample.currentMhz[1] == 3000 && sample.idleState[0] == 5);
+	CHECK(!sampler.Read(4, sample));
+	CHECK(sampler.Latest(sample) && sample.timestampUs == 50);
+}
+
+TEST_CASE(FrequencySampler, AverageOverTheNewestSamples)
+{
+	FrequencySampler sampler(Frames(6), 4);
+	unsigned current[2], limit[2];
+	CHECK(sampler.Average(2, current, limit) == 0);
+	CHECK(current[0] == 0 && limit[0] == 0);
+
+	for (unsigned n = 0; n < 6; n++) {
+		sampler.Sample(n);
+	}
+	CHECK(sampler.Average(2, current, limit) == 2);
+	CHECK(current[0] == 1450 && current[1] == 2900 && limit[0] == 4000);
+	// no more than the ring holds
+	CHECK(sampler.Average(10, current, limit) == 4);
+	CHECK(current[0] == 1350);
+}
+
+TEST_CASE(FrequencySampler, NoSourceNeverSamples)
+{
+	FrequencySampler sampler(nullptr);
+	FrequencySampleView sample;
+	CHECK(sampler.CoreCount() == 0);
+	CHECK(!sampler.Sample(0));
+	CHECK(!sampler.Latest(sample));
+}
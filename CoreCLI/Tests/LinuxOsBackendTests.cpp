@@ -0,0 +1,76 @@
+// The Linux backend against live processes: this test process and a child it kills.
+
+#ifdef __linux__
+
+#include "Check.h"
+#include "OsBackend.h"
+
+#include <dirent.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <memory>
+#include <vector>
+
+using Core::OsBackend;
+using Core::OsStatus;
+using Core::ProcessHandle;
+
+static std::size_t OpenDescriptors()
+{
+	std::size_t count = 0;
+	DIR* fds = opendir("/proc/self/fd");
+	if (fds == nullptr) {
+		return 0;
+	}
+	while (readdir(fds) != nullptr) {
+		count++;
+	}
+	closedir(fds);
+	return count;
+}
+
+// Open processes hold no descriptors, so the handle cache can keep all of them.
+TEST_CASE(LinuxOsBackend, OpenProcessesHoldNoDescriptors)
+{
+	std::unique_ptr<OsBackend> backend = Core::CreateOsBackend();
+	std::size_t before = OpenDescriptors();
+	std::vector<ProcessHandle> processes(256);
+	for (ProcessHandle& process : processes) {
+		CHECK(backend->OpenProcess(static_cast<unsigned long>(getpid()), process) == OsStatus::Ok);
+		CHECK(process.creationTime != 0);
+	}
+	CHECK(OpenDescriptors() == before);
+	CHECK(!backend->HasExited(processes[0].handle));
+	for (ProcessHandle& process : processes) {
+		backend->CloseProcess(process.handle);
+	}
+	CHECK(backend->MaxCachedHandles() >= processes.size());
+}
+
+TEST_CASE(LinuxOsBackend, KilledProcessHasExited)
+{
+	std::unique_ptr<OsBackend> backend = Core::CreateOsBackend();
+	pid_t child = fork();
+	if (child == 0) {
+		for (;;) {
+			pause();
+		}
+	}
+	CHECK(child > 0);
+	if (child <= 0) {
+		return;
+	}
+
+	ProcessHandle process;
+	CHECK(backend->OpenProcess(static_cast<unsigned long>(child), process) == OsStatus::Ok);
+	CHECK(!backend->HasExited(process.handle));
+	kill(child, SIGKILL);
+	waitpid(child, nullptr, 0);
+	CHECK(backend->HasExited(process.handle));
+	backend->CloseProcess(process.handle);
+
+	CHECK(backend->OpenProcess(static_cast<unsigned long>(child), process) != OsStatus::Ok);
+}
+
+#endif
@@ -0,0 +1,265 @@
+// Hard, soft, policy and thread placements applied by a controller on a simulated system of
+// two P-cores (processors 0-1, CPU sets 0-1) and four E-cores (processors 2-5, CPU sets 2-5).
+
+#include "Check.h"
+#include "NativeController.h"
+#include "SimulatedOsBackend.h"
+
+#include <memory>
+#include <vector>
+
+using Core::CoreClass;
+using Core::ApplyResult;
+using Core::CpuMask;
+using Core::NativeController;
+using Core::PlacementMode;
+using Core::PlacementRule;
+using Core::PriorityClass;
+using Core::SimulatedCall;
+using Core::SimulatedCallType;
+using Core::SimulatedOsBackend;
+using Core::SimulatedProcess;
+using Core::ThreadPlacementPolicy;
+
+struct PlacementSystem
+{
+	SimulatedOsBackend* backend;
+	std::unique_ptr<NativeController> controller;
+
+	explicit PlacementSystem(unsigned long processCount)
+	{
+		std::unique_ptr<SimulatedOsBackend> simulated(new SimulatedOsBackend());
+		simulated->AddCores(CoreClass::Performance, 2);
+		simulated->AddCores(CoreClass::Efficiency, 4);
+		for (unsigned long pid = 100; pid < 100 + processCount; pid++) {
+			SimulatedProcess process;
+			process.pid = pid;
+			process.exeName = pid == 100 ? L"app.exe" : L"other.exe";
+			simulated->AddProcess(process);
+		}
+		backend = simulated.get();
+		controller.reset(new NativeController(std::move(simulated)));
+		controller->SetApplyConcurrency(1);
+	}
+
+	SimulatedProcess Process(unsigned long pid) const
+	{
+		SimulatedProcess process;
+		backend->FindProcess(pid, process);
+		return process;
+	}
+
+	// Recorded calls of one type, in the order they were made.
+	std::vector<SimulatedCall> Calls(SimulatedCallType type) const
+	{
+		std::vector<SimulatedCall> calls;
+		for (const SimulatedCall& call : backend->Calls()) {
+			if (call.type == type) {
+				calls.push_back(call);
+			}
+		}
+		return calls;
+	}
+};
+
+static const std::vector<unsigned long> firstTwoECores = { 2, 3 };
+
+TEST_CASE(Placement, HardAfterSoftClearsCpuSets)
+{
+	PlacementSystem system(3);
+	system.controller->MoveAllAppsToHybridCores(2, 0, PlacementMode::Soft);
+	CHECK(system.Process(101).cpuSets == firstTwoECores);
+
+	system.controller->MoveAllAppsToHybridCores(0, 2, PlacementMode::Hard);
+	SimulatedProcess process = system.Process(101);
+	CHECK(process.mode == PlacementMode::Hard);
+	CHECK(process.mask == CpuMask::FromGroup(0, 0x03));
+	CHECK(process.cpuSets.empty());
+
+	// the single-app path clears them too
+	CHECK(system.controller->MoveAppToHybridCores(L"app.exe", 2, 0, PlacementMode::Soft));
+	CHECK(system.Process(100).cpuSets == firstTwoECores);
+	CHECK(system.controller->MoveAppToHybridCores(L"app.exe", 0, 2, PlacementMode::Hard));
+	CHECK(system.Process(100).cpuSets.empty());
+}
+
+// CPU sets the controller never applied are not cleared, so a hard placement costs one call.
+TEST_CASE(Placement, HardLeavesUnknownCpuSetsAlone)
+{
+	PlacementSystem system(1);
+	SimulatedProcess process = system.Process(100);
+	process.cpuSets = firstTwoECores;
+	system.backend->AddProcess(process);
+
+	system.controller->MoveAllAppsToHybridCores(0, 2, PlacementMode::Hard);
+	process = system.Process(100);
+	CHECK(process.mask == CpuMask::FromGroup(0, 0x03));
+	CHECK(process.cpuSets == firstTwoECores);
+}
+
+TEST_CASE(Placement, HardApplyBindsOnceThenSkips)
+{
+	PlacementSystem system(4);
+	system.controller->MoveAllAppsToHybridCores(0, 2, PlacementMode::Hard);
+	std::vector<SimulatedCall> calls = system.Calls(SimulatedCallType::ApplyPlacement);
+	CHECK(calls.size() == 4);
+	for (unsigned long i = 0; i < calls.size() && i < 4; i++) {
+		CHECK(calls[i].id == 100 + i);
+		CHECK(calls[i].status == Core::OsStatus::Ok);
+		CHECK(calls[i].mask == CpuMask::FromGroup(0, 0x03));
+		CHECK(calls[i].mode == PlacementMode::Hard);
+	}
+	ApplyResult result = system.controller->LastApplyResult();
+	CHECK(result.scanned == 4);
+	CHECK(result.bound == 4);
+	CHECK(result.skipped == 0);
+
+	// the same placement again costs no calls that change a process and no opens
+	system.backend->ClearCalls();
+	system.controller->MoveAllAppsToHybridCores(0, 2, PlacementMode::Hard);
+	result = system.controller->LastApplyResult();
+	CHECK(result.scanned == 4);
+	CHECK(result.bound == 0);
+	CHECK(result.skipped == 4);
+	CHECK(system.Calls(SimulatedCallType::ApplyPlacement).empty());
+	CHECK(system.Calls(SimulatedCallType::OpenProcess).empty());
+
+	// a different placement binds every process again
+	system.backend->ClearCalls();
+	system.controller->MoveAllAppsToHybridCores(4, 0, PlacementMode::Hard);
+	result = system.controller->LastApplyResult();
+	CHECK(result.bound == 4);
+	CHECK(result.skipped == 0);
+	calls = system.Calls(SimulatedCallType::ApplyPlacement);
+	CHECK(calls.size() == 4);
+	CHECK(!calls.empty() && calls[0].mask == CpuMask::FromGroup(0, 0x3C));
+}
+
+TEST_CASE(Placement, SoftApplyRecordsCpuSets)
+{
+	PlacementSystem system(3);
+	system.controller->MoveAllAppsToHybridCores(2, 0, PlacementMode::Soft);
+	std::vector<SimulatedCall> calls = system.Calls(SimulatedCallType::ApplyPlacement);
+	CHECK(calls.size() == 3);
+	for (const SimulatedCall& call : calls) {
+		CHECK(call.mode == PlacementMode::Soft);
+		CHECK(call.value == 2);
+	}
+	for (unsigned long pid = 100; pid < 103; pid++) {
+		SimulatedProcess process = system.Process(pid);
+		CHECK(process.mode == PlacementMode::Soft);
+		CHECK(process.cpuSets == firstTwoECores);
+	}
+
+	system.backend->ClearCalls();
+	system.controller->MoveAllAppsToHybridCores(2, 0, PlacementMode::Soft);
+	CHECK(system.controller->LastApplyResult().skipped == 3);
+	CHECK(system.Calls(SimulatedCallType::ApplyPlacement).empty());
+
+	// the same cores as a hard placement are a different binding
+	system.backend->ClearCalls();
+	system.controller->MoveAllAppsToHybridCores(2, 0, PlacementMode::Hard);
+	CHECK(system.controller->LastApplyResult().bound == 3);
+	CHECK(system.Calls(SimulatedCallType::ApplyPlacement).size() == 3);
+	CHECK(system.Process(100).cpuSets.empty());
+}
+
+TEST_CASE(Placement, PolicyAppliesMatchingRules)
+{
+	PlacementSystem system(3);
+	PlacementRule rule;
+	rule.pattern = L"app.exe";
+	rule.pCores = 2;
+	rule.priority = PriorityClass::High;
+	system.controller->SetPlacementPolicy({ rule });
+
+	CHECK(system.controller->ApplyPlacementPolicy() == 1);
+	std::vector<SimulatedCall> calls = system.Calls(SimulatedCallType::ApplyPlacement);
+	CHECK(calls.size() == 1);
+	CHECK(!calls.empty() && calls[0].id == 100);
+	CHECK(!calls.empty() && calls[0].mask == CpuMask::FromGroup(0, 0x03));
+	calls = system.Calls(SimulatedCallType::SetPriority);
+	CHECK(calls.size() == 1);
+	CHECK(!calls.empty() && calls[0].value == static_cast<unsigned>(PriorityClass::High));
+	CHECK(system.Process(100).priority == PriorityClass::High);
+	CHECK(system.Process(101).mask.Empty());
+	CHECK(system.Process(101).priority == PriorityClass::Normal);
+
+	// reapplying reuses the cached handle
+	system.backend->ClearCalls();
+	CHECK(system.controller->ApplyPlacementPolicy() == 1);
+	CHECK(system.Calls(SimulatedCallType::OpenProcess).empty());
+	CHECK(system.Calls(SimulatedCallType::ApplyPlacement).size() == 1);
+
+	// a process started later is matched on the next apply
+	SimulatedProcess process;
+	process.pid = 200;
+	process.exeName = L"app.exe";
+	system.backend->AddProcess(process);
+	CHECK(system.controller->ApplyPlacementPolicy() == 2);
+	CHECK(system.Process(200).mask == CpuMask::FromGroup(0, 0x03));
+}
+
+// Four threads using 4000, 2000, 1000 and 1000 units: the two busiest cover 75% of the time
+// and fill both P-cores, the rest go to the E-cores.
+TEST_CASE(Placement, ThreadsSplitByCpuTime)
+{
+	PlacementSystem system(1);
+	SimulatedProcess process = system.Process(100);
+	process.threadCount = 4;
+	process.cpuTime = 8000;
+	system.backend->AddProcess(process);
+
+	ThreadPlacementPolicy policy;
+	CHECK(system.controller->PlaceAppThreads(L"app.exe", policy) == 4);
+	std::vector<SimulatedCall> calls = system.Calls(SimulatedCallType::SetThreadCpus);
+	CHECK(calls.size() == 4);
+	for (const SimulatedCall& call : calls) {
+		bool busiest = call.id == 100 * 1024 + 1 || call.id == 100 * 1024 + 2;
+		CHECK(call.value == (busiest ? 2u : 4u));
+	}
+
+	// only the busiest thread fits under a 50% share
+	system.backend->ClearCalls();
+	CHECK(system.backend->SetCpuTime(100, 16000));
+	policy.performanceShare = 0.5;
+	CHECK(system.controller->PlaceAppThreads(L"app.exe", policy) == 4);
+	calls = system.Calls(SimulatedCallType::SetThreadCpus);
+	CHECK(calls.size() == 4);
+	for (const SimulatedCall& call : calls) {
+		CHECK(call.value == (call.id == 100 * 1024 + 1 ? 2u : 4u));
+	}
+
+	// threads that used nothing since the last plan stay off the P-cores
+	system.backend->ClearCalls();
+	CHECK(system.controller->PlaceAppThreads(L"app.exe", policy) == 4);
+	for (const SimulatedCall& call : system.Calls(SimulatedCallType::SetThreadCpus)) {
+		CHECK(call.value == 4);
+	}
+}
+
+TEST_CASE(Placement, SweepsCloseHandlesOfExitedProcesses)
+{
+	PlacementSystem system(6);
+	system.controller->MoveAllAppsToHybridCores(0, 2, PlacementMode::Hard);
+	CHECK(system.backend->OpenHandles() == 6);
+
+	system.backend->RemoveProcess(101);
+	system.backend->RemoveProcess(102);
+	system.controller->MoveAllAppsToHybridCores(0, 2, PlacementMode::Hard);
+	CHECK(system.controller->LastApplyResult().skipped == 4);
+	CHECK(system.backend->OpenHandles() == 4);
+
+	// a reused PID is a new process and gets bound through a new handle
+	SimulatedProcess process;
+	process.pid = 103;
+	process.exeName = L"other.exe";
+	system.backend->AddProcess(process);
+	system.backend->ClearCalls();
+	system.controller->MoveAllAppsToHybridCores(0, 2, PlacementMode::Hard);
+	ApplyResult result = system.controller->LastApplyResult();
+	CHECK(result.bound == 1);
+	CHECK(result.skipped == 3);
+	CHECK(system.Calls(SimulatedCallType::OpenProcess).size() == 1);
+	CHECK(system.backend->OpenHandles() == 4);
+}
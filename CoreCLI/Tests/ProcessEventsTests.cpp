@@ -0,0 +1,152 @@
+// Watched apps bound from process start events fed through the mock source, on a simulated
+// system of two P-cores (processors 0-1) and four E-cores (processors 2-5).
+
+#include "Check.h"
+#include "NativeController.h"
+#include "ProcessEventQueue.h"
+#include "ProcessEventSource.h"
+#include "SimulatedOsBackend.h"
+
+#include <memory>
+
+using Core::CoreClass;
+using Core::CpuMask;
+using Core::MockProcessEventSource;
+using Core::NativeController;
+using Core::ProcessEventType;
+using Core::SimulatedCallType;
+using Core::SimulatedOsBackend;
+using Core::SimulatedProcess;
+
+struct EventSystem
+{
+	SimulatedOsBackend* backend;
+	MockProcessEventSource* events;
+	std::unique_ptr<NativeController> controller;
+
+	EventSystem()
+	{
+		std::unique_ptr<SimulatedOsBackend> simulated(new SimulatedOsBackend());
+		simulated->AddCores(CoreClass::Performance, 2);
+		simulated->AddCores(CoreClass::Efficiency, 4);
+		backend = simulated.get();
+		controller.reset(new NativeController(std::move(simulated)));
+
+		std::unique_ptr<MockProcessEventSource> source(new MockProcessEventSource());
+		events = source.get();
+		controller->StartProcessEvents(std::move(source));
+	}
+
+	void Start(unsigned long pid, const wchar_t* exeName, unsigned long long creationTime = 0)
+	{
+		SimulatedProcess process;
+		process.pid = pid;
+		process.exeName = exeName;
+		process.creationTime = creationTime;
+		backend->AddProcess(process);
+		events->Push(ProcessEventType::Started, pid, exeName);
+	}
+
+	CpuMask MaskOf(unsigned long pid) const
+	{
+		SimulatedProcess process;
+		backend->FindProcess(pid, process);
+		return process.mask;
+	}
+};
+
+static const CpuMask performanceCores = CpuMask::FromGroup(0, 0x03);
+static const CpuMask efficiencyCores = CpuMask::FromGroup(0, 0x3c);
+
+TEST_CASE(ProcessEvents, StartedWatchedAppIsBound)
+{
+	EventSystem system;
+	CHECK(system.controller->WatchApp(L"game.exe", 0, 2));
+	system.Start(100, L"game.exe");
+	system.Start(200, L"editor.exe");
+	CHECK(system.controller->DrainProcessEvents() == 1);
+	CHECK(system.MaskOf(100) == performanceCores);
+	CHECK(system.MaskOf(200).Empty());
+	CHECK(system.backend->CallCount(SimulatedCallType::ApplyPlacement) == 1);
+
+	// nothing left to drain
+	CHECK(system.controller->DrainProcessEvents() == 0);
+}
+
+// The event carries the image path on some sources, only its file name is matched.
+TEST_CASE(ProcessEvents, EventNamesAreTrimmedToTheFileName)
+{
+	EventSystem system;
+	system.controller->WatchApp(L"game.exe", 4, 0);
+	SimulatedProcess process;
+	process.pid = 100;
+	process.exeName = L"game.exe";
+	system.backend->AddProcess(process);
+	system.events->Push(ProcessEventType::Started, 100, L"C:\\Games\\game.exe");
+	CHECK(system.controller->DrainProcessEvents() == 1);
+	CHECK(system.MaskOf(100) == efficiencyCores);
+}
+
+TEST_CASE(ProcessEvents, UnwatchedAppIsLeftAlone)
+{
+	EventSystem system;
+	system.controller->WatchApp(L"game.exe", 0, 2);
+	system.controller->UnwatchApp(L"game.exe");
+	system.Start(100, L"game.exe");
+	CHECK(system.controller->DrainProcessEvents() == 0);
+	CHECK(system.backend->CallCount(SimulatedCallType::ApplyPlacement) == 0);
+}
+
+// An exit forgets the binding, so a new process reusing the PID is bound again.
+TEST_CASE(ProcessEvents, ExitThenPidReuseBindsAgain)
+{
+	EventSystem system;
+	system.controller->WatchApp(L"game.exe", 0, 2);
+	system.Start(100, L"game.exe", 1000);
+	CHECK(system.controller->DrainProcessEvents() == 1);
+
+	system.backend->RemoveProcess(100);
+	system.events->Push(ProcessEventType::Exited, 100, nullptr);
+	system.Start(100, L"game.exe", 2000);
+	CHECK(system.controller->DrainProcessEvents() == 1);
+	CHECK(system.MaskOf(100) == performanceCores);
+	CHECK(system.backend->CallCount(SimulatedCallType::ApplyPlacement) == 2);
+}
+
+// Starts pushed while the queue is full are lost, the drain rescans the watched apps instead.
+TEST_CASE(ProcessEvents, DroppedEventsRescanWatchedApps)
+{
+	EventSystem system;
+	system.controller->WatchApp(L"game.exe", 0, 2);
+	for (unsigned long pid = 1000; system.events->Push(ProcessEventType::Started, pid, L"other.exe"); pid++) {
+	}
+	system.Start(100, L"game.exe");
+	system.controller->DrainProcessEvents();
+	CHECK(system.MaskOf(100) == performanceCores);
+
+	system.Start(200, L"game.exe");
+	CHECK(system.controller->DrainProcessEvents() == 1);
+	CHECK(system.MaskOf(200) == performanceCores);
+}
+
+// The mock source pushes only while started, and the queue counts what did not fit.
+TEST_CASE(ProcessEvents, MockSourceFeedsItsQueue)
+{
+	MockProcessEventSource source;
+	CHECK(!source.Push(ProcessEventType::Started, 100, L"game.exe"));
+
+	Core::ProcessEventQueue queue(3);
+	CHECK(queue.Capacity() == 4);
+	CHECK(source.Start(queue));
+	for (unsigned long pid = 1; pid <= 4; pid++) {
+		CHECK(source.Push(ProcessEventType::Started, pid, L"game.exe"));
+	}
+	CHECK(!source.Push(ProcessEventType::Started, 5, L"game.exe"));
+	CHECK(queue.TakeDropped() == 1);
+	CHECK(queue.TakeDropped() == 0);
+
+	Core::ProcessEvent event;
+	CHECK(queue.Pop(event) && event.pid == 1 && Core::SameExeName(event.exeName, L"game.exe"));
+	source.Stop();
+	CHECK(!source.Push(ProcessEventType::Started, 6, L"game.exe"));
+}
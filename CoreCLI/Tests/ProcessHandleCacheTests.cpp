@@ -0,0 +1,92 @@
+// How many handles the cache keeps open, bounded by the backend, and what a sweep closes.
+
+#include "Check.h"
+#include "ProcessHandleCache.h"
+#include "SimulatedOsBackend.h"
+
+using Core::ProcessHandle;
+using Core::ProcessHandleCache;
+using Core::SimulatedOsBackend;
+using Core::SimulatedProcess;
+
+static void AddProcesses(SimulatedOsBackend& backend, unsigned long count)
+{
+	for (unsigned long pid = 1; pid <= count; pid++) {
+		SimulatedProcess process;
+		process.pid = pid;
+		process.exeName = L"app.exe";
+		backend.AddProcess(process);
+	}
+}
+
+// Acquires every process and releases the handles that did not fit.
+static void AcquireAll(ProcessHandleCache& cache, unsigned long count)
+{
+	for (unsigned long pid = 1; pid <= count; pid++) {
+		cache.Release(cache.Acquire(pid));
+	}
+}
+
+TEST_CASE(ProcessHandleCache, CapacityIsClampedToTheBackend)
+{
+	SimulatedOsBackend backend;
+	backend.SetMaxCachedHandles(4);
+	AddProcesses(backend, 10);
+	{
+		ProcessHandleCache cache(backend, 8);
+		AcquireAll(cache, 10);
+		CHECK(cache.Size() == 4);
+
+		cache.EnsureCapacity(100);
+		AcquireAll(cache, 10);
+		CHECK(cache.Size() == 4);
+		CHECK(backend.OpenHandles() == 4);
+	}
+	CHECK(backend.OpenHandles() == 0);
+}
+
+TEST_CASE(ProcessHandleCache, CapacityGrowsToTheProcessCount)
+{
+	SimulatedOsBackend backend;
+	AddProcesses(backend, 10);
+	ProcessHandleCache cache(backend, 2);
+	AcquireAll(cache, 10);
+	CHECK(cache.Size() == 2);
+
+	cache.EnsureCapacity(10);
+	AcquireAll(cache, 10);
+	CHECK(cache.Size() == 10);
+
+	// never shrinks
+	cache.EnsureCapacity(1);
+	AcquireAll(cache, 10);
+	CHECK(cache.Size() == 10);
+	CHECK(backend.OpenHandles() == 10);
+}
+
+TEST_CASE(ProcessHandleCache, SweepClosesHandlesOfExitedProcesses)
+{
+	SimulatedOsBackend backend;
+	AddProcesses(backend, 4);
+	ProcessHandleCache cache(backend, 8);
+	cache.BeginSweep();
+	AcquireAll(cache, 4);
+	cache.EndSweep();
+	CHECK(cache.Size() == 4);
+
+	backend.RemoveProcess(2);
+	backend.RemoveProcess(3);
+	cache.BeginSweep();
+	cache.Release(cache.Acquire(1));
+	cache.Release(cache.Acquire(4));
+	cache.EndSweep();
+	CHECK(cache.Size() == 2);
+	CHECK(backend.OpenHandles() == 2);
+
+	// a cached handle is reused rather than opened again
+	backend.ClearCalls();
+	ProcessHandle process = cache.Acquire(1);
+	CHECK(process.handle != nullptr && process.cached);
+	CHECK(backend.CallCount(Core::SimulatedCallType::OpenProcess) == 0);
+	cache.Release(process);
+}
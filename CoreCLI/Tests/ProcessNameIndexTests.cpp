@@ -0,0 +1,57 @@
+// The name index must resolve exactly the names SameExeName matches, or the batch and
+// adaptive paths would miss processes that a single-app bind finds.
+
+#include "Check.h"
+#include "NativeController.h"
+#include "ProcessNameIndex.h"
+
+using Core::ProcessNameIndex;
+
+TEST_CASE(ProcessNameIndex, FindsEveryPidOfAName)
+{
+	ProcessNameIndex index;
+	index.Add(L"app.exe", 100);
+	index.Add(L"other.exe", 200);
+	index.Add(L"app.exe", 300);
+
+	const std::vector<unsigned long>* pids = index.Find(L"app.exe");
+	CHECK(pids != nullptr && pids->size() == 2);
+	CHECK(pids != nullptr && (*pids)[0] == 100 && (*pids)[1] == 300);
+	CHECK(index.Find(L"missing.exe") == nullptr);
+	CHECK(index.Size() == 2);
+
+	index.Clear();
+	CHECK(index.Find(L"app.exe") == nullptr);
+}
+
+TEST_CASE(ProcessNameIndex, MatchesAsSameExeNameDoes)
+{
+	ProcessNameIndex index;
+	index.Add(L"App.exe", 100);
+	index.Add(L"APP.EXE", 200);
+
+	bool folded = Core::SameExeName(L"App.exe", L"APP.EXE");
+	const std::vector<unsigned long>* pids = index.Find(L"app.exe");
+	if (folded) {
+		CHECK(index.Size() == 1);
+		CHECK(pids != nullptr && pids->size() == 2);
+	}
+	else {
+		CHECK(index.Size() == 2);
+		CHECK(pids == nullptr);
+		CHECK(index.Find(L"APP.EXE") != nullptr);
+	}
+	CHECK((index.Find(L"aPp.ExE") != nullptr) == Core::SameExeName(L"aPp.ExE", L"App.exe"));
+}
+
+TEST_CASE(ProcessNameIndex, CaseFoldsOnlyOnWindows)
+{
+#ifdef _WIN32
+	CHECK(Core::SameExeName(L"App.exe", L"APP.EXE"));
+#else
+	CHECK(!Core::SameExeName(L"App.exe", L"APP.EXE"));
+#endif
+	CHECK(Core::SameExeName(L"app.exe", L"app.exe"));
+	CHECK(!Core::SameExeName(L"app.exe", L"app.ex"));
+	CHECK(!Core::SameExeName(L"app", L"app.exe"));
+}
@@ -0,0 +1,111 @@
+// Which pending requests a later request replaces, and how settings requests run on a
+// controller on the simulated system.
+
+#include "Check.h"
+#include "NativeController.h"
+#include "RequestQueue.h"
+#include "SimulatedOsBackend.h"
+
+#include <memory>
+#include <vector>
+
+static Core::ControllerRequest Request(Core::RequestType type, const wchar_t* target = L"")
+{
+	Core::ControllerRequest request;
+	request.type = type;
+	request.target = target;
+	return request;
+}
+
+TEST_CASE(RequestQueue, BulkAppliesSupersedeEachOther)
+{
+	using Core::RequestType;
+	CHECK(Core::Supersedes(Request(RequestType::ResetToDefaultCores), Request(RequestType::MoveAllAppsToEfficiencyCores)));
+	CHECK(Core::Supersedes(Request(RequestType::MoveAllAppsToHybridCores), Request(RequestType::MoveAllAppsToSomeEfficiencyCores)));
+	CHECK(!Core::Supersedes(Request(RequestType::MoveAllAppsToHybridCores), Request(RequestType::MoveAppToHybridCores, L"app.exe")));
+}
+
+TEST_CASE(RequestQueue, PolicyOnlySupersedesPolicy)
+{
+	using Core::RequestType;
+	CHECK(Core::Supersedes(Request(RequestType::ApplyPlacementPolicy), Request(RequestType::ApplyPlacementPolicy)));
+	CHECK(!Core::Supersedes(Request(RequestType::MoveAllAppsToEfficiencyCores), Request(RequestType::ApplyPlacementPolicy)));
+	CHECK(!Core::Supersedes(Request(RequestType::ResetToDefaultCores), Request(RequestType::ApplyPlacementPolicy)));
+	CHECK(!Core::Supersedes(Request(RequestType::ApplyPlacementPolicy), Request(RequestType::MoveAllAppsToHybridCores)));
+	CHECK(!Core::Supersedes(Request(RequestType::ApplyPlacementPolicy), Request(RequestType::MoveAppToHybridCores, L"app.exe")));
+}
+
+TEST_CASE(RequestQueue, AppBindsSupersedeTheSameApp)
+{
+	using Core::RequestType;
+	CHECK(Core::Supersedes(Request(RequestType::MoveAppToHybridCores, L"app.exe"), Request(RequestType::MoveAppToHybridCores, L"app.exe")));
+	// names differing in case are the same app only where SameExeName says so
+	CHECK(Core::Supersedes(Request(RequestType::MoveAppToHybridCores, L"App.exe"), Request(RequestType::MoveAppToHybridCores, L"app.exe"))
+		== Core::SameExeName(L"App.exe", L"app.exe"));
+	CHECK(!Core::Supersedes(Request(RequestType::MoveAppToHybridCores, L"other.exe"), Request(RequestType::MoveAppToHybridCores, L"app.exe")));
+}
+
+// A persona switch queued behind a policy apply must leave the policy apply pending.
+TEST_CASE(RequestQueue, QueueKeepsPolicyBehindBulkApply)
+{
+	using Core::RequestType;
+	Core::NativeController controller(std::unique_ptr<Core::OsBackend>(new Core::SimulatedOsBackend()));
+	Core::RequestQueue queue(controller);
+	std::vector<unsigned long long> superseded;
+
+	unsigned long long policy = queue.Submit(Request(RequestType::ApplyPlacementPolicy), superseded);
+	unsigned long long efficiency = queue.Submit(Request(RequestType::MoveAllAppsToEfficiencyCores), superseded);
+	CHECK(superseded.empty());
+	queue.Submit(Request(RequestType::ResetToDefaultCores), superseded);
+	CHECK(superseded.size() == 1 && superseded[0] == efficiency);
+	CHECK(queue.PendingCount() == 2);
+
+	queue.Submit(Request(RequestType::ApplyPlacementPolicy), superseded);
+	CHECK(superseded.size() == 1 && superseded[0] == policy);
+	CHECK(queue.PendingCount() == 2);
+}
+
+TEST_CASE(RequestQueue, SettingsAreNeverSuperseded)
+{
+	using Core::RequestType;
+	CHECK(!Core::Supersedes(Request(RequestType::WatchApp, L"app.exe"), Request(RequestType::WatchApp, L"app.exe")));
+	CHECK(!Core::Supersedes(Request(RequestType::MoveAppToHybridCores, L"app.exe"), Request(RequestType::WatchApp, L"app.exe")));
+	CHECK(!Core::Supersedes(Request(RequestType::WatchApp, L"app.exe"), Request(RequestType::MoveAppToHybridCores, L"app.exe")));
+	CHECK(!Core::Supersedes(Request(RequestType::MoveAllAppsToHybridCores), Request(RequestType::WatchApp, L"app.exe")));
+	CHECK(!Core::Supersedes(Request(RequestType::UnwatchApp, L"app.exe"), Request(RequestType::WatchApp, L"app.exe")));
+	// a policy apply queued between two loads must run with the first
+	CHECK(!Core::Supersedes(Request(RequestType::LoadPlacementPolicy, L"b.policy"), Request(RequestType::LoadPlacementPolicy, L"a.policy")));
+	CHECK(!Core::Supersedes(Request(RequestType::ApplyPlacementPolicy), Request(RequestType::LoadPlacementPolicy, L"a.policy")));
+	CHECK(!Core::Supersedes(Request(RequestType::LoadPlacementPolicy, L"a.policy"), Request(RequestType::ApplyPlacementPolicy)));
+}
+
+TEST_CASE(RequestQueue, SettingsRunInOrder)
+{
+	using Core::RequestType;
+	std::unique_ptr<Core::SimulatedOsBackend> backend(new Core::SimulatedOsBackend());
+	backend->AddCores(Core::CoreClass::Performance, 2);
+	backend->AddCores(Core::CoreClass::Efficiency, 4);
+	backend->SetFile(L"apps.policy", L"app.exe p=2\n");
+	Core::NativeController controller(std::move(backend));
+	Core::RequestQueue queue(controller);
+
+	Core::ControllerRequest watch = Request(RequestType::WatchApp, L"app.exe");
+	watch.eCores = 4;
+	queue.Submit(watch);
+	Core::ControllerRequest invalid = Request(RequestType::WatchApp, L"other.exe");
+	invalid.eCores = 5;
+	queue.Submit(invalid);
+	queue.Submit(Request(RequestType::LoadPlacementPolicy, L"apps.policy"));
+	queue.Submit(Request(RequestType::LoadPlacementPolicy, L"missing.policy"));
+	queue.Submit(Request(RequestType::UnwatchApp, L"app.exe"));
+	CHECK(queue.PendingCount() == 5);
+
+	std::vector<int> results;
+	Core::ControllerRequest request;
+	unsigned long long token;
+	while (queue.Take(request, token)) {
+		results.push_back(Core::ExecuteRequest(controller, request));
+		CHECK(queue.Finish(token) == Core::RequestStatus::Completed);
+	}
+	CHECK(results == std::vector<int>({ 1, 0, 1, 0, 1 }));
+}
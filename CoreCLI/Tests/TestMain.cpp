@@ -0,0 +1,76 @@
+// Runs the registered tests, or those of the suite named by the only argument.
+
+#include "Check.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace Tests
+{
+	struct Test
+	{
+		const char* suite;
+		const char* name;
+		TestFunction function;
+	};
+
+	// Built from static constructors, so it is created on first use.
+	std::vector<Test>& Registry()
+	{
+		static std::vector<Test> tests;
+		return tests;
+	}
+
+	int failures = 0;
+
+	TestRegistration::TestRegistration(const char* suite, const char* name, TestFunction function)
+	{
+		Test test = { suite, name, function };
+		Registry().push_back(test);
+	}
+
+	void Fail(const char* file, int line, const char* condition)
+	{
+		std::printf("%s:%d: CHECK(%s) failed\n", file, line, condition);
+		failures++;
+	}
+}
+
+// Discards what the controller logs, so only failures are printed.
+class NullBuffer : public std::streambuf
+{
+protected:
+	int overflow(int c) override { return c; }
+};
+
+int main(int argc, char** argv)
+{
+	const char* suite = argc > 1 ? argv[1] : nullptr;
+	NullBuffer nullBuffer;
+	std::streambuf* console = std::cout.rdbuf(&nullBuffer);
+
+	int run = 0;
+	int failed = 0;
+	for (const Tests::Test& test : Tests::Registry()) {
+		if (suite != nullptr && std::strcmp(suite, test.suite) != 0) {
+			continue;
+		}
+		int before = Tests::failures;
+		test.function();
+		run++;
+		if (Tests::failures != before) {
+			std::printf("FAILED %s.%s\n", test.suite, test.name);
+			failed++;
+		}
+	}
+	std::cout.rdbuf(console);
+
+	if (run == 0) {
+		std::printf("No tests match %s\n", suite != nullptr ? suite : "");
+		return 1;
+	}
+	std::printf("%d of %d tests passed\n", run - failed, run);
+	return failed > 0 ? 1 : 0;
+}
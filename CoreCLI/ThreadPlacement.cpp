@@ -0,0 +1,191 @@
+#include "ThreadPlacement.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <TlHelp32.h>
+#else
+#include <dirent.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#endif
+
+namespace Core
+{
+#ifdef _WIN32
+	unsigned long long FileTimeToTicks(const FILETIME& time) {
+		return (static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+	}
+
+	bool EnumerateThreads(unsigned long pid, std::vector<ThreadSample>& threads) {
+		threads.clear();
+
+		// thread snapshots cover the whole system, the process ID argument is ignored
+		HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+		if (snapshot == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		THREADENTRY32 entry;
+		entry.dwSize = sizeof(THREADENTRY32);
+		if (Thread32First(snapshot, &entry)) {
+			do {
+				if (entry.th32OwnerProcessID != pid) {
+					continue;
+				}
+
+				ThreadSample sample;
+				sample.tid = entry.th32ThreadID;
+
+				HANDLE thread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, entry.th32ThreadID);
+				if (thread != NULL) {
+					FILETIME creationTime, exitTime, kernelTime, userTime;
+					if (GetThreadTimes(thread, &creationTime, &exitTime, &kernelTime, &userTime)) {
+						sample.cpuTime = FileTimeToTicks(kernelTime) + FileTimeToTicks(userTime);
+					}
+					CloseHandle(thread);
+				}
+				threads.push_back(sample);
+			} while (Thread32Next(snapshot, &entry));
+		}
+
+		CloseHandle(snapshot);
+		return !threads.empty();
+	}
+#else
+	// Reads utime + stime from /proc/<pid>/task/<tid>/stat and converts clock ticks to 100ns units.
+	bool ReadThreadCpuTime(unsigned long pid, unsigned long tid, unsigned long long& cpuTime) {
+		std::string path = "/proc/" + std::to_string(pid) + "/task/" + std::to_string(tid) + "/stat";
+		FILE* file = fopen(path.c_str(), "r");
+		if (file == nullptr) {
+			return false;
+		}
+
+		char buffer[1024];
+		size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+		fclose(file);
+		buffer[length] = '\0';
+
+		// the command name can contain spaces, the remaining fields start after its closing parenthesis
+		const char* fields = strrchr(buffer, ')');
+		if (fields == nullptr) {
+			return false;
+		}
+
+		unsigned long long utime = 0, stime = 0;
+		if (sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) {
+			return false;
+		}
+
+		static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+		cpuTime = (utime + stime) * (10000000ULL / static_cast<unsigned long long>(ticksPerSecond));
+		return true;
+	}
+
+	bool EnumerateThreads(unsigned long pid, std::vector<ThreadSample>& threads) {
+		threads.clear();
+
+		std::string path = "/proc/" + std::to_string(pid) + "/task";
+		DIR* directory = opendir(path.c_str());
+		if (directory == nullptr) {
+			return false;
+		}
+
+		while (dirent* entry = readdir(directory)) {
+			char* end = nullptr;
+			unsigned long tid = strtoul(entry->d_name, &end, 10);
+			if (end == entry->d_name || *end != '\0') {
+				continue;
+			}
+
+			ThreadSample sample;
+			sample.tid = tid;
+			ReadThreadCpuTime(pid, tid, sample.cpuTime);
+			threads.push_back(sample);
+		}
+
+		closedir(directory);
+		return !threads.empty();
+	}
+
+#ifdef __linux__
+	bool SetThreadCpus(unsigned long tid, const std::vector<unsigned long>& cpus) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (unsigned long cpu : cpus) {
+			if (cpu < CPU_SETSIZE) {
+				CPU_SET(cpu, &set);
+			}
+		}
+		return sched_setaffinity(static_cast<pid_t>(tid), sizeof(set), &set) == 0;
+	}
+#endif
+#endif
+
+	void ThreadPlanner::Plan(unsigned long pid, const std::vector<ThreadSample>& threads, const ThreadPlacementPolicy& policy,
+		int performanceCores, std::vector<ThreadAssignment>& assignments)
+	{
+		std::unordered_map<unsigned long, unsigned long long>& lastCpuTime = m_LastCpuTime[pid];
+
+		// CPU time used by each thread since the previous plan
+		std::vector<ThreadSample> usage;
+		usage.reserve(threads.size());
+		unsigned long long total = 0;
+		for (const ThreadSample& thread : threads) {
+			ThreadSample used = thread;
+			auto it = lastCpuTime.find(thread.tid);
+			if (it != lastCpuTime.end() && it->second <= thread.cpuTime) {
+				used.cpuTime = thread.cpuTime - it->second;
+			}
+			usage.push_back(used);
+			total += used.cpuTime;
+		}
+
+		lastCpuTime.clear();
+		for (const ThreadSample& thread : threads) {
+			lastCpuTime[thread.tid] = thread.cpuTime;
+		}
+
+		std::stable_sort(usage.begin(), usage.end(), [](const ThreadSample& a, const ThreadSample& b) {
+			return a.cpuTime > b.cpuTime;
+		});
+
+		int maxPerformance = policy.maxPerformanceThreads > 0 ? policy.maxPerformanceThreads : performanceCores;
+		if (maxPerformance > performanceCores) {
+			maxPerformance = performanceCores;
+		}
+
+		assignments.clear();
+		assignments.reserve(usage.size());
+		unsigned long long covered = 0;
+		int performanceThreads = 0;
+		for (const ThreadSample& thread : usage) {
+			ThreadAssignment assignment;
+			assignment.tid = thread.tid;
+
+			// idle threads never earn a P-core
+			if (thread.cpuTime > 0 && performanceThreads < maxPerformance
+				&& covered < policy.performanceShare * static_cast<double>(total)) {
+				assignment.coreClass = CoreClass::Performance;
+				covered += thread.cpuTime;
+				performanceThreads++;
+			}
+			assignments.push_back(assignment);
+		}
+	}
+
+	void ThreadPlanner::Forget(unsigned long pid)
+	{
+		m_LastCpuTime.erase(pid);
+	}
+
+	void ThreadPlanner::Clear()
+	{
+		m_LastCpuTime.clear();
+	}
+}
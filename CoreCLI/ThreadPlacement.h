@@ -0,0 +1,55 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+#include "CoreTopology.h"
+
+namespace Core
+{
+    // CPU time a thread has used so far, in 100ns units.
+    struct ThreadSample
+    {
+        unsigned long tid = 0;
+        unsigned long long cpuTime = 0;
+    };
+
+    struct ThreadAssignment
+    {
+        unsigned long tid = 0;
+        CoreClass coreClass = CoreClass::Efficiency;
+    };
+
+    struct ThreadPlacementPolicy
+    {
+        // The busiest threads go to P-cores until they account for this share of the CPU time.
+        double performanceShare = 0.8;
+
+        // Most threads placed on P-cores, 0 allows one per P-core.
+        int maxPerformanceThreads = 0;
+    };
+
+    // Lists the threads of a process with their CPU time, from a Toolhelp thread
+    // snapshot on Windows and /proc/<pid>/task on Linux.
+    bool EnumerateThreads(unsigned long pid, std::vector<ThreadSample>& threads);
+
+#ifdef __linux__
+    // Restricts a thread to the given CPU numbers.
+    bool SetThreadCpus(unsigned long tid, const std::vector<unsigned long>& cpus);
+#endif
+
+    // Splits the threads of a process between core classes by the CPU time each used since
+    // the previous plan for that process, or since the thread started on the first plan.
+    class ThreadPlanner
+    {
+    public:
+        void Plan(unsigned long pid, const std::vector<ThreadSample>& threads, const ThreadPlacementPolicy& policy,
+            int performanceCores, std::vector<ThreadAssignment>& assignments);
+
+        void Forget(unsigned long pid);
+        void Clear();
+
+    private:
+        // pid -> tid -> CPU time at the previous plan
+        std::unordered_map<unsigned long, std::unordered_map<unsigned long, unsigned long long>> m_LastCpuTime;
+    };
+}
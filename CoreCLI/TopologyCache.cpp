@@ -0,0 +1,343 @@
+#include "TopologyCache.h"
+
+#include "HybridDetect.h"
+#include <cstring>
+#include <type_traits>
+
+namespace Core
+{
+	const unsigned cacheMagic = 0x43545045; // "EPTC"
+	const unsigned cacheVersion = 1;
+
+	// Appends trivially copyable values to a byte buffer.
+	class CacheWriter
+	{
+	public:
+		template <typename T>
+		void Put(const T& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "cache fields must be trivially copyable");
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+			m_Buffer.insert(m_Buffer.end(), bytes, bytes + sizeof(T));
+		}
+
+		std::vector<unsigned char>& Buffer() { return m_Buffer; }
+
+	private:
+		std::vector<unsigned char> m_Buffer;
+	};
+
+	// Reads values back in the order they were written, failing once the buffer runs out.
+	class CacheReader
+	{
+	public:
+		CacheReader(const unsigned char* data, size_t size) : m_Data(data), m_Size(size) {}
+
+		template <typename T>
+		bool Get(T& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "cache fields must be trivially copyable");
+			if (m_Size - m_Offset < sizeof(T)) {
+				return false;
+			}
+			memcpy(&value, m_Data + m_Offset, sizeof(T));
+			m_Offset += sizeof(T);
+			return true;
+		}
+
+		bool AtEnd() const { return m_Offset == m_Size; }
+
+	private:
+		const unsigned char* m_Data;
+		size_t m_Size;
+		size_t m_Offset = 0;
+	};
+
+	// FNV-1a, enough to reject a truncated or partially written file.
+	unsigned long long Checksum(const unsigned char* data, size_t size) {
+		unsigned long long hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ data[i]) * 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	unsigned PackFeatures(const LOGICAL_PROCESSOR_INFO& core) {
+		unsigned flags[] = {
+			core.SSE, core.AVX, core.AVX2, core.AVX512, core.AVX512F, core.AVX512DQ, core.AVX512PF,
+			core.AVX512ER, core.AVX512CD, core.AVX512BW, core.AVX512VL, core.AVX512_IFMA, core.AVX512_VBMI,
+			core.AVX512_VBMI2, core.AVX512_VNNI, core.AVX512_BITALG, core.AVX512_VPOPCNTDQ, core.AVX512_4VNNIW,
+			core.AVX512_4FMAPS, core.AVX512_VP2INTERSECT, core.SGX, core.SHA
+		};
+
+		unsigned packed = 0;
+		for (unsigned i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+			packed |= (flags[i] & 1u) << i;
+		}
+		return packed;
+	}
+
+	void UnpackFeatures(unsigned packed, LOGICAL_PROCESSOR_INFO& core) {
+		unsigned bit = 0;
+		core.SSE = (packed >> bit++) & 1u;
+		core.AVX = (packed >> bit++) & 1u;
+		core.AVX2 = (packed >> bit++) & 1u;
+		core.AVX512 = (packed >> bit++) & 1u;
+		core.AVX512F = (packed >> bit++) & 1u;
+		core.AVX512DQ = (packed >> bit++) & 1u;
+		core.AVX512PF = (packed >> bit++) & 1u;
+		core.AVX512ER = (packed >> bit++) & 1u;
+		core.AVX512CD = (packed >> bit++) & 1u;
+		core.AVX512BW = (packed >> bit++) & 1u;
+		core.AVX512VL = (packed >> bit++) & 1u;
+		core.AVX512_IFMA = (packed >> bit++) & 1u;
+		core.AVX512_VBMI = (packed >> bit++) & 1u;
+		core.AVX512_VBMI2 = (packed >> bit++) & 1u;
+		core.AVX512_VNNI = (packed >> bit++) & 1u;
+		core.AVX512_BITALG = (packed >> bit++) & 1u;
+		core.AVX512_VPOPCNTDQ = (packed >> bit++) & 1u;
+		core.AVX512_4VNNIW = (packed >> bit++) & 1u;
+		core.AVX512_4FMAPS = (packed >> bit++) & 1u;
+		core.AVX512_VP2INTERSECT = (packed >> bit++) & 1u;
+		core.SGX = (packed >> bit++) & 1u;
+		core.SHA = (packed >> bit++) & 1u;
+	}
+
+	bool SameKey(const TopologyCacheKey& a, const TopologyCacheKey& b) {
+		return memcmp(a.brand, b.brand, sizeof(a.brand)) == 0 && a.microcode == b.microcode
+			&& a.osBuild == b.osBuild && a.osRevision == b.osRevision && a.processorCount == b.processorCount;
+	}
+
+	TopologyCacheKey ReadTopologyCacheKey() {
+		TopologyCacheKey key;
+
+		std::array<unsigned, 4> cpuInfo;
+		CallCPUID(LEAF_EXTENDED_BRAND_STRING_1, cpuInfo);
+		memcpy(key.brand + 0, cpuInfo.data(), sizeof(cpuInfo));
+		CallCPUID(LEAF_EXTENDED_BRAND_STRING_2, cpuInfo);
+		memcpy(key.brand + 16, cpuInfo.data(), sizeof(cpuInfo));
+		CallCPUID(LEAF_EXTENDED_BRAND_STRING_3, cpuInfo);
+		memcpy(key.brand + 32, cpuInfo.data(), sizeof(cpuInfo));
+
+		// The microcode revision the OS loaded, in the high dword of "Update Revision"
+		DWORD size = sizeof(key.microcode);
+		RegGetValueW(HKEY_LOCAL_MACHINE, L"HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0",
+			L"Update Revision", RRF_RT_REG_BINARY, NULL, &key.microcode, &size);
+
+		wchar_t build[16] = {};
+		size = sizeof(build);
+		if (RegGetValueW(HKEY_LOCAL_MACHINE, L"SOFTWARE\\Microsoft\\Windows NT\\CurrentVersion",
+			L"CurrentBuildNumber", RRF_RT_REG_SZ, NULL, build, &size) == ERROR_SUCCESS) {
+			key.osBuild = static_cast<unsigned>(wcstoul(build, nullptr, 10));
+		}
+
+		DWORD revision = 0;
+		size = sizeof(revision);
+		RegGetValueW(HKEY_LOCAL_MACHINE, L"SOFTWARE\\Microsoft\\Windows NT\\CurrentVersion",
+			L"UBR", RRF_RT_REG_DWORD, NULL, &revision, &size);
+		key.osRevision = revision;
+
+		key.processorCount = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+		return key;
+	}
+
+	std::wstring DefaultTopologyCachePath() {
+		wchar_t localAppData[MAX_PATH];
+		DWORD length = GetEnvironmentVariableW(L"LOCALAPPDATA", localAppData, MAX_PATH);
+		if (length == 0 || length >= MAX_PATH) {
+			return std::wstring();
+		}
+		return std::wstring(localAppData) + L"\\EnergyPerformance\\ApplicationData\\TopologyCache.bin";
+	}
+
+	bool LoadTopologyCache(const std::wstring& path, const TopologyCacheKey& key, PROCESSOR_INFO& procInfo) {
+		if (path.empty()) {
+			return false;
+		}
+
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		// the cache is a few kilobytes even on large systems
+		std::vector<unsigned char> buffer(64 * 1024);
+		DWORD read = 0;
+		BOOL success = ReadFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), &read, NULL);
+		CloseHandle(file);
+		if (!success || read < sizeof(unsigned long long) || read == buffer.size()) {
+			return false;
+		}
+
+		size_t payloadSize = read - sizeof(unsigned long long);
+		unsigned long long checksum;
+		memcpy(&checksum, buffer.data() + payloadSize, sizeof(checksum));
+		if (checksum != Checksum(buffer.data(), payloadSize)) {
+			return false;
+		}
+
+		CacheReader reader(buffer.data(), payloadSize);
+		unsigned magic = 0, version = 0;
+		TopologyCacheKey cachedKey;
+		if (!reader.Get(magic) || !reader.Get(version) || magic != cacheMagic || version != cacheVersion
+			|| !reader.Get(cachedKey) || !SameKey(cachedKey, key)) {
+			return false;
+		}
+
+		unsigned char flags = 0;
+		unsigned groupCount = 0, nodeCount = 0, cacheCount = 0, coreCount = 0;
+		bool valid = reader.Get(procInfo.vendorID) && reader.Get(procInfo.brandString)
+			&& reader.Get(procInfo.numGroups) && reader.Get(procInfo.numNUMANodes)
+			&& reader.Get(procInfo.numProcessorPackages) && reader.Get(procInfo.numPhysicalCores)
+			&& reader.Get(procInfo.numLogicalCores) && reader.Get(procInfo.numL1Caches)
+			&& reader.Get(procInfo.numL2Caches) && reader.Get(procInfo.numL3Caches)
+			&& reader.Get(procInfo.osMajorVersion) && reader.Get(procInfo.osMinorVersion)
+			&& reader.Get(procInfo.osBuildNumber) && reader.Get(flags);
+		procInfo.hybrid = (flags & 1) != 0;
+		procInfo.turboBoost = (flags & 2) != 0;
+		procInfo.turboBoost3_0 = (flags & 4) != 0;
+
+		valid = valid && reader.Get(groupCount);
+		for (unsigned i = 0; valid && i < groupCount; i++) {
+			GROUP_INFO group;
+			valid = reader.Get(group);
+			procInfo.groups.push_back(group);
+		}
+
+		valid = valid && reader.Get(nodeCount);
+		for (unsigned i = 0; valid && i < nodeCount; i++) {
+			NUMA_NODE_INFO node;
+			valid = reader.Get(node);
+			procInfo.nodes.push_back(node);
+		}
+
+		valid = valid && reader.Get(cacheCount);
+		for (unsigned i = 0; valid && i < cacheCount; i++) {
+			CACHE_INFO cache;
+			ULONG64 mask = 0;
+			valid = reader.Get(cache.group) && reader.Get(mask) && reader.Get(cache.level) && reader.Get(cache.size)
+				&& reader.Get(cache.lineSize) && reader.Get(cache.type) && reader.Get(cache.associativity);
+			cache.processorMask = std::bitset<64>(mask);
+			procInfo.caches.push_back(cache);
+		}
+
+		procInfo.coreMasks.clear();
+		procInfo.cpuSets.clear();
+		valid = valid && reader.Get(coreCount);
+		for (unsigned i = 0; valid && i < coreCount; i++) {
+			LOGICAL_PROCESSOR_INFO core;
+			ULONG64 mask = 0;
+			unsigned features = 0, coreType = 0;
+			valid = reader.Get(core.id) && reader.Get(core.group) && reader.Get(core.node) && reader.Get(core.coreIndex)
+				&& reader.Get(core.logicalProcessorIndex) && reader.Get(mask) && reader.Get(core.baseFrequency)
+				&& reader.Get(core.maximumFrequency) && reader.Get(core.busFrequency) && reader.Get(features)
+				&& reader.Get(core.efficiencyClass) && reader.Get(core.schedulingClass) && reader.Get(coreType);
+			core.processorMask = std::bitset<64>(mask);
+			core.coreType = static_cast<CoreTypes>(coreType);
+			UnpackFeatures(features, core);
+
+			// parking and allocation are run-time state and are not cached
+			core.parked = 0;
+			core.allocated = 0;
+			core.allocatedToTargetProcess = 0;
+			core.realTime = 0;
+			procInfo.cores.push_back(core);
+
+			// rebuilt the same way GetProcessorInfo fills them
+			procInfo.coreMasks[CoreTypes::ANY] |= mask;
+			procInfo.coreMasks[core.coreType] |= mask;
+			procInfo.cpuSets[CoreTypes::ANY].push_back(core.id);
+			procInfo.cpuSets[core.coreType].push_back(core.id);
+		}
+
+		return valid && reader.AtEnd();
+	}
+
+	bool SaveTopologyCache(const std::wstring& path, const TopologyCacheKey& key, const PROCESSOR_INFO& procInfo) {
+		if (path.empty() || procInfo.cores.empty()) {
+			return false;
+		}
+
+		CacheWriter writer;
+		writer.Put(cacheMagic);
+		writer.Put(cacheVersion);
+		writer.Put(key);
+
+		writer.Put(procInfo.vendorID);
+		writer.Put(procInfo.brandString);
+		writer.Put(procInfo.numGroups);
+		writer.Put(procInfo.numNUMANodes);
+		writer.Put(procInfo.numProcessorPackages);
+		writer.Put(procInfo.numPhysicalCores);
+		writer.Put(procInfo.numLogicalCores);
+		writer.Put(procInfo.numL1Caches);
+		writer.Put(procInfo.numL2Caches);
+		writer.Put(procInfo.numL3Caches);
+		writer.Put(procInfo.osMajorVersion);
+		writer.Put(procInfo.osMinorVersion);
+		writer.Put(procInfo.osBuildNumber);
+		unsigned char flags = (procInfo.hybrid ? 1 : 0) | (procInfo.turboBoost ? 2 : 0) | (procInfo.turboBoost3_0 ? 4 : 0);
+		writer.Put(flags);
+
+		writer.Put(static_cast<unsigned>(procInfo.groups.size()));
+		for (const GROUP_INFO& group : procInfo.groups) {
+			writer.Put(group);
+		}
+
+		writer.Put(static_cast<unsigned>(procInfo.nodes.size()));
+		for (const NUMA_NODE_INFO& node : procInfo.nodes) {
+			writer.Put(node);
+		}
+
+		writer.Put(static_cast<unsigned>(procInfo.caches.size()));
+		for (const CACHE_INFO& cache : procInfo.caches) {
+			writer.Put(cache.group);
+			writer.Put(static_cast<ULONG64>(cache.processorMask.to_ullong()));
+			writer.Put(cache.level);
+			writer.Put(cache.size);
+			writer.Put(cache.lineSize);
+			writer.Put(cache.type);
+			writer.Put(cache.associativity);
+		}
+
+		// current frequencies and power state change at run time and are not cached
+		writer.Put(static_cast<unsigned>(procInfo.cores.size()));
+		for (const LOGICAL_PROCESSOR_INFO& core : procInfo.cores) {
+			writer.Put(core.id);
+			writer.Put(core.group);
+			writer.Put(core.node);
+			writer.Put(core.coreIndex);
+			writer.Put(core.logicalProcessorIndex);
+			writer.Put(static_cast<ULONG64>(core.processorMask.to_ullong()));
+			writer.Put(core.baseFrequency);
+			writer.Put(core.maximumFrequency);
+			writer.Put(core.busFrequency);
+			writer.Put(PackFeatures(core));
+			writer.Put(core.efficiencyClass);
+			writer.Put(core.schedulingClass);
+			writer.Put(static_cast<unsigned>(core.coreType));
+		}
+
+		std::vector<unsigned char>& buffer = writer.Buffer();
+		unsigned long long checksum = Checksum(buffer.data(), buffer.size());
+		writer.Put(checksum);
+
+		// write beside the cache and swap it in, so a reader never sees a partial file
+		for (size_t separator = path.find(L'\\', 3); separator != std::wstring::npos; separator = path.find(L'\\', separator + 1)) {
+			CreateDirectoryW(path.substr(0, separator).c_str(), NULL);
+		}
+
+		std::wstring temporaryPath = path + L".tmp";
+		HANDLE file = CreateFileW(temporaryPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		DWORD written = 0;
+		BOOL success = WriteFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), &written, NULL);
+		CloseHandle(file);
+		if (!success || written != buffer.size()) {
+			DeleteFileW(temporaryPath.c_str());
+			return false;
+		}
+		return MoveFileExW(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) == TRUE;
+	}
+}
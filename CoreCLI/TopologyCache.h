@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+
+struct _PROCESSOR_INFO;
+struct _LOGICAL_PROCESSOR_INFO;
+
+namespace Core
+{
+    // Identifies the hardware and OS build a cached topology was detected on. Reading the
+    // key is cheap compared to detection, which runs CPUID on every logical processor.
+    struct TopologyCacheKey
+    {
+        char brand[64] = {};
+        unsigned long long microcode = 0;
+        unsigned osBuild = 0;
+        unsigned osRevision = 0;
+        unsigned processorCount = 0;
+    };
+
+    TopologyCacheKey ReadTopologyCacheKey();
+
+    // %LOCALAPPDATA%\EnergyPerformance\ApplicationData\TopologyCache.bin
+    std::wstring DefaultTopologyCachePath();
+
+    // Fills procInfo from the cache at path. Fails when the file is missing, corrupt,
+    // written by another format version or detected under a different key.
+    bool LoadTopologyCache(const std::wstring& path, const TopologyCacheKey& key, _PROCESSOR_INFO& procInfo);
+    bool SaveTopologyCache(const std::wstring& path, const TopologyCacheKey& key, const _PROCESSOR_INFO& procInfo);
+
+    // CPUID feature flags of a logical processor as bits in CoreFeature order.
+    unsigned PackFeatures(const _LOGICAL_PROCESSOR_INFO& core);
+}
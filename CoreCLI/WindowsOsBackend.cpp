@@ -0,0 +1,350 @@
+#include "OsBackend.h"
+
+#include "HybridDetect.h"
+#include <windows.h>
+#include <TlHelp32.h>
+#include <cwchar>
+#include "CoreFeatureTable.h"
+#include "TopologyCache.h"
+
+namespace Core
+{
+	// Enough to set affinity, CPU sets and priority, read the creation time and wait for exit.
+	const DWORD handleAccess = PROCESS_SET_INFORMATION | PROCESS_SET_LIMITED_INFORMATION
+		| PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE;
+
+	OsStatus LastErrorStatus() {
+		return GetLastError() == ERROR_ACCESS_DENIED ? OsStatus::AccessDenied : OsStatus::Failed;
+	}
+
+	// Classifies each logical processor from the data collected by GetProcessorInfo.
+	// Where CPUID reports a hybrid core type it decides the class. Otherwise the highest
+	// efficiency class marks the P-cores, so a system with a single class has no E-cores.
+	std::vector<LogicalCore> ReadLogicalCores(const PROCESSOR_INFO& procInfo) {
+		unsigned highestClass = 0;
+		for (const LOGICAL_PROCESSOR_INFO& core : procInfo.cores) {
+			if (core.efficiencyClass > highestClass) {
+				highestClass = core.efficiencyClass;
+			}
+		}
+
+		std::vector<LogicalCore> logicalCores;
+		logicalCores.reserve(procInfo.cores.size());
+		for (const LOGICAL_PROCESSOR_INFO& core : procInfo.cores) {
+			LogicalCore logicalCore;
+			logicalCore.group = static_cast<unsigned short>(core.group);
+			logicalCore.index = static_cast<unsigned char>(core.logicalProcessorIndex);
+			logicalCore.coreIndex = static_cast<unsigned char>(core.coreIndex);
+			logicalCore.efficiencyClass = static_cast<unsigned char>(core.efficiencyClass);
+			logicalCore.cpuSetId = core.id;
+
+			if (procInfo.hybrid && core.coreType == CoreTypes::INTEL_ATOM) {
+				logicalCore.coreClass = CoreClass::Efficiency;
+			}
+			else if (procInfo.hybrid && core.coreType == CoreTypes::INTEL_CORE) {
+				logicalCore.coreClass = CoreClass::Performance;
+			}
+			else {
+				logicalCore.coreClass = core.efficiencyClass == highestClass ? CoreClass::Performance : CoreClass::Efficiency;
+			}
+			logicalCores.push_back(logicalCore);
+		}
+		return logicalCores;
+	}
+
+	// Finds the one processor group a process runs in. A process whose threads span several
+	// groups, which Windows 11 allows, has no single group and leaves spanning set.
+	OsStatus ProcessGroup(HANDLE hProcess, unsigned groupCount, USHORT& group, bool& spanning) {
+		group = 0;
+		spanning = false;
+		if (groupCount <= 1) {
+			return OsStatus::Ok;
+		}
+
+		USHORT groups[CpuMask::MaxGroups] = {};
+		USHORT count = CpuMask::MaxGroups;
+		if (!GetProcessGroupAffinity(hProcess, &count, groups)) {
+			return LastErrorStatus();
+		}
+		group = groups[0];
+		spanning = count > 1;
+		return OsStatus::Ok;
+	}
+
+	// Restricts a process to mask with a hard affinity. SetProcessAffinityMask only addresses
+	// the group the process runs in, and the CPU set masks that reach other groups are only a
+	// preference, so a mask with cores outside that group is Unsupported rather than applied softly.
+	OsStatus SetProcessMask(HANDLE hProcess, const CpuMask& mask, unsigned groupCount) {
+		if (mask.Empty()) {
+			return OsStatus::Failed;
+		}
+
+		USHORT group;
+		bool spanning;
+		OsStatus status = ProcessGroup(hProcess, groupCount, group, spanning);
+		if (status != OsStatus::Ok) {
+			return status;
+		}
+		if (spanning) {
+			return OsStatus::Unsupported;
+		}
+		for (unsigned other = 0; other < mask.GroupSpan(); other++) {
+			if (other != group && mask.Group(other) != 0) {
+				return OsStatus::Unsupported;
+			}
+		}
+		return SetProcessAffinityMask(hProcess, static_cast<DWORD_PTR>(mask.Group(group))) ? OsStatus::Ok : LastErrorStatus();
+	}
+
+	// Lifts a hard mask left by an earlier apply, giving the process every core of its group.
+	// A process spanning groups cannot hold one, as SetProcessMask never sets it there.
+	OsStatus ResetProcessMask(HANDLE hProcess, const CpuMask& allMask, unsigned groupCount) {
+		USHORT group;
+		bool spanning;
+		OsStatus status = ProcessGroup(hProcess, groupCount, group, spanning);
+		if (status != OsStatus::Ok || spanning) {
+			return status;
+		}
+		return SetProcessAffinityMask(hProcess, static_cast<DWORD_PTR>(allMask.Group(group))) ? OsStatus::Ok : LastErrorStatus();
+	}
+
+	// Toolhelp snapshots, process handles and CPU sets. The processor info of the last
+	// detection backs the thread-level CPU set calls.
+	class WindowsOsBackend : public OsBackend
+	{
+	public:
+		bool DetectTopology(bool allowCached, std::vector<ProcessorDescription>& processors) override
+		{
+			// detection pins a thread to every logical processor in turn, the cache avoids it
+			// unless the CPU, microcode or OS build has changed
+			m_ProcessorInfo.reset(new PROCESSOR_INFO());
+			if (!allowCached || !LoadTopologyCache(DefaultTopologyCachePath(), ReadTopologyCacheKey(), *m_ProcessorInfo)) {
+				m_ProcessorInfo.reset(new PROCESSOR_INFO());
+				GetProcessorInfo(*m_ProcessorInfo);
+				SaveTopologyCache(DefaultTopologyCachePath(), ReadTopologyCacheKey(), *m_ProcessorInfo);
+			}
+
+			std::vector<LogicalCore> logicalCores = ReadLogicalCores(*m_ProcessorInfo);
+			processors.clear();
+			processors.reserve(logicalCores.size());
+			for (size_t i = 0; i < logicalCores.size(); i++) {
+				const LOGICAL_PROCESSOR_INFO& core = m_ProcessorInfo->cores[i];
+				ProcessorDescription processor;
+				processor.core = logicalCores[i];
+				processor.features = PackFeatures(core);
+				if (core.parked) processor.features |= FeatureBit(CoreFeature::Parked);
+				if (core.allocated) processor.features |= FeatureBit(CoreFeature::Allocated);
+				if (core.realTime) processor.features |= FeatureBit(CoreFeature::RealTime);
+				processor.coreType = static_cast<unsigned char>(core.coreType);
+				processor.baseMhz = core.baseFrequency;
+				processor.maxMhz = core.maximumFrequency;
+				processors.push_back(processor);
+			}
+			return !processors.empty();
+		}
+
+		bool EnumerateProcesses(ProcessList& processes) override
+		{
+			processes.Clear();
+
+			HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+			if (snapshot == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			PROCESSENTRY32 entry;
+			entry.dwSize = sizeof(PROCESSENTRY32);
+			if (Process32First(snapshot, &entry) == TRUE) {
+				do {
+					processes.Add(entry.th32ProcessID, entry.szExeFile);
+				} while (Process32Next(snapshot, &entry) == TRUE);
+			}
+			CloseHandle(snapshot);
+			return true;
+		}
+
+		OsStatus OpenProcess(unsigned long pid, ProcessHandle& process) override
+		{
+			HANDLE hProcess = ::OpenProcess(handleAccess, FALSE, pid);
+			if (hProcess == NULL) {
+				return LastErrorStatus();
+			}
+
+			FILETIME creationTime, exitTime, kernelTime, userTime;
+			process.creationTime = 0;
+			if (GetProcessTimes(hProcess, &creationTime, &exitTime, &kernelTime, &userTime)) {
+				process.creationTime = (static_cast<unsigned long long>(creationTime.dwHighDateTime) << 32) | creationTime.dwLowDateTime;
+			}
+			process.handle = hProcess;
+			return OsStatus::Ok;
+		}
+
+		bool HasExited(void* handle) override
+		{
+			return WaitForSingleObject(handle, 0) != WAIT_TIMEOUT;
+		}
+
+		void CloseProcess(void* handle) override
+		{
+			CloseHandle(handle);
+		}
+
+		// Far below the per-process handle limit of about 16 million
+		std::size_t MaxCachedHandles() override
+		{
+			return 65536;
+		}
+
+		bool ProcessImagePath(void* handle, std::wstring& path) override
+		{
+			wchar_t buffer[MAX_PATH] = {};
+			DWORD size = MAX_PATH;
+			if (!QueryFullProcessImageNameW(handle, 0, buffer, &size)) {
+				path.clear();
+				return false;
+			}
+			path.assign(buffer, size);
+			return true;
+		}
+
+		OsStatus ApplyPlacement(void* handle, const Placement& placement, bool clearCpuSets, const CpuMask& allMask, unsigned groupCount) override
+		{
+			if (placement.mode == PlacementMode::Hard) {
+				// drop the CPU sets of an earlier soft placement, which would otherwise keep
+				// steering the process within the new mask. The mask still holds if this fails.
+				if (clearCpuSets) {
+					SetProcessDefaultCpuSets(handle, NULL, 0);
+				}
+				return SetProcessMask(handle, placement.mask, groupCount);
+			}
+
+			// a soft placement first widens any hard mask left by an earlier apply to every core,
+			// since the affinity mask would otherwise still confine the process
+			OsStatus status = ResetProcessMask(handle, allMask, groupCount);
+			if (status != OsStatus::Ok) {
+				return status;
+			}
+			BOOL success = SetProcessDefaultCpuSets(handle, placement.cpuSets.empty() ? NULL : placement.cpuSets.data(),
+				static_cast<ULONG>(placement.cpuSets.size()));
+			return success ? OsStatus::Ok : LastErrorStatus();
+		}
+
+		void EndBackgroundMode(void* handle) override
+		{
+			SetPriorityClass(handle, PROCESS_MODE_BACKGROUND_END);
+		}
+
+		bool SetPriority(void* handle, PriorityClass priority) override
+		{
+			switch (priority) {
+			case PriorityClass::Idle: return SetPriorityClass(handle, IDLE_PRIORITY_CLASS) == TRUE;
+			case PriorityClass::BelowNormal: return SetPriorityClass(handle, BELOW_NORMAL_PRIORITY_CLASS) == TRUE;
+			case PriorityClass::Normal: return SetPriorityClass(handle, NORMAL_PRIORITY_CLASS) == TRUE;
+			case PriorityClass::AboveNormal: return SetPriorityClass(handle, ABOVE_NORMAL_PRIORITY_CLASS) == TRUE;
+			case PriorityClass::High: return SetPriorityClass(handle, HIGH_PRIORITY_CLASS) == TRUE;
+			default: return true;
+			}
+		}
+
+		bool SetPowerThrottling(void* handle, PowerThrottling throttling) override
+		{
+			if (throttling == PowerThrottling::Unchanged) {
+				return true;
+			}
+
+			PROCESS_POWER_THROTTLING_STATE state = {};
+			state.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+			state.ControlMask = throttling == PowerThrottling::Auto ? 0 : PROCESS_POWER_THROTTLING_EXECUTION_SPEED;
+			state.StateMask = throttling == PowerThrottling::On ? PROCESS_POWER_THROTTLING_EXECUTION_SPEED : 0;
+			return SetProcessInformation(handle, ProcessPowerThrottling, &state, sizeof(state)) == TRUE;
+		}
+
+		bool SetMemoryPriority(void* handle, MemoryPriority priority) override
+		{
+			if (priority == MemoryPriority::Unchanged) {
+				return true;
+			}
+
+			MEMORY_PRIORITY_INFORMATION info = {};
+			info.MemoryPriority = static_cast<ULONG>(priority);
+			return SetProcessInformation(handle, ProcessMemoryPriority, &info, sizeof(info)) == TRUE;
+		}
+
+		bool EnumerateThreads(unsigned long pid, std::vector<ThreadSample>& threads) override
+		{
+			return Core::EnumerateThreads(pid, threads);
+		}
+
+		bool SetThreadCpus(unsigned long tid, const std::vector<unsigned long>& cpuSets) override
+		{
+			if (!m_ProcessorInfo) {
+				return false;
+			}
+
+			HANDLE thread = OpenThread(THREAD_SET_LIMITED_INFORMATION, FALSE, tid);
+			if (thread == NULL) {
+				return false;
+			}
+			// ULONG is unsigned long, so the ID list is passed as a view without copying
+			bool placed = RunOnCPUSet(*m_ProcessorInfo, thread, cpuSets) == 1;
+			CloseHandle(thread);
+			return placed;
+		}
+
+		bool SetCurrentThreadCpus(const std::vector<unsigned long>& cpuSets) override
+		{
+			return m_ProcessorInfo && RunOnCPUSet(*m_ProcessorInfo, GetCurrentThread(), cpuSets) == 1;
+		}
+
+		bool ReadTextFile(const wchar_t* path, std::wstring& text) override
+		{
+			HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			std::string contents;
+			char buffer[4096];
+			DWORD read = 0;
+			while (ReadFile(file, buffer, sizeof(buffer), &read, NULL) && read > 0) {
+				contents.append(buffer, read);
+			}
+			CloseHandle(file);
+
+			text.assign(contents.size(), L'\0');
+			int length = MultiByteToWideChar(CP_UTF8, 0, contents.data(), static_cast<int>(contents.size()), &text[0], static_cast<int>(text.size()));
+			text.resize(length > 0 ? length : 0);
+			return true;
+		}
+
+		bool WriteTextFile(const wchar_t* path, const std::string& text) override
+		{
+			bool pipe = wcsncmp(path, L"\\\\.\\pipe\\", 9) == 0;
+			std::wstring target = pipe ? std::wstring(path) : std::wstring(path) + L".tmp";
+			HANDLE file = CreateFileW(target.c_str(), GENERIC_WRITE, 0, NULL, pipe ? OPEN_EXISTING : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			DWORD written = 0;
+			bool ok = WriteFile(file, text.data(), static_cast<DWORD>(text.size()), &written, NULL) && written == text.size();
+			CloseHandle(file);
+			if (pipe) {
+				return ok;
+			}
+			if (!ok || !MoveFileExW(target.c_str(), path, MOVEFILE_REPLACE_EXISTING)) {
+				DeleteFileW(target.c_str());
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		std::unique_ptr<PROCESSOR_INFO> m_ProcessorInfo;
+	};
+
+	std::unique_ptr<OsBackend> CreateOsBackend()
+	{
+		return std::unique_ptr<OsBackend>(new WindowsOsBackend());
+	}
+}
@@ -0,0 +1,72 @@
+#include "WorkerPool.h"
+
+namespace Core
+{
+	WorkerPool::WorkerPool(unsigned workers)
+	{
+		m_Threads.reserve(workers);
+		for (unsigned i = 0; i < workers; i++) {
+			m_Threads.emplace_back(&WorkerPool::WorkerLoop, this, i);
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_WorkReady.notify_all();
+
+		for (std::thread& thread : m_Threads) {
+			thread.join();
+		}
+	}
+
+	unsigned WorkerPool::Size() const
+	{
+		return static_cast<unsigned>(m_Threads.size());
+	}
+
+	std::thread::native_handle_type WorkerPool::NativeHandle(unsigned worker)
+	{
+		return m_Threads[worker].native_handle();
+	}
+
+	void WorkerPool::Run(const std::function<void(unsigned)>& task)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Task = &task;
+		m_Pending = Size();
+		m_Generation++;
+		m_WorkReady.notify_all();
+
+		m_WorkDone.wait(lock, [this] { return m_Pending == 0; });
+		m_Task = nullptr;
+	}
+
+	void WorkerPool::WorkerLoop(unsigned worker)
+	{
+		unsigned seenGeneration = 0;
+
+		for (;;) {
+			const std::function<void(unsigned)>* task;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_WorkReady.wait(lock, [&] { return m_Stopping || m_Generation != seenGeneration; });
+				if (m_Stopping) {
+					return;
+				}
+				seenGeneration = m_Generation;
+				task = m_Task;
+			}
+
+			(*task)(worker);
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (--m_Pending == 0) {
+				m_WorkDone.notify_one();
+			}
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Core
+{
+    // Fixed set of worker threads that run one task on every worker and wait for all
+    // of them to finish. Workers are long-lived so they can be pinned once when created.
+    class WorkerPool
+    {
+    public:
+        explicit WorkerPool(unsigned workers);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        unsigned Size() const;
+        std::thread::native_handle_type NativeHandle(unsigned worker);
+
+        // Runs task(workerIndex) on every worker and blocks until all have returned.
+        void Run(const std::function<void(unsigned)>& task);
+
+    private:
+        void WorkerLoop(unsigned worker);
+
+        std::vector<std::thread> m_Threads;
+        std::mutex m_Mutex;
+        std::condition_variable m_WorkReady;
+        std::condition_variable m_WorkDone;
+        const std::function<void(unsigned)>* m_Task = nullptr;
+        unsigned m_Generation = 0;
+        unsigned m_Pending = 0;
+        bool m_Stopping = false;
+    };
+}
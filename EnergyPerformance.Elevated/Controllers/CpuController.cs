@@ -12,6 +12,14 @@ namespace EnergyPerformance.Elevated.Controllers
             _controller = new ManagedController();
         }
         
+        /// <summary>
+        /// Shares a controller that is also called directly, so both see the same native state.
+        /// </summary>
+        public CpuController(ManagedController controller)
+        {
+            _controller = controller;
+        }
+        
         public void MoveAllAppsToEfficiencyCores()
         {
             _controller.MoveAllAppsToEfficiencyCores();
@@ -22,14 +30,117 @@ namespace EnergyPerformance.Elevated.Controllers
             _controller.MoveAllAppsToSomeEfficiencyCores();
         }
         
-        public bool MoveAppToHybridCores(string target, int eCores, int pCores) 
+        public bool MoveAppToHybridCores(string target, int eCores, int pCores, PlacementMode mode = PlacementMode.Hard) 
+        {
+            return _controller.MoveAppToHybridCores(target, eCores, pCores, mode);
+        }
+        
+        public bool[] MoveAppsToHybridCores(string[] targets, int[] eCores, int[] pCores)
+        {
+            return _controller.MoveAppsToHybridCores(targets, eCores, pCores);
+        }
+        
+        public int PlaceAppThreads(string target, double performanceShare, int maxPerformanceThreads)
+        {
+            return _controller.PlaceAppThreads(target, performanceShare, maxPerformanceThreads);
+        }
+        
+        public bool WatchApp(string target, int eCores, int pCores)
+        {
+            return _controller.WatchApp(target, eCores, pCores);
+        }
+        
+        public void UnwatchApp(string target)
+        {
+            _controller.UnwatchApp(target);
+        }
+        
+        public bool LoadPlacementPolicy(string path)
+        {
+            return _controller.LoadPlacementPolicy(path);
+        }
+        
+        public int ApplyPlacementPolicy()
+        {
+            return _controller.ApplyPlacementPolicy();
+        }
+        
+        /// <summary>
+        /// Samples every process and returns the busiest as "pid:cores" pairs separated by spaces,
+        /// measured over the time since the previous call.
+        /// </summary>
+        public string TopCpuProcesses(int count)
+        {
+            if (!_controller.SampleProcessCpu() || count <= 0)
+            {
+                return string.Empty;
+            }
+
+            var pids = new uint[count];
+            var utilization = new float[count];
+            var found = _controller.TopProcessCpu(pids, utilization);
+            var pairs = new string[found];
+            for (var i = 0; i < found; i++)
+            {
+                pairs[i] = FormattableString.Invariant($"{pids[i]}:{utilization[i]}");
+            }
+            return string.Join(" ", pairs);
+        }
+        
+        /// <summary>
+        /// Estimates the energy of every process since the previous call and returns the processes that
+        /// used any as "pid:joules" pairs separated by spaces.
+        /// </summary>
+        public string ProcessEnergy(double packageWatts)
+        {
+            if (!_controller.SampleEnergy(packageWatts))
+            {
+                return string.Empty;
+            }
+
+            var capacity = _controller.ProcessCpuCount();
+            var pids = new uint[capacity];
+            var joules = new float[capacity];
+            var count = _controller.CopyProcessEnergy(pids, joules);
+            var pairs = new List<string>();
+            for (var i = 0; i < count; i++)
+            {
+                if (joules[i] > 0)
+                {
+                    pairs.Add(FormattableString.Invariant($"{pids[i]}:{joules[i]}"));
+                }
+            }
+            return string.Join(" ", pairs);
+        }
+        
+        public void SetEnergyCoefficients(double eCoreWatts, double pCoreWatts, double exponent, double baseWatts)
+        {
+            _controller.SetEnergyCoefficients(eCoreWatts, pCoreWatts, exponent, baseWatts);
+        }
+        
+        public void StartAdaptivePlacement(double promoteAbove, double demoteBelow, int minDwellMs, int intervalMs)
+        {
+            _controller.StartAdaptivePlacement(promoteAbove, demoteBelow, minDwellMs, intervalMs);
+        }
+        
+        public void StopAdaptivePlacement()
+        {
+            _controller.StopAdaptivePlacement();
+        }
+        
+        public bool AdaptApp(string target)
+        {
+            return _controller.AdaptApp(target);
+        }
+        
+        public void StopAdaptingApp(string target)
         {
-            return _controller.MoveAppToHybridCores(target, eCores, pCores);
+            _controller.StopAdaptingApp(target);
         }
         
-        public void MoveAllAppsToHybridCores(int eCores, int pCores)
+        public void MoveAllAppsToHybridCores(int eCores, int pCores, PlacementMode mode = PlacementMode.Hard)
         {
-            _controller.MoveAllAppsToHybridCores(eCores, pCores);
+            _controller.MoveAllAppsToHybridCores(eCores, pCores, mode);
         }
         
         public void ResetToDefaultCores()
@@ -1,12 +1,36 @@
 ﻿using System;
+using System.Threading;
 using System.Threading.Tasks;
 using CLI;
+using EnergyPerformance.Elevated.Controllers;
 
 namespace EnergyPerformance.Elevated.MessageHandlers;
 
 public class CpuHandler: MessageHandler
 {
     private readonly ManagedController _controller = new();
+    // formats the sampler reports on top of _controller
+    private readonly CpuController _reports;
+    // cancels the applies queued or running when CancelApplies arrives
+    private CancellationTokenSource _applies = new();
+
+    public CpuHandler()
+    {
+        _reports = new CpuController(_controller);
+
+        // Watched apps are bound as soon as they start, falling back to explicit applies
+        // if process events are unavailable
+        if (!_controller.StartProcessEvents())
+        {
+            Console.WriteLine("Process events unavailable");
+        }
+
+        // High-rate clients send binary command batches here instead of text messages
+        if (!_controller.StartCommandServer(@"\\.\pipe\EnergyPerformanceCommands"))
+        {
+            Console.WriteLine("Command server unavailable");
+        }
+    }
     
     public string? HandleMessage(string message)
     {
@@ -17,20 +41,87 @@ public class CpuHandler: MessageHandler
 
         switch (command)
         {
+            // Applies and the settings that shape them are queued so the pipe thread answers at
+            // once instead of waiting for a running apply, and run in the order they arrived.
+            // A later persona switch replaces one that has not started yet
             case "MoveAllAppsToEfficiencyCores":
-                _controller.MoveAllAppsToEfficiencyCores();
+                Observe(_controller.MoveAllAppsToEfficiencyCoresAsync(_applies.Token));
                 break;
             case "MoveAllAppsToSomeEfficiencyCores":
-                _controller.MoveAllAppsToSomeEfficiencyCores();
+                Observe(_controller.MoveAllAppsToSomeEfficiencyCoresAsync(_applies.Token));
+                break;
+            case "CancelApplies":
+                _applies.Cancel();
+                _applies.Dispose();
+                _applies = new CancellationTokenSource();
                 break;
             case "MoveAppToHybridCores":
-                _controller.MoveAppToHybridCores(args[1], int.Parse(args[2]), int.Parse(args[3]));
+                Observe(_controller.MoveAppToHybridCoresAsync(args[1], int.Parse(args[2]), int.Parse(args[3]), ParseMode(args, 4), _applies.Token),
+                    $"No instance of {args[1]} was bound");
+                break;
+            case "MoveAppsToHybridCores":
+                var fields = message.Length > command.Length ? message.Substring(command.Length + 1) : "";
+                if (!HybridCoreBatch.TryParse(fields, out var targets, out var eCores, out var pCores))
+                {
+                    response = null;
+                    break;
+                }
+                var results = _controller.MoveAppsToHybridCores(targets, eCores, pCores);
+                response = string.Join(" ", Array.ConvertAll(results, r => r ? "true" : "false"));
+                break;
+            case "PlaceAppThreads":
+                // "<target> <performanceShare> <maxPerformanceThreads>"
+                var placed = _controller.PlaceAppThreads(args[1],
+                    double.Parse(args[2], System.Globalization.CultureInfo.InvariantCulture), int.Parse(args[3]));
+                response = placed.ToString();
+                break;
+            case "WatchApp":
+                // settings are not applies, so CancelApplies leaves them queued
+                Observe(_controller.WatchAppAsync(args[1], int.Parse(args[2]), int.Parse(args[3]), ParseMode(args, 4), CancellationToken.None),
+                    $"Cannot watch {args[1]} on {args[2]} E-cores and {args[3]} P-cores");
+                break;
+            case "UnwatchApp":
+                // queued too, or it would run before a WatchApp still waiting
+                Observe(_controller.UnwatchAppAsync(args[1], CancellationToken.None));
+                break;
+            case "LoadPlacementPolicy":
+                // the path may contain spaces
+                var path = string.Join(" ", args, 1, args.Length - 1);
+                Observe(_controller.LoadPlacementPolicyAsync(path, CancellationToken.None), $"Cannot load the placement policy {path}");
+                break;
+            case "ApplyPlacementPolicy":
+                Observe(_controller.ApplyPlacementPolicyAsync(_applies.Token));
+                break;
+            case "TopCpuProcesses":
+                response = _reports.TopCpuProcesses(int.Parse(args[1]));
+                break;
+            case "ProcessEnergy":
+                response = _reports.ProcessEnergy(double.Parse(args[1], System.Globalization.CultureInfo.InvariantCulture));
+                break;
+            case "SetEnergyCoefficients":
+                _controller.SetEnergyCoefficients(double.Parse(args[1], System.Globalization.CultureInfo.InvariantCulture),
+                    double.Parse(args[2], System.Globalization.CultureInfo.InvariantCulture),
+                    double.Parse(args[3], System.Globalization.CultureInfo.InvariantCulture),
+                    double.Parse(args[4], System.Globalization.CultureInfo.InvariantCulture));
+                break;
+            case "StartAdaptivePlacement":
+                _controller.StartAdaptivePlacement(double.Parse(args[1], System.Globalization.CultureInfo.InvariantCulture),
+                    double.Parse(args[2], System.Globalization.CultureInfo.InvariantCulture), int.Parse(args[3]), int.Parse(args[4]));
+                break;
+            case "StopAdaptivePlacement":
+                _controller.StopAdaptivePlacement();
+                break;
+            case "AdaptApp":
+                response = _controller.AdaptApp(args[1]) ? "true" : "false";
+                break;
+            case "StopAdaptingApp":
+                _controller.StopAdaptingApp(args[1]);
                 break;
             case "MoveAllAppsToHybridCores":
-                _controller.MoveAllAppsToHybridCores(int.Parse(args[1]), int.Parse(args[2]));
+                Observe(_controller.MoveAllAppsToHybridCoresAsync(int.Parse(args[1]), int.Parse(args[2]), ParseMode(args, 3), _applies.Token));
                 break;
             case "ResetToDefaultCores":
-                _controller.ResetToDefaultCores();
+                Observe(_controller.ResetToDefaultCoresAsync(_applies.Token));
                 break;
             case "DetectCoreCount":
                 _controller.DetectCoreCount();
@@ -54,4 +145,27 @@ public class CpuHandler: MessageHandler
         
         return response;
     }
+
+    // Nobody waits on queued requests, so failures are logged here, and so is rejected when
+    // given and the request completes with 0
+    private static void Observe(Task<int> request, string? rejected = null)
+    {
+        request.ContinueWith(t =>
+        {
+            if (t.IsFaulted)
+            {
+                Console.WriteLine($"Apply failed: {t.Exception?.InnerException?.Message}");
+            }
+            else if (rejected != null && t.IsCompletedSuccessfully && t.Result == 0)
+            {
+                Console.WriteLine(rejected);
+            }
+        });
+    }
+
+    // An optional trailing "soft" selects CPU set placement instead of an affinity mask
+    private static PlacementMode ParseMode(string[] args, int index)
+    {
+        return args.Length > index && args[index] == "soft" ? PlacementMode.Soft : PlacementMode.Hard;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+﻿using System;
+
+namespace EnergyPerformance.Elevated.MessageHandlers;
+
+/// <summary>
+/// Parses the arguments of the MoveAppsToHybridCores message: triples of
+/// "&lt;target&gt;|&lt;eCores&gt;|&lt;pCores&gt;" joined by '|', which no file name contains,
+/// so a target may contain spaces.
+/// </summary>
+public static class HybridCoreBatch
+{
+    /// <summary>
+    /// Returns false, leaving the arrays empty, unless the fields form whole triples with a
+    /// non-empty target and integer core counts.
+    /// </summary>
+    public static bool TryParse(string fields, out string[] targets, out int[] eCores, out int[] pCores)
+    {
+        targets = Array.Empty<string>();
+        eCores = Array.Empty<int>();
+        pCores = Array.Empty<int>();
+
+        var parts = fields.Split('|');
+        if (fields.Length == 0 || parts.Length % 3 != 0)
+        {
+            return false;
+        }
+
+        var count = parts.Length / 3;
+        var parsedTargets = new string[count];
+        var parsedECores = new int[count];
+        var parsedPCores = new int[count];
+        for (var i = 0; i < count; i++)
+        {
+            parsedTargets[i] = parts[i * 3];
+            if (parsedTargets[i].Length == 0 || !int.TryParse(parts[i * 3 + 1], out parsedECores[i]) ||
+                !int.TryParse(parts[i * 3 + 2], out parsedPCores[i]))
+            {
+                return false;
+            }
+        }
+
+        targets = parsedTargets;
+        eCores = parsedECores;
+        pCores = parsedPCores;
+        return true;
+    }
+}
@@ -0,0 +1,44 @@
+﻿using EnergyPerformance.Elevated.MessageHandlers;
+
+namespace EnergyPerformance.Tests.MSTest.MessageHandlers;
+
+[TestClass]
+public class HybridCoreBatchTests
+{
+    [TestMethod]
+    public void TestParsesTriplesWithSpacesInTargets()
+    {
+        Assert.IsTrue(HybridCoreBatch.TryParse("my app.exe|2|4|other.exe|0|8",
+            out var targets, out var eCores, out var pCores));
+
+        CollectionAssert.AreEqual(new[] { "my app.exe", "other.exe" }, targets);
+        CollectionAssert.AreEqual(new[] { 2, 0 }, eCores);
+        CollectionAssert.AreEqual(new[] { 4, 8 }, pCores);
+    }
+
+    [TestMethod]
+    [DataRow("")]
+    [DataRow("app.exe")]
+    [DataRow("app.exe|2")]
+    [DataRow("app.exe|2|4|other.exe")]
+    [DataRow("app.exe|2|4|other.exe|1")]
+    public void TestRejectsIncompleteTriples(string fields)
+    {
+        Assert.IsFalse(HybridCoreBatch.TryParse(fields, out var targets, out var eCores, out var pCores));
+        Assert.AreEqual(0, targets.Length);
+        Assert.AreEqual(0, eCores.Length);
+        Assert.AreEqual(0, pCores.Length);
+    }
+
+    [TestMethod]
+    [DataRow("app.exe|two|4")]
+    [DataRow("app.exe|2|4.5")]
+    [DataRow("app.exe|2|")]
+    [DataRow("app.exe|2|4|other.exe|1|x")]
+    [DataRow("|2|4")]
+    public void TestRejectsNonIntegerCountsAndEmptyTargets(string fields)
+    {
+        Assert.IsFalse(HybridCoreBatch.TryParse(fields, out var targets, out _, out _));
+        Assert.AreEqual(0, targets.Length);
+    }
+}
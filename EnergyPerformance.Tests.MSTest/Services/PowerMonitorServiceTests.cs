@@ -129,4 +129,44 @@ public class PowerMonitorServiceTests
         
     }
 
+    private static (PowerMonitorService, EnergyUsageModel, CpuInfo) GetServiceWithEnergy(List<(int Pid, double Joules)>? energy)
+    {
+        // the elevated process is not running, only the mocked queries may be made
+        var pipeClient = new PipeClient("EnergyPerformanceTestPipe");
+        var controller = new Mock<Controller>(pipeClient);
+        controller.Setup(c => c.ProcessEnergy(It.IsAny<double>())).Returns(energy);
+        var cpuInfo = new CpuInfo(controller.Object);
+        var powerInfo = new PowerInfo { CpuPower = 10 };
+        var model = new EnergyUsageModel(new CarbonIntensityInfo(), new EnergyRateInfo(), _databaseService);
+        var service = new PowerMonitorService(model, powerInfo, cpuInfo, new GpuInfo(), new MonitorController(pipeClient));
+        return (service, model, cpuInfo);
+    }
+
+    [TestMethod]
+    public void TestProcessEnergyUsesNativeEstimates()
+    {
+        var self = Process.GetCurrentProcess();
+        var (service, model, cpuInfo) = GetServiceWithEnergy(new List<(int Pid, double Joules)> { (self.Id, 2.5) });
+        cpuInfo.ProcessesCpuUsage = new Dictionary<string, double> { { self.ProcessName, 50 } };
+
+        service.UpdateProcessEnergy(10);
+        service.AccumulateCpuEnergy();
+
+        Assert.AreEqual(2.5, cpuInfo.ProcessesCpuEnergy[self.ProcessName]);
+        Assert.AreEqual(2.5, model.AccumulatedWattsPerApp[self.ProcessName]);
+    }
+
+    [TestMethod]
+    public void TestProcessEnergyFallsBackToCpuUsage()
+    {
+        var (service, model, cpuInfo) = GetServiceWithEnergy(null);
+        cpuInfo.ProcessesCpuUsage = new Dictionary<string, double> { { "process", 50 } };
+
+        service.UpdateProcessEnergy(10);
+        service.AccumulateCpuEnergy();
+
+        Assert.AreEqual(0, cpuInfo.ProcessesCpuEnergy.Count);
+        Assert.AreEqual(5, model.AccumulatedWattsPerApp["process"]);
+    }
+
 }
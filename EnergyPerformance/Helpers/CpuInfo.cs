@@ -38,10 +38,17 @@ public class CpuInfo
     /// </summary>
     public Dictionary<string, double> ProcessesCpuUsage { get; set; }
 
+    /// <summary>
+    /// The CPU energy, in joules, each process used over the last second, estimated by the native
+    /// attribution engine. Empty when the estimates are not available.
+    /// </summary>
+    public Dictionary<string, double> ProcessesCpuEnergy { get; set; }
+
     public CpuInfo(Controller controller)
     {
         CpuController = controller;
         ProcessesCpuUsage = new Dictionary<string, double>();
+        ProcessesCpuEnergy = new Dictionary<string, double>();
         IsSupported = CheckProcessorIsSupported();
         CpuUsage = 0;
     }
@@ -71,6 +78,21 @@ public class CpuInfo
         CpuController.MoveAppToHybridCores(filename, cpuSetting.Item1, cpuSetting.Item2);
     }
 
+    /// <summary>
+    /// Binds the application to its CPU setting whenever it starts, without waiting for a creation watcher.
+    /// </summary>
+    public virtual void WatchCpuSetting(string path, (int, int) cpuSetting)
+    {
+        var filename = Path.GetFileName(path);
+        CpuController.WatchApp(filename, cpuSetting.Item1, cpuSetting.Item2);
+    }
+
+    public virtual void UnwatchCpuSetting(string path)
+    {
+        var filename = Path.GetFileName(path);
+        CpuController.UnwatchApp(filename);
+    }
+
     public virtual void DisableCpuSetting(string path, (int, int) cpuSetting)
     {
         // Disabling is equivalent to setting affinity to all cores
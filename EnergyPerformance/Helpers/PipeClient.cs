@@ -32,10 +32,21 @@ public class PipeClient
         return response;
     }
     
-    public string? SendAndReceiveMessage(string message)
+    /// <summary>
+    /// Sends the message and reads one line back. With a connectTimeout, in milliseconds, the call
+    /// returns null instead of waiting for a server that is not running.
+    /// </summary>
+    public string? SendAndReceiveMessage(string message, int connectTimeout = Timeout.Infinite)
     {
         using var pipeClient = new NamedPipeClientStream(".", _pipeName, PipeDirection.InOut);
-        pipeClient.Connect();
+        try
+        {
+            pipeClient.Connect(connectTimeout);
+        }
+        catch (TimeoutException)
+        {
+            return null;
+        }
         var writer = new StreamWriter(pipeClient);
         writer.WriteLine(message);
         writer.Flush();
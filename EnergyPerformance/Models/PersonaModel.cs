@@ -71,6 +71,7 @@ public class PersonaModel
         {
             // Add watchers for an existing persona
             _processMonitorService.AddWatcher(persona.Path);
+            _cpuInfo.WatchCpuSetting(persona.Path, persona.CpuSetting);
             Debug.WriteLine($"Registered watcher for {persona.Path}");
 
             var processName = GetProcessName(persona.Path);
@@ -174,6 +175,7 @@ public class PersonaModel
 
             // Add creation and deletion watchers for the application
             _processMonitorService.AddWatcher(personaName);
+            _cpuInfo.WatchCpuSetting(personaName, entry.CpuSetting);
 
             await _personaFileService.SaveFileAsync();
             _nextPersonaId += 1;
@@ -216,6 +218,7 @@ public class PersonaModel
                 
                 _processMonitorService.RemoveWatcher(personaName);
                 _processMonitorService.AddWatcher(personaName);
+                _cpuInfo.WatchCpuSetting(persona.Path, persona.CpuSetting);
             }
         });
         await _personaFileService.SaveFileAsync();
@@ -231,6 +234,7 @@ public class PersonaModel
             return false;
 
         _processMonitorService.RemoveWatcher(personaName);
+        _cpuInfo.UnwatchCpuSetting(personaName);
         var res = _allPersonas.RemoveAll(persona => persona.Path.Equals(personaName, StringComparison.OrdinalIgnoreCase)) > 0;
         await _personaFileService.SaveFileAsync();
         return true;
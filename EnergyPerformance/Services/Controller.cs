@@ -3,8 +3,11 @@ using EnergyPerformance.Helpers;
 
 namespace EnergyPerformance.Services;
 
-public sealed class Controller
+public class Controller
 {
+    // How long a query made on every power sample waits for the elevated process
+    private const int SampleConnectTimeout = 200;
+
     private readonly PipeClient _pipeClient;
     
     public Controller(PipeClient pipeClient)
@@ -24,16 +27,181 @@ public sealed class Controller
         _pipeClient.SendMessage(command);
     }
     
-    public bool MoveAppToHybridCores(string target, int eCores, int pCores) 
+    /// <summary>
+    /// Binds the application to the given cores. A soft placement only sets a preference,
+    /// so the application can still borrow other cores when they are idle. The bind is queued
+    /// behind any apply in progress, and an application that is not running is only logged.
+    /// </summary>
+    public void MoveAppToHybridCores(string target, int eCores, int pCores, bool soft = false) 
+    {
+        var command = $"MoveAppToHybridCores {target} {eCores} {pCores}" + (soft ? " soft" : "");
+        _pipeClient.SendMessage(command);
+    }
+
+    /// <summary>
+    /// Binds several applications in a single request, returning whether each target was bound.
+    /// Fields are separated by '|', which cannot appear in a file name, so names may contain spaces.
+    /// </summary>
+    public bool[] MoveAppsToHybridCores(IReadOnlyList<(string Target, int ECores, int PCores)> targets)
+    {
+        if (targets.Count == 0)
+        {
+            return Array.Empty<bool>();
+        }
+        if (targets.Any(t => t.Target.Contains('|')))
+        {
+            throw new ArgumentException("Target names cannot contain '|'", nameof(targets));
+        }
+
+        var command = "MoveAppsToHybridCores " +
+            string.Join("|", targets.Select(t => $"{t.Target}|{t.ECores}|{t.PCores}"));
+        var response = _pipeClient.SendAndReceiveMessage(command) ?? "";
+        var results = response.Split(' ', StringSplitOptions.RemoveEmptyEntries);
+        return targets.Select((_, i) => i < results.Length && results[i] == "true").ToArray();
+    }
+
+    /// <summary>
+    /// Places the busiest threads of the application on P-cores and the rest on E-cores.
+    /// Returns the number of threads placed.
+    /// </summary>
+    public int PlaceAppThreads(string target, double performanceShare = 0.8, int maxPerformanceThreads = 0)
     {
-        var command = $"MoveAppToHybridCores {target} {eCores} {pCores}";
+        var command = FormattableString.Invariant($"PlaceAppThreads {target} {performanceShare} {maxPerformanceThreads}");
         var response = _pipeClient.SendAndReceiveMessage(command);
+        return int.TryParse(response, out var placed) ? placed : 0;
+    }
+
+    /// <summary>
+    /// Has the elevated process bind the application whenever it starts. Queued like the applies,
+    /// so an invalid core count is only logged by the elevated process.
+    /// </summary>
+    public void WatchApp(string target, int eCores, int pCores, bool soft = false)
+    {
+        var command = $"WatchApp {target} {eCores} {pCores}" + (soft ? " soft" : "");
+        _pipeClient.SendMessage(command);
+    }
+
+    public void UnwatchApp(string target)
+    {
+        var command = $"UnwatchApp {target}";
+        _pipeClient.SendMessage(command);
+    }
+
+    /// <summary>
+    /// Replaces the elevated process's placement rules with those in the policy file.
+    /// Matching apps are then placed as they start, without a call per app. The load is queued
+    /// behind any apply in progress, and a file that cannot be read or parsed is only logged.
+    /// </summary>
+    public void LoadPlacementPolicy(string path)
+    {
+        _pipeClient.SendMessage($"LoadPlacementPolicy {path}");
+    }
+
+    /// <summary>
+    /// Applies the placement rules to every running process, after the requests sent before it.
+    /// </summary>
+    public void ApplyPlacementPolicy()
+    {
+        _pipeClient.SendMessage("ApplyPlacementPolicy");
+    }
+
+    /// <summary>
+    /// The busiest processes since the previous call, busiest first. Utilization is in cores, so it
+    /// is divided by TotalCoreCount for a share of the whole CPU.
+    /// </summary>
+    public List<(int Pid, double Utilization)> TopCpuProcesses(int count)
+    {
+        var processes = new List<(int Pid, double Utilization)>();
+        var response = _pipeClient.SendAndReceiveMessage($"TopCpuProcesses {count}");
+        if (string.IsNullOrEmpty(response))
+        {
+            return processes;
+        }
+
+        foreach (var pair in response.Split(' '))
+        {
+            var parts = pair.Split(':');
+            if (parts.Length == 2 && int.TryParse(parts[0], out var pid)
+                && double.TryParse(parts[1], System.Globalization.NumberStyles.Float, System.Globalization.CultureInfo.InvariantCulture, out var utilization))
+            {
+                processes.Add((pid, utilization));
+            }
+        }
+        return processes;
+    }
+
+    /// <summary>
+    /// Energy each process used since the previous call, in joules, estimated natively from its CPU time
+    /// on each core class and the core frequencies. cpuWatts is the measured CPU package power, which the
+    /// estimates are scaled to; pass a negative value when it is not known. Null when the elevated process
+    /// did not answer in time.
+    /// </summary>
+    public virtual List<(int Pid, double Joules)>? ProcessEnergy(double cpuWatts)
+    {
+        var processes = new List<(int Pid, double Joules)>();
+        var response = _pipeClient.SendAndReceiveMessage(FormattableString.Invariant($"ProcessEnergy {cpuWatts}"), SampleConnectTimeout);
+        if (response == null)
+        {
+            return null;
+        }
+        if (response.Length == 0)
+        {
+            return processes;
+        }
+
+        foreach (var pair in response.Split(' '))
+        {
+            var parts = pair.Split(':');
+            if (parts.Length == 2 && int.TryParse(parts[0], out var pid)
+                && double.TryParse(parts[1], System.Globalization.NumberStyles.Float, System.Globalization.CultureInfo.InvariantCulture, out var joules))
+            {
+                processes.Add((pid, joules));
+            }
+        }
+        return processes;
+    }
+
+    /// <summary>
+    /// Calibrates the energy model: a busy logical processor draws coreWatts * GHz^exponent, and baseWatts
+    /// of the package power is not attributed to any process.
+    /// </summary>
+    public void SetEnergyCoefficients(double eCoreWatts, double pCoreWatts, double exponent, double baseWatts)
+    {
+        _pipeClient.SendMessage(FormattableString.Invariant($"SetEnergyCoefficients {eCoreWatts} {pCoreWatts} {exponent} {baseWatts}"));
+    }
+
+    /// <summary>
+    /// Starts moving adapted applications between E-cores and P-cores by their CPU load. Loads are
+    /// in cores, so 0.5 is half of one core busy.
+    /// </summary>
+    public void StartAdaptivePlacement(double promoteAbove = 0.5, double demoteBelow = 0.1, int minDwellMs = 5000, int intervalMs = 1000)
+    {
+        var command = FormattableString.Invariant($"StartAdaptivePlacement {promoteAbove} {demoteBelow} {minDwellMs} {intervalMs}");
+        _pipeClient.SendMessage(command);
+    }
+
+    public void StopAdaptivePlacement()
+    {
+        _pipeClient.SendMessage("StopAdaptivePlacement");
+    }
+
+    /// <summary>
+    /// Places the application on E-cores and lets adaptive placement promote it while it is busy.
+    /// </summary>
+    public bool AdaptApp(string target)
+    {
+        var response = _pipeClient.SendAndReceiveMessage($"AdaptApp {target}");
         return response == "true";
     }
 
-    public void MoveAllAppsToHybridCores(int eCores, int pCores)
+    public void StopAdaptingApp(string target)
+    {
+        _pipeClient.SendMessage($"StopAdaptingApp {target}");
+    }
+
+    public void MoveAllAppsToHybridCores(int eCores, int pCores, bool soft = false)
     {
-        var command = $"MoveAllAppsToHybridCores {eCores} {pCores}";
+        var command = $"MoveAllAppsToHybridCores {eCores} {pCores}" + (soft ? " soft" : "");
         _pipeClient.SendMessage(command);
     }
 
@@ -56,14 +224,14 @@ public sealed class Controller
         return int.Parse(response);
     }
 
-    public int EfficiencyCoreCount()
+    public virtual int EfficiencyCoreCount()
     {
         var command = "EfficiencyCoreCount";
         var response = _pipeClient.SendAndReceiveMessage(command);
         return int.Parse(response);
     }
 
-    public int PerformanceCoreCount()
+    public virtual int PerformanceCoreCount()
     {
         var command = "PerformanceCoreCount";
         var response = _pipeClient.SendAndReceiveMessage(command                                                                                                                                 );
@@ -1,4 +1,5 @@
-﻿using EnergyPerformance.Contracts.Services;
+﻿using System.Diagnostics;
+using EnergyPerformance.Contracts.Services;
 using EnergyPerformance.Helpers;
 using EnergyPerformance.Models;
 using Microsoft.Extensions.Hosting;
@@ -18,6 +19,7 @@ public class PowerMonitorService : BackgroundService, IPowerMonitorService
     private readonly CpuInfo _cpuInfo;
     private readonly GpuInfo _gpuInfo;
     private readonly MonitorController _monitorController;
+    private readonly Dictionary<int, string> _processNames = new();
     
     private readonly string _localApplicationData = Environment.GetFolderPath(Environment.SpecialFolder.LocalApplicationData);
     private const string _defaultApplicationDataFolder = "EnergyPerformance/ApplicationData";
@@ -88,6 +90,8 @@ public class PowerMonitorService : BackgroundService, IPowerMonitorService
             
             // CPU power usage
             cpuPower = _monitorController.GetCpuPower();
+
+            UpdateProcessEnergy(cpuPower);
         });
 
         Power = cpuPower + gpuPower;
@@ -100,6 +104,49 @@ public class PowerMonitorService : BackgroundService, IPowerMonitorService
         UpdateHourlyUsage(currentDateTime);
     }
 
+    /// <summary>
+    /// Splits the CPU power between processes with the native attribution engine, which weighs each
+    /// process's CPU time by the core type and frequency it ran at. Without an answer from the elevated
+    /// process the estimates are left empty, so the power is split by CPU usage instead.
+    /// </summary>
+    internal void UpdateProcessEnergy(double cpuPower)
+    {
+        var energy = new Dictionary<string, double>();
+        var estimates = _cpuInfo.CpuController?.ProcessEnergy(cpuPower);
+        if (estimates == null)
+        {
+            _cpuInfo.ProcessesCpuEnergy = energy;
+            return;
+        }
+
+        var pids = new HashSet<int>();
+        foreach (var (pid, joules) in estimates)
+        {
+            pids.Add(pid);
+            if (!_processNames.TryGetValue(pid, out var name))
+            {
+                try
+                {
+                    name = Process.GetProcessById(pid).ProcessName;
+                }
+                catch (Exception)
+                {
+                    continue;
+                }
+                _processNames[pid] = name;
+            }
+            energy[name] = energy.GetValueOrDefault(name) + joules;
+        }
+
+        // PIDs that used nothing this second may have exited and been reused
+        foreach (var pid in _processNames.Keys.Where(pid => !pids.Contains(pid)).ToList())
+        {
+            _processNames.Remove(pid);
+        }
+
+        _cpuInfo.ProcessesCpuEnergy = energy;
+    }
+
     /// <summary>
     /// Method to update the daily power usage in the model.
     /// </summary>
@@ -121,13 +168,7 @@ public class PowerMonitorService : BackgroundService, IPowerMonitorService
         {
             _model.AccumulatedWatts += Power;
 
-            // calculate an app's CPU power
-            foreach (var (process, _) in _cpuInfo.ProcessesCpuUsage)
-            {
-                var cpuUsage = _cpuInfo.ProcessesCpuUsage.GetValueOrDefault(process);
-                var accWatts = _model.AccumulatedWattsPerApp.GetValueOrDefault(process);
-                _model.AccumulatedWattsPerApp[process] = accWatts + cpuUsage/100 * CpuPower;
-            }
+            AccumulateCpuEnergy();
 
             // calculate an app's GPU power
             foreach (var (process, _) in _gpuInfo.ProcessesGpuUsage)
@@ -143,13 +184,7 @@ public class PowerMonitorService : BackgroundService, IPowerMonitorService
             _model.CurrentDay = currentDateTime;
             _model.AccumulatedWatts = Power;
 
-            // calculate an app's CPU power
-            foreach (var (process, _) in _cpuInfo.ProcessesCpuUsage)
-            {
-                var cpuUsage = _cpuInfo.ProcessesCpuUsage.GetValueOrDefault(process);
-                var accWatts = _model.AccumulatedWattsPerApp.GetValueOrDefault(process);
-                _model.AccumulatedWattsPerApp[process] = accWatts + cpuUsage/100 * CpuPower;
-            }
+            AccumulateCpuEnergy();
 
             // calculate an app's GPU power
             foreach (var (process, _) in _gpuInfo.ProcessesGpuUsage)
@@ -161,6 +196,30 @@ public class PowerMonitorService : BackgroundService, IPowerMonitorService
         }
     }
 
+    /// <summary>
+    /// Adds each app's CPU energy over the last second, from the native estimates when there are any and
+    /// otherwise from the app's share of CPU usage.
+    /// </summary>
+    internal void AccumulateCpuEnergy()
+    {
+        if (_cpuInfo.ProcessesCpuEnergy.Count > 0)
+        {
+            foreach (var (process, joules) in _cpuInfo.ProcessesCpuEnergy)
+            {
+                var accWatts = _model.AccumulatedWattsPerApp.GetValueOrDefault(process);
+                _model.AccumulatedWattsPerApp[process] = accWatts + joules;
+            }
+            return;
+        }
+
+        foreach (var (process, _) in _cpuInfo.ProcessesCpuUsage)
+        {
+            var cpuUsage = _cpuInfo.ProcessesCpuUsage.GetValueOrDefault(process);
+            var accWatts = _model.AccumulatedWattsPerApp.GetValueOrDefault(process);
+            _model.AccumulatedWattsPerApp[process] = accWatts + cpuUsage/100 * CpuPower;
+        }
+    }
+
     /// <summary>
     /// Method to update the hourly power usage in the model.
     /// </summary>